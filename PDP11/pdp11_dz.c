@@ -92,6 +92,9 @@
 #define DZ_LMASK        ((1 << DZ_LINES) - 1)           /* mask of lines */
 #define DZ_SILO_ALM     16                              /* silo alarm level */
 
+#define DZ_V_FILL       (TTUF_V_UF + 0)                 /* fill silo in bulk */
+#define DZ_FILL         (1u << DZ_V_FILL)
+
 /* DZCSR - 160100 - control/status register */
 
 #define CSR_MAINT       0000010                         /* maint - NI */
@@ -328,6 +331,8 @@ MTAB dz_mod[] = {
     { TT_MODE, TT_MODE_7B, "7b", "7B", NULL, NULL, NULL, "7 bit mode" },
     { TT_MODE, TT_MODE_8B, "8b", "8B", NULL, NULL, NULL, "8 bit mode" },
     { TT_MODE, TT_MODE_7P, "7p", "7P", NULL, NULL, NULL, "7 bit mode - non printing suppressed" },
+    { DZ_FILL, 0,       NULL,        "NOSILOFILL", NULL, NULL, NULL, "Receive one character per line per scan" },
+    { DZ_FILL, DZ_FILL, "silo fill", "SILOFILL",   NULL, NULL, NULL, "Receive a share of the silo per line per scan" },
     { MTAB_XTD|MTAB_VDV|MTAB_VALR, 1, NULL, "DISCONNECT",
         &tmxr_dscln, NULL, &dz_desc, "Disconnect a specific line" },
     { UNIT_ATT, UNIT_ATT, "summary", NULL,
@@ -615,7 +620,8 @@ return ret;
 
 void dz_update_rcvi (void)
 {
-int32 i, dz, c;
+int32 i, j, n, dz, c;
+uint8 chars[DZ_SILO_ALM], brks[DZ_SILO_ALM];
 TMLN *lp;
 
 for (dz = 0; dz < dz_desc.lines/DZ_LINES; dz++) {       /* loop thru muxes */
@@ -624,10 +630,12 @@ for (dz = 0; dz < dz_desc.lines/DZ_LINES; dz++) {       /* loop thru muxes */
             if (dz_scnt[dz] >= DZ_SILO_ALM)
                 break;
             lp = &dz_ldsc[(dz * DZ_LINES) + i];         /* get line desc */
-            c = tmxr_getc_ln (lp);                      /* test for input */
-            if (c & SCPE_BREAK)                         /* break? frame err */
-                c = RBUF_FRME;
-            if (c) {                                    /* save in silo */
+            n = 1;                                      /* one char per scan */
+            if (dz_unit[0].flags & DZ_FILL)             /* unless filling */
+                n = (DZ_SILO_ALM - dz_scnt[dz]) / (DZ_LINES - i);/* fair share of silo */
+            n = tmxr_read_ln (lp, chars, brks, (n > 0) ? n : 1);/* test for input */
+            for (j = 0; j < n; j++) {                   /* save in silo */
+                c = brks[j] ? RBUF_FRME : chars[j];     /* break? frame err */
                 c = (c & (RBUF_CHAR | RBUF_FRME)) | RBUF_VALID | (i << RBUF_V_RLINE);
                 dz_silo[dz][dz_scnt[dz]] = (uint16)c;
                 ++dz_scnt[dz];
@@ -968,6 +976,12 @@ fprintf (st, "                  non-printing characters suppressed\n");
 fprintf (st, "  7B  high-order bit cleared  high-order bit cleared\n");
 fprintf (st, "  8B  no changes      no changes\n\n");
 fprintf (st, "The default is 8B.\n\n");
+fprintf (st, "Each receive scan normally moves at most one character from each line into\n");
+fprintf (st, "the silo.  The command\n\n");
+fprintf (st, "   sim> SET %s SILOFILL\n\n", dptr->name);
+fprintf (st, "lets each scan move up to a fair share of the free silo space from each\n");
+fprintf (st, "line, which helps bulk transfers over fast connections.  SET %s NOSILOFILL\n", dptr->name);
+fprintf (st, "restores the default.\n\n");
 fprintf (st, "The %s supports logging on a per-line basis.  The command\n\n", devtype);
 fprintf (st, "   sim> SET %s LOG=n=filename\n\n", dptr->name);
 fprintf (st, "enables logging for the specified line(n) to the indicated file.  The command\n\n");
@@ -984,6 +998,7 @@ fprintf (st, "DETACH %s command.\n\n", dptr->name);
 fprintf (st, "Other special %s commands:\n\n", dptr->name);
 fprintf (st, "   sim> SHOW %s CONNECTIONS           show current connections\n", dptr->name);
 fprintf (st, "   sim> SHOW %s STATISTICS            show statistics for active connections\n", dptr->name);
+fprintf (st, "   sim> SHOW -M %s STATISTICS         show statistics for all lines as key=value records\n", dptr->name);
 fprintf (st, "   sim> SET %s DISCONNECT=linenumber  disconnects the specified line.\n\n\n", dptr->name);
 fprintf (st, "All open connections are lost when the simulator shuts down or the %s is\n", dptr->name);
 fprintf (st, "detached.\n\n");
@@ -935,27 +935,60 @@ static t_stat vh_putc ( int32   vh,
     return (status);
 }
 
+/* TX a run of characters on a line, returning the count accepted */
+
+static int32 vh_write ( int32   vh,
+            TMLX    *lp,
+            int32   chan,
+            uint8   *buf,
+            int32   count   )
+{
+    int32   i, sent, more;
+
+    if (((lp->lnctrl >> LNCTRL_V_MAINT) & LNCTRL_M_MAINT) != 0) {
+        /* maintenance modes are handled a character at a time */
+        for (sent = 0; sent < count; ++sent)
+            if (vh_putc (vh, lp, chan, buf[sent]) == SCPE_STALL)
+                break;
+        return (sent);
+    }
+    /* truncate to desired character length */
+    for (i = 0; i < count; i++)
+        buf[i] &= bitmask[(lp->lpr >> LPR_V_CHAR_LGTH) & LPR_M_CHAR_LGTH];
+    if (tmxr_write_ln (lp->tmln, buf, count, &sent) == SCPE_STALL) {
+        /* let's flush and try again */
+        tmxr_send_buffered_data (lp->tmln);
+        tmxr_write_ln (lp->tmln, buf + sent, count - sent, &more);
+        sent += more;
+    }
+    return (sent);
+}
+
 /* Retrieve all stored input from TMXR and place in RX FIFO */
 
 static void vh_getc (   int32   vh  )
 {
     uint32  i, c;
+    int32   j, n;
     TMLX    *lp;
     int32   modem_incoming_bits;
     uint16  new_lstat;
+    uint8   chars[FIFO_SIZE], brks[FIFO_SIZE];
 
     for (i = 0; i < (uint32)VH_LINES; i++) {
         if (rbuf_idx[vh] >= (FIFO_ALARM-1)) /* close to fifo capacity? */
             continue;                       /* don't bother checking for data */
         lp = &vh_parm[(vh * VH_LINES) + i];
-        while ((c = tmxr_getc_ln (lp->tmln)) != 0) {
-            if (c & SCPE_BREAK) {
-                fifo_put (vh, lp,
-                    RBUF_FRAME_ERR | RBUF_PUTLINE (i));
-            } else {
-                c &= bitmask[(lp->lpr >> LPR_V_CHAR_LGTH) &
-                    LPR_M_CHAR_LGTH];
-                fifo_put (vh, lp, RBUF_PUTLINE (i) | c);
+        while ((n = tmxr_read_ln (lp->tmln, chars, brks, sizeof (chars))) != 0) {
+            for (j = 0; j < n; j++) {
+                if (brks[j]) {
+                    fifo_put (vh, lp,
+                        RBUF_FRAME_ERR | RBUF_PUTLINE (i));
+                } else {
+                    c = chars[j] & bitmask[(lp->lpr >> LPR_V_CHAR_LGTH) &
+                        LPR_M_CHAR_LGTH];
+                    fifo_put (vh, lp, RBUF_PUTLINE (i) | c);
+                }
             }
         }
         tmxr_set_get_modem_bits (lp->tmln, 0, 0, &modem_incoming_bits);
@@ -1383,18 +1416,25 @@ static void doDMA ( int32   vh,
         pa |= (lp->tbuf2 & TB2_M_TBUFFAD) << 16;
         status = chan << CSR_V_TX_LINE;
         while (lp->tbuffct) {
-            uint8   buf;
-            if (Map_ReadB (pa, 1, &buf)) {
+            uint8   buf[256];
+            int32   count, bad, done;
+
+            count = (lp->tbuffct < sizeof (buf)) ? lp->tbuffct : sizeof (buf);
+            if ((uint32)count > (1u << 22) - pa)  /* stop at the top of memory */
+                count = (1 << 22) - pa;
+            bad = Map_ReadB (pa, count, buf);
+            count -= bad;
+            done = vh_write (vh, lp, chan, buf, count);
+            sent += done;
+            pa = (pa + done) & ((1 << 22) - 1);
+            lp->tbuffct -= done;
+            if (done < count)   /* stalled */
+                break;
+            if (bad) {
                 status |= CSR_TX_DMA_ERR;
                 lp->tbuffct = 0;
                 break;
             }
-            if (vh_putc (vh, lp, chan, buf) == SCPE_STALL)
-                break;
-            ++sent;
-            /* pa = (pa + 1) & PAMASK; */
-            pa = (pa + 1) & ((1 << 22) - 1);
-            lp->tbuffct--;
         }
         lp->tbuf1 = pa & 0177777;
         lp->tbuf2 = (lp->tbuf2 & ~TB2_M_TBUFFAD) |
@@ -1923,6 +1963,7 @@ fprintf (st, "command, or a DETACH %s command.\n\n", dptr->name);
 fprintf (st, "Other special %s commands:\n\n", dptr->name);
 fprintf (st, "   sim> SHOW %s CONNECTIONS       show current connections\n", dptr->name);
 fprintf (st, "   sim> SHOW %s STATISTICS        show statistics for active connections\n", dptr->name);
+fprintf (st, "   sim> SHOW -M %s STATISTICS     show statistics for all lines as key=value records\n", dptr->name);
 fprintf (st, "   sim> SET %s DISCONNECT=linenumber  disconnects the specified line.\n\n", dptr->name);
 fprintf (st, "The %s does not support save and restore.  All open connections are lost\n", devtype);
 fprintf (st, "when the simulator shuts down or the %s is detached.\n\n", dptr->name);
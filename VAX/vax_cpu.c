@@ -305,6 +305,26 @@ const uint32 align[4] = {
  0xFFFFFFFF, 0x00FFFFFF, 0x0000FFFF, 0x000000FF
  };
 
+/* Instruction stream field cache (see dc_lookup) */
+
+#define DC_SIZE         4096                            /* entries, power of 2 */
+#define DC_MAXFLD       24                              /* max istream fields */
+#define DC_MAXLW        8                               /* max lw's spanned */
+#define DC_HASH(pa)     (((pa) ^ ((pa) >> 12)) & (DC_SIZE - 1))
+
+typedef struct {
+    int32       pa;                                     /* opcode phys addr, -1 = empty */
+    int32       nlw;                                    /* lw's spanned */
+    int32       fld[DC_MAXFLD];                         /* istream fields, in fetch order */
+    uint32      lw[DC_MAXLW];                           /* copy of the instruction lw's */
+    } DCENT;
+
+static DCENT *dcache = NULL;                            /* decode cache, NULL if disabled */
+static DCENT *dc_rec = NULL;                            /* entry being recorded */
+static int32 *dc_fld = NULL;                            /* next field being replayed */
+static int32 dc_nfld;                                   /* fields recorded */
+static int32 dc_pa;                                     /* phys addr of current opcode */
+
 /* External and forward references */
 
 extern int32 sys_model;
@@ -321,9 +341,13 @@ t_stat cpu_set_idle (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat cpu_show_idle (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 t_stat cpu_set_instruction_set (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat cpu_show_instruction_set (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+t_stat cpu_set_dcache (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
+t_stat cpu_show_dcache (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 const char *cpu_description (DEVICE *dptr);
 int32 cpu_get_vsw (int32 sw);
 static SIM_INLINE int32 get_istr (int32 lnt, int32 acc);
+static SIM_INLINE void dc_lookup (void);
+static SIM_INLINE void dc_done (int32 lnt);
 int32 ReadOcta (int32 va, int32 *opnd, int32 j, int32 acc);
 t_bool cpu_show_opnd (FILE *st, InstHistory *h, int32 line);
 t_stat cpu_show_hist_records (FILE *st, t_bool do_header, int32 start, int32 count);
@@ -431,6 +455,10 @@ MTAB cpu_mod[] = {
       &cpu_set_hist, &cpu_show_hist, NULL, "Displays instruction history" },
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "VIRTUAL", NULL,
       NULL, &cpu_show_virt, NULL, "show translation for address arg in KESU mode" },
+    { MTAB_XTD|MTAB_VDV, 1, "DECODECACHE", "DECODECACHE",
+      &cpu_set_dcache, &cpu_show_dcache, NULL, "Enables the instruction stream field cache" },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NODECODECACHE",
+      &cpu_set_dcache, NULL, NULL, "Disables the instruction stream field cache" },
     CPU_MODEL_MODIFIERS  /* Model specific cpu modifiers from vaxXXX_defs.h */
     CPU_INST_MODIFIERS   /* Model specific cpu instruction modifiers from vaxXXX_defs.h */
     { 0 }
@@ -512,6 +540,8 @@ SET_IRQL;                                               /* eval interrupts */
 FLUSH_ISTR;                                             /* clear prefetch */
 
 abortval = setjmp (save_env);                           /* set abort hdlr */
+dc_rec = NULL;                                          /* abandon decode cache */
+dc_fld = NULL;
 if (abortval > 0) {                                     /* sim stop? */
     PSL = PSL | cc;                                     /* put PSL together */
     pcq_r->qptr = pcq_p;                                /* update pc q ptr */
@@ -651,7 +681,13 @@ for ( ;; ) {
     recqptr = 0;                                        /* clr recovery q */
     AIO_CHECK_EVENT;                                    /* queue async events */
     if (sim_interval <= 0) {                            /* chk clock queue */
+        PSL = PSL | cc;                                 /* events see a whole PSL */
+        pcq_r->qptr = pcq_p;                            /* and current PC queue */
         temp = sim_process_event ();
+        if (sim_rem_con_direct_pending)                 /* remote console command */
+            sim_rem_con_direct ();                      /* waiting for a boundary? */
+        cc = PSL & CC_MASK;                             /* split PSL */
+        PSL = PSL & ~CC_MASK;
         if (temp)
             ABORT (temp);
         SET_IRQL;                                       /* update interrupts */
@@ -722,6 +758,8 @@ for ( ;; ) {
 
     sim_interval = sim_interval - (1 + (extra_bytes>>5));/* count instr */
     extra_bytes = 0;                                    /* digest string count */
+    if (dcache && ((PSL & PSL_FPD) == 0))               /* decoded before? */
+        dc_lookup ();
     GET_ISTR (opc, L_BYTE);                             /* get opcode */
     if (opc == 0xFD) {                                  /* 2 byte op? */
         GET_ISTR (opc, L_BYTE);                         /* get second byte */
@@ -1551,6 +1589,8 @@ for ( ;; ) {
                 }                                       /* end case spec */
             }                                           /* end for */
         }                                               /* end if not FPD */
+    if (dc_rec || dc_fld)                               /* finish decode cache */
+        dc_done (PC - fault_PC);
 
 /* Optionally record instruction history */
 
@@ -2630,7 +2670,10 @@ for ( ;; ) {
             while ((sim_clock_queue != QUEUE_LIST_END) &&
                    ((sim_clock_queue->flags & UNIT_IDLE) == 0)) {
                 sim_interval = 0;
+                PSL = PSL | cc;                         /* events see a whole PSL */
                 temp = sim_process_event ();
+                cc = PSL & CC_MASK;                     /* split PSL */
+                PSL = PSL & ~CC_MASK;
                 if (temp)
                     ABORT (temp);
                 SET_IRQL;                               /* update interrupts */
@@ -3184,6 +3227,10 @@ static SIM_INLINE int32 get_istr (int32 lnt, int32 acc)
 int32 bo = PC & 3;
 int32 sc, val, t;
 
+if (dc_fld) {                                           /* replaying decode? */
+    PC = PC + lnt;
+    return *dc_fld++;
+    }
 while ((bo + lnt) > ibcnt) {                            /* until enuf bytes */
     if ((ppc < 0) || (VA_GETOFF (ppc) == 0)) {          /* PPC inv, xpg? */
         ppc = Test ((PC + ibcnt) & ~03, RD, &t);        /* xlate PC */
@@ -3213,9 +3260,96 @@ if ((bo + lnt) >= 4) {                                  /* retire ibufl? */
     ibufl = ibufh;
     ibcnt = ibcnt - 4;
     }
+if (dc_rec) {                                           /* recording decode? */
+    if (dc_nfld < DC_MAXFLD)
+        dc_rec->fld[dc_nfld] = val;
+    dc_nfld = dc_nfld + 1;
+    }
 return val;
 }
 
+/* Instruction stream field cache
+
+   The cache remembers instructions in main memory by the physical address
+   of their opcode.  An entry holds the instruction stream fields (opcode,
+   specifier bytes, displacements, immediates and branch displacements) in
+   the order the specifier flows fetched them, plus a copy of the longwords
+   the instruction occupies.  When the instruction is executed again,
+   get_istr hands back the remembered fields instead of extracting them
+   from the prefetch buffer a byte, word or longword at a time.
+
+   Only the instruction stream fetches are saved.  The opcode dispatch
+   through drom and the specifier flows still run for every instruction,
+   so the gain is limited to tight loops of short instructions.
+
+   Entries are tagged with physical addresses, and the PC is translated
+   before every lookup, so TLB flushes and context switches never make an
+   entry stale.  A hit also requires the instruction's longwords to still
+   match memory; a write to the instruction, by the CPU, by DMA or from the
+   console, simply turns the next lookup into a miss.  Instructions which
+   cross a page, or are too long for an entry, are not cached.
+*/
+
+static SIM_INLINE void dc_lookup (void)
+{
+int32 pa, t, i;
+DCENT *dp;
+
+dc_fld = NULL;
+dc_rec = NULL;
+if ((ppc >= 0) && ((ibcnt != 0) || (VA_GETOFF (ppc) != 0)))
+    pa = ppc - ibcnt + (PC & 3);                        /* PC in prefetch page */
+else {
+    ppc = Test (PC & ~03, RD, &t);                      /* xlate PC */
+    ibcnt = 0;
+    if (ppc < 0)                                        /* let get_istr fault */
+        return;
+    pa = ppc + (PC & 3);
+    }
+if (!ADDR_IS_MEM (pa))                                  /* memory only */
+    return;
+dp = &dcache[DC_HASH (pa)];
+if (dp->pa == pa) {                                     /* tag match? */
+    for (i = 0; i < dp->nlw; i++) {                     /* unchanged? */
+        if (dp->lw[i] != M[(pa >> 2) + i])
+            break;
+        }
+    if (i == dp->nlw) {                                 /* hit, replay */
+        dc_fld = dp->fld;
+        dc_pa = pa;
+        return;
+        }
+    }
+dp->pa = -1;                                            /* miss, record */
+dc_rec = dp;
+dc_nfld = 0;
+dc_pa = pa;
+ibcnt = 0;                                              /* fetch from memory */
+ppc = pa & ~03;
+}
+
+static SIM_INLINE void dc_done (int32 lnt)
+{
+int32 i;
+
+if (dc_fld) {                                           /* replayed? */
+    dc_fld = NULL;
+    ibcnt = 0;                                          /* resync prefetch */
+    ppc = (dc_pa + lnt) & ~03;
+    return;
+    }
+if ((dc_nfld <= DC_MAXFLD) && (lnt > 0) &&              /* fits, in one page? */
+    ((VA_GETOFF (dc_pa) + lnt) <= VA_PAGSIZE)) {
+    dc_rec->nlw = ((dc_pa & 03) + lnt + 3) >> 2;
+    if (dc_rec->nlw <= DC_MAXLW) {
+        for (i = 0; i < dc_rec->nlw; i++)
+            dc_rec->lw[i] = M[(dc_pa >> 2) + i];
+        dc_rec->pa = dc_pa;                             /* entry now valid */
+        }
+    }
+dc_rec = NULL;
+}
+
 /* Read octaword specifier */
 
 int32 ReadOcta (int32 va, int32 *opnd, int32 j, int32 acc)
@@ -3322,9 +3456,11 @@ if (M == NULL) {                        /* first time init? */
     if (pcq_r == NULL)
         return SCPE_IERR;
     pcq_r->qptr = 0;
+    sim_set_readable_registers_state ();                /* consistent during events */
     M = (uint32 *) calloc (((uint32) MEMSIZE) >> 2, sizeof (uint32));
     if (M == NULL)
         return SCPE_MEM;
+    cpu_set_dcache (&cpu_unit, 1, NULL, NULL);          /* decode cache on */
     auto_config(NULL, 0);               /* do an initial auto configure */
     }
 return build_dib_tab ();
@@ -3762,6 +3898,32 @@ if (sim_idle_enab && (cpu_idle_type != 0))
 sim_show_idle (st, uptr, val, desc);
 return SCPE_OK;
 }
+
+/* Enable/disable the instruction stream field cache (always starts empty) */
+
+t_stat cpu_set_dcache (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+int32 i;
+
+if (cptr)
+    return SCPE_ARG;
+free (dcache);
+dcache = NULL;
+if (val) {
+    dcache = (DCENT *) malloc (DC_SIZE * sizeof (DCENT));
+    if (dcache == NULL)
+        return SCPE_MEM;
+    for (i = 0; i < DC_SIZE; i++)
+        dcache[i].pa = -1;
+    }
+return SCPE_OK;
+}
+
+t_stat cpu_show_dcache (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+fprintf (st, dcache ? "decode cache" : "no decode cache");
+return SCPE_OK;
+}
  
 static struct {
     int32 mask;
@@ -781,6 +781,41 @@ return 0;                                               /* q can't be empty */
 #define MVC_M_STATE     3
 #define MVC_V_CC        2
 
+/* String fast paths
+
+   While the pages referenced by a string instruction are in memory,
+   the instructions work a chunk at a time directly on host memory, via
+   Host, instead of a byte or longword at a time via Read and Write.
+   A chunk never crosses a page boundary of any string it references,
+   and all of its pages are translated (and any fault taken) before
+   the chunk is processed, so the registers are exact whenever a fault
+   can occur.  If a page is not in memory, the normal loop finishes the
+   instruction from the current register state.
+
+   str_chunk returns the length of the next chunk, limited to lnt and
+   to the bytes left in the pages of va1 and va2, going up from them
+   (forward) or down from them (backward).
+*/
+
+static int32 str_chunk (int32 lnt, uint32 va1, uint32 va2, t_bool back)
+{
+int32 pl1, pl2;
+
+if (back) {
+    pl1 = VA_GETOFF (va1 - 1) + 1;
+    pl2 = VA_GETOFF (va2 - 1) + 1;
+    }
+else {
+    pl1 = (int32) VA_PAGSIZE - VA_GETOFF (va1);
+    pl2 = (int32) VA_PAGSIZE - VA_GETOFF (va2);
+    }
+if (lnt > pl1)
+    lnt = pl1;
+if (lnt > pl2)
+    lnt = pl2;
+return lnt;
+}
+
 /* MOVC3, MOVC5
 
    if PSL<fpd> = 0 and MOVC3,
@@ -808,6 +843,7 @@ int32 op_movc (int32 *opnd, int32 movc5, int32 acc)
 {
 int32 i, cc, fill, wd;
 int32 j, lnt, mlnt[3];
+uint8 *src, *dst;
 static const int32 looplnt[3] = { L_BYTE, L_LONG, L_BYTE };
 
 if (PSL & PSL_FPD) {                                    /* FPD set? */
@@ -859,6 +895,17 @@ else {
 switch (R[5] & MVC_M_STATE) {                           /* case on state */
 
     case MVC_FRWD:                                      /* move forward */
+        while (R[2] != 0) {                             /* fast path */
+            lnt = str_chunk (R[2], R[1], R[3], FALSE);
+            if (((src = Host (R[1], RA)) == NULL) ||    /* src, dst pages */
+                ((dst = Host (R[3], WA)) == NULL))      /* in memory? */
+                break;
+            memmove (dst, src, lnt);                    /* move chunk */
+            R[1] = R[1] + lnt;                          /* inc src addr */
+            R[3] = R[3] + lnt;                          /* inc dst addr */
+            R[2] = R[2] - lnt;                          /* dec move lnt */
+            extra_bytes = extra_bytes + (lnt >> 2);
+            }
         mlnt[0] = (4 - R[3]) & 3;                       /* length to align */
         if (mlnt[0] > R[2])                             /* cant exceed total */
             mlnt[0] = R[2];
@@ -877,6 +924,17 @@ switch (R[5] & MVC_M_STATE) {                           /* case on state */
         goto FILL;                                      /* check for fill */
 
     case MVC_BACK:                                      /* move backward */
+        while (R[2] != 0) {                             /* fast path */
+            lnt = str_chunk (R[2], R[1], R[3], TRUE);
+            if (((src = Host (R[1] - 1, RA)) == NULL) ||/* src, dst pages */
+                ((dst = Host (R[3] - 1, WA)) == NULL))  /* in memory? */
+                break;
+            memmove (dst - (lnt - 1), src - (lnt - 1), lnt);
+            R[1] = R[1] - lnt;                          /* dec src addr */
+            R[3] = R[3] - lnt;                          /* dec dst addr */
+            R[2] = R[2] - lnt;                          /* dec move lnt */
+            extra_bytes = extra_bytes + (lnt >> 2);
+            }
         mlnt[0] = R[3] & 03;                            /* length to align */
         if (mlnt[0] > R[2])                             /* cant exceed total */
             mlnt[0] = R[2];
@@ -900,6 +958,15 @@ switch (R[5] & MVC_M_STATE) {                           /* case on state */
         if (R[4] <= 0)                                  /* any fill? */
             break;
         R[5] = R[5] | MVC_FILL;                         /* set state */
+        while (R[4] > 0) {                              /* fast path */
+            lnt = str_chunk (R[4], R[3], R[3], FALSE);
+            if ((dst = Host (R[3], WA)) == NULL)        /* dst in memory? */
+                break;
+            memset (dst, fill & BMASK, lnt);            /* fill chunk */
+            R[3] = R[3] + lnt;                          /* inc dst addr */
+            R[4] = R[4] - lnt;                          /* dec fill lnt */
+            extra_bytes = extra_bytes + (lnt >> 2);
+            }
         mlnt[0] = (4 - R[3]) & 3;                       /* length to align */
         if (mlnt[0] > R[4])                             /* cant exceed total */
             mlnt[0] = R[4];
@@ -952,7 +1019,8 @@ return cc;
 
 int32 op_cmpc (int32 *opnd, int32 cmpc5, int32 acc)
 {
-int32 cc, s1, s2, fill;
+int32 cc, s1, s2, fill, i, lnt;
+uint8 *src1, *src2;
 
 if (PSL & PSL_FPD) {                                    /* FPD set? */
     SETPC (fault_PC + STR_GETDPC (R[0]));               /* reset PC */
@@ -974,6 +1042,25 @@ else {
     PSL = PSL | PSL_FPD;
     }
 R[2] = R[2] & STR_LNMASK;                               /* mask src2len */
+while ((R[0] & STR_LNMASK) && R[2]) {                   /* fast path */
+    lnt = str_chunk (((R[0] & STR_LNMASK) < R[2])? (R[0] & STR_LNMASK): R[2],
+        R[1], R[3], FALSE);
+    if (((src1 = Host (R[1], RA)) == NULL) ||           /* src1, src2 pages */
+        ((src2 = Host (R[3], RA)) == NULL))             /* in memory? */
+        break;
+    i = lnt;
+    if (memcmp (src1, src2, lnt) != 0) {                /* mismatch? */
+        for (i = 0; src1[i] == src2[i]; i++)            /* find it */
+            continue;
+        }
+    R[0] = (R[0] & ~STR_LNMASK) | ((R[0] - i) & STR_LNMASK);
+    R[1] = R[1] + i;
+    R[2] = R[2] - i;
+    R[3] = R[3] + i;
+    extra_bytes = extra_bytes + i;
+    if (i < lnt)                                        /* mismatch is done */
+        break;                                          /* in loop below */
+    }
 for (s1 = s2 = 0; ((R[0] | R[2]) & STR_LNMASK) != 0; extra_bytes++) {
     if (R[0] & STR_LNMASK)                              /* src1? read */
         s1 = Read (R[1], L_BYTE, RA);
@@ -1012,7 +1099,8 @@ return cc;
 
 int32 op_locskp (int32 *opnd, int32 skpc, int32 acc)
 {
-int32 c, match;
+int32 c, match, i, lnt;
+uint8 *src, *mp;
 
 if (PSL & PSL_FPD) {                                    /* FPD set? */
     SETPC (fault_PC + STR_GETDPC (R[0]));               /* reset PC */
@@ -1024,6 +1112,24 @@ else {
     R[1] = opnd[2];                                     /* src addr */
     PSL = PSL | PSL_FPD;
     }
+while ((R[0] & STR_LNMASK) != 0) {                      /* fast path */
+    lnt = str_chunk (R[0] & STR_LNMASK, R[1], R[1], FALSE);
+    if ((src = Host (R[1], RA)) == NULL)                /* src in memory? */
+        break;
+    if (skpc) {                                         /* SKPC? */
+        for (i = 0; (i < lnt) && (src[i] == (match & BMASK)); i++)
+            continue;
+        }
+    else {                                              /* LOCC */
+        mp = (uint8 *) memchr (src, match & BMASK, lnt);
+        i = mp? (int32) (mp - src): lnt;
+        }
+    R[0] = (R[0] & ~STR_LNMASK) | ((R[0] - i) & STR_LNMASK);
+    R[1] = R[1] + i;
+    extra_bytes = extra_bytes + i;
+    if (i < lnt)                                        /* found is done */
+        break;                                          /* in loop below */
+    }
 for ( ; (R[0] & STR_LNMASK) != 0; extra_bytes++ ) {    /* loop thru string */
     c = Read (R[1], L_BYTE, RA);                        /* get src byte */
     if ((c == match) ^ skpc)                            /* match & locc? */
@@ -1052,7 +1158,8 @@ return (R[0]? 0: CC_Z);                                 /* set cc's */
 
 int32 op_scnspn (int32 *opnd, int32 spanc, int32 acc)
 {
-int32 c, t, mask;
+int32 c, t, mask, i, lnt;
+uint8 *src, *tbl = NULL;
 
 if (PSL & PSL_FPD) {                                    /* FPD set? */
     SETPC (fault_PC + STR_GETDPC (R[0]));               /* reset PC */
@@ -1065,6 +1172,23 @@ else {
     R[0] = STR_PACK (mask, opnd[0]);                    /* srclen + FPD data */
     PSL = PSL | PSL_FPD;
     }
+while (((R[0] & STR_LNMASK) != 0) &&                    /* fast path if */
+    ((VA_GETOFF (R[3]) + 256) <= (int32) VA_PAGSIZE)) { /* tbl in one page */
+    lnt = str_chunk (R[0] & STR_LNMASK, R[1], R[1], FALSE);
+    if ((src = Host (R[1], RA)) == NULL)                /* src in memory? */
+        break;
+    if ((tbl == NULL) &&                                /* tbl in memory? */
+        ((tbl = Host (R[3], RA)) == NULL))
+        break;
+    for (i = 0; (i < lnt) &&                            /* test vs instr */
+        ((((tbl[src[i]] & mask) != 0) ^ spanc) == 0); i++)
+        continue;
+    R[0] = (R[0] & ~STR_LNMASK) | ((R[0] - i) & STR_LNMASK);
+    R[1] = R[1] + i;
+    extra_bytes = extra_bytes + i;
+    if (i < lnt)                                        /* found is done */
+        break;                                          /* in loop below */
+    }
 for ( ; (R[0] & STR_LNMASK) != 0; extra_bytes++ ) {    /* loop thru string */
     c = Read (R[1], L_BYTE, RA);                        /* get byte */
     t = Read (R[3] + c, L_BYTE, RA);                    /* get table ent */
@@ -86,6 +86,7 @@ t_stat tlb_reset (DEVICE *dptr);
 const char *tlb_description (DEVICE *dptr);
 
 TLBENT fill (uint32 va, int32 lnt, int32 acc, int32 *stat);
+static void tlb_set (TLBENT *tlbp, int32 vpn, int32 tlbpte);
 extern int32 ReadIO (uint32 pa, int32 lnt);
 extern void WriteIO (uint32 pa, int32 val, int32 lnt);
 extern int32 ReadReg (uint32 pa, int32 lnt);
@@ -142,7 +143,7 @@ TLBENT fill (uint32 va, int32 lnt, int32 acc, int32 *stat)
 {
 int32 ptidx = (((uint32) va) >> 7) & ~03;
 int32 tlbpte, ptead, pte, tbi, vpn;
-static TLBENT zero_pte = { 0, 0 };
+static TLBENT zero_pte = { 0, 0, 0, NULL };
 
 if (va & VA_S0) {                                       /* system space? */
     if (ptidx >= d_slr)                                 /* system */
@@ -176,9 +177,8 @@ else {
 #endif
         if ((pte & PTE_V) == 0)                         /* spte TNV? */
             MM_ERR (PR_PTNV);
-        stlb[tbi].tag = vpn;                            /* set stlb tag */
-        stlb[tbi].pte = cvtacc[PTE_GETACC (pte)] |
-            ((pte << VA_N_OFF) & TLB_PFN);              /* set stlb data */
+        tlb_set (&stlb[tbi], vpn, cvtacc[PTE_GETACC (pte)] |
+            ((pte << VA_N_OFF) & TLB_PFN));             /* set stlb ent */
         }
     ptead = (stlb[tbi].pte & TLB_PFN) | VA_GETOFF (ptead);
 #endif
@@ -198,15 +198,39 @@ if (acc & TLB_WACC) {                                   /* write? */
 vpn = VA_GETVPN (va);
 tbi = VA_GETTBI (vpn);
 if ((va & VA_S0) == 0) {                                /* process space? */
-    ptlb[tbi].tag = vpn;                                /* store tlb ent */
-    ptlb[tbi].pte = tlbpte;
+    tlb_set (&ptlb[tbi], vpn, tlbpte);                  /* store tlb ent */
     return ptlb[tbi];
     }
-stlb[tbi].tag = vpn;                                    /* system space */
-stlb[tbi].pte = tlbpte;                                 /* store tlb ent */
+tlb_set (&stlb[tbi], vpn, tlbpte);                      /* system space */
 return stlb[tbi];
 }
 
+/* Set TLB entry
+
+   Besides the tag and pte, this records the host memory fast path
+   used by Read and Write.  Pages in memory get a host pointer to the
+   start of the page and fast path bits for the access modes allowed
+   to read the page, plus those allowed to write it if pte<m> is set.
+   Pages in I/O space get no fast path bits, so every reference to
+   them takes the normal path.
+*/
+
+static void tlb_set (TLBENT *tlbp, int32 vpn, int32 tlbpte)
+{
+uint32 pa = (uint32) (tlbpte & TLB_PFN);
+
+tlbp->tag = vpn;
+tlbp->pte = tlbpte;
+if (ADDR_IS_MEM (pa)) {
+    tlbp->fast = tlbpte & ((tlbpte & TLB_M)? (TLB_RACC | TLB_WACC): TLB_RACC);
+    tlbp->mem = M + (pa >> 2);
+    }
+else {
+    tlbp->fast = 0;
+    tlbp->mem = NULL;
+    }
+}
+
 /* Utility routines */
 
 void set_map_reg (void)
@@ -227,8 +251,11 @@ size_t i;
 
 for (i = 0; i < VA_TBSIZE; i++) {
     ptlb[i].tag = ptlb[i].pte = -1;
-    if (stb)
+    ptlb[i].fast = 0;
+    if (stb) {
         stlb[i].tag = stlb[i].pte = -1;
+        stlb[i].fast = 0;
+        }
     }
 }
 
@@ -238,9 +265,14 @@ void zap_tb_ent (uint32 va)
 {
 int32 tbi = VA_GETTBI (VA_GETVPN (va));
 
-if (va & VA_S0)
+if (va & VA_S0) {
     stlb[tbi].tag = stlb[tbi].pte = -1;
-else ptlb[tbi].tag = ptlb[tbi].pte = -1;
+    stlb[tbi].fast = 0;
+    }
+else {
+    ptlb[tbi].tag = ptlb[tbi].pte = -1;
+    ptlb[tbi].fast = 0;
+    }
 }
 
 /* Check for tlb entry corresponding to va */
@@ -281,6 +313,9 @@ uint32 idx = (uint32) addr >> 1;
 
 if (idx >= VA_TBSIZE)
     return SCPE_NXM;
+if (tlbn)                                               /* no fast path */
+    stlb[idx].fast = 0;
+else ptlb[idx].fast = 0;
 if (addr & 1) {
     if (tlbn) stlb[idx].pte = (int32) val;
     else ptlb[idx].pte = (int32) val;
@@ -298,8 +333,10 @@ t_stat tlb_reset (DEVICE *dptr)
 {
 size_t i;
 
-for (i = 0; i < VA_TBSIZE; i++)
+for (i = 0; i < VA_TBSIZE; i++) {
     stlb[i].tag = ptlb[i].tag = stlb[i].pte = ptlb[i].pte = -1;
+    stlb[i].fast = ptlb[i].fast = 0;
+    }
 return SCPE_OK;
 }
 
@@ -42,6 +42,7 @@
         ReadB(W)        -       read aligned physical byte (word)
         WriteB(W)       -       write aligned physical byte (word)
         Test            -       test acccess
+        Host            -       host address of virtual byte
 
 */
 
@@ -54,6 +55,8 @@
 typedef struct {
     int32       tag;                                    /* tag */
     int32       pte;                                    /* pte */
+    int32       fast;                                   /* fast path access */
+    uint32      *mem;                                   /* host page ptr */
     } TLBENT;
 
 extern uint32 *M;
@@ -91,6 +94,13 @@ static SIM_INLINE void WriteL (uint32 pa, int32 val);
 
    These routines logically fall into three phases:
 
+   0.   If mapping is on and the TLB entry for the page is valid, the
+        page is in memory, the access mode has a fast path bit set,
+        and the reference is aligned, access host memory directly
+        through the entry's host pointer.  TLB entries for I/O space
+        never have fast path bits set.  Write fast path bits are only
+        set once pte<m> is set, so writes that must update the pte
+        still go through fill.
    1.   Look up the virtual address in the translation buffer, calling
         the fill routine on a tag mismatch or access mismatch (invalid
         tlb entries have access = 0 and thus always mismatch).  The
@@ -120,14 +130,24 @@ static SIM_INLINE int32 Read (uint32 va, int32 lnt, int32 acc)
 {
 int32 vpn, off, tbi, pa;
 int32 pa1, bo, sc, wl, wh;
-TLBENT xpte;
+TLBENT xpte, *tlbp;
 
 mchk_va = va;
 if (mapen) {                                            /* mapping on? */
     vpn = VA_GETVPN (va);                               /* get vpn, offset */
     off = VA_GETOFF (va);
     tbi = VA_GETTBI (vpn);
-    xpte = (va & VA_S0)? stlb[tbi]: ptlb[tbi];          /* access tlb */
+    tlbp = (va & VA_S0)? &stlb[tbi]: &ptlb[tbi];        /* access tlb */
+    if ((tlbp->fast & acc) && (tlbp->tag == vpn) &&     /* fast path? */
+        ((off & (lnt - 1)) == 0)) {
+        wl = tlbp->mem[off >> 2];                       /* direct read */
+        if (lnt >= L_LONG)
+            return wl;
+        if (lnt == L_WORD)
+            return ((wl >> ((off & 2) << 3)) & WMASK);
+        return ((wl >> ((off & 3) << 3)) & BMASK);
+        }
+    xpte = *tlbp;
     if (((xpte.pte & acc) == 0) || (xpte.tag != vpn) ||
         ((acc & TLB_WACC) && ((xpte.pte & TLB_M) == 0)))
         xpte = fill (va, lnt, acc, NULL);               /* fill if needed */
@@ -186,14 +206,29 @@ static SIM_INLINE void Write (uint32 va, int32 val, int32 lnt, int32 acc)
 {
 int32 vpn, off, tbi, pa;
 int32 pa1, bo, sc;
-TLBENT xpte;
+TLBENT xpte, *tlbp;
 
 mchk_va = va;
 if (mapen) {
     vpn = VA_GETVPN (va);
     off = VA_GETOFF (va);
     tbi = VA_GETTBI (vpn);
-    xpte = (va & VA_S0)? stlb[tbi]: ptlb[tbi];          /* access tlb */
+    tlbp = (va & VA_S0)? &stlb[tbi]: &ptlb[tbi];        /* access tlb */
+    if ((tlbp->fast & acc) && (tlbp->tag == vpn) &&     /* fast path? */
+        ((off & (lnt - 1)) == 0)) {
+        uint32 *mp = &tlbp->mem[off >> 2];              /* direct write */
+        if (lnt >= L_LONG)
+            *mp = val;
+        else {
+            sc = (off & 3) << 3;
+            if (lnt == L_WORD)
+                *mp = (*mp & ~(WMASK << sc)) | (val << sc);
+            else
+                *mp = (*mp & ~(BMASK << sc)) | (val << sc);
+            }
+        return;
+        }
+    xpte = *tlbp;
     if (((xpte.pte & acc) == 0) || (xpte.tag != vpn) ||
         ((xpte.pte & TLB_M) == 0))
         xpte = fill (va, lnt, acc, NULL);
@@ -264,6 +299,47 @@ if (mapen) {                                            /* mapping on? */
 return va & PAMASK;                                     /* ret phys addr */
 }
 
+/* Host address of a virtual byte (string instructions)
+
+   Inputs:
+        va      =       virtual address
+        acc     =       access code (KESU)
+   Output:
+        pointer to the host copy of the byte, or NULL if the page is
+        not in memory or the host is big endian
+
+   The page is translated as for Read or Write with the same access
+   code, including any fault, so the caller may reference the rest of
+   the page directly through the returned pointer.
+*/
+
+static SIM_INLINE uint8 *Host (uint32 va, int32 acc)
+{
+int32 vpn, off, tbi;
+uint32 pa;
+TLBENT *tlbp;
+
+if (!sim_end)                                           /* VAX byte order? */
+    return NULL;
+mchk_va = va;
+if (mapen) {                                            /* mapping on? */
+    vpn = VA_GETVPN (va);                               /* get vpn, offset */
+    off = VA_GETOFF (va);
+    tbi = VA_GETTBI (vpn);
+    tlbp = (va & VA_S0)? &stlb[tbi]: &ptlb[tbi];        /* access tlb */
+    if (((tlbp->fast & acc) == 0) || (tlbp->tag != vpn)) {
+        fill (va, L_BYTE, acc, NULL);                   /* fill or fault */
+        if (((tlbp->fast & acc) == 0) || (tlbp->tag != vpn))
+            return NULL;                                /* not memory */
+        }
+    return ((uint8 *) tlbp->mem) + off;
+    }
+pa = va & PAMASK;
+if (ADDR_IS_MEM (pa))
+    return ((uint8 *) M) + pa;
+return NULL;
+}
+
 /* Read aligned physical (in virtual context, unless indicated)
 
    Inputs:
@@ -357,6 +357,62 @@ DEVICE sim_scp_dev = {
     scp_debug, NULL, NULL, NULL, NULL, NULL,
     sim_scp_description};
 
+/* Event record and replay
+
+   SET ASYNCH RECORD=file logs, in simulated time (sim_gtime), everything 
+   which reaches a running simulator from outside of its instruction stream:
+
+       A <gtime> <events> <unit> <delay>
+                                        an asynchronous I/O completion moved
+                                        into the event queue after <events>
+                                        events had been dispatched
+       I <gtime> <source> <hex data>    input read from a mux line, the
+                                        console keyboard or a LAN interface
+       V <gtime> <tag> <value>          a value derived from host time (clock
+                                        calibrations, idle periods, time of day)
+
+   SET ASYNCH REPLAY=file feeds that back to a later run started from the 
+   same state: completions which arrive are held until the simulated time 
+   and event they were recorded at (waiting for them when the host is slower 
+   this time), input comes from the log rather than the host, and host time 
+   derived values are replaced by the recorded ones.  The run then executes 
+   the same instruction stream as the recorded one.  A replay which finds 
+   that it no longer follows the log (a value requested at another time 
+   than recorded, or a completion which never shows up) says where and 
+   carries on as an ordinary run.
+*/
+
+typedef struct {
+    double      gtime;                  /* simulated time of the record */
+    char        type;                   /* 'A', 'I' or 'V' */
+    t_bool      done;                   /* consumed by the replay */
+    UNIT        *uptr;                  /* A: unit completing */
+    uint32      events;                 /* A: events dispatched before it */
+    char        *name;                  /* I: input source, V: value tag */
+    uint8       *data;                  /* I: input data */
+    int32       size;                   /* I: input data length */
+    int32       used;                   /* I: input data already delivered */
+    t_int64     value;                  /* A: activation delay, V: value */
+    } EVLOG_REC;
+
+#define EVLOG_WAIT_MS       10000       /* longest wait for a held back completion */
+
+static FILE *sim_evlog_file = NULL;     /* recording to */
+static char *sim_evlog_rname = NULL;    /* recording file name */
+static char *sim_evlog_pname = NULL;    /* replaying file name */
+static EVLOG_REC *sim_evlog_rec = NULL; /* records being replayed */
+static uint32 sim_evlog_count = 0;
+static uint32 sim_evlog_next[3];        /* first unconsumed A, I and V records */
+static uint32 sim_evlog_events = 0;     /* events dispatched since record/replay began */
+#if defined (SIM_ASYNCH_IO)
+static UNIT *sim_evlog_held = QUEUE_LIST_END;/* completions waiting for their time */
+static void _sim_evlog_deliver (void);
+#endif
+static t_stat sim_evlog_svc (UNIT *uptr);
+static void _sim_evlog_schedule (void);
+static void _sim_evlog_replay_stop (const char *why);
+static void _sim_evlog_replay_free (void);
+
 /* Asynch I/O support */
 #if defined (SIM_ASYNCH_IO)
 pthread_mutex_t sim_asynch_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -371,14 +427,45 @@ pthread_t sim_asynch_main_threadid;
 UNIT * volatile sim_asynch_queue;
 t_bool sim_asynch_enabled = TRUE;
 int32 sim_asynch_check;
+int32 sim_asynch_inflight = 0;         /* disk and tape requests not yet completed */
 int32 sim_asynch_latency = 4000;      /* 4 usec interrupt latency */
 int32 sim_asynch_inst_latency = 20;   /* assume 5 mip simulator */
 
+/* Move arrived completions onto the replay's held list (AIO_LOCK held) */
+
+static int _sim_evlog_hold (void)
+{
+int held = 0;
+
+while (AIO_QUEUE_VAL != QUEUE_LIST_END) {
+    UNIT *q, *uptr;
+
+    do {                                /* Grab current queue */
+        q = AIO_QUEUE_VAL;
+        } while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));
+    while (q != QUEUE_LIST_END) {
+        uptr = q;
+        q = q->a_next;
+        uptr->a_next = sim_evlog_held;
+        sim_evlog_held = uptr;
+        ++held;
+        }
+    }
+return held;
+}
+
 int sim_aio_update_queue (void)
 {
 int migrated = 0;
 
 AIO_ILOCK;
+if (sim_evlog_rec) {                    /* replaying? */
+    migrated = _sim_evlog_hold ();      /* hold until their recorded time */
+    AIO_IUNLOCK;
+    sim_perf_asynch += migrated;
+    _sim_evlog_deliver ();
+    return migrated;
+    }
 if (AIO_QUEUE_VAL != QUEUE_LIST_END) {  /* List !Empty */
     UNIT *q, *uptr;
     int32 a_event_time;
@@ -399,6 +486,8 @@ if (AIO_QUEUE_VAL != QUEUE_LIST_END) {  /* List !Empty */
         else
             a_event_time = uptr->a_event_time;
         AIO_IUNLOCK;
+        if (sim_evlog_file)
+            fprintf (sim_evlog_file, "A %.0f %u %s %d\n", sim_gtime (), sim_evlog_events, sim_uname (uptr), a_event_time);
         uptr->a_activate_call (uptr, a_event_time);
         if (uptr->a_check_completion) {
             sim_debug (SIM_DBG_AIO_QUEUE, &sim_scp_dev, "Calling Completion Check for asynch event on %s\n", sim_uname(uptr));
@@ -408,6 +497,7 @@ if (AIO_QUEUE_VAL != QUEUE_LIST_END) {  /* List !Empty */
         }
     }
 AIO_IUNLOCK;
+sim_perf_asynch += migrated;
 return migrated;
 }
 
@@ -438,6 +528,443 @@ if (sim_idle_wait) {
 t_bool sim_asynch_enabled = FALSE;
 #endif
 
+static const char *sim_int_evlog_description (DEVICE *dptr)
+{
+return "Event replay facility";
+}
+
+static UNIT sim_evlog_unit = { UDATA (&sim_evlog_svc, UNIT_IDLE, 0) };
+DEVICE sim_evlog_dev = {
+    "INT-EVLOG", &sim_evlog_unit, NULL, NULL, 
+    1, 0, 0, 0, 0, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL, 
+    NULL, DEV_NOSAVE, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL,
+    sim_int_evlog_description};
+
+t_bool sim_evlog_active (void)
+{
+return (sim_evlog_file != NULL) || (sim_evlog_rec != NULL);
+}
+
+t_bool sim_evlog_replaying (void)
+{
+return (sim_evlog_rec != NULL);
+}
+
+/* Find the next unconsumed record of a type at or after its cursor */
+
+static EVLOG_REC *_sim_evlog_next (char type)
+{
+uint32 *next = &sim_evlog_next[(type == 'A') ? 0 : ((type == 'I') ? 1 : 2)];
+
+while ((*next < sim_evlog_count) && 
+       ((sim_evlog_rec[*next].type != type) || sim_evlog_rec[*next].done))
+    ++*next;
+return (*next < sim_evlog_count) ? &sim_evlog_rec[*next] : NULL;
+}
+
+static void _sim_evlog_check_done (void)
+{
+if ((_sim_evlog_next ('A') == NULL) && 
+    (_sim_evlog_next ('I') == NULL) && 
+    (_sim_evlog_next ('V') == NULL))
+    _sim_evlog_replay_stop (NULL);
+}
+
+/* sim_evlog_value      record or replay a value derived from host time
+
+   Inputs:
+        tag     =       what the value is
+        value   =       value computed by this run
+   Outputs:
+        value   =       value to use (the recorded one when replaying)
+*/
+
+t_int64 sim_evlog_value (const char *tag, t_int64 value)
+{
+if (sim_evlog_file)
+    fprintf (sim_evlog_file, "V %.0f %s %" LL_FMT "d\n", sim_gtime (), tag, (LL_TYPE)value);
+else {
+    if (sim_evlog_rec) {
+        EVLOG_REC *rec = _sim_evlog_next ('V');
+        double now = sim_gtime ();
+
+        if (rec == NULL)
+            return value;
+        if ((rec->gtime != now) || (strcmp (rec->name, tag) != 0)) {
+            char why[CBUFSIZE];
+
+            snprintf (why, sizeof (why), "%s requested at %.0f, log has %s at %.0f", tag, now, rec->name, rec->gtime);
+            _sim_evlog_replay_stop (why);
+            return value;
+            }
+        rec->done = TRUE;
+        value = rec->value;
+        _sim_evlog_check_done ();
+        }
+    }
+return value;
+}
+
+/* sim_evlog_input      record or replay input from outside the simulator
+
+   Inputs:
+        source  =       name of the input source (no spaces)
+        buf     =       buffer holding the input just read
+        count   =       number of bytes read into buf
+        size    =       size of buf
+   Outputs:
+        count   =       number of bytes to process (replaced by the 
+                        recorded input which is due when replaying)
+*/
+
+int32 sim_evlog_input (const char *source, uint8 *buf, int32 count, int32 size)
+{
+if (sim_evlog_file) {
+    if (count > 0) {
+        int32 i;
+
+        fprintf (sim_evlog_file, "I %.0f %s ", sim_gtime (), source);
+        for (i = 0; i < count; i++)
+            fprintf (sim_evlog_file, "%02X", buf[i]);
+        fprintf (sim_evlog_file, "\n");
+        }
+    }
+else {
+    if (sim_evlog_rec) {
+        double now = sim_gtime ();
+        uint32 i;
+
+        count = 0;
+        for (i = sim_evlog_next[1]; (i < sim_evlog_count) && (count < size); i++) {
+            EVLOG_REC *rec = &sim_evlog_rec[i];
+            int32 n;
+
+            if ((rec->type != 'I') || rec->done)
+                continue;
+            if (rec->gtime > now)                       /* records are in time order */
+                break;
+            if (strcmp (rec->name, source) != 0)
+                continue;
+            n = MIN (rec->size - rec->used, size - count);
+            memcpy (buf + count, rec->data + rec->used, n);
+            count += n;
+            rec->used += n;
+            rec->done = (rec->used == rec->size);
+            }
+        _sim_evlog_check_done ();
+        }
+    }
+return count;
+}
+
+/* sim_evlog_packet     record or replay one packet from outside the simulator
+
+   As sim_evlog_input, except that a replay returns a single recorded 
+   packet per call instead of everything for the source which is due, 
+   so packets recorded at the same time stay separate.
+*/
+
+int32 sim_evlog_packet (const char *source, uint8 *buf, int32 count, int32 size)
+{
+if (sim_evlog_rec) {
+    double now = sim_gtime ();
+    uint32 i;
+
+    for (i = sim_evlog_next[1]; i < sim_evlog_count; i++) {
+        EVLOG_REC *rec = &sim_evlog_rec[i];
+
+        if ((rec->type != 'I') || rec->done)
+            continue;
+        if (rec->gtime > now)                           /* records are in time order */
+            break;
+        if (strcmp (rec->name, source) != 0)
+            continue;
+        count = MIN (rec->size - rec->used, size);
+        memcpy (buf, rec->data + rec->used, count);
+        rec->done = TRUE;
+        _sim_evlog_check_done ();
+        return count;
+        }
+    return 0;
+    }
+return sim_evlog_input (source, buf, count, size);
+}
+
+#if defined (SIM_ASYNCH_IO)
+/* Activate a held completion with its recorded delay */
+
+static t_bool _sim_evlog_release (UNIT *uptr, int32 delay)
+{
+uint32 start = sim_os_msec ();
+
+while (1) {
+    UNIT **pp;
+
+    AIO_LOCK;
+    _sim_evlog_hold ();                                 /* hold whatever has completed */
+    for (pp = &sim_evlog_held; *pp != QUEUE_LIST_END; pp = &((*pp)->a_next))
+        if (*pp == uptr)
+            break;
+    if (*pp == uptr) {
+        *pp = uptr->a_next;
+        uptr->a_next = NULL;
+        AIO_UNLOCK;
+        uptr->a_activate_call (uptr, delay);
+        if (uptr->a_check_completion)
+            uptr->a_check_completion (uptr);
+        return TRUE;
+        }
+    AIO_UNLOCK;
+    if ((sim_os_msec () - start) > EVLOG_WAIT_MS)       /* never going to complete? */
+        return FALSE;
+    sim_os_ms_sleep (1);
+    }
+}
+
+/* Deliver the held completions which are due at this point of the run.
+
+   The queue is checked for completions at the start of event processing,
+   after each event and every few instructions, so the point a completion
+   was recorded at is identified by the simulated time together with the
+   number of events dispatched by then.
+*/
+
+static void _sim_evlog_deliver (void)
+{
+static t_bool delivering = FALSE;
+EVLOG_REC *rec;
+double now = sim_gtime ();
+
+if (delivering)                                         /* activating checks the queue too */
+    return;
+delivering = TRUE;
+while (((rec = _sim_evlog_next ('A')) != NULL) && 
+       ((rec->gtime < now) || ((rec->gtime == now) && (rec->events <= sim_evlog_events)))) {
+    char why[CBUFSIZE];
+
+    if ((rec->gtime < now) || (rec->events < sim_evlog_events))
+        snprintf (why, sizeof (why), "%s completion at %.0f after %u events was missed", sim_uname (rec->uptr), rec->gtime, rec->events);
+    else {
+        if (_sim_evlog_release (rec->uptr, (int32)rec->value)) {
+            rec->done = TRUE;
+            continue;
+            }
+        snprintf (why, sizeof (why), "%s didn't complete as recorded at %.0f", sim_uname (rec->uptr), rec->gtime);
+        }
+    _sim_evlog_replay_stop (why);
+    break;
+    }
+_sim_evlog_schedule ();
+_sim_evlog_check_done ();
+delivering = FALSE;
+}
+#endif
+
+/* Make sure the event queue is looked at when the next completion is due */
+
+static void _sim_evlog_schedule (void)
+{
+EVLOG_REC *rec = _sim_evlog_next ('A');
+double delay;
+
+if (rec == NULL)
+    return;
+delay = rec->gtime - sim_gtime ();
+if (delay > 0.0)
+    sim_activate_abs (&sim_evlog_unit, (delay > 0x7FFFFFFF) ? 0x7FFFFFFF : (int32)delay);
+}
+
+static t_stat sim_evlog_svc (UNIT *uptr)
+{
+#if defined (SIM_ASYNCH_IO)
+_sim_evlog_deliver ();
+#endif
+return SCPE_OK;
+}
+
+/* End a replay, either complete (why == NULL) or diverged */
+
+static void _sim_evlog_replay_stop (const char *why)
+{
+if (sim_evlog_rec == NULL)
+    return;
+if (why)
+    sim_printf ("Event replay of %s diverged: %s\n", sim_evlog_pname, why);
+else
+    sim_messagef (SCPE_OK, "Event replay of %s complete\n", sim_evlog_pname);
+_sim_evlog_replay_free ();
+}
+
+static void _sim_evlog_replay_free (void)
+{
+uint32 i;
+
+for (i = 0; i < sim_evlog_count; i++) {
+    free (sim_evlog_rec[i].name);
+    free (sim_evlog_rec[i].data);
+    }
+free (sim_evlog_rec);
+sim_evlog_rec = NULL;
+sim_evlog_count = 0;
+free (sim_evlog_pname);
+sim_evlog_pname = NULL;
+sim_cancel (&sim_evlog_unit);
+#if defined (SIM_ASYNCH_IO)
+AIO_LOCK;
+while (sim_evlog_held != QUEUE_LIST_END) {              /* let held completions happen now */
+    UNIT *uptr = sim_evlog_held;
+
+    sim_evlog_held = uptr->a_next;
+    uptr->a_next = NULL;
+    AIO_UNLOCK;
+    uptr->a_activate_call (uptr, uptr->a_event_time);
+    if (uptr->a_check_completion)
+        uptr->a_check_completion (uptr);
+    AIO_LOCK;
+    }
+AIO_UNLOCK;
+#endif
+}
+
+static t_stat _sim_evlog_load (const char *filename)
+{
+FILE *f;
+char line[4*CBUFSIZE];
+uint32 alloc = 0, lineno = 0;
+t_stat r = SCPE_OK;
+
+f = sim_fopen (filename, "r");
+if (f == NULL)
+    return sim_messagef (SCPE_OPENERR, "Can't open event log %s: %s\n", filename, strerror (errno));
+while ((r == SCPE_OK) && fgets (line, sizeof (line), f)) {
+    char gbuf[CBUFSIZE], name[CBUFSIZE];
+    const char *cptr;
+    EVLOG_REC *rec;
+    LL_TYPE value;
+
+    ++lineno;
+    sim_trim_endspc (line);
+    if ((line[0] == ';') || (line[0] == '\0'))
+        continue;
+    if (sim_evlog_count == alloc) {
+        alloc = alloc ? 2 * alloc : 1024;
+        sim_evlog_rec = (EVLOG_REC *)realloc (sim_evlog_rec, alloc * sizeof (*sim_evlog_rec));
+        }
+    rec = &sim_evlog_rec[sim_evlog_count];
+    memset (rec, 0, sizeof (*rec));
+    cptr = get_glyph_nc (line, gbuf, 0);                /* type */
+    rec->type = gbuf[0];
+    cptr = get_glyph_nc (cptr, gbuf, 0);                /* time */
+    rec->gtime = strtod (gbuf, NULL);
+    if (rec->type == 'A') {
+        char ebuf[CBUFSIZE];
+
+        cptr = get_glyph_nc (cptr, ebuf, 0);            /* events dispatched */
+        rec->events = (uint32)strtoul (ebuf, NULL, 10);
+        }
+    cptr = get_glyph_nc (cptr, name, 0);                /* unit, source or tag */
+    if ((name[0] == '\0') || (*cptr == '\0') || (gbuf[strspn (gbuf, "0123456789")] != '\0')) {
+        r = sim_messagef (SCPE_FMT, "%s line %u: invalid event record\n", filename, lineno);
+        break;
+        }
+    switch (rec->type) {
+        case 'A':
+            if (find_unit (name, &rec->uptr) == NULL) {
+                r = sim_messagef (SCPE_NXUN, "%s line %u: unknown unit %s\n", filename, lineno, name);
+                break;
+                }
+            rec->value = strtol (cptr, NULL, 10);
+            break;
+        case 'I':
+            rec->size = (int32)(strlen (cptr) / 2);
+            rec->data = (uint8 *)malloc (rec->size);
+            for (rec->used = 0; rec->used < rec->size; rec->used++) {
+                unsigned int byte;
+
+                if (1 != sscanf (cptr + 2 * rec->used, "%2X", &byte))
+                    break;
+                rec->data[rec->used] = (uint8)byte;
+                }
+            if (rec->used != rec->size)
+                r = sim_messagef (SCPE_FMT, "%s line %u: invalid input data\n", filename, lineno);
+            rec->used = 0;
+            rec->name = strdup (name);
+            break;
+        case 'V':
+            if (1 == sscanf (cptr, "%" LL_FMT "d", &value))
+                rec->value = (t_int64)value;
+            else
+                r = sim_messagef (SCPE_FMT, "%s line %u: invalid value\n", filename, lineno);
+            rec->name = strdup (name);
+            break;
+        default:
+            r = sim_messagef (SCPE_FMT, "%s line %u: unknown event record type %c\n", filename, lineno, rec->type);
+            break;
+        }
+    ++sim_evlog_count;
+    }
+fclose (f);
+sim_evlog_pname = strdup (filename);
+sim_evlog_next[0] = sim_evlog_next[1] = sim_evlog_next[2] = 0;
+sim_evlog_events = 0;
+if (r != SCPE_OK)
+    _sim_evlog_replay_free ();
+return r;
+}
+
+/* SET ASYNCH RECORD=file, NORECORD, REPLAY=file and NOREPLAY */
+
+static t_stat sim_set_evlog (CONST char *cptr)
+{
+char gbuf[CBUFSIZE];
+t_stat r;
+
+cptr = get_glyph (cptr, gbuf, '=');
+if ((strcmp (gbuf, "RECORD") == 0) || (strcmp (gbuf, "REPLAY") == 0)) {
+    char fbuf[CBUFSIZE];
+
+    if ((cptr == NULL) || (*cptr == '\0'))
+        return sim_messagef (SCPE_2FARG, "Missing event log file name\n");
+    get_glyph_nc (cptr, fbuf, 0);
+    if (sim_evlog_active ())
+        return sim_messagef (SCPE_ARG, "Already %s events with %s\n", sim_evlog_file ? "recording" : "replaying", sim_evlog_file ? sim_evlog_rname : sim_evlog_pname);
+    if (gbuf[2] == 'C') {                               /* RECORD */
+        sim_evlog_file = sim_fopen (fbuf, "w");
+        if (sim_evlog_file == NULL)
+            return sim_messagef (SCPE_OPENERR, "Can't create event log %s: %s\n", fbuf, strerror (errno));
+        sim_evlog_rname = strdup (fbuf);
+        sim_evlog_events = 0;
+        fprintf (sim_evlog_file, "; %s event log\n", sim_name);
+        return SCPE_OK;
+        }
+    r = _sim_evlog_load (fbuf);                         /* REPLAY */
+    if (r != SCPE_OK)
+        return r;
+    sim_messagef (SCPE_OK, "Replaying %u events from %s\n", sim_evlog_count, fbuf);
+    _sim_evlog_schedule ();
+    _sim_evlog_check_done ();
+    return SCPE_OK;
+    }
+if ((cptr != NULL) && (*cptr != '\0'))
+    return SCPE_2MARG;
+if (strcmp (gbuf, "NORECORD") == 0) {
+    if (sim_evlog_file) {
+        fclose (sim_evlog_file);
+        sim_evlog_file = NULL;
+        free (sim_evlog_rname);
+        sim_evlog_rname = NULL;
+        }
+    return SCPE_OK;
+    }
+if (strcmp (gbuf, "NOREPLAY") == 0) {
+    _sim_evlog_replay_stop ("replay cancelled");
+    return SCPE_OK;
+    }
+return sim_messagef (SCPE_ARG, "Unknown ASYNCH option: %s\n", gbuf);
+}
+
 /* The per-simulator init routine is a weak global that defaults to NULL
    The other per-simulator pointers can be overrriden by the init routine */
 
@@ -594,6 +1121,7 @@ int32 sim_brk_lnt = 0;
 int32 sim_brk_ins = 0;
 int32 sim_quiet = 0;
 int32 sim_step = 0;
+t_bool sim_test_bench = FALSE;      /* unit tests report throughput (-T -B) */
 char *sim_sub_instr = NULL;         /* Copy of pre-substitution buffer contents */
 char *sim_sub_instr_buf = NULL;     /* Buffer address that substitutions were saved in */
 size_t sim_sub_instr_size = 0;      /* substitution buffer size */
@@ -1227,6 +1755,10 @@ static const char simh_help[] =
       "++++++++                     specify console serial port and optionally\n"
       "++++++++                     the port config (i.e. ;9600-8n1)\n"
       "+SET CONSOLE NOSERIAL        disable console serial session\n"
+      "+SET CONSOLE BATCH{=bufsize} buffer console window output and write it\n"
+      "++++++++                     a line at a time, and read input from a\n"
+      "++++++++                     non terminal stdin in batches\n"
+      "+SET CONSOLE NOBATCH         disable console batch mode\n"
        /***************** 80 character line width template *************************/
 #define HLP_SET_REMOTE "*Commands SET REMOTE"
       "3Remote\n"
@@ -1291,6 +1823,11 @@ static const char simh_help[] =
       "5-E\n"
       " The -E switch causes data blob output to also display the data as\n"
       " EBCDIC characters.\n"
+      "5-W\n"
+      " The -W switch causes debug output to be written to the file by a\n"
+      " background thread (see SET LOGGING), so the simulator doesn't wait for\n"
+      " the disk.  Output which the thread hasn't written yet is lost if the\n"
+      " simulator crashes, so by default debug output is written directly.\n"
       "5-B\n"
       " The -B switch causes debug data output to be written to a circular\n"
       " buffer in memory.   This avoids the potential delays for disk I/O to\n"
@@ -1298,6 +1835,36 @@ static const char simh_help[] =
       " The size of the circular memory buffer that is used is specified on\n"
       " the SET DEBUG command line, for example:\n\n"
       "++SET DEBUG -B <sizeinMB> <debug-destination>\n\n"
+#define HLP_SET_LOGGING "*Commands SET Logging"
+       /***************** 80 character line width template *************************/
+      "3Logging\n"
+      " Debug output and multiplexer line logs (including the console log) can\n"
+      " be written through a log stream.  Data written to a log stream is passed\n"
+      " to a background thread which writes it to the file, so the simulator\n"
+      " doesn't wait for the disk.  Log streams can also rotate, compress and\n"
+      " time stamp their files.  The session log (SET LOG) is always written\n"
+      " directly.\n\n"
+      "+SET LOGGING ASYNCHRONOUS    write line logs from a background thread\n"
+      "++++++++                     (default)\n"
+      "+SET LOGGING SYNCHRONOUS     write line logs directly\n"
+      "+SET LOGGING ROTATE=n{K|M|G} rotate files after n bytes have been written\n"
+      "+SET LOGGING INTERVAL=n{S|M|H|D}\n"
+      "++++++++                     rotate files after n seconds, minutes,\n"
+      "++++++++                     hours or days\n"
+      "+SET LOGGING KEEP=n          keep n rotated files (default 5)\n"
+      "+SET LOGGING NOROTATE        disable rotation\n"
+      "+SET LOGGING COMPRESS        gzip log files (.gz is added to the name)\n"
+      "+SET LOGGING NOCOMPRESS      write uncompressed log files\n"
+      "+SET LOGGING TIMESTAMP       prefix each line with the time of day\n"
+      "+SET LOGGING NOTIMESTAMP     don't time stamp lines\n\n"
+      " Several options can be combined, separated by commas.  The settings\n"
+      " apply to log files which are opened after the command.  When a file is\n"
+      " rotated, file.log is renamed to file.log.1, file.log.1 to file.log.2 and\n"
+      " so on, and a new file.log is started.  Compressed files are named\n"
+      " file.log.gz, file.log.1.gz and so on.\n\n"
+      " Debug output is only written from a background thread when SET DEBUG\n"
+      " is given the -W switch.\n\n"
+      " SHOW LOGGING displays the settings and the state of open log streams.\n"
 #define HLP_SET_BREAK  "*Commands SET Breakpoints"
       "3Breakpoints\n"
       "+SET BREAK <list>            set breakpoints\n"
@@ -1312,7 +1879,10 @@ static const char simh_help[] =
       "+SET THROTTLE x%%             occupy x percent of the host capacity\n"
       "++++++++executing instructions\n"
       "+SET THROTTLE x/t            sleep for t milliseconds after executing x\n"
-      "++++++++instructions\n\n"
+      "++++++++instructions\n"
+      "+SET THROTTLE FAIR{=w}{,CPUS=n}{,GROUP=name}\n"
+      "++++++++share the host CPUs fairly with other\n"
+      "++++++++simulators, with weight w (default 100)\n\n"
       "+SET NOTHROTTLE              set simulation rate to maximum\n\n"
       " Throttling is only available on host systems that implement a precision\n"
       " real-time delay function.\n\n"
@@ -1324,6 +1894,18 @@ static const char simh_help[] =
       " The SET NOTHROTTLE command turns off throttling.  The SHOW THROTTLE\n"
       " command shows the current settings for throttling and the calibration\n"
       " results\n\n"
+      " FAIR mode coordinates all the simulators on the host which use it (and\n"
+      " name the same GROUP) through a shared memory scoreboard.  Once a second\n"
+      " each of them divides the host's CPUs (all of them, or n if CPUS=n is\n"
+      " given) among the active simulators in proportion to their weights,\n"
+      " giving the unused part of any simulator's share to those which want\n"
+      " more, and throttles itself to its own share.  Nothing is throttled while\n"
+      " the host has enough CPU for all of them.  SHOW THROTTLE displays the\n"
+      " target and achieved shares, and SHOW -D THROTTLE those of every\n"
+      " simulator in the group.  FAIR mode may be combined with idling.\n\n"
+      " The number of CPUs belongs to the group and is set by the first\n"
+      " simulator to join it.  A simulator joining an active group with a\n"
+      " different CPUS=n is rejected.\n\n"
       " Some simulators implement a different form of host CPU resource management\n"
       " called idling.  Idling suspends simulated execution whenever the program\n"
       " running in the simulator is doing nothing, and runs the simulator at full\n"
@@ -1339,13 +1921,40 @@ static const char simh_help[] =
       "+SET CLOCK catchup           enable catchup clock ticks\n"
       "+SET CLOCK calib=n%%          specify idle calibration skip %%\n"
       "+SET CLOCK calib=ALWAYS      specify calibration independent of idle\n"
-      "+SET CLOCK stop=n            stop execution after n instructions\n\n"
+      "+SET CLOCK stop=n            stop execution after n instructions\n"
+      "+SET CLOCK calibfile=file    learn execution rates in file\n"
+      "+SET CLOCK nocalibfile       stop learning execution rates\n"
+      "+SET CLOCK warp              skip idle time rather than sleep\n"
+      "+SET CLOCK nowarp            sleep while idle\n\n"
       " The SET CLOCK STOP command allows execution to have a bound when\n"
-      " execution starts with a BOOT, NEXT or CONTINUE command.\n"
+      " execution starts with a BOOT, NEXT or CONTINUE command.\n\n"
+      " The SET CLOCK CALIBFILE command loads the execution rates learned by\n"
+      " an earlier run from the file, if it exists, so that clocks start out\n"
+      " calibrated, and saves the rates learned by this run there whenever\n"
+      " execution stops and once a minute while running.\n\n"
+      " The SET CLOCK WARP command makes an idle simulator move time forward to\n"
+      " its next event rather than sleep until it is due.  Simulated clocks and\n"
+      " the time of day the simulated system sees advance as if the idle time\n"
+      " had passed, so work which spends most of its time waiting for timers\n"
+      " runs as fast as the host allows.  Idling must be enabled, clocks must\n"
+      " not be asynchronous, and no time is skipped while I/O is in progress.\n"
 #define HLP_SET_ASYNCH "*Commands SET Asynch"
       "3Asynch\n"
       "+SET ASYNCH                  enable asynchronous I/O\n"
       "+SET NOASYNCH                disable asynchronous I/O\n"
+      "+SET ASYNCH RECORD=file      record asynchronous events to file\n"
+      "+SET ASYNCH NORECORD         stop recording\n"
+      "+SET ASYNCH REPLAY=file      replay asynchronous events from file\n"
+      "+SET ASYNCH NOREPLAY         stop replaying\n\n"
+      " A recording holds, in simulated time, each I/O completion, each piece\n"
+      " of input from mux lines, the console keyboard and LAN interfaces, and\n"
+      " each value derived from host time (clock calibrations, time of day).\n"
+      " Replaying it in a later run started the same way delivers the same\n"
+      " events at the same simulated times, so that run executes exactly the\n"
+      " same instructions.  Idle periods skip straight to the next event while\n"
+      " recording or replaying.  A replay which stops following the log says\n"
+      " where and continues as an ordinary run.  Throttling and asynchronous\n"
+      " clocks are not deterministic and should not be used with either.\n"
 #define HLP_SET_ENVIRON "*Commands SET Environment"
       "3Environment\n"
       "4Explicitily Changing a Variable\n"
@@ -1458,6 +2067,7 @@ static const char simh_help[] =
       "+sh{ow} ve{rsion}            show simulator version\n"
       "+sh{ow} def{ault}            show current directory\n" 
       "+sh{ow} re{mote}             show remote console configuration\n" 
+      "+sh{ow} logging              show log stream policy and open streams\n"
       "+sh{ow} <dev> RADIX          show device display radix\n"
       "+sh{ow} <dev> DEBUG          show device debug flags\n"
       "+sh{ow} <dev> MODIFIERS      show device modifiers\n"
@@ -1490,6 +2100,7 @@ static const char simh_help[] =
 #define HLP_SHOW_REMOTE         "*Commands SHOW"
 #define HLP_SHOW_BREAK          "*Commands SHOW"
 #define HLP_SHOW_LOG            "*Commands SHOW"
+#define HLP_SHOW_LOGGING        "*Commands SHOW"
 #define HLP_SHOW_DEBUG          "*Commands SHOW"
 #define HLP_SHOW_THROTTLE       "*Commands SHOW"
 #define HLP_SHOW_ASYNCH         "*Commands SHOW"
@@ -2382,6 +2993,7 @@ static CTAB set_glob_tab[] = {
     { "NOTELNET",   &sim_set_notelnet,          0 },            /* deprecated */
     { "LOG",        &sim_set_logon,             0, HLP_SET_LOG  },
     { "NOLOG",      &sim_set_logoff,            0, HLP_SET_LOG  },
+    { "LOGGING",    &sim_set_logging,           0, HLP_SET_LOGGING },
     { "DEBUG",      &sim_set_debon,             0, HLP_SET_DEBUG  },
     { "NODEBUG",    &sim_set_deboff,            0, HLP_SET_DEBUG  },
     { "THROTTLE",   &sim_set_throt,             1, HLP_SET_THROTTLE },
@@ -2439,6 +3051,7 @@ static SHTAB show_glob_tab[] = {
     { "REMOTE",         &sim_show_remote_console,   0, HLP_SHOW_REMOTE },
     { "BREAK",          &show_break,                0, HLP_SHOW_BREAK },
     { "LOG",            &sim_show_log,              0, HLP_SHOW_LOG },
+    { "LOGGING",        &sim_show_logging,          0, HLP_SHOW_LOGGING },
     { "TELNET",         &sim_show_telnet,           0 },    /* deprecated */
     { "DEBUG",          &sim_show_debug,            0, HLP_SHOW_DEBUG },
     { "THROTTLE",       &sim_show_throt,            0, HLP_SHOW_THROTTLE },
@@ -2575,6 +3188,7 @@ sim_register_internal_device (&sim_scp_dev);
 sim_register_internal_device (&sim_expect_dev);
 sim_register_internal_device (&sim_step_dev);
 sim_register_internal_device (&sim_flush_dev);
+sim_register_internal_device (&sim_evlog_dev);
 
 if ((stat = sim_ttinit ()) != SCPE_OK) {
     fprintf (stderr, "Fatal terminal initialization error\n%s\n",
@@ -2675,6 +3289,7 @@ if (SCPE_BARE_STATUS(stat) != SCPE_EXIT)
     process_stdin_commands (SCPE_BARE_STATUS(stat), argv);
 
 detach_all (0, TRUE);                                   /* close files */
+sim_set_evlog ("NORECORD");                             /* close event log */
 sim_set_deboff (0, NULL);                               /* close debug */
 sim_set_logoff (0, NULL);                               /* close log */
 sim_set_notelnet (0, NULL);                             /* close Telnet */
@@ -5086,8 +5701,11 @@ return SCPE_OK;
 
 t_stat sim_set_asynch (int32 flag, CONST char *cptr)
 {
-if (cptr && (*cptr != 0))                               /* now eol? */
+if (cptr && (*cptr != 0)) {                             /* now eol? */
+    if (flag)                                           /* SET ASYNCH option? */
+        return sim_set_evlog (cptr);
     return SCPE_2MARG;
+    }
 #ifdef SIM_ASYNCH_IO
 if (flag == sim_asynch_enabled)                         /* already set correctly? */
     return SCPE_OK;
@@ -5140,6 +5758,15 @@ fprintf (st, "Asynchronous Clock is %sabled\n", (sim_asynch_timer) ? "en" : "dis
 #else
 fprintf (st, "Asynchronous I/O is not available in this simulator\n");
 #endif
+if (sim_evlog_file)
+    fprintf (st, "Recording events to %s\n", sim_evlog_rname);
+if (sim_evlog_rec) {
+    uint32 i, done = 0;
+
+    for (i = 0; i < sim_evlog_count; i++)
+        done += sim_evlog_rec[i].done ? 1 : 0;
+    fprintf (st, "Replaying events from %s, %u of %u replayed\n", sim_evlog_pname, done, sim_evlog_count);
+    }
 return SCPE_OK;
 }
 
@@ -8054,6 +8681,7 @@ if (sim_step) {                                         /* set step timer */
         sim_activate (&sim_step_unit, sim_step);        /* instruction based step */
     }
 sim_activate_after (&sim_flush_unit, FLUSH_INTERVAL);   /* Enable periodic buffer flushing */
+_sim_evlog_schedule ();                                 /* next replayed completion */
 stop_cpu = FALSE;
 sim_is_running = TRUE;                                  /* flag running */
 fflush(stdout);                                         /* flush stdout */
@@ -8323,6 +8951,8 @@ for (gptr = gbuf, reason = SCPE_OK;
             return SCPE_ARG;
         if ((lowr = sim_dfdev->registers) == NULL)
             return SCPE_NXREG;
+        if ((flag == EX_E) && (sim_dfdev == &sim_perf_dev))
+            sim_perf_update ();                         /* current counters */
         for (highr = lowr; highr->name != NULL; highr++) ;
         sim_switches = sim_switches | SIM_SW_HIDE;
         reason = exdep_reg_loop (ofile, sim_schrptr, flag, cptr,
@@ -8355,6 +8985,8 @@ for (gptr = gbuf, reason = SCPE_OK;
             }
         if (*tptr && (*tptr++ != ','))
             return SCPE_ARG;
+        if ((flag == EX_E) && (tdptr == &sim_perf_dev))
+            sim_perf_update ();                         /* current counters */
         reason = exdep_reg_loop (ofile, sim_schrptr, flag, cptr,
             lowr, highr, (uint32) low, (uint32) high);
         if ((flag & EX_E) && (!sim_oline) && (sim_log && (ofile == stdout)))
@@ -10822,6 +11454,9 @@ do {
         else
             reason = SCPE_OK;
         }
+    ++sim_perf_events;
+    if (uptr != &sim_evlog_unit)                        /* count for event record/replay */
+        ++sim_evlog_events;
     AIO_EVENT_COMPLETE(uptr, reason);
     bare_reason = SCPE_BARE_STATUS (reason);
     if ((bare_reason != SCPE_OK)     &&  /* Provide context for unexpected errors */
@@ -10904,6 +11539,53 @@ sim_interval = sim_clock_queue->time;
 return SCPE_OK;
 }
 
+/* _sim_activate_list - activate a list of events to occur now
+
+   Inputs:
+        first   =       first unit of a QUEUE_LIST_END terminated list
+                        of inactive units
+        last    =       last unit of that list
+   Outputs:
+        none
+
+   The units are queued, in list order, behind any events which are
+   already due now.  The result is the same as calling _sim_activate
+   (uptr, 0) for each unit, but the event queue is only walked once.
+*/
+
+void _sim_activate_list (UNIT *first, UNIT *last)
+{
+UNIT *cptr, *prvptr;
+int32 accum;
+
+UPDATE_SIM_TIME;                                        /* update sim time */
+
+prvptr = NULL;
+accum = 0;
+for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+    if (0 < (accum + cptr->time))
+        break;
+    accum = accum + cptr->time;
+    prvptr = cptr;
+    }
+for (cptr = first; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+    sim_debug (SIM_DBG_ACTIVATE, &sim_scp_dev, "Activating %s delay=0\n", sim_uname (cptr));
+    cptr->time = 0;
+    }
+if (prvptr == NULL) {                                   /* insert at head */
+    cptr = last->next = sim_clock_queue;
+    sim_clock_queue = first;
+    }
+else {
+    cptr = last->next = prvptr->next;                   /* insert at prvptr */
+    prvptr->next = first;
+    }
+first->time = -accum;
+if (cptr != QUEUE_LIST_END)
+    cptr->time = cptr->time - first->time;
+sim_interval = sim_clock_queue->time;
+}
+
 /* sim_activate_abs - activate (queue) event even if event already scheduled
 
    Inputs:
@@ -14693,9 +15375,10 @@ static t_stat sim_library_unit_tests (void)
 {
 int i;
 DEVICE *dptr;
-int32 saved_switches = sim_switches & ~SWMASK ('T');
+int32 saved_switches = sim_switches & ~(SWMASK ('T') | SWMASK ('B'));
 t_stat stat = SCPE_OK;
 
+sim_test_bench = ((sim_switches & SWMASK ('B')) != 0);  /* -B means something else to some tests */
 if (sim_switches & SWMASK ('D')) {
     sim_switches &= ~(SWMASK ('D') | SWMASK ('R') | SWMASK ('F') | SWMASK ('T'));
     sim_set_debon (0, "STDOUT");
@@ -14717,6 +15400,9 @@ for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
         case DEV_ETHER:
             tstat = sim_ether_test (dptr);
             break;
+        case DEV_MUX:
+            tstat = sim_tmxr_test (dptr);
+            break;
         case DEV_TAPE:
             tstat = sim_tape_test (dptr);
             break;
@@ -14726,5 +15412,8 @@ for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
     if (tstat != SCPE_OK)
         stat = tstat;
     }
+sim_switches = saved_switches;
+if (sim_timer_test () != SCPE_OK)
+    stat = SCPE_IERR;
 return stat;
 }
@@ -129,6 +129,7 @@ t_stat debug_cmd (int32 flag, CONST char *ptr);
 t_stat sim_process_event (void);
 t_stat sim_activate (UNIT *uptr, int32 interval);
 t_stat _sim_activate (UNIT *uptr, int32 interval);
+void _sim_activate_list (UNIT *first, UNIT *last);
 t_stat sim_activate_abs (UNIT *uptr, int32 interval);
 t_stat sim_activate_notbefore (UNIT *uptr, int32 rtime);
 t_stat sim_activate_after (UNIT *uptr, uint32 usecs_walltime);
@@ -362,6 +363,7 @@ extern int32 sim_switches;
 extern int32 sim_switch_number;
 extern int32 sim_quiet;
 extern int32 sim_step;
+extern t_bool sim_test_bench;                           /* unit tests report throughput */
 extern t_stat sim_last_cmd_stat;                        /* Command Status */
 extern FILE *sim_log;                                   /* log file */
 extern FILEREF *sim_log_ref;                            /* log file file reference */
@@ -390,6 +392,11 @@ extern t_addr sim_brk_match_addr;
 extern BRKTYPTAB *sim_brk_type_desc;                      /* type descriptions */
 extern FILE *stdnul;
 extern t_bool sim_asynch_enabled;
+t_bool sim_evlog_active (void);
+t_bool sim_evlog_replaying (void);
+t_int64 sim_evlog_value (const char *tag, t_int64 value);
+int32 sim_evlog_input (const char *source, uint8 *buf, int32 count, int32 size);
+int32 sim_evlog_packet (const char *source, uint8 *buf, int32 count, int32 size);
 #if defined(SIM_ASYNCH_IO)
 int sim_aio_update_queue (void);
 void sim_aio_activate (ACTIVATE_API caller, UNIT *uptr, int32 event_time);
@@ -101,6 +101,11 @@
    sim_set_cons_nolog           set console nolog
    sim_show_cons_buff           show console buffered
    sim_show_cons_log            show console log
+   sim_set_cons_batch           set console batch/nobatch
+   sim_set_logging              set log stream policy
+   sim_show_logging             show log stream policy and open streams
+   sim_open_logstream           open a log file as a log stream
+   sim_show_cons_batch          show console batch
    sim_tt_inpcvt                convert input character per mode
    sim_tt_outcvt                convert output character per mode
    sim_cons_get_send            get console send structure address
@@ -114,8 +119,12 @@
    sim_ttisatty                 called to determine if running interactively
    sim_os_poll_kbd              poll for keyboard input
    sim_os_putchar               output character to console
+   sim_os_read_batch            read a batch of console input
+   sim_os_write_batch           write a batch of console output
    sim_set_noconsole_port       Enable automatic WRU console polling
    sim_set_stable_registers_state Declare that all registers are always stable
+   sim_set_readable_registers_state Declare that the CPU calls sim_rem_con_direct
+   sim_rem_con_direct           answer a remote command at an instruction boundary
 
 
    The first group is OS-independent; the second group is OS-dependent.
@@ -147,6 +156,8 @@
 static t_stat sim_os_poll_kbd (void);
 static t_bool sim_os_poll_kbd_ready (int ms_timeout);
 static t_stat sim_os_putchar (int32 out);
+static int32 sim_os_read_batch (uint8 *buf, int32 size);
+static int32 sim_os_write_batch (const uint8 *buf, int32 len);
 static t_stat sim_os_ttinit (void);
 static t_stat sim_os_ttrun (void);
 static t_stat sim_os_ttcmd (void);
@@ -264,6 +275,18 @@ sim_con_stable_registers = TRUE;
 return SCPE_OK;
 }
 
+static t_bool sim_con_readable_registers = FALSE;
+
+/* Declare that the instruction loop calls sim_rem_con_direct at an instruction
+   boundary whenever sim_rem_con_direct_pending is set, so read-only remote
+   console commands can be answered there without leaving the instruction loop */
+
+t_stat sim_set_readable_registers_state (void)
+{
+sim_con_readable_registers = TRUE;
+return SCPE_OK;
+}
+
 /* Unit service for console connection polling */
 
 static t_stat sim_con_poll_svc (UNIT *uptr)
@@ -317,6 +340,8 @@ static CTAB set_con_tab[] = {
     { "NOLOG",   &sim_set_logoff, 0 },
     { "DEBUG",   &sim_set_debon, 0 },
     { "NODEBUG", &sim_set_deboff, 0 },
+    { "BATCH",   &sim_set_cons_batch, 1 },
+    { "NOBATCH", &sim_set_cons_batch, 0 },
 #define CMD_WANTSTR     0100000
     { "HALT", &sim_set_halt, 1 | CMD_WANTSTR },
     { "NOHALT", &sim_set_halt, 0 },
@@ -350,6 +375,7 @@ static SHTAB show_con_tab[] = {
     { "TELNET", &sim_show_telnet, 0 },
     { "DEBUG", &sim_show_cons_debug, 0 },
     { "BUFFERED", &sim_show_cons_buff, 0 },
+    { "BATCH", &sim_show_cons_batch, 0 },
     { "EXPECT", &sim_show_cons_expect, 0 },
     { "HALT", &sim_show_cons_expect, -1 },
     { "INPUT", &sim_show_cons_send_input, 0 },
@@ -526,6 +552,8 @@ static TMXR sim_rem_con_tmxr = { 0, 0, 0, NULL, NULL, &sim_remote_console };/* r
 static uint32 sim_rem_read_timeout = 30;    /* seconds before automatic continue */
 static int32 sim_rem_active_number = -1;    /* -1 - not active, >= 0 is index of active console */
 int32 sim_rem_cmd_active_line = -1;         /* step in progress on line # */
+t_bool sim_rem_con_direct_pending = FALSE; /* read only command waiting for an instruction boundary */
+static int32 sim_rem_direct_line = -1;     /* line the waiting command came from */
 static CTAB *sim_rem_active_command = NULL; /* active command */
 static char *sim_rem_command_buf;           /* active command buffer */
 static t_bool sim_log_temp = FALSE;         /* temporary log file active */
@@ -534,6 +562,191 @@ static t_bool sim_rem_master_mode = FALSE;  /* Master Mode Enabled Flag */
 static t_bool sim_rem_master_was_enabled = FALSE; /* Master was Enabled */
 static t_bool sim_rem_master_was_connected = FALSE; /* Master Mode has been connected */
 static t_offset sim_rem_cmd_log_start = 0;  /* Log File saved position */
+static uint32 sim_rem_cmds_direct = 0;      /* commands answered while running */
+static uint32 sim_rem_cmds_paused = 0;      /* commands which stopped instruction execution */
+
+/* Remote console I/O thread
+
+   When asynchronous I/O is available a dedicated thread watches the remote
+   console listening socket and all of the session sockets while the
+   simulator runs, and schedules the connection or data service as soon as
+   anything arrives.  The data service then only needs to poll the sessions
+   occasionally, rather than every REM_CON_DATA_POLL_USECS.
+
+   The thread never looks at the remote console line state itself.  The
+   connection and data services publish the set of sockets to watch, under
+   sim_rem_io_lock, each time they run, and the thread only selects on that
+   copy.  A readable socket activates the INT-REMIO wakeup unit, whose
+   service then schedules the connection or data service from the simulator
+   thread, where all of the session I/O is done.
+*/
+
+#define REM_CON_DATA_POLL_USECS 100000      /* session poll interval */
+#define REM_CON_DATA_IDLE_USECS 1000000     /* session poll interval with the I/O thread */
+
+static t_bool sim_rem_io_running = FALSE;   /* I/O thread active */
+
+#if defined(SIM_ASYNCH_IO)
+static pthread_t sim_rem_io_thread;         /* I/O thread id */
+static pthread_mutex_t sim_rem_io_lock = PTHREAD_MUTEX_INITIALIZER;
+static SOCKET sim_rem_io_master = 0;        /* listening socket being watched */
+static SOCKET *sim_rem_io_socks = NULL;     /* session sockets being watched */
+static int32 sim_rem_io_sock_count = 0;     /* number of session sockets */
+static uint32 sim_rem_io_generation = 0;    /* bumped each time the socket set is published */
+static t_bool sim_rem_io_wake_pending = FALSE;/* wakeup issued but not yet serviced */
+static t_bool sim_rem_io_wake_conn = FALSE; /* wakeup is for a pending connection */
+
+static t_stat sim_rem_io_wake_svc (UNIT *uptr);
+
+static const char *sim_rem_io_description (DEVICE *dptr)
+{
+return "Remote Console I/O thread wakeup";
+}
+
+static UNIT sim_rem_io_unit = { UDATA (&sim_rem_io_wake_svc, 0, 0) };
+DEVICE sim_rem_io_dev = {
+    "INT-REMIO", &sim_rem_io_unit, NULL, NULL, 
+    1, 0, 0, 0, 0, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL, 
+    NULL, DEV_NOSAVE, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL,
+    sim_rem_io_description};
+
+/* Publish the sockets the I/O thread should watch.  Called from the
+   simulator thread whenever the remote console services have run, which
+   also acknowledges any outstanding wakeup. */
+
+static void _sim_rem_con_io_watch (void)
+{
+int32 i;
+
+if (!sim_rem_io_running)
+    return;
+pthread_mutex_lock (&sim_rem_io_lock);
+sim_rem_io_socks = (SOCKET *)realloc (sim_rem_io_socks, sizeof (*sim_rem_io_socks) * (sim_rem_con_tmxr.lines + 1));
+sim_rem_io_master = sim_rem_con_tmxr.master;
+sim_rem_io_sock_count = 0;
+for (i = 0; i < sim_rem_con_tmxr.lines; i++)
+    if (sim_rem_con_tmxr.ldsc[i].sock)
+        sim_rem_io_socks[sim_rem_io_sock_count++] = sim_rem_con_tmxr.ldsc[i].sock;
+++sim_rem_io_generation;
+sim_rem_io_wake_pending = FALSE;
+pthread_mutex_unlock (&sim_rem_io_lock);
+}
+
+static void *
+_sim_rem_con_io (void *arg)
+{
+/* Boost Priority for this I/O thread vs the CPU instruction execution 
+   thread so that session input is noticed promptly */
+sim_os_set_thread_priority (PRIORITY_ABOVE_NORMAL);
+
+sim_debug (DBG_ASY, &sim_remote_console, "_sim_rem_con_io() - starting\n");
+
+while (sim_rem_io_running) {
+    fd_set readfds;
+    struct timeval timeout;
+    SOCKET master, maxsock;
+    uint32 generation;
+    t_bool idle, wake = FALSE;
+    int32 i;
+    int status;
+
+    FD_ZERO (&readfds);
+    pthread_mutex_lock (&sim_rem_io_lock);
+    idle = (sim_rem_io_wake_pending ||      /* previous wakeup not yet serviced */
+            (!sim_is_running));             /* or scp is polling the sessions itself? */
+    master = maxsock = sim_rem_io_master;
+    generation = sim_rem_io_generation;
+    if (!idle) {
+        if (master)
+            FD_SET (master, &readfds);
+        for (i = 0; i < sim_rem_io_sock_count; i++) {
+            FD_SET (sim_rem_io_socks[i], &readfds);
+            if (sim_rem_io_socks[i] > maxsock)
+                maxsock = sim_rem_io_socks[i];
+            }
+        }
+    pthread_mutex_unlock (&sim_rem_io_lock);
+    if (idle) {
+        sim_os_ms_sleep (10);
+        continue;
+        }
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 250000;
+    status = select ((int)maxsock + 1, &readfds, NULL, NULL, &timeout);
+    if (status < 0)                         /* socket closed underneath us? */
+        sim_os_ms_sleep (10);
+    if ((status <= 0) || (!sim_rem_io_running) || (!sim_is_running))
+        continue;
+    pthread_mutex_lock (&sim_rem_io_lock);
+    if ((generation == sim_rem_io_generation) &&/* socket set unchanged while waiting? */
+        (!sim_rem_io_wake_pending)) {
+        sim_rem_io_wake_pending = wake = TRUE;
+        sim_rem_io_wake_conn = (master && FD_ISSET (master, &readfds));
+        }
+    pthread_mutex_unlock (&sim_rem_io_lock);
+    if (wake) {
+        sim_debug (DBG_ASY, &sim_remote_console, "_sim_rem_con_io() - %s\n", sim_rem_io_wake_conn ? "connection pending" : "session input available");
+        _sim_activate (&sim_rem_io_unit, 0);
+        }
+    }
+
+sim_debug (DBG_ASY, &sim_remote_console, "_sim_rem_con_io() - exiting\n");
+return NULL;
+}
+
+/* Unit service for I/O thread wakeups, runs in the simulator thread */
+
+static t_stat sim_rem_io_wake_svc (UNIT *uptr)
+{
+t_bool conn;
+
+if (!sim_rem_io_running)
+    return SCPE_OK;
+pthread_mutex_lock (&sim_rem_io_lock);
+conn = sim_rem_io_wake_conn;
+pthread_mutex_unlock (&sim_rem_io_lock);
+return sim_activate_abs (conn ? rem_con_poll_unit : rem_con_data_unit, 0);
+}
+
+static void _sim_rem_con_io_start (void)
+{
+pthread_attr_t attr;
+
+if (sim_rem_io_running || (!sim_asynch_enabled))
+    return;
+sim_register_internal_device (&sim_rem_io_dev);
+sim_rem_io_running = TRUE;
+_sim_rem_con_io_watch ();
+pthread_attr_init (&attr);
+pthread_attr_setscope (&attr, PTHREAD_SCOPE_SYSTEM);
+if (pthread_create (&sim_rem_io_thread, &attr, _sim_rem_con_io, NULL))
+    sim_rem_io_running = FALSE;
+pthread_attr_destroy (&attr);
+}
+
+static void _sim_rem_con_io_stop (void)
+{
+if (!sim_rem_io_running)
+    return;
+sim_rem_io_running = FALSE;
+pthread_join (sim_rem_io_thread, NULL);
+sim_cancel (&sim_rem_io_unit);
+free (sim_rem_io_socks);
+sim_rem_io_socks = NULL;
+sim_rem_io_sock_count = 0;
+}
+#else
+#define _sim_rem_con_io_start()
+#define _sim_rem_con_io_stop()
+#define _sim_rem_con_io_watch()
+#endif
+
+static int32 _sim_rem_data_poll_usecs (void)
+{
+return sim_rem_io_running ? REM_CON_DATA_IDLE_USECS : REM_CON_DATA_POLL_USECS;
+}
 
 static t_stat sim_rem_sample_output (FILE *st, int32 line)
 {
@@ -608,6 +821,10 @@ if (!sim_rem_con_tmxr.master)
 else {
     fprintf (st, "Remote Console Command Input listening on TCP port: %s\n", rem_con_poll_unit->filename);
     fprintf (st, "Remote Console Per Command Output buffer size:      %d bytes\n", sim_rem_con_tmxr.buffered);
+    if (sim_rem_io_running)
+        fprintf (st, "Remote Console sessions are served by an I/O thread\n");
+    fprintf (st, "Remote Console Commands answered while running:     %u\n", sim_rem_cmds_direct);
+    fprintf (st, "Remote Console Commands which paused the simulator: %u\n", sim_rem_cmds_paused);
     }
 for (i=connections=0; i<sim_rem_con_tmxr.lines; i++) {
     rem = &sim_rem_consoles[i];
@@ -661,8 +878,7 @@ t_stat sim_rem_con_poll_svc (UNIT *uptr)
 {
 int32 c;
 
-c = tmxr_poll_conn (&sim_rem_con_tmxr);
-if (c >= 0) {                                           /* poll connect */
+while ((c = tmxr_poll_conn (&sim_rem_con_tmxr)) >= 0) { /* poll connect (all that are waiting) */
     REMOTE *rem = &sim_rem_consoles[c];
     TMLN *lp = rem->lp;
     char wru_name[8];
@@ -688,6 +904,7 @@ if (c >= 0) {                                           /* poll connect */
         rem->single_mode = FALSE;                       /*  start in multi-command mode */
     tmxr_send_buffered_data (lp);                       /* flush buffered data */
     }
+_sim_rem_con_io_watch ();                               /* watch any new sessions */
 sim_activate_after(uptr, 1000000);                      /* check again in 1 second */
 if (sim_con_ldsc.conn)
     tmxr_send_buffered_data (&sim_con_ldsc);            /* try to flush any buffered data */
@@ -847,6 +1064,29 @@ sim_printf ("Enter \"HELP cmd\" for detailed help on a command\r\n");
 return SCPE_OK;
 }
 
+/* Determine if a single mode command can be answered while the simulator is
+   running.  Only commands which just report state qualify, and only when the
+   simulator's instruction loop will run them at an instruction boundary (see
+   sim_rem_con_direct), so instruction execution doesn't have to stop. */
+
+static t_bool _sim_rem_direct_cmd (REMOTE *rem, const char *gbuf)
+{
+CTAB *cmdp;
+
+if ((!sim_is_running) || (!rem->single_mode) ||
+    (!sim_con_readable_registers) || sim_rem_con_direct_pending)
+    return FALSE;
+cmdp = find_ctab (allowed_single_remote_cmds, gbuf);
+return ((cmdp != NULL) &&
+        (((cmdp->action == &exdep_cmd) && (cmdp->arg == EX_E)) ||
+         (cmdp->action == &show_cmd)   ||
+         (cmdp->action == &eval_cmd)   ||
+         (cmdp->action == &echo_cmd)   ||
+         (cmdp->action == &pwd_cmd)    ||
+         (cmdp->action == &dir_cmd)    ||
+         (cmdp->action == &x_help_cmd)));
+}
+
 static t_stat _sim_rem_message (const char *cmd, t_stat stat)
 {
 CTAB *cmdp = NULL;
@@ -907,7 +1147,7 @@ cptr = cbuf;
 cptr = get_glyph (cptr, gbuf, 0);               /* get command glyph */
 sim_rem_active_command = find_cmd (gbuf);       /* find command */
 
-if (!sim_processing_event)
+if ((!sim_processing_event) && (!sim_is_running))
     sim_ttcmd ();                               /* restore console */
 stat = sim_rem_active_command->action (sim_rem_active_command->arg, cptr);/* execute command */
 if (stat != SCPE_OK)
@@ -916,13 +1156,39 @@ sim_last_cmd_stat = SCPE_BARE_STATUS(stat);
 if (sim_vm_post != NULL)                        /* optionally let the simulator know */
     (*sim_vm_post) (TRUE);                      /* something might have changed */
 if (!sim_processing_event) {
-    sim_ttrun ();                               /* set console mode */
+    if (!sim_is_running)
+        sim_ttrun ();                           /* set console mode */
     sim_cancel (rem_con_data_unit);             /* force immediate activation of sim_rem_con_data_svc */
     sim_activate (rem_con_data_unit, -1);
     }
 sim_switches = saved_switches;                  /* restore original switches */
 }
 
+/* Answer the read only command which the data service left for the next
+   instruction boundary.  Simulators which declare readable registers call
+   this from their instruction loop whenever sim_rem_con_direct_pending is set. */
+
+void sim_rem_con_direct (void)
+{
+REMOTE *rem;
+int32 saved_switches = sim_switches;
+
+if (!sim_rem_con_direct_pending)
+    return;
+sim_rem_con_direct_pending = FALSE;
+rem = &sim_rem_consoles[sim_rem_direct_line];
+sim_debug (DBG_CMD, &sim_remote_console, "Processing Read Only Command while running\n");
+sim_rem_active_number = rem->line;
+sim_oline = rem->lp;                            /* specify output socket */
+sim_switches = 0;
+sim_remote_process_command ();
+sim_switches = saved_switches;
+sim_rem_active_number = -1;
+++sim_rem_cmds_direct;
+_sim_rem_log_out (rem->lp);
+tmxr_send_buffered_data (rem->lp);              /* nothing else flushes it while running */
+}
+
 /* Clear pending actions */
 
 static char *sim_rem_clract (int32 line)
@@ -1367,10 +1633,14 @@ CONST char *cptr;
 CTAB *cmdp = NULL;
 CTAB *basecmdp = NULL;
 uint32 read_start_time = 0;
+t_bool direct;
 
+_sim_rem_con_io_watch ();                              /* acknowledge any I/O thread wakeup */
+if (!sim_is_running)
+    sim_rem_con_direct ();                             /* answer any command left when instructions stopped */
 tmxr_poll_rx (&sim_rem_con_tmxr);                      /* poll input */
 for (i=(was_active_command ? sim_rem_cmd_active_line : 0); 
-     (i < sim_rem_con_tmxr.lines) && (!active_command); 
+     (i < sim_rem_con_tmxr.lines) && (!active_command) && (!sim_rem_con_direct_pending); 
      i++) {
     REMOTE *rem = &sim_rem_consoles[i];
     t_bool master_session = (sim_rem_master_mode && (i == 0));
@@ -1654,7 +1924,8 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
         cptr = get_glyph (cptr, gbuf, 0);               /* get command glyph */
         sim_switches = 0;                               /* init switches */
         sim_rem_active_number = i;
-        if (!sim_log) {                                 /* Not currently logging? */
+        direct = _sim_rem_direct_cmd (rem, gbuf);       /* answer without stopping? */
+        if ((!sim_log) && (!direct)) {                  /* Not currently logging? */
             int32 save_quiet = sim_quiet;
 
             sim_quiet = 1;
@@ -1663,7 +1934,8 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
             sim_quiet = save_quiet;
             sim_log_temp = TRUE;
             }
-        sim_rem_cmd_log_start = sim_ftell (sim_log);
+        if (sim_log)
+            sim_rem_cmd_log_start = sim_ftell (sim_log);
         basecmdp = find_cmd (gbuf);                     /* validate basic command */
         if (basecmdp == NULL)
             basecmdp = find_ctab (remote_only_cmds, gbuf);/* validate basic command */
@@ -1754,8 +2026,17 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
                                                 stat = SCPE_OK;         /* any message has already been emitted */
                                                 }
                                             else {
-                                                sim_debug (DBG_CMD, &sim_remote_console, "Processing Command via SCPE_REMOTE\n");
-                                                stat = SCPE_REMOTE;     /* force processing outside of sim_instr() */
+                                                if (direct) {
+                                                    sim_debug (DBG_CMD, &sim_remote_console, "Deferring Read Only Command to an instruction boundary\n");
+                                                    sim_rem_direct_line = i;
+                                                    sim_rem_con_direct_pending = TRUE;
+                                                    stat = SCPE_OK;     /* answered by sim_rem_con_direct */
+                                                    }
+                                                else {
+                                                    sim_debug (DBG_CMD, &sim_remote_console, "Processing Command via SCPE_REMOTE\n");
+                                                    ++sim_rem_cmds_paused;
+                                                    stat = SCPE_REMOTE; /* force processing outside of sim_instr() */
+                                                    }
                                                 }
                                             }
                                         }
@@ -1771,6 +2052,8 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
         sim_rem_active_number = -1;
         if ((stat != SCPE_OK) && (stat != SCPE_REMOTE))
             stat = _sim_rem_message (gbuf, stat);
+        if (sim_rem_con_direct_pending)             /* output comes when the command runs */
+            break;
         _sim_rem_log_out (lp);
         if (master_session && !sim_rem_master_mode) {
             rem->single_mode = TRUE;
@@ -1831,6 +2114,7 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
         rem->single_mode = FALSE;
         }
     }
+_sim_rem_con_io_watch ();                                   /* stop watching closed sessions */
 if (sim_rem_master_was_connected &&                         /* Master mode ever connected? */
     !sim_rem_con_tmxr.ldsc[0].sock)                         /* Master Connection lost? */
     return sim_messagef (SCPE_EXIT, "Master Session Disconnect");/* simulator has been 'unplugged' */
@@ -1841,7 +2125,7 @@ if (sim_rem_cmd_active_line != -1) {
         return SCPE_REMOTE;                                 /* force sim_instr() to exit to process command */
     }
 else
-    sim_activate_after(uptr, 100000);                       /* check again in 100 milliaeconds */
+    sim_activate_after(uptr, _sim_rem_data_poll_usecs ());  /* check again later */
 if (sim_rem_master_was_enabled && !sim_rem_master_mode) {   /* Transitioning out of master mode? */
     lp = &sim_rem_con_tmxr.ldsc[0];
     tmxr_linemsgf (lp, "Non Master Mode Session...");       /* report transition */
@@ -1870,7 +2154,7 @@ if (sim_rem_con_tmxr.lines) {
             sim_activate (&rem_con_smp_smpl_units[rem->line], rem->smp_sample_interval);    /* schedule */
         }
     if (i != sim_rem_con_tmxr.lines)
-        sim_activate_after (rem_con_data_unit, 100000);     /* continue polling for open sessions */
+        sim_activate_after (rem_con_data_unit, _sim_rem_data_poll_usecs ());/* continue polling for open sessions */
     return sim_rem_con_poll_svc (rem_con_poll_unit);        /* establish polling for new sessions */
     }
 return SCPE_OK;
@@ -1888,10 +2172,13 @@ if (flag) {
         if (sim_rem_con_tmxr.lines == 0)                    /* Ir no connection limit set */
             sim_set_rem_connections (0, "1");               /* use 1 */
         sim_rem_con_tmxr.buffered = 8192;                   /* Use big enough buffers */
+        sim_rem_con_tmxr.backlog = TMXR_DEFAULT_BACKLOG;    /* accept bursts of connections together */
         sim_register_internal_device (&sim_remote_console);
         r = tmxr_attach (&sim_rem_con_tmxr, rem_con_poll_unit, cptr);/* open master socket */
-        if (r == SCPE_OK)
+        if (r == SCPE_OK) {
             sim_activate_after(rem_con_poll_unit, 1000000);/* check for connection in 1 second */
+            _sim_rem_con_io_start ();                   /* watch sockets while running */
+            }
         return r;
         }
     return SCPE_NOPARAM;
@@ -1900,6 +2187,8 @@ else {
     if (sim_rem_con_tmxr.master) {
         int32 i;
 
+        _sim_rem_con_io_stop ();
+        sim_rem_con_direct_pending = FALSE;
         tmxr_detach (&sim_rem_con_tmxr, rem_con_poll_unit);
         for (i=0; i<sim_rem_con_tmxr.lines; i++) {
             REMOTE *rem = &sim_rem_consoles[i];
@@ -2260,6 +2549,8 @@ return old_deb_switches;
 
 /* Set debug routine */
 
+static t_stat _sim_open_logstream (const char *filename, t_bool binary, t_bool async, FILE **pf, FILEREF **pref);
+
 t_stat sim_set_debon (int32 flag, CONST char *cptr)
 {
 char gbuf[CBUFSIZE];
@@ -2278,7 +2569,7 @@ if (sim_switches & SWMASK ('B')) {
 cptr = get_glyph_nc (cptr, gbuf, 0);                    /* get file name */
 if (*cptr != 0)                                         /* now eol? */
     return SCPE_2MARG;
-r = sim_open_logfile (gbuf, FALSE, &sim_deb, &sim_deb_ref);
+r = _sim_open_logstream (gbuf, FALSE, (sim_switches & SWMASK ('W')) != 0, &sim_deb, &sim_deb_ref);
 
 if (r != SCPE_OK)
     return r;
@@ -2728,6 +3019,640 @@ if (!ref)
 return ref->name;
 }
 
+/* Log streams
+
+   Multiplexer line logs (which include SET CONSOLE LOG) and debug
+   output may be written through a log stream rather than directly to
+   a file.  A log stream is a stdio FILE whose data is handed to a
+   writer thread, so the simulation thread only copies output into a
+   buffer and never waits for the disk.  The stream also implements
+   size and time based rotation of the file, gzip compression and
+   time stamping of each output line.
+
+   The session log (SET LOG) is always a plain file since the remote
+   console reads command output back from it.
+
+   The policy established with SET LOGGING applies to log files opened
+   after the command is entered.  With the default policy (asynchronous
+   writes only) a plain file is used when threads aren't available.
+
+   Debug output is written synchronously unless SET DEBUG -W asks for
+   the writer thread, since the output buffered by the writer would be
+   lost if the simulator crashes, which is when it matters most.
+*/
+
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+#define SIM_LOGSTREAM   1                           /* fopencookie available */
+#endif
+
+#define LOGSTREAM_BUFSIZE   65536                   /* initial hand-off buffer size */
+#define LOGSTREAM_MAXBUF    (4*1024*1024)           /* data pending before the writer is waited on */
+#define LOGSTREAM_DEF_KEEP  5                       /* default rotated files kept */
+
+static t_bool sim_logstream_async = TRUE;           /* write from a background thread */
+static t_bool sim_logstream_compress = FALSE;       /* gzip output */
+static t_bool sim_logstream_stamp = FALSE;          /* time stamp each line */
+static t_uint64 sim_logstream_rotate_size = 0;      /* rotate after bytes (0 = never) */
+static uint32 sim_logstream_rotate_secs = 0;        /* rotate after seconds (0 = never) */
+static uint32 sim_logstream_keep = LOGSTREAM_DEF_KEEP;/* rotated files kept */
+
+#if defined(SIM_LOGSTREAM)
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+typedef struct LOGSTREAM LOGSTREAM;
+struct LOGSTREAM {
+    char                path[CBUFSIZE];             /* file being written */
+    FILE                *fp;                        /* stream handed to callers */
+    FILE                *out;                       /* plain output file */
+#if defined(HAVE_ZLIB)
+    gzFile              gz;                         /* compressed output file */
+#endif
+    t_bool              compress;                   /* gzip output */
+    t_bool              stamp;                      /* time stamp lines */
+    t_bool              bol;                        /* next data starts a line */
+    t_bool              async;                      /* writer thread running */
+    t_uint64            rotate_size;                /* rotate after bytes */
+    uint32              rotate_secs;                /* rotate after seconds */
+    uint32              keep;                       /* rotated files kept */
+    time_t              opened;                     /* current file started */
+    t_uint64            file_bytes;                 /* bytes in current file */
+    char                *buf;                       /* data pending for the writer */
+    size_t              buf_used;
+    size_t              buf_size;
+    t_uint64            bytes;                      /* total bytes written */
+    uint32              batches;                    /* writes done by the writer */
+    uint32              stalls;                     /* producer waited for the writer */
+    uint32              rotations;                  /* files rotated */
+    uint32              errors;                     /* write errors */
+#if defined(SIM_ASYNCH_IO)
+    t_bool              closing;                    /* writer should drain and exit */
+    pthread_t           writer;
+    pthread_mutex_t     lock;
+    pthread_cond_t      work;                       /* data pending or closing */
+    pthread_cond_t      room;                       /* writer took the pending data */
+#endif
+    LOGSTREAM           *next;
+    };
+
+static LOGSTREAM *sim_logstreams = NULL;            /* open log streams */
+
+static t_bool _logstream_open_output (LOGSTREAM *ls, const char *mode)
+{
+#if defined(HAVE_ZLIB)
+if (ls->compress) {
+    ls->gz = gzopen (ls->path, mode);
+    return (ls->gz != NULL);
+    }
+#endif
+ls->out = sim_fopen (ls->path, mode);
+return (ls->out != NULL);
+}
+
+static void _logstream_close_output (LOGSTREAM *ls)
+{
+#if defined(HAVE_ZLIB)
+if (ls->gz)
+    gzclose (ls->gz);
+ls->gz = NULL;
+#endif
+if (ls->out)
+    fclose (ls->out);
+ls->out = NULL;
+}
+
+static void _logstream_flush_output (LOGSTREAM *ls)
+{
+#if defined(HAVE_ZLIB)
+if (ls->gz)
+    gzflush (ls->gz, Z_SYNC_FLUSH);             /* readable up to here */
+#endif
+if (ls->out)
+    fflush (ls->out);
+}
+
+static void _logstream_put (LOGSTREAM *ls, const char *data, size_t len)
+{
+size_t written = 0;
+
+if (len == 0)
+    return;
+#if defined(HAVE_ZLIB)
+if (ls->gz)
+    written = (size_t)gzwrite (ls->gz, data, (unsigned int)len);
+#endif
+if (ls->out)
+    written = fwrite (data, 1, len, ls->out);
+if (written != len)
+    ++ls->errors;
+ls->bytes += written;
+ls->file_bytes += written;
+}
+
+/* Name of rotated generation n of the file: name.n or, for a compressed
+   file, the name with .n inserted before the .gz suffix */
+
+static void _logstream_generation (LOGSTREAM *ls, uint32 n, char *name, size_t size)
+{
+size_t len = strlen (ls->path);
+
+if (n == 0)
+    strlcpy (name, ls->path, size);
+else {
+    if (ls->compress && (len > 3) && (0 == strcmp (ls->path + len - 3, ".gz")))
+        snprintf (name, size, "%.*s.%u.gz", (int)(len - 3), ls->path, (unsigned int)n);
+    else
+        snprintf (name, size, "%s.%u", ls->path, (unsigned int)n);
+    }
+}
+
+static void _logstream_rotate (LOGSTREAM *ls)
+{
+char from[2*CBUFSIZE], to[2*CBUFSIZE];
+uint32 n;
+
+_logstream_close_output (ls);
+for (n = ls->keep; n > 0; n--) {                    /* shift older generations up */
+    _logstream_generation (ls, n - 1, from, sizeof (from));
+    _logstream_generation (ls, n, to, sizeof (to));
+    rename (from, to);                              /* missing generations are ok */
+    }
+if (!_logstream_open_output (ls, "wb"))
+    ++ls->errors;
+ls->opened = time (NULL);
+ls->file_bytes = 0;
+++ls->rotations;
+}
+
+static void _logstream_check_rotate (LOGSTREAM *ls)
+{
+if (ls->file_bytes == 0)                            /* never rotate to an empty file */
+    return;
+if (((ls->rotate_size != 0) && (ls->file_bytes >= ls->rotate_size)) ||
+    ((ls->rotate_secs != 0) && ((time (NULL) - ls->opened) >= (time_t)ls->rotate_secs)))
+    _logstream_rotate (ls);
+}
+
+#if defined(SIM_ASYNCH_IO)
+static void *_logstream_writer (void *arg)
+{
+LOGSTREAM *ls = (LOGSTREAM *)arg;
+char *data = NULL, *swap;
+size_t data_size = 0, len;
+
+pthread_mutex_lock (&ls->lock);
+while (1) {
+    if (ls->buf_used == 0) {
+        if (ls->closing)
+            break;
+        if (ls->rotate_secs) {                      /* wake up to rotate idle files */
+            struct timespec deadline;
+
+            clock_gettime (CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += 1;
+            pthread_cond_timedwait (&ls->work, &ls->lock, &deadline);
+            }
+        else
+            pthread_cond_wait (&ls->work, &ls->lock);
+        if (ls->buf_used == 0) {
+            pthread_mutex_unlock (&ls->lock);
+            _logstream_check_rotate (ls);
+            pthread_mutex_lock (&ls->lock);
+            continue;
+            }
+        }
+    swap = ls->buf;                                 /* take the pending data */
+    ls->buf = data;
+    data = swap;
+    len = ls->buf_size;
+    ls->buf_size = data_size;
+    data_size = len;
+    len = ls->buf_used;
+    ls->buf_used = 0;
+    pthread_cond_broadcast (&ls->room);
+    pthread_mutex_unlock (&ls->lock);
+    _logstream_put (ls, data, len);
+    _logstream_flush_output (ls);
+    ++ls->batches;
+    _logstream_check_rotate (ls);
+    pthread_mutex_lock (&ls->lock);
+    }
+pthread_mutex_unlock (&ls->lock);
+free (data);
+return NULL;
+}
+
+/* Drain any pending data and stop the writer thread; later output
+   is written synchronously */
+
+static void _logstream_stop (LOGSTREAM *ls)
+{
+if (!ls->async)
+    return;
+pthread_mutex_lock (&ls->lock);
+ls->closing = TRUE;
+pthread_cond_signal (&ls->work);
+pthread_mutex_unlock (&ls->lock);
+pthread_join (ls->writer, NULL);
+pthread_cond_destroy (&ls->room);
+pthread_cond_destroy (&ls->work);
+pthread_mutex_destroy (&ls->lock);
+ls->async = FALSE;
+}
+#else
+#define _logstream_stop(ls)
+#endif
+
+static void _logstream_queue (LOGSTREAM *ls, const char *data, size_t len)
+{
+#if defined(SIM_ASYNCH_IO)
+if (ls->async) {
+    pthread_mutex_lock (&ls->lock);
+    while (ls->buf_used + len > ls->buf_size) {
+        size_t need = ls->buf_used + len;
+        size_t size = (ls->buf_size == 0) ? LOGSTREAM_BUFSIZE : 2 * ls->buf_size;
+        char *newbuf;
+
+        if ((need > LOGSTREAM_MAXBUF) && (ls->buf_used != 0)) {
+            ++ls->stalls;                           /* writer is behind, wait for it */
+            pthread_cond_signal (&ls->work);
+            pthread_cond_wait (&ls->room, &ls->lock);
+            continue;
+            }
+        if (size > LOGSTREAM_MAXBUF)
+            size = LOGSTREAM_MAXBUF;
+        if (size < need)
+            size = need;
+        newbuf = (char *)realloc (ls->buf, size);
+        if (newbuf == NULL) {
+            ++ls->errors;
+            pthread_mutex_unlock (&ls->lock);
+            return;
+            }
+        ls->buf = newbuf;
+        ls->buf_size = size;
+        }
+    memcpy (ls->buf + ls->buf_used, data, len);
+    ls->buf_used += len;
+    pthread_cond_signal (&ls->work);
+    pthread_mutex_unlock (&ls->lock);
+    return;
+    }
+#endif
+_logstream_put (ls, data, len);
+}
+
+static size_t _logstream_timestamp (char *buf, size_t size)
+{
+struct timespec now;
+struct tm tm;
+
+clock_gettime (CLOCK_REALTIME, &now);
+localtime_r (&now.tv_sec, &tm);
+return (size_t)snprintf (buf, size, "[%04d-%02d-%02d %02d:%02d:%02d.%03d] ",
+                         tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                         tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(now.tv_nsec / 1000000));
+}
+
+static ssize_t _logstream_cookie_write (void *cookie, const char *data, size_t size)
+{
+LOGSTREAM *ls = (LOGSTREAM *)cookie;
+const char *next = data;
+size_t left = size;
+char stamp[64];
+
+while (left > 0) {
+    const char *eol = ls->stamp ? (const char *)memchr (next, '\n', left) : NULL;
+    size_t len = eol ? (size_t)(eol + 1 - next) : left;
+
+    if (ls->stamp && ls->bol)
+        _logstream_queue (ls, stamp, _logstream_timestamp (stamp, sizeof (stamp)));
+    _logstream_queue (ls, next, len);
+    ls->bol = (next[len - 1] == '\n');
+    next += len;
+    left -= len;
+    }
+if (!ls->async) {
+    _logstream_flush_output (ls);
+    _logstream_check_rotate (ls);
+    }
+return (ssize_t)size;
+}
+
+static int _logstream_cookie_close (void *cookie)
+{
+LOGSTREAM *ls = (LOGSTREAM *)cookie;
+LOGSTREAM **lsp;
+
+_logstream_stop (ls);
+_logstream_close_output (ls);
+for (lsp = &sim_logstreams; *lsp; lsp = &(*lsp)->next)
+    if (*lsp == ls) {
+        *lsp = ls->next;
+        break;
+        }
+free (ls->buf);
+free (ls);
+return 0;
+}
+
+/* Streams still open when the process exits are drained here, since
+   the final stdio flush happens after the writer threads are gone */
+
+static void _logstream_atexit (void)
+{
+LOGSTREAM *ls;
+
+for (ls = sim_logstreams; ls; ls = ls->next) {
+    fflush (ls->fp);
+    _logstream_stop (ls);
+    _logstream_flush_output (ls);
+    }
+}
+#endif /* SIM_LOGSTREAM */
+
+/* Open a log file as a log stream according to the SET LOGGING policy.
+   The special destinations (LOG, DEBUG, STDOUT and STDERR) and hosts
+   without log stream support use sim_open_logfile.  The stream is
+   closed with sim_close_logfile. */
+
+t_stat sim_open_logstream (const char *filename, t_bool binary, FILE **pf, FILEREF **pref)
+{
+return _sim_open_logstream (filename, binary, sim_logstream_async, pf, pref);
+}
+
+/* Open a log stream, with the writer thread only if async is requested */
+
+static t_stat _sim_open_logstream (const char *filename, t_bool binary, t_bool async, FILE **pf, FILEREF **pref)
+{
+#if defined(SIM_LOGSTREAM)
+char gbuf[CBUFSIZE];
+const char *tptr;
+LOGSTREAM *ls;
+size_t len;
+static t_bool atexit_done = FALSE;
+static cookie_io_functions_t logstream_io = {
+    NULL, _logstream_cookie_write, NULL, _logstream_cookie_close };
+
+#if !defined(SIM_ASYNCH_IO)
+async = FALSE;
+#endif
+if ((filename == NULL) || (*filename == 0))             /* too few arguments? */
+    return SCPE_2FARG;
+tptr = get_glyph (filename, gbuf, 0);
+if (*tptr != 0)                                         /* now eol? */
+    return SCPE_2MARG;
+if ((!async) && (!sim_logstream_compress) && (!sim_logstream_stamp) &&
+    (sim_logstream_rotate_size == 0) && (sim_logstream_rotate_secs == 0))
+    return sim_open_logfile (filename, binary, pf, pref);/* nothing for a stream to do */
+if ((strcmp (gbuf, "LOG") == 0) || (strcmp (gbuf, "DEBUG") == 0) ||
+    (strcmp (gbuf, "STDOUT") == 0) || (strcmp (gbuf, "STDERR") == 0))
+    return sim_open_logfile (filename, binary, pf, pref);
+sim_close_logfile (pref);
+*pf = NULL;
+*pref = (FILEREF *)calloc (1, sizeof(**pref));
+ls = (LOGSTREAM *)calloc (1, sizeof (*ls));
+if ((*pref == NULL) || (ls == NULL)) {
+    free (*pref);
+    free (ls);
+    *pref = NULL;
+    return SCPE_MEM;
+    }
+get_glyph_nc (filename, gbuf, 0);                       /* reparse */
+strlcpy (ls->path, gbuf, sizeof (ls->path));
+ls->compress = sim_logstream_compress;
+len = strlen (ls->path);
+if (ls->compress && ((len < 3) || strcmp (ls->path + len - 3, ".gz")))
+    strlcat (ls->path, ".gz", sizeof (ls->path));
+ls->stamp = sim_logstream_stamp;
+ls->bol = TRUE;
+ls->rotate_size = sim_logstream_rotate_size;
+ls->rotate_secs = sim_logstream_rotate_secs;
+ls->keep = sim_logstream_keep;
+ls->opened = time (NULL);
+if (sim_switches & SWMASK ('N'))                        /* if a new log file is requested */
+    ls->file_bytes = 0;
+else                                                    /* otherwise append */
+    ls->file_bytes = (t_uint64)sim_fsize_name_ex (ls->path);
+if (!_logstream_open_output (ls, (sim_switches & SWMASK ('N')) ? "wb" : "ab")) {
+    free (*pref);
+    free (ls);
+    *pref = NULL;
+    return SCPE_OPENERR;
+    }
+ls->fp = fopencookie (ls, "w", logstream_io);
+if (ls->fp == NULL) {
+    _logstream_close_output (ls);
+    free (*pref);
+    free (ls);
+    *pref = NULL;
+    return SCPE_OPENERR;
+    }
+setvbuf (ls->fp, NULL, ls->stamp ? _IOLBF : _IOFBF, LOGSTREAM_BUFSIZE);
+#if defined(SIM_ASYNCH_IO)
+if (async) {
+    pthread_mutex_init (&ls->lock, NULL);
+    pthread_cond_init (&ls->work, NULL);
+    pthread_cond_init (&ls->room, NULL);
+    ls->async = (0 == pthread_create (&ls->writer, NULL, _logstream_writer, ls));
+    if (!ls->async) {                                   /* no thread, write synchronously */
+        pthread_cond_destroy (&ls->room);
+        pthread_cond_destroy (&ls->work);
+        pthread_mutex_destroy (&ls->lock);
+        }
+    }
+#endif
+ls->next = sim_logstreams;
+sim_logstreams = ls;
+if (!atexit_done) {
+    atexit (_logstream_atexit);
+    atexit_done = TRUE;
+    }
+strlcpy ((*pref)->name, ls->path, sizeof((*pref)->name));
+(*pref)->file = *pf = ls->fp;
+(*pref)->refcount = 1;                                  /* need close */
+return SCPE_OK;
+#else
+return sim_open_logfile (filename, binary, pf, pref);
+#endif
+}
+
+/* SET LOGGING command */
+
+#define LOGGING_ASYNC       1
+#define LOGGING_SYNC        2
+#define LOGGING_ROTATE      3
+#define LOGGING_NOROTATE    4
+#define LOGGING_INTERVAL    5
+#define LOGGING_KEEP        6
+#define LOGGING_COMPRESS    7
+#define LOGGING_NOCOMPRESS  8
+#define LOGGING_STAMP       9
+#define LOGGING_NOSTAMP     10
+
+static t_stat _sim_set_logging_opt (int32 flag, CONST char *cptr);
+
+static CTAB set_logging_tab[] = {
+    { "ASYNCHRONOUS",   &_sim_set_logging_opt, LOGGING_ASYNC },
+    { "SYNCHRONOUS",    &_sim_set_logging_opt, LOGGING_SYNC },
+    { "ROTATE",         &_sim_set_logging_opt, LOGGING_ROTATE },
+    { "NOROTATE",       &_sim_set_logging_opt, LOGGING_NOROTATE },
+    { "INTERVAL",       &_sim_set_logging_opt, LOGGING_INTERVAL },
+    { "KEEP",           &_sim_set_logging_opt, LOGGING_KEEP },
+    { "COMPRESS",       &_sim_set_logging_opt, LOGGING_COMPRESS },
+    { "NOCOMPRESS",     &_sim_set_logging_opt, LOGGING_NOCOMPRESS },
+    { "TIMESTAMP",      &_sim_set_logging_opt, LOGGING_STAMP },
+    { "NOTIMESTAMP",    &_sim_set_logging_opt, LOGGING_NOSTAMP },
+    { NULL, NULL, 0 }
+    };
+
+/* Parse a count with an optional scale suffix */
+
+static t_stat _sim_logging_value (CONST char *cptr, const char *suffixes, const uint32 *scales, t_uint64 *val)
+{
+char *tptr;
+const char *sp;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_MISVAL;
+*val = (t_uint64)strtoul (cptr, &tptr, 10);
+if (tptr == cptr)
+    return SCPE_ARG;
+if (*tptr != 0) {
+    if ((tptr[1] != 0) || (NULL == (sp = strchr (suffixes, sim_toupper (*tptr)))))
+        return SCPE_ARG;
+    *val *= scales[sp - suffixes];
+    }
+return SCPE_OK;
+}
+
+static t_stat _sim_set_logging_opt (int32 flag, CONST char *cptr)
+{
+static const uint32 size_scales[] = {1024, 1024*1024, 1024*1024*1024};
+static const uint32 time_scales[] = {1, 60, 60*60, 24*60*60};
+t_uint64 val;
+t_stat r;
+
+if ((cptr != NULL) && (flag != LOGGING_ROTATE) && (flag != LOGGING_INTERVAL) && (flag != LOGGING_KEEP))
+    return SCPE_ARG;
+switch (flag) {
+    case LOGGING_ASYNC:
+#if !defined(SIM_ASYNCH_IO)
+        return sim_messagef (SCPE_NOFNC, "Asynchronous logging requires threads\n");
+#endif
+    case LOGGING_SYNC:
+        sim_logstream_async = (flag == LOGGING_ASYNC);
+        break;
+    case LOGGING_ROTATE:
+        r = _sim_logging_value (cptr, "KMG", size_scales, &val);
+        if (r != SCPE_OK)
+            return sim_messagef (r, "Invalid rotation size: %s\n", cptr ? cptr : "");
+        sim_logstream_rotate_size = val;
+        break;
+    case LOGGING_NOROTATE:
+        sim_logstream_rotate_size = 0;
+        sim_logstream_rotate_secs = 0;
+        break;
+    case LOGGING_INTERVAL:
+        r = _sim_logging_value (cptr, "SMHD", time_scales, &val);
+        if ((r != SCPE_OK) || (val > 0xFFFFFFFF))
+            return sim_messagef (SCPE_ARG, "Invalid rotation interval: %s\n", cptr ? cptr : "");
+        sim_logstream_rotate_secs = (uint32)val;
+        break;
+    case LOGGING_KEEP:
+        r = _sim_logging_value (cptr, "", NULL, &val);
+        if ((r != SCPE_OK) || (val > 999))
+            return sim_messagef (SCPE_ARG, "Invalid number of rotated files: %s\n", cptr ? cptr : "");
+        sim_logstream_keep = (uint32)val;
+        break;
+    case LOGGING_COMPRESS:
+#if !defined(HAVE_ZLIB)
+        return sim_messagef (SCPE_NOFNC, "Compressed logging requires zlib\n");
+#endif
+    case LOGGING_NOCOMPRESS:
+        sim_logstream_compress = (flag == LOGGING_COMPRESS);
+        break;
+    case LOGGING_STAMP:
+    case LOGGING_NOSTAMP:
+        sim_logstream_stamp = (flag == LOGGING_STAMP);
+        break;
+    default:
+        return SCPE_IERR;
+    }
+return SCPE_OK;
+}
+
+t_stat sim_set_logging (int32 flag, CONST char *cptr)
+{
+char *cvptr, gbuf[CBUFSIZE];
+CTAB *ctptr;
+t_stat r;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+#if !defined(SIM_LOGSTREAM)
+return sim_messagef (SCPE_NOFNC, "Log streams are not available on this host\n");
+#endif
+while (*cptr != 0) {                                    /* do all mods */
+    cptr = get_glyph_nc (cptr, gbuf, ',');              /* get modifier */
+    if ((cvptr = strchr (gbuf, '=')))                   /* = value? */
+        *cvptr++ = 0;
+    get_glyph (gbuf, gbuf, 0);                          /* modifier to UC */
+    if ((ctptr = find_ctab (set_logging_tab, gbuf))) {  /* match? */
+        r = ctptr->action (ctptr->arg, cvptr);          /* do the rest */
+        if (r != SCPE_OK)
+            return r;
+        }
+    else return SCPE_NOPARAM;
+    }
+return SCPE_OK;
+}
+
+/* SHOW LOGGING command */
+
+t_stat sim_show_logging (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr)
+{
+#if defined(SIM_LOGSTREAM)
+LOGSTREAM *ls;
+#endif
+
+if (cptr && (*cptr != 0))
+    return SCPE_2MARG;
+#if defined(SIM_LOGSTREAM)
+fprintf (st, "Line logs opened from now on are written %s", sim_logstream_async ? "asynchronously" : "synchronously");
+if (sim_logstream_compress)
+    fprintf (st, ", compressed");
+if (sim_logstream_stamp)
+    fprintf (st, ", time stamped");
+fprintf (st, "\n");
+if (sim_logstream_rotate_size || sim_logstream_rotate_secs) {
+    fprintf (st, "Rotated");
+    if (sim_logstream_rotate_size)
+        fprintf (st, " after %" LL_FMT "u bytes", sim_logstream_rotate_size);
+    if (sim_logstream_rotate_size && sim_logstream_rotate_secs)
+        fprintf (st, " or");
+    if (sim_logstream_rotate_secs)
+        fprintf (st, " every %u seconds", (unsigned int)sim_logstream_rotate_secs);
+    fprintf (st, ", keeping %u older file%s\n", (unsigned int)sim_logstream_keep, (sim_logstream_keep == 1) ? "" : "s");
+    }
+for (ls = sim_logstreams; ls; ls = ls->next) {
+    fprintf (st, "%s:\n", ls->path);
+    fprintf (st, "  %s%s%s, %" LL_FMT "u bytes written, %u writer batches, %u stalls\n",
+                 ls->async ? "asynchronous" : "synchronous",
+                 ls->compress ? ", compressed" : "", ls->stamp ? ", time stamped" : "",
+                 ls->bytes, (unsigned int)ls->batches, (unsigned int)ls->stalls);
+    if (ls->rotations || ls->rotate_size || ls->rotate_secs)
+        fprintf (st, "  %" LL_FMT "u bytes in current file, %u rotations\n", ls->file_bytes, (unsigned int)ls->rotations);
+    if (ls->errors)
+        fprintf (st, "  %u write errors\n", (unsigned int)ls->errors);
+    }
+#else
+fprintf (st, "Log streams are not available on this host\n");
+#endif
+return SCPE_OK;
+}
+
 /* Check connection before executing 
    (including a remote console which may be required in master mode) */
 
@@ -2829,12 +3754,185 @@ fprintf (st, "Console Send processing:\n");
 return sim_show_send_input (st, &sim_con_send);
 }
 
+/* Batch console I/O
+
+   Headless runs which boot an operating system and dump large volumes of
+   output to the console window spend most of their console time in per
+   character write, log and debug calls.  When batch mode is enabled
+   (SET CONSOLE BATCH{=bufsize}) console window output is accumulated in
+   a ring buffer which is written in bulk when a line is completed, when
+   the buffer fills, when output has been pending for CON_BATCH_TMO msecs
+   or when the simulator stops.  The console log and the XMT debug trace
+   receive the same bulk data.  When stdin is not a terminal, keyboard
+   input is read from it in buffer sized batches (it otherwise isn't read
+   at all), so commands should then come from a DO file rather than stdin.
+
+   Expect rules are still checked on each character as it is output.
+*/
+
+#define CON_BATCH_DEFSIZE   8192                        /* default buffer size */
+#define CON_BATCH_MINSIZE   256                         /* smallest buffer size */
+#define CON_BATCH_MAXSIZE   (1024*1024)                 /* largest buffer size */
+#define CON_BATCH_TMO       100                         /* msecs before a partial line is flushed */
+
+static int32 sim_con_batch_size = 0;                    /* buffer size (0 = batch mode off) */
+static uint8 *sim_con_obuf = NULL;                      /* output ring */
+static int32 sim_con_obuf_out = 0;                      /* output ring removal index */
+static int32 sim_con_obuf_cnt = 0;                      /* output characters pending */
+static uint32 sim_con_obuf_time = 0;                    /* time oldest pending output was queued */
+static uint8 *sim_con_ibuf = NULL;                      /* input batch */
+static int32 sim_con_ibuf_pos = 0;                      /* next input character */
+static int32 sim_con_ibuf_cnt = 0;                      /* input characters in batch */
+static t_bool sim_con_ibuf_eof = FALSE;                 /* input at end of file */
+static uint32 sim_con_batch_writes = 0;                 /* bulk writes */
+static uint32 sim_con_batch_reads = 0;                  /* batch reads */
+static t_uint64 sim_con_batch_ochars = 0;               /* characters written */
+static t_uint64 sim_con_batch_ichars = 0;               /* characters read */
+
+/* Write out all pending console output */
+
+static void _sim_con_batch_flush (void)
+{
+while (sim_con_obuf_cnt > 0) {
+    uint8 *data = &sim_con_obuf[sim_con_obuf_out];
+    int32 len = MIN (sim_con_obuf_cnt, sim_con_batch_size - sim_con_obuf_out);
+    int32 sent = sim_os_write_batch (data, len);
+
+    if (sent <= 0)                                      /* output failing? */
+        sent = len;                                     /* discard */
+    else {
+        if (sim_log)                                    /* log file? */
+            fwrite (data, 1, sent, sim_log);
+        sim_data_trace (&sim_con_telnet, &sim_con_unit, data, "", sent, "sim_putchar batch", DBG_XMT);
+        ++sim_con_batch_writes;
+        sim_con_batch_ochars += sent;
+        }
+    sim_con_obuf_out = (sim_con_obuf_out + sent) % sim_con_batch_size;
+    sim_con_obuf_cnt -= sent;
+    }
+sim_con_obuf_out = 0;
+}
+
+/* Queue a console output character */
+
+static t_stat _sim_con_batch_putc (int32 c)
+{
+if (sim_con_obuf_cnt == 0)                              /* first pending character? */
+    sim_con_obuf_time = sim_os_msec ();
+sim_con_obuf[(sim_con_obuf_out + sim_con_obuf_cnt) % sim_con_batch_size] = (uint8)c;
+if ((++sim_con_obuf_cnt == sim_con_batch_size) ||       /* ring full or line complete? */
+    (c == '\n'))
+    _sim_con_batch_flush ();
+return SCPE_OK;
+}
+
+/* Get the next console input character from the current batch */
+
+static t_stat _sim_con_batch_getc (void)
+{
+int32 c;
+
+if (sim_con_ibuf_pos == sim_con_ibuf_cnt) {             /* batch consumed? */
+    int32 n;
+
+    if (sim_con_ibuf_eof)
+        return SCPE_OK;
+    n = sim_os_read_batch (sim_con_ibuf, sim_con_batch_size);
+    if (n < 0) {
+        sim_debug (DBG_RCV, &sim_con_telnet, "_sim_con_batch_getc() - end of input\n");
+        sim_con_ibuf_eof = TRUE;
+        }
+    if (n <= 0)
+        return SCPE_OK;
+    sim_data_trace (&sim_con_telnet, &sim_con_unit, sim_con_ibuf, "", n, "sim_poll_kbd batch", DBG_RCV);
+    sim_con_ibuf_pos = 0;
+    sim_con_ibuf_cnt = n;
+    ++sim_con_batch_reads;
+    sim_con_batch_ichars += n;
+    }
+c = sim_con_ibuf[sim_con_ibuf_pos++];
+if (sim_brk_char && (c == sim_brk_char))
+    return SCPE_BREAK;
+if (sim_int_char && (c == sim_int_char))
+    return SCPE_STOP;
+return (c | SCPE_KFLAG);
+}
+
+/* Set console batch mode (flag = 1) or return to unbatched I/O (flag = 0) */
+
+t_stat sim_set_cons_batch (int32 flag, CONST char *cptr)
+{
+int32 size = CON_BATCH_DEFSIZE;
+int32 pending = sim_con_ibuf_cnt - sim_con_ibuf_pos;
+uint8 *obuf, *ibuf;
+t_stat r;
+
+if (flag == 0) {                                        /* NOBATCH */
+    if (cptr && (*cptr != 0))
+        return SCPE_2MARG;
+    _sim_con_batch_flush ();
+    free (sim_con_obuf);
+    sim_con_obuf = NULL;
+    free (sim_con_ibuf);
+    sim_con_ibuf = NULL;
+    sim_con_ibuf_pos = sim_con_ibuf_cnt = 0;
+    sim_con_batch_size = 0;
+    return SCPE_OK;
+    }
+if (cptr && (*cptr != 0)) {
+    size = (int32)get_uint (cptr, 10, CON_BATCH_MAXSIZE, &r);
+    if ((r != SCPE_OK) || (size < CON_BATCH_MINSIZE))
+        return sim_messagef (SCPE_ARG, "Invalid console batch buffer size: %s (range %d-%d)\n", cptr, CON_BATCH_MINSIZE, CON_BATCH_MAXSIZE);
+    }
+_sim_con_batch_flush ();
+if (pending > size)                                     /* keep any unread input */
+    return sim_messagef (SCPE_ARG, "%d characters of console input pending, buffer size must be at least that\n", pending);
+if (sim_con_ibuf && pending)
+    memmove (sim_con_ibuf, &sim_con_ibuf[sim_con_ibuf_pos], pending);
+obuf = (uint8 *)realloc (sim_con_obuf, size);
+ibuf = (uint8 *)realloc (sim_con_ibuf, size);
+if (obuf)
+    sim_con_obuf = obuf;
+if (ibuf)
+    sim_con_ibuf = ibuf;
+if ((obuf == NULL) || (ibuf == NULL))
+    return SCPE_MEM;
+sim_con_ibuf_pos = 0;
+sim_con_ibuf_cnt = pending;
+sim_con_ibuf_eof = FALSE;                               /* try reading input again */
+sim_con_batch_size = size;
+return SCPE_OK;
+}
+
+t_stat sim_show_cons_batch (FILE *st, DEVICE *dunused, UNIT *uunused, int32 flag, CONST char *cptr)
+{
+if (cptr && (*cptr != 0))
+    return SCPE_2MARG;
+if (sim_con_batch_size == 0) {
+    fprintf (st, "Unbatched console I/O\n");
+    return SCPE_OK;
+    }
+fprintf (st, "Batched console I/O, Buffer Size = %d\n", sim_con_batch_size);
+fprintf (st, "  Output: %u writes, %" LL_FMT "u characters, %d pending\n", 
+             sim_con_batch_writes, sim_con_batch_ochars, sim_con_obuf_cnt);
+if (sim_ttisatty ())
+    fprintf (st, "  Input:  terminal (not batched)\n");
+else
+    fprintf (st, "  Input:  %u reads, %" LL_FMT "u characters, %d pending%s\n", 
+                 sim_con_batch_reads, sim_con_batch_ichars, sim_con_ibuf_cnt - sim_con_ibuf_pos,
+                 sim_con_ibuf_eof ? ", end of file" : "");
+return SCPE_OK;
+}
+
 /* Poll for character */
 
 t_stat sim_poll_kbd (void)
 {
 t_stat c;
 
+if ((sim_con_obuf_cnt > 0) &&                              /* batched output timed out? */
+    ((sim_os_msec () - sim_con_obuf_time) >= CON_BATCH_TMO))
+    _sim_con_batch_flush ();
 if (sim_send_poll_data (&sim_con_send, &c))                 /* injected input characters available? */
     return c;
 if (!sim_rem_master_mode) {
@@ -2843,14 +3941,27 @@ if (!sim_rem_master_mode) {
         return SCPE_OK;                                     /* not yet */
     if (sim_ttisatty ())
         c = sim_os_poll_kbd ();                             /* get character */
-    else
-        c = SCPE_OK;
+    else {
+        if (sim_con_batch_size)                             /* batch mode? */
+            c = _sim_con_batch_getc ();                     /* get from input batch */
+        else
+            c = SCPE_OK;
+        }
     if (c == SCPE_STOP) {                                   /* ^E */
         stop_cpu = TRUE;                                    /* Force a stop (which is picked up by sim_process_event */
         return SCPE_OK;
         }
     if ((sim_con_tmxr.master == 0) &&                       /* not Telnet? */
         (sim_con_ldsc.serport == 0)) {                      /* and not serial? */
+        if (sim_evlog_active () &&                          /* keyboard input recorded or replayed? */
+            ((c == SCPE_OK) || (c & SCPE_KFLAG))) {         /*   (other status is passed through) */
+            uint8 ch = (uint8)c;
+
+            if (sim_evlog_input ("CON", &ch, (c & SCPE_KFLAG) ? 1 : 0, 1))
+                c = (t_stat)ch | SCPE_KFLAG;
+            else
+                c = SCPE_OK;
+            }
         if (c && sim_con_ldsc.rxbps)                        /* got something && rate limiting? */
             sim_con_ldsc.rxnexttime =                       /* compute next input time */
                 floor (sim_gtime () + ((sim_con_ldsc.rxdeltausecs * sim_timer_inst_per_sec ()) / USECS_PER_SECOND));
@@ -2880,6 +3991,8 @@ t_stat sim_putchar (int32 c)
 sim_exp_check (&sim_con_expect, c);
 if ((sim_con_tmxr.master == 0) &&                       /* not Telnet? */
     (sim_con_ldsc.serport == 0)) {                      /* and not serial port */
+    if (sim_con_batch_size)                             /* batch mode? */
+        return _sim_con_batch_putc (c);                 /* queue it */
     if (sim_log)                                        /* log file? */
         fputc (c, sim_log);
     sim_debug (DBG_XMT, &sim_con_telnet, "sim_putchar('%c' (0x%02X)\n", sim_isprint (c) ? c : '.', c);
@@ -2903,6 +4016,8 @@ t_stat r;
 sim_exp_check (&sim_con_expect, c);
 if ((sim_con_tmxr.master == 0) &&                       /* not Telnet? */
     (sim_con_ldsc.serport == 0)) {                      /* and not serial port */
+    if (sim_con_batch_size)                             /* batch mode? */
+        return _sim_con_batch_putc (c);                 /* queue it */
     if (sim_log)                                        /* log file? */
         fputc (c, sim_log);
     sim_debug (DBG_XMT, &sim_con_telnet, "sim_putchar('%c' (0x%02X)\n", sim_isprint (c) ? c : '.', c);
@@ -3153,6 +4268,7 @@ return sim_os_ttrun ();
 
 t_stat sim_ttcmd (void)
 {
+_sim_con_batch_flush ();                                /* write pending batched output */
 #if defined(SIM_ASYNCH_IO) && defined(SIM_ASYNCH_MUX)
 pthread_mutex_lock (&sim_tmxr_poll_lock);
 if (sim_console_poll_running) {
@@ -3170,8 +4286,11 @@ return sim_os_ttcmd ();
 
 t_stat sim_ttclose (void)
 {
-t_stat r1 = tmxr_shutdown ();
-t_stat r2 = sim_os_ttclose ();
+t_stat r1, r2;
+
+_sim_rem_con_io_stop ();                                /* stop remote console I/O thread */
+r1 = tmxr_shutdown ();
+r2 = sim_os_ttclose ();
 
 if (r1 != SCPE_OK)
     return r1;
@@ -3364,6 +4483,20 @@ if ((status != SS$_NORMAL) || (iosb.status != SS$_NORMAL))
 return SCPE_OK;
 }
 
+static int32 sim_os_read_batch (uint8 *buf, int32 size)
+{
+return 0;                                               /* batched input not supported */
+}
+
+static int32 sim_os_write_batch (const uint8 *buf, int32 len)
+{
+int32 i;
+
+for (i = 0; i < len; i++)
+    sim_os_putchar (buf[i]);
+return len;
+}
+
 /* Win32 routines */
 
 #elif defined (_WIN32)
@@ -3613,6 +4746,20 @@ if (c != 0177) {
 return SCPE_OK;
 }
 
+static int32 sim_os_read_batch (uint8 *buf, int32 size)
+{
+return 0;                                               /* batched input not supported */
+}
+
+static int32 sim_os_write_batch (const uint8 *buf, int32 len)
+{
+int32 i;
+
+for (i = 0; i < len; i++)
+    sim_os_putchar (buf[i]);
+return len;
+}
+
 /* OS/2 routines, from Bruce Ray and Holger Veit */
 
 #elif defined (__OS2__)
@@ -3696,6 +4843,20 @@ if (c != 0177) {
 return SCPE_OK;
 }
 
+static int32 sim_os_read_batch (uint8 *buf, int32 size)
+{
+return 0;                                               /* batched input not supported */
+}
+
+static int32 sim_os_write_batch (const uint8 *buf, int32 len)
+{
+int32 i;
+
+for (i = 0; i < len; i++)
+    sim_os_putchar (buf[i]);
+return len;
+}
+
 /* Metrowerks CodeWarrior Macintosh routines, from Louis Chretien and
    Peter Schorn */
 
@@ -3889,6 +5050,20 @@ if (c != 0177) {
 return SCPE_OK;
 }
 
+static int32 sim_os_read_batch (uint8 *buf, int32 size)
+{
+return 0;                                               /* batched input not supported */
+}
+
+static int32 sim_os_write_batch (const uint8 *buf, int32 len)
+{
+int32 i;
+
+for (i = 0; i < len; i++)
+    sim_os_putchar (buf[i]);
+return len;
+}
+
 /* BSD UNIX routines */
 
 #elif defined (BSDTTY)
@@ -4041,6 +5216,33 @@ write (1, &c, 1);
 return SCPE_OK;
 }
 
+static int32 sim_os_read_batch (uint8 *buf, int32 size)
+{
+fd_set readfds;
+struct timeval timeout;
+ssize_t status;
+
+FD_ZERO (&readfds);
+FD_SET (0, &readfds);
+timeout.tv_sec = timeout.tv_usec = 0;
+if (1 != select (1, &readfds, NULL, NULL, &timeout))    /* nothing available? */
+    return 0;
+status = read (0, buf, size);
+if (status == 0)                                        /* end of file? */
+    return -1;
+return (status < 0) ? 0 : (int32)status;
+}
+
+static int32 sim_os_write_batch (const uint8 *buf, int32 len)
+{
+ssize_t status;
+
+do
+    status = write (1, buf, len);
+    while ((status < 0) && (errno == EINTR));
+return (status < 0) ? 0 : (int32)status;
+}
+
 /* POSIX UNIX routines, from Leendert Van Doorn */
 
 #else
@@ -4215,6 +5417,33 @@ c = out;
 return SCPE_OK;
 }
 
+static int32 sim_os_read_batch (uint8 *buf, int32 size)
+{
+fd_set readfds;
+struct timeval timeout;
+ssize_t status;
+
+FD_ZERO (&readfds);
+FD_SET (0, &readfds);
+timeout.tv_sec = timeout.tv_usec = 0;
+if (1 != select (1, &readfds, NULL, NULL, &timeout))    /* nothing available? */
+    return 0;
+status = read (0, buf, size);
+if (status == 0)                                        /* end of file? */
+    return -1;
+return (status < 0) ? 0 : (int32)status;
+}
+
+static int32 sim_os_write_batch (const uint8 *buf, int32 len)
+{
+ssize_t status;
+
+do
+    status = write (1, buf, len);
+    while ((status < 0) && (errno == EINTR));
+return (status < 0) ? 0 : (int32)status;
+}
+
 #endif
 
 /* Decode a string.
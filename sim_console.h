@@ -88,7 +88,9 @@ t_stat sim_set_cons_buff (int32 flg, CONST char *cptr);
 t_stat sim_set_cons_unbuff (int32 flg, CONST char *cptr);
 t_stat sim_set_cons_log (int32 flg, CONST char *cptr);
 t_stat sim_set_cons_nolog (int32 flg, CONST char *cptr);
+t_stat sim_set_cons_batch (int32 flag, CONST char *cptr);
 t_stat sim_set_deboff (int32 flag, CONST char *cptr);
+t_stat sim_set_logging (int32 flag, CONST char *cptr);
 t_stat sim_set_cons_expect (int32 flg, CONST char *cptr);
 t_stat sim_set_cons_noexpect (int32 flg, CONST char *cptr);
 t_stat sim_set_pchar (int32 flag, CONST char *cptr);
@@ -99,14 +101,17 @@ t_stat sim_show_kmap (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char
 t_stat sim_show_telnet (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_log (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_debug (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
+t_stat sim_show_logging (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_pchar (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_cons_speed (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_cons_buff (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_cons_log (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
+t_stat sim_show_cons_batch (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_cons_debug (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_cons_expect (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_check_console (int32 sec);
 t_stat sim_open_logfile (const char *filename, t_bool binary, FILE **pf, FILEREF **pref);
+t_stat sim_open_logstream (const char *filename, t_bool binary, FILE **pf, FILEREF **pref);
 t_stat sim_close_logfile (FILEREF **pref);
 const char *sim_logfile_name (FILE *st, FILEREF *ref);
 SEND *sim_cons_get_send (void);
@@ -114,6 +119,8 @@ EXPECT *sim_cons_get_expect (void);
 t_stat sim_show_cons_send_input (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_set_noconsole_port (void);
 t_stat sim_set_stable_registers_state (void);
+t_stat sim_set_readable_registers_state (void);
+void sim_rem_con_direct (void);
 t_stat sim_poll_kbd (void);
 t_stat sim_putchar (int32 c);
 t_stat sim_putchar_s (int32 c);
@@ -128,6 +135,7 @@ t_stat sim_tt_settabs (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat sim_tt_showtabs (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 
 extern int32 sim_rem_cmd_active_line;                       /* command in progress on line # */
+extern t_bool sim_rem_con_direct_pending;                   /* remote command waiting for an instruction boundary */
 
 extern int32 sim_int_char;                                  /* interrupt character */
 extern int32 sim_brk_char;                                  /* break character */
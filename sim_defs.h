@@ -1084,6 +1084,7 @@ extern pthread_t sim_asynch_main_threadid;
 extern UNIT * volatile sim_asynch_queue;
 extern volatile t_bool sim_idle_wait;
 extern int32 sim_asynch_check;
+extern int32 sim_asynch_inflight;
 extern int32 sim_asynch_latency;
 extern int32 sim_asynch_inst_latency;
 
@@ -145,6 +145,7 @@ if ((!callback) || !ctx->asynch_io)
         ctx->sects = _sects;                                    \
         ctx->rsects = _rsects;                                  \
         ctx->callback = _callback;                              \
+        ++sim_asynch_inflight;                                  \
         pthread_cond_signal (&ctx->io_cond);                    \
         pthread_mutex_unlock (&ctx->io_lock);                   \
         }                                                       \
@@ -224,6 +225,7 @@ if (ctx->io_dop != DOP_DONE)
 
 if (ctx->callback && ctx->io_dop == DOP_DONE) {
     ctx->callback = NULL;
+    --sim_asynch_inflight;
     callback (uptr, ctx->io_status);
     }
 }
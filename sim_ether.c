@@ -375,6 +375,14 @@
 #include <unistd.h>
 #endif
 
+/* CRC32 using the x86 carry-less multiply instruction is available when 
+   the compiler can target it per function and then dispatched at run time */
+#if defined(__x86_64__) && \
+    (defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))))
+#define ETH_CRC32_PCLMUL
+#include <immintrin.h>
+#endif
+
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
 /* Internal routines - forward declarations */
@@ -546,28 +554,171 @@ static const uint32 crcTable[256] = {
   0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
+/* crcSlice[k][b] is the CRC contribution of byte b when it is followed 
+   by k more bytes.  crcSlice[0] is crcTable.  These tables let 8 bytes 
+   be folded into the CRC with independent lookups (slicing-by-8).  They
+   are built by eth_open on the simulator thread before any reader or
+   writer thread exists, so those threads only ever see complete tables.
+   Until then eth_crc32 uses the byte at a time reference. */
+static uint32 crcSlice[8][256];
+static int crcSliceReady = 0;
+#if defined(ETH_CRC32_PCLMUL)
+static int crcUsePclmul = 0;
+#endif
+
+static void _eth_crc32_init(void)
+{
+  int i, k;
+
+  if (crcSliceReady)
+    return;
+  for (i = 0; i < 256; i++) {
+    crcSlice[0][i] = crcTable[i];
+    for (k = 1; k < 8; k++)
+      crcSlice[k][i] = (crcSlice[k-1][i] >> 8) ^ crcTable[crcSlice[k-1][i] & 0xFF];
+  }
+#if defined(ETH_CRC32_PCLMUL)
+  __builtin_cpu_init();
+  crcUsePclmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+  crcSliceReady = 1;
+}
+
+/* Reference (one byte at a time) CRC, operating on the inverted CRC state */
+static uint32 _eth_crc32_bytewise(uint32 crc, const unsigned char* buf, size_t len)
+{
+  while (0 != len--)
+    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
+  return crc;
+}
+
+/* Slicing-by-8 CRC, operating on the inverted CRC state */
+static uint32 _eth_crc32_slice8(uint32 crc, const unsigned char* buf, size_t len)
+{
+  while (len >= 8) {
+    crc ^= (uint32)buf[0] | ((uint32)buf[1] << 8) | ((uint32)buf[2] << 16) | ((uint32)buf[3] << 24);
+    crc = crcSlice[7][crc & 0xFF] ^ crcSlice[6][(crc >> 8) & 0xFF] ^
+          crcSlice[5][(crc >> 16) & 0xFF] ^ crcSlice[4][crc >> 24] ^
+          crcSlice[3][buf[4]] ^ crcSlice[2][buf[5]] ^
+          crcSlice[1][buf[6]] ^ crcSlice[0][buf[7]];
+    buf += 8;
+    len -= 8;
+  }
+  return _eth_crc32_bytewise(crc, buf, len);
+}
+
+#if defined(ETH_CRC32_PCLMUL)
+/* Fold 64 byte blocks with carry-less multiplies and Barrett reduce the 
+   result ("Fast CRC Computation for Generic Polynomials Using PCLMULQDQ 
+   Instruction", Intel 2009).  len must be at least 64 and a multiple of 16.
+   Operates on the inverted CRC state. */
+__attribute__((target("pclmul,sse4.1")))
+static uint32 _eth_crc32_pclmul(uint32 crc, const unsigned char* buf, size_t len)
+{
+  static const t_uint64 k1k2[2] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+  static const t_uint64 k3k4[2] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+  static const t_uint64 k5k0[2] = { 0x0163cd6124ULL, 0x0000000000ULL };
+  static const t_uint64 poly[2] = { 0x01db710641ULL, 0x01f7011641ULL };
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+  x0 = _mm_loadu_si128((const __m128i *)k1k2);
+  buf += 64;
+  len -= 64;
+  /* Fold 4 x 128 bits in parallel */
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+    buf += 64;
+    len -= 64;
+  }
+  /* Fold the 4 accumulators into one */
+  x0 = _mm_loadu_si128((const __m128i *)k3k4);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+  /* Fold any remaining 16 byte blocks */
+  while (len >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)buf)), x5);
+    buf += 16;
+    len -= 16;
+  }
+  /* Reduce 128 bits to 64 bits */
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  /* Barrett reduce to 32 bits */
+  x0 = _mm_loadu_si128((const __m128i *)poly);
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return (uint32)_mm_extract_epi32(x1, 1);
+}
+#endif /* ETH_CRC32_PCLMUL */
+
 uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len)
 {
   const uint32 mask = 0xFFFFFFFF;
   const unsigned char* buf = (const unsigned char*)vbuf;
 
   crc ^= mask;
-  while (len > 8) {
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    len -= 8;
+  if (!crcSliceReady)                                     /* no device opened yet? */
+    return(_eth_crc32_bytewise(crc, buf, len) ^ mask);
+#if defined(ETH_CRC32_PCLMUL)
+  if (crcUsePclmul && (len >= 64)) {
+    size_t blocks = len & ~((size_t)15);
+
+    crc = _eth_crc32_pclmul(crc, buf, blocks);
+    buf += blocks;
+    len -= blocks;
   }
-  while (0 != len--)
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
+#endif
+  crc = _eth_crc32_slice8(crc, buf, len);
   return(crc ^ mask);
 }
 
+/* CRC of a 6 byte MAC address (for AUTODIN II multicast hashing) with 
+   all 6 table lookups independent of each other */
+static uint32 _eth_crc32_mac(const unsigned char* mac)
+{
+  uint32 crc = 0xFFFFFFFF ^ ((uint32)mac[0] | ((uint32)mac[1] << 8) | ((uint32)mac[2] << 16) | ((uint32)mac[3] << 24));
+
+  crc = crcSlice[5][crc & 0xFF] ^ crcSlice[4][(crc >> 8) & 0xFF] ^
+        crcSlice[3][(crc >> 16) & 0xFF] ^ crcSlice[2][crc >> 24] ^
+        crcSlice[1][mac[4]] ^ crcSlice[0][mac[5]];
+  return crc ^ 0xFFFFFFFF;
+}
+
 int eth_get_packet_crc32_data(const uint8 *msg, int len, uint8 *crcdata)
 {
   int crc_len;
@@ -987,6 +1138,12 @@ const char *eth_capabilities(void)
 #endif
 #if defined (HAVE_SLIRP_NETWORK)
      ":NAT"
+#endif
+#if defined (HAVE_AF_PACKET_NETWORK)
+     ":AF_PACKET"
+#endif
+#if defined (HAVE_SHM_NETWORK)
+     ":SHM"
 #endif
      ":UDP";
  }
@@ -1019,6 +1176,11 @@ typedef void * pcap_t;  /* Pseudo Type to avoid compiler errors */
 #include <sys/ioctl.h> 
 #include <net/if.h> 
 #include <linux/if_tun.h> 
+#if defined(IFF_VNET_HDR) && defined(TUNSETOFFLOAD) && defined(TUNGETFEATURES)
+#define HAVE_TAP_VNET_HDR
+#include <sys/uio.h>
+#include <linux/virtio_net.h>
+#endif
 #elif defined(HAVE_BSDTUNTAP)
 #include <sys/types.h>
 #include <net/if_types.h>
@@ -1026,6 +1188,9 @@ typedef void * pcap_t;  /* Pseudo Type to avoid compiler errors */
 #else /* We don't know how to do this on the current platform */
 #undef HAVE_TAP_NETWORK
 #endif
+/* Largest frame read from a tap: with TSO4 the host can hand us a 64KB 
+   IPv4 segment behind an Ethernet header and a VLAN tag */
+#define ETH_MAX_TAP_FRAME (65535 + 14 + 4)
 #endif /* HAVE_TAP_NETWORK */
 
 #ifdef HAVE_VDE_NETWORK
@@ -1042,6 +1207,35 @@ extern "C" {
 #include "sim_slirp.h"
 #endif /* HAVE_SLIRP_NETWORK */
 
+#ifdef HAVE_AF_PACKET_NETWORK
+#if defined(__linux) || defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#else /* AF_PACKET is only available on Linux */
+#undef HAVE_AF_PACKET_NETWORK
+#endif
+#endif /* HAVE_AF_PACKET_NETWORK */
+
+#ifdef HAVE_SHM_NETWORK
+#if defined(HAVE_SHM_OPEN) && defined(__GNUC__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <signal.h>
+#if defined(__linux) || defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#else /* Needs shm_open() and the gcc __atomic builtins */
+#undef HAVE_SHM_NETWORK
+#endif
+#endif /* HAVE_SHM_NETWORK */
+
 /* Allows windows to look up user-defined adapter names */
 #if defined(_WIN32)
 #include <winreg.h>
@@ -1552,6 +1746,19 @@ static void eth_get_nic_hw_addr(ETH_DEV* dev, const char *devname)
 {
   memset(&dev->host_nic_phy_hw_addr, 0, sizeof(dev->host_nic_phy_hw_addr));
   dev->have_host_nic_phy_addr = 0;
+#if defined(HAVE_AF_PACKET_NETWORK)
+  if (dev->eth_api == ETH_API_AFPKT) {
+    struct ifreq ifr;
+
+    memset (&ifr, 0, sizeof(ifr));
+    strlcpy (ifr.ifr_name, devname + strlen ("afpacket:"), sizeof(ifr.ifr_name));
+    if (0 == ioctl (dev->fd_handle, SIOCGIFHWADDR, &ifr)) {
+      memcpy (dev->host_nic_phy_hw_addr, ifr.ifr_hwaddr.sa_data, sizeof(ETH_MAC));
+      dev->have_host_nic_phy_addr = 1;
+      }
+    return;
+    }
+#endif
   if (dev->eth_api != ETH_API_PCAP)
     return;
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -1687,6 +1894,14 @@ _eth_write(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine);
 static void
 _eth_error(ETH_DEV* dev, const char* where);
 
+#if defined(HAVE_TAP_NETWORK)
+static int
+_eth_tap_read(ETH_DEV* dev, u_char* buf, size_t size);
+
+static int
+_eth_tap_write(ETH_DEV* dev, const u_char* msg, size_t len);
+#endif
+
 #if defined(HAVE_SLIRP_NETWORK)
 static void _slirp_callback (void *opaque, const unsigned char *buf, int len)
 {
@@ -1698,6 +1913,667 @@ _eth_callback((u_char *)opaque, &header, buf);
 }
 #endif
 
+#if defined(HAVE_AF_PACKET_NETWORK)
+/*
+   Linux AF_PACKET transport using TPACKET_V3 memory mapped rings.
+
+   Received frames are delivered by the kernel a block at a time into a
+   receive ring shared with this process, so no system call or copy is
+   needed per packet.  Transmitted frames are placed in a separate
+   transmit ring and handed to the kernel with a single send() for
+   however many frames are pending.  A classic BPF program built from
+   the device's current filter addresses is attached to the socket so
+   that the kernel only queues frames the simulated NIC may accept.
+*/
+
+#define ETH_AFPKT_RX_BLOCK_SIZE  (1 << 18)      /* must hold a full jumbo frame */
+#define ETH_AFPKT_RX_BLOCK_NR    8
+#define ETH_AFPKT_RX_FRAME_SIZE  2048
+#define ETH_AFPKT_RX_BLOCK_TOV   1              /* ms before a partial block is retired */
+#define ETH_AFPKT_TX_BLOCK_SIZE  (1 << 16)
+#define ETH_AFPKT_TX_BLOCK_NR    4
+#define ETH_AFPKT_TX_FRAME_SIZE  2048
+#define ETH_AFPKT_TX_DATA_OFFSET TPACKET_ALIGN(sizeof(struct tpacket3_hdr))
+#define ETH_AFPKT_FILTER_ACCEPT  0x40000        /* BPF return: accept whole frame */
+#define ETH_AFPKT_FILTER_MAX     (5*(ETH_FILTER_MAX+1)+5)
+#define ETH_AFPKT_HEADER_LEN     14             /* dst + src + type */
+
+typedef struct eth_afpkt {
+  int                   fd;                     /* AF_PACKET socket */
+  uint8                 *map;                   /* RX ring followed by the TX ring */
+  size_t                map_size;
+  uint8                 *tx_ring;               /* start of TX ring (NULL if unavailable) */
+  struct tpacket_req3   rx_req;
+  struct tpacket_req3   tx_req;
+  uint32                rx_block;               /* next RX block to examine */
+  uint32                rx_pkts_left;           /* packets not yet delivered from rx_block */
+  struct tpacket3_hdr   *rx_pkt;                /* next packet in rx_block */
+  uint32                tx_frame;               /* next TX frame slot to fill */
+  uint32                tx_pending;             /* frames filled but not yet kicked */
+  } ETH_AFPKT;
+
+static void
+_eth_afpkt_close (ETH_AFPKT *afp)
+{
+if (afp == NULL)
+  return;
+if (afp->map)
+  munmap (afp->map, afp->map_size);
+if (afp->fd >= 0)
+  close (afp->fd);
+free (afp);
+}
+
+static ETH_AFPKT *
+_eth_afpkt_open (const char *ifname, char errbuf[PCAP_ERRBUF_SIZE])
+{
+ETH_AFPKT *afp = (ETH_AFPKT *)calloc (1, sizeof (*afp));
+int version = TPACKET_V3;
+struct sockaddr_ll sll;
+struct packet_mreq mreq;
+size_t rx_size, tx_size = 0;
+unsigned int ifindex;
+
+afp->fd = -1;
+if (0 == (ifindex = if_nametoindex (ifname))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "No such interface: %s", ifname);
+  goto Error;
+  }
+if ((afp->fd = socket (AF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0) {
+  strlcpy (errbuf, strerror (errno), PCAP_ERRBUF_SIZE);
+  goto Error;
+  }
+if (setsockopt (afp->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof (version))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "TPACKET_V3 unavailable: %s", strerror (errno));
+  goto Error;
+  }
+afp->rx_req.tp_block_size = ETH_AFPKT_RX_BLOCK_SIZE;
+afp->rx_req.tp_block_nr = ETH_AFPKT_RX_BLOCK_NR;
+afp->rx_req.tp_frame_size = ETH_AFPKT_RX_FRAME_SIZE;
+afp->rx_req.tp_frame_nr = (ETH_AFPKT_RX_BLOCK_SIZE / ETH_AFPKT_RX_FRAME_SIZE) * ETH_AFPKT_RX_BLOCK_NR;
+afp->rx_req.tp_retire_blk_tov = ETH_AFPKT_RX_BLOCK_TOV;
+if (setsockopt (afp->fd, SOL_PACKET, PACKET_RX_RING, &afp->rx_req, sizeof (afp->rx_req))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "PACKET_RX_RING: %s", strerror (errno));
+  goto Error;
+  }
+rx_size = (size_t)afp->rx_req.tp_block_size * afp->rx_req.tp_block_nr;
+/* A TPACKET_V3 transmit ring needs a 4.11 or later kernel.  Without it,
+   frames are simply sent with send() */
+afp->tx_req.tp_block_size = ETH_AFPKT_TX_BLOCK_SIZE;
+afp->tx_req.tp_block_nr = ETH_AFPKT_TX_BLOCK_NR;
+afp->tx_req.tp_frame_size = ETH_AFPKT_TX_FRAME_SIZE;
+afp->tx_req.tp_frame_nr = (ETH_AFPKT_TX_BLOCK_SIZE / ETH_AFPKT_TX_FRAME_SIZE) * ETH_AFPKT_TX_BLOCK_NR;
+if (0 == setsockopt (afp->fd, SOL_PACKET, PACKET_TX_RING, &afp->tx_req, sizeof (afp->tx_req)))
+  tx_size = (size_t)afp->tx_req.tp_block_size * afp->tx_req.tp_block_nr;
+else
+  memset (&afp->tx_req, 0, sizeof (afp->tx_req));
+afp->map_size = rx_size + tx_size;
+afp->map = (uint8 *)mmap (NULL, afp->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, afp->fd, 0);
+if (afp->map == MAP_FAILED)     /* MAP_LOCKED may exceed RLIMIT_MEMLOCK */
+  afp->map = (uint8 *)mmap (NULL, afp->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, afp->fd, 0);
+if (afp->map == MAP_FAILED) {
+  afp->map = NULL;
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "mmap of packet rings failed: %s", strerror (errno));
+  goto Error;
+  }
+if (tx_size)
+  afp->tx_ring = afp->map + rx_size;
+memset (&sll, 0, sizeof (sll));
+sll.sll_family = AF_PACKET;
+sll.sll_protocol = htons (ETH_P_ALL);
+sll.sll_ifindex = ifindex;
+if (bind (afp->fd, (struct sockaddr *)&sll, sizeof (sll))) {
+  strlcpy (errbuf, strerror (errno), PCAP_ERRBUF_SIZE);
+  goto Error;
+  }
+memset (&mreq, 0, sizeof (mreq));
+mreq.mr_ifindex = ifindex;
+mreq.mr_type = PACKET_MR_PROMISC;
+if (setsockopt (afp->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof (mreq))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "Can't set promiscuous mode: %s", strerror (errno));
+  goto Error;
+  }
+return afp;
+
+Error:
+_eth_afpkt_close (afp);
+return NULL;
+}
+
+/* Build a classic BPF program which accepts any frame the simulated NIC
+   might want.  Frames are still filtered exactly by _eth_callback(), so
+   the kernel filter only has to pass a superset of them. */
+static int
+_eth_afpkt_build_filter (ETH_DEV *dev, struct sock_filter *prog)
+{
+int i, len = 0;
+ETH_MAC macs[ETH_FILTER_MAX + 1];
+int mac_count = 0;
+
+if (dev->promiscuous) {
+  struct sock_filter accept = BPF_STMT (BPF_RET | BPF_K, ETH_AFPKT_FILTER_ACCEPT);
+
+  prog[len++] = accept;
+  return len;
+  }
+for (i = 0; i < dev->addr_count; i++)
+  memcpy (macs[mac_count++], dev->filter_address[i], sizeof (ETH_MAC));
+/* Responses to loopback frames arrive addressed to the host NIC */
+if (dev->have_host_nic_phy_addr)
+  memcpy (macs[mac_count++], dev->host_nic_phy_hw_addr, sizeof (ETH_MAC));
+for (i = 0; i < mac_count; i++) {
+  uint32 mac_hi = ((uint32)macs[i][0] << 24) | ((uint32)macs[i][1] << 16) |
+                  ((uint32)macs[i][2] << 8) | macs[i][3];
+  uint32 mac_lo = ((uint32)macs[i][4] << 8) | macs[i][5];
+  struct sock_filter match[5] = {
+      BPF_STMT (BPF_LD  | BPF_W   | BPF_ABS, 0),
+      BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K,   0, 0, 3),
+      BPF_STMT (BPF_LD  | BPF_H   | BPF_ABS, 4),
+      BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K,   0, 0, 1),
+      BPF_STMT (BPF_RET | BPF_K,             ETH_AFPKT_FILTER_ACCEPT)};
+
+  match[1].k = mac_hi;
+  match[3].k = mac_lo;
+  memcpy (&prog[len], match, sizeof (match));
+  len += 5;
+  }
+/* Multicast hash matching is done by _eth_callback() */
+if (dev->all_multicast || dev->hash_filter) {
+  struct sock_filter multicast[3] = {
+      BPF_STMT (BPF_LD  | BPF_B    | BPF_ABS, 0),
+      BPF_JUMP (BPF_JMP | BPF_JSET | BPF_K,   0x01, 0, 1),
+      BPF_STMT (BPF_RET | BPF_K,              ETH_AFPKT_FILTER_ACCEPT)};
+
+  memcpy (&prog[len], multicast, sizeof (multicast));
+  len += 3;
+  }
+if (1) {
+  struct sock_filter reject = BPF_STMT (BPF_RET | BPF_K, 0);
+
+  prog[len++] = reject;
+  }
+return len;
+}
+
+static int
+_eth_afpkt_attach_filter (int fd, ETH_DEV *dev)
+{
+struct sock_filter prog[ETH_AFPKT_FILTER_MAX];
+struct sock_fprog fprog;
+
+fprog.len = (unsigned short)_eth_afpkt_build_filter (dev, prog);
+fprog.filter = prog;
+return setsockopt (fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof (fprog));
+}
+
+/* Deliver up to max (-1 for all) received frames to _eth_callback().
+   Returns the number of frames delivered or -1 on error. */
+static int
+_eth_afpkt_dispatch (ETH_DEV *dev, int max)
+{
+ETH_AFPKT *afp = (ETH_AFPKT *)dev->handle;
+int delivered = 0;
+
+while ((max < 0) || (delivered < max)) {
+  struct tpacket_block_desc *block = (struct tpacket_block_desc *)
+            (afp->map + (size_t)afp->rx_block * afp->rx_req.tp_block_size);
+  struct pcap_pkthdr header;
+
+  if (afp->rx_pkt == NULL) {
+    if (0 == (block->hdr.bh1.block_status & TP_STATUS_USER))
+      break;                    /* No more retired blocks */
+    afp->rx_pkts_left = block->hdr.bh1.num_pkts;
+    afp->rx_pkt = (struct tpacket3_hdr *)((uint8 *)block + block->hdr.bh1.offset_to_first_pkt);
+    }
+  if (afp->rx_pkts_left) {
+    struct tpacket3_hdr *pkt = afp->rx_pkt;
+
+    memset (&header, 0, sizeof (header));
+    header.caplen = pkt->tp_snaplen;
+    header.len = pkt->tp_len;
+    --afp->rx_pkts_left;
+    afp->rx_pkt = (struct tpacket3_hdr *)((uint8 *)pkt + pkt->tp_next_offset);
+    if (pkt->tp_snaplen >= ETH_AFPKT_HEADER_LEN) {
+      _eth_callback ((u_char *)dev, &header, (uint8 *)pkt + pkt->tp_mac);
+      ++delivered;
+      }
+    }
+  if (afp->rx_pkts_left == 0) {
+    /* Hand the exhausted block back to the kernel */
+    afp->rx_pkt = NULL;
+    __sync_synchronize ();
+    block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+    afp->rx_block = (afp->rx_block + 1) % afp->rx_req.tp_block_nr;
+    }
+  }
+return delivered;
+}
+
+/* Ask the kernel to transmit every frame placed in the TX ring */
+static int
+_eth_afpkt_flush (ETH_AFPKT *afp)
+{
+if (afp->tx_pending == 0)
+  return 0;
+afp->tx_pending = 0;
+if ((send (afp->fd, NULL, 0, 0) < 0) && (errno != ENOBUFS))
+  return -1;
+return 0;
+}
+
+/* Queue a frame for transmission.  Unless flush is set, the frame is only
+   placed in the TX ring and is sent by a later _eth_afpkt_flush() */
+static int
+_eth_afpkt_send (ETH_AFPKT *afp, const uint8 *msg, size_t len, int flush)
+{
+struct tpacket3_hdr *frame;
+
+if (afp->tx_ring == NULL)
+  return ((ssize_t)len == send (afp->fd, msg, len, 0)) ? 0 : -1;
+if (len > ETH_AFPKT_TX_FRAME_SIZE - ETH_AFPKT_TX_DATA_OFFSET)
+  return -1;
+frame = (struct tpacket3_hdr *)(afp->tx_ring + (size_t)afp->tx_frame * afp->tx_req.tp_frame_size);
+if (frame->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) {
+  /* Ring is full: push out what is pending, which waits for completion */
+  afp->tx_pending = 1;
+  if (_eth_afpkt_flush (afp))
+    return -1;
+  if (frame->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING))
+    return -1;
+  }
+memcpy ((uint8 *)frame + ETH_AFPKT_TX_DATA_OFFSET, msg, len);
+frame->tp_len = (uint32)len;
+frame->tp_next_offset = 0;
+__sync_synchronize ();
+frame->tp_status = TP_STATUS_SEND_REQUEST;
+afp->tx_frame = (afp->tx_frame + 1) % afp->tx_req.tp_frame_nr;
+++afp->tx_pending;
+return flush ? _eth_afpkt_flush (afp) : 0;
+}
+#endif /* HAVE_AF_PACKET_NETWORK */
+
+#if defined(HAVE_SHM_NETWORK)
+/*
+   Shared memory virtual switch.
+
+   Simulators on one host which attach to shm:name share a memory segment
+   (/dev/shm/simh-eth-name) which behaves as a learning Ethernet switch 
+   with ETH_SHM_PORTS ports.  Each ordered pair of ports has its own single
+   producer, single consumer ring, so frames move between simulators with
+   ordinary loads and stores and no locks or system calls.  A sender 
+   learns its frames' source addresses into a table in the segment, places
+   unicast frames only in the ring to the port the destination was learned
+   on, and floods everything else to all other active ports.  A receiver
+   with nothing to read sleeps on a futex in its port slot, which senders 
+   only wake when the receiver is actually sleeping.  Frames which arrive 
+   at a full ring are dropped, as a switch would.
+
+   Ports are claimed and released while holding an flock() on the segment.
+   Ports left behind by processes which have exited are reclaimed, and the
+   last port to close removes the segment.
+*/
+
+#define ETH_SHM_MAGIC        0x48534D53         /* "SMSH" */
+#define ETH_SHM_VERSION      1
+#define ETH_SHM_PORTS        16
+#define ETH_SHM_RING_SLOTS   64                 /* must be a power of 2 */
+#define ETH_SHM_SLOT_SIZE    1536               /* frame length + ETH_MAX_PACKET */
+#define ETH_SHM_MAC_TABLE    256                /* learned addresses (power of 2) */
+#define ETH_SHM_MAC_PROBE    4                  /* entries examined per address */
+#define ETH_SHM_NAME_PREFIX  "/simh-eth-"
+#define ETH_SHM_HEADER_LEN   14                 /* dst + src + type */
+
+typedef struct {
+  uint32                len;
+  uint8                 msg[ETH_SHM_SLOT_SIZE - sizeof(uint32)];
+  } ETH_SHM_SLOT;
+
+typedef struct {
+  volatile uint32       head;                   /* next slot to read (written by receiver) */
+  uint8                 pad1[60];
+  volatile uint32       tail;                   /* next slot to fill (written by sender) */
+  uint8                 pad2[60];
+  ETH_SHM_SLOT          slot[ETH_SHM_RING_SLOTS];
+  } ETH_SHM_RING;
+
+typedef struct {
+  volatile int32        pid;                    /* owning process (0 when free) */
+  volatile int32        sleeping;               /* receiver is waiting (futex word) */
+  volatile uint32       dropped;                /* frames lost to full rings into this port */
+  uint8                 pad[52];
+  } ETH_SHM_PORT;
+
+typedef struct {
+  volatile uint32       magic;
+  uint32                version;
+  uint32                ports;
+  uint32                ring_slots;
+  uint8                 pad[48];
+  ETH_SHM_PORT          port[ETH_SHM_PORTS];
+  volatile t_uint64     mac_table[ETH_SHM_MAC_TABLE];   /* MAC << 16 | port + 1 */
+  ETH_SHM_RING          ring[ETH_SHM_PORTS][ETH_SHM_PORTS]; /* [from][to] */
+  } ETH_SHM_SEGMENT;
+
+typedef struct eth_shm {
+  ETH_SHM_SEGMENT       *seg;
+  int                   fd;                     /* segment (also used for flock) */
+  int                   port;                   /* this device's port */
+  int                   next_from;              /* round robin start for receiving */
+  char                  name[CBUFSIZE];         /* shared memory object name */
+  } ETH_SHM;
+
+static t_uint64
+_eth_shm_mac (const uint8 *mac)
+{
+return ((t_uint64)mac[0] << 40) | ((t_uint64)mac[1] << 32) | ((t_uint64)mac[2] << 24) |
+       ((t_uint64)mac[3] << 16) | ((t_uint64)mac[4] << 8) | (t_uint64)mac[5];
+}
+
+static int
+_eth_shm_mac_index (t_uint64 mac)
+{
+return (int)(((mac * 0x9E3779B97F4A7C15ULL) >> 56) & (ETH_SHM_MAC_TABLE - 1));
+}
+
+/* Return the port a unicast address was learned on, or -1 */
+static int
+_eth_shm_lookup (ETH_SHM_SEGMENT *seg, const uint8 *dst)
+{
+t_uint64 mac = _eth_shm_mac (dst);
+int i, idx = _eth_shm_mac_index (mac);
+
+for (i = 0; i < ETH_SHM_MAC_PROBE; i++) {
+  t_uint64 entry = __atomic_load_n (&seg->mac_table[(idx + i) & (ETH_SHM_MAC_TABLE - 1)], __ATOMIC_RELAXED);
+
+  if ((entry != 0) && ((entry >> 16) == mac))
+    return (int)(entry & 0xFFFF) - 1;
+  }
+return -1;
+}
+
+static void
+_eth_shm_learn (ETH_SHM *shm, const uint8 *src)
+{
+ETH_SHM_SEGMENT *seg = shm->seg;
+t_uint64 mac = _eth_shm_mac (src);
+t_uint64 entry = (mac << 16) | (t_uint64)(shm->port + 1);
+int i, idx = _eth_shm_mac_index (mac);
+
+if (src[0] & 1)                         /* Never learn group addresses */
+  return;
+for (i = 0; i < ETH_SHM_MAC_PROBE; i++) {
+  volatile t_uint64 *slot = &seg->mac_table[(idx + i) & (ETH_SHM_MAC_TABLE - 1)];
+  t_uint64 current = __atomic_load_n (slot, __ATOMIC_RELAXED);
+
+  if (current == entry)                 /* Already known (the usual case) */
+    return;
+  if ((current == 0) || ((current >> 16) == mac)) {
+    __atomic_store_n (slot, entry, __ATOMIC_RELAXED);
+    return;
+    }
+  }
+/* Neighbourhood is full: replace the first entry */
+__atomic_store_n (&seg->mac_table[idx], entry, __ATOMIC_RELAXED);
+}
+
+/* Forget every address learned on a port (under the segment lock) */
+static void
+_eth_shm_forget_port (ETH_SHM_SEGMENT *seg, int port)
+{
+int i;
+
+for (i = 0; i < ETH_SHM_MAC_TABLE; i++)
+  if ((seg->mac_table[i] & 0xFFFF) == (t_uint64)(port + 1))
+    __atomic_store_n (&seg->mac_table[i], 0, __ATOMIC_RELAXED);
+}
+
+static int
+_eth_shm_port_alive (ETH_SHM_SEGMENT *seg, int port)
+{
+int32 pid = seg->port[port].pid;
+
+return (pid != 0) && ((0 == kill ((pid_t)pid, 0)) || (errno != ESRCH));
+}
+
+static void
+_eth_shm_wake (ETH_SHM_PORT *port)
+{
+if (__atomic_load_n (&port->sleeping, __ATOMIC_SEQ_CST)) {
+  __atomic_store_n (&port->sleeping, 0, __ATOMIC_SEQ_CST);
+#if defined(__linux) || defined(__linux__)
+  syscall (SYS_futex, &port->sleeping, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+  }
+}
+
+static void
+_eth_shm_put (ETH_SHM *shm, int to, const uint8 *msg, size_t len)
+{
+ETH_SHM_SEGMENT *seg = shm->seg;
+ETH_SHM_RING *ring = &seg->ring[shm->port][to];
+uint32 tail = ring->tail;
+ETH_SHM_SLOT *slot;
+
+if ((tail - __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE)) >= ETH_SHM_RING_SLOTS) {
+  __atomic_add_fetch (&seg->port[to].dropped, 1, __ATOMIC_RELAXED);
+  return;
+  }
+slot = &ring->slot[tail & (ETH_SHM_RING_SLOTS - 1)];
+memcpy (slot->msg, msg, len);
+slot->len = (uint32)len;
+/* Publishing the slot and checking for a sleeping receiver are both 
+   sequentially consistent so that a wakeup can't be missed */
+__atomic_store_n (&ring->tail, tail + 1, __ATOMIC_SEQ_CST);
+_eth_shm_wake (&seg->port[to]);
+}
+
+static int
+_eth_shm_send (ETH_SHM *shm, const uint8 *msg, size_t len)
+{
+ETH_SHM_SEGMENT *seg = shm->seg;
+int to;
+
+if ((len < ETH_SHM_HEADER_LEN) || (len > sizeof (seg->ring[0][0].slot[0].msg)))
+  return -1;
+_eth_shm_learn (shm, msg + 6);
+if (0 == (msg[0] & 1)) {
+  to = _eth_shm_lookup (seg, msg);
+  if (to == shm->port)                  /* Destination is on our own port */
+    return 0;
+  if ((to >= 0) && (seg->port[to].pid != 0)) {
+    _eth_shm_put (shm, to, msg, len);
+    return 0;
+    }
+  }
+for (to = 0; to < ETH_SHM_PORTS; to++)
+  if ((to != shm->port) && (seg->port[to].pid != 0))
+    _eth_shm_put (shm, to, msg, len);
+return 0;
+}
+
+/* Return a port with a frame waiting for this port, or -1 */
+static int
+_eth_shm_ready (ETH_SHM *shm)
+{
+int i;
+
+for (i = 0; i < ETH_SHM_PORTS; i++) {
+  int from = (shm->next_from + i) % ETH_SHM_PORTS;
+  ETH_SHM_RING *ring = &shm->seg->ring[from][shm->port];
+
+  if ((from != shm->port) && 
+      (ring->head != __atomic_load_n (&ring->tail, __ATOMIC_SEQ_CST)))
+    return from;
+  }
+return -1;
+}
+
+/* Wait up to ms milliseconds for a frame to arrive */
+static int
+_eth_shm_wait (ETH_SHM *shm, int ms)
+{
+ETH_SHM_PORT *port = &shm->seg->port[shm->port];
+
+if (_eth_shm_ready (shm) >= 0)
+  return 1;
+__atomic_store_n (&port->sleeping, 1, __ATOMIC_SEQ_CST);
+if (_eth_shm_ready (shm) < 0) {
+#if defined(__linux) || defined(__linux__)
+  struct timespec timeout;
+
+  timeout.tv_sec = ms / 1000;
+  timeout.tv_nsec = (ms % 1000) * 1000000;
+  syscall (SYS_futex, &port->sleeping, FUTEX_WAIT, 1, &timeout, NULL, 0);
+#else
+  uint32 start = sim_os_msec ();
+
+  while ((_eth_shm_ready (shm) < 0) && ((sim_os_msec () - start) < (uint32)ms))
+    sim_os_ms_sleep (1);
+#endif
+  }
+__atomic_store_n (&port->sleeping, 0, __ATOMIC_SEQ_CST);
+return (_eth_shm_ready (shm) >= 0);
+}
+
+/* Deliver up to max (or all if max < 0) waiting frames to _eth_callback.
+   Frames are handed over directly from the ring slot they arrived in. */
+static int
+_eth_shm_dispatch (ETH_DEV *dev, int max)
+{
+ETH_SHM *shm = (ETH_SHM *)dev->handle;
+int delivered = 0;
+int from;
+
+while (((max < 0) || (delivered < max)) && ((from = _eth_shm_ready (shm)) >= 0)) {
+  ETH_SHM_RING *ring = &shm->seg->ring[from][shm->port];
+  ETH_SHM_SLOT *slot = &ring->slot[ring->head & (ETH_SHM_RING_SLOTS - 1)];
+  struct pcap_pkthdr header;
+
+  memset (&header, 0, sizeof (header));
+  header.caplen = header.len = slot->len;
+  if ((slot->len >= ETH_SHM_HEADER_LEN) && (slot->len <= sizeof (slot->msg))) {
+    _eth_callback ((u_char *)dev, &header, slot->msg);
+    ++delivered;
+    }
+  __atomic_store_n (&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+  shm->next_from = (from + 1) % ETH_SHM_PORTS;   /* Take turns between senders */
+  }
+return delivered;
+}
+
+static void
+_eth_shm_close (ETH_SHM *shm)
+{
+if (shm == NULL)
+  return;
+if (shm->seg) {
+  int port, in_use = 0;
+
+  flock (shm->fd, LOCK_EX);
+  _eth_shm_forget_port (shm->seg, shm->port);
+  shm->seg->port[shm->port].pid = 0;
+  for (port = 0; port < ETH_SHM_PORTS; port++)
+    in_use |= _eth_shm_port_alive (shm->seg, port);
+  munmap ((void *)shm->seg, sizeof (*shm->seg));
+  if (!in_use)
+    shm_unlink (shm->name);
+  flock (shm->fd, LOCK_UN);
+  }
+if (shm->fd >= 0)
+  close (shm->fd);
+free (shm);
+}
+
+static ETH_SHM *
+_eth_shm_open (const char *switch_name, char errbuf[PCAP_ERRBUF_SIZE])
+{
+ETH_SHM *shm = (ETH_SHM *)calloc (1, sizeof (*shm));
+ETH_SHM_SEGMENT *seg;
+struct stat statb;
+int tries, port, from;
+
+shm->fd = -1;
+shm->port = -1;
+if ((*switch_name == '\0') || strchr (switch_name, '/') ||
+    ((strlen (ETH_SHM_NAME_PREFIX) + strlen (switch_name)) >= sizeof (shm->name))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "Invalid switch name: '%s'", switch_name);
+  goto Error;
+  }
+snprintf (shm->name, sizeof (shm->name), "%s%s", ETH_SHM_NAME_PREFIX, switch_name);
+/* A segment can be unlinked by its last user between our open and lock,
+   in which case we start over with a new one */
+for (tries = 0; tries < 10; tries++) {
+  if ((shm->fd = shm_open (shm->name, O_RDWR | O_CREAT, 0660)) < 0)
+    break;
+  if (flock (shm->fd, LOCK_EX) || fstat (shm->fd, &statb)) {
+    close (shm->fd);
+    shm->fd = -1;
+    break;
+    }
+  if (statb.st_nlink > 0)
+    break;
+  close (shm->fd);
+  shm->fd = -1;
+  }
+if (shm->fd < 0) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: %s", shm->name, strerror (errno));
+  goto Error;
+  }
+if ((statb.st_size != 0) && (statb.st_size != (off_t)sizeof (*seg))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: incompatible switch segment", shm->name);
+  goto Unlock;
+  }
+if ((statb.st_size == 0) && ftruncate (shm->fd, sizeof (*seg))) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: %s", shm->name, strerror (errno));
+  goto Unlock;
+  }
+seg = (ETH_SHM_SEGMENT *)mmap (NULL, sizeof (*seg), PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+if (seg == (ETH_SHM_SEGMENT *)MAP_FAILED) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: mmap: %s", shm->name, strerror (errno));
+  goto Unlock;
+  }
+shm->seg = seg;
+if (seg->magic == 0) {                  /* Fresh (zero filled) segment */
+  seg->version = ETH_SHM_VERSION;
+  seg->ports = ETH_SHM_PORTS;
+  seg->ring_slots = ETH_SHM_RING_SLOTS;
+  seg->magic = ETH_SHM_MAGIC;
+  }
+if ((seg->magic != ETH_SHM_MAGIC) || (seg->version != ETH_SHM_VERSION) ||
+    (seg->ports != ETH_SHM_PORTS) || (seg->ring_slots != ETH_SHM_RING_SLOTS)) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: incompatible switch segment", shm->name);
+  goto Unlock;
+  }
+for (port = 0; port < ETH_SHM_PORTS; port++)
+  if (!_eth_shm_port_alive (seg, port))
+    break;
+if (port == ETH_SHM_PORTS) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: all %d switch ports are in use", shm->name, ETH_SHM_PORTS);
+  goto Unlock;
+  }
+/* Discard anything left behind by a previous owner of the port */
+_eth_shm_forget_port (seg, port);
+for (from = 0; from < ETH_SHM_PORTS; from++)
+  seg->ring[from][port].head = seg->ring[from][port].tail;
+seg->port[port].sleeping = 0;
+seg->port[port].dropped = 0;
+seg->port[port].pid = (int32)getpid ();
+shm->port = port;
+flock (shm->fd, LOCK_UN);
+return shm;
+
+Unlock:
+flock (shm->fd, LOCK_UN);
+Error:
+if (shm->seg) {
+  munmap ((void *)shm->seg, sizeof (*shm->seg));
+  shm->seg = NULL;
+  }
+_eth_shm_close (shm);
+return NULL;
+}
+#endif /* HAVE_SHM_NETWORK */
+
 #if defined (USE_READER_THREAD)
 static void *
 _eth_reader(void *arg)
@@ -1724,6 +2600,8 @@ switch (dev->eth_api) {
   case ETH_API_VDE:
   case ETH_API_UDP:
   case ETH_API_NAT:
+  case ETH_API_AFPKT:
+  case ETH_API_SHM:
     do_select = 1;
     select_fd = dev->fd_handle;
     break;
@@ -1751,6 +2629,12 @@ while (dev->handle) {
         sel_ret = sim_slirp_select ((SLIRP*)dev->handle, 250);
         }
       else
+#endif
+#ifdef HAVE_SHM_NETWORK
+      if (dev->eth_api == ETH_API_SHM) {
+        sel_ret = _eth_shm_wait ((ETH_SHM *)dev->handle, 250);
+        }
+      else
 #endif
         {
         fd_set setl;
@@ -1783,10 +2667,10 @@ while (dev->handle) {
         if (1) {
           struct pcap_pkthdr header;
           int len;
-          u_char buf[ETH_MAX_JUMBO_FRAME];
+          u_char buf[ETH_MAX_TAP_FRAME];
 
           memset(&header, 0, sizeof(header));
-          len = read(dev->fd_handle, buf, sizeof(buf));
+          len = _eth_tap_read(dev, buf, sizeof(buf));
           if (len > 0) {
             status = 1;
             header.caplen = header.len = len;
@@ -1830,6 +2714,16 @@ while (dev->handle) {
         status = 1;
         break;
 #endif /* HAVE_SLIRP_NETWORK */
+#ifdef HAVE_AF_PACKET_NETWORK
+      case ETH_API_AFPKT:
+        status = _eth_afpkt_dispatch (dev, -1);
+        break;
+#endif /* HAVE_AF_PACKET_NETWORK */
+#ifdef HAVE_SHM_NETWORK
+      case ETH_API_SHM:
+        status = _eth_shm_dispatch (dev, -1);
+        break;
+#endif /* HAVE_SHM_NETWORK */
       case ETH_API_UDP:
         if (1) {
           struct pcap_pkthdr header;
@@ -1855,45 +2749,187 @@ while (dev->handle) {
     if ((status > 0) && (dev->asynch_io)) {
       int wakeup_needed;
 
-      pthread_mutex_lock (&dev->lock);
-      wakeup_needed = (dev->read_queue.count != 0);
-      pthread_mutex_unlock (&dev->lock);
-      if (wakeup_needed) {
-        sim_debug(dev->dbit, dev->dptr, "Queueing automatic poll\n");
-        sim_activate_abs (dev->dptr->units, dev->asynch_io_latency);
+      pthread_mutex_lock (&dev->lock);
+      wakeup_needed = (dev->read_queue.count != 0);
+      pthread_mutex_unlock (&dev->lock);
+      if (wakeup_needed) {
+        sim_debug(dev->dbit, dev->dptr, "Queueing automatic poll\n");
+        sim_activate_abs (dev->dptr->units, dev->asynch_io_latency);
+        }
+      }
+    if (status < 0) {
+      ++dev->receive_packet_errors;
+      _eth_error (dev, "_eth_reader");
+      if (dev->handle) { /* Still attached? */
+#if defined (_WIN32)
+        hWait = (dev->eth_api == ETH_API_PCAP) ? pcap_getevent ((pcap_t*)dev->handle) : NULL;
+#endif
+        if (do_select) {
+          select_fd = dev->fd_handle;
+#if !defined (_WIN32) && defined(HAVE_PCAP_NETWORK)
+          if (dev->eth_api == ETH_API_PCAP)
+            select_fd = pcap_get_selectable_fd((pcap_t *)dev->handle);
+#endif
+          }
+        }
+      }
+    }
+  }
+
+sim_debug(dev->dbit, dev->dptr, "Reader Thread Exiting\n");
+return NULL;
+}
+
+/* Apply the transmit throttle (if enabled) ahead of sending a packet */
+static void
+_eth_write_throttle (ETH_DEV* dev)
+{
+uint32 packet_delta_time;
+
+if (dev->throttle_delay == ETH_THROT_DISABLED_DELAY)
+  return;
+packet_delta_time = sim_os_msec() - dev->throttle_packet_time;
+dev->throttle_events <<= 1;
+dev->throttle_events += (packet_delta_time < dev->throttle_time) ? 1 : 0;
+if ((dev->throttle_events & dev->throttle_mask) == dev->throttle_mask) {
+  sim_os_ms_sleep (dev->throttle_delay);
+  ++dev->throttle_count;
+  }
+dev->throttle_packet_time = sim_os_msec();
+}
+
+#if defined(HAVE_SENDMMSG) || defined(HAVE_AF_PACKET_NETWORK)
+#define ETH_WRITE_BATCH_MAX 64                  /* packets gathered per run */
+
+/* Can this packet be sent as part of a gathered run? */
+static int
+_eth_write_batchable (ETH_DEV* dev, ETH_PACK* packet)
+{
+switch (dev->eth_api) {
+#if defined(HAVE_SENDMMSG)
+  case ETH_API_UDP:
+#endif
+#if defined(HAVE_AF_PACKET_NETWORK)
+  case ETH_API_AFPKT:
+#endif
+    break;
+  default:
+    return FALSE;
+  }
+/* Loopback frames need the per packet bookkeeping done in _eth_write() */
+return ((dev->throttle_delay == ETH_THROT_DISABLED_DELAY) &&
+        (packet->len >= ETH_MIN_PACKET) &&
+        (packet->len <= ETH_MAX_PACKET) &&
+        (!LOOPBACK_SELF_FRAME(packet->msg, packet->msg)) &&
+        (!LOOPBACK_PHYSICAL_RESPONSE(dev, packet->msg)));
+}
+
+/* Send a gathered run of ordinary (non loopback) packets with as few
+   system calls as possible.  Whatever the batched call didn't take is
+   sent a packet at a time, so only frames which really fail are counted
+   as errors. */
+static void
+_eth_write_run (ETH_DEV* dev, ETH_WRITE_REQUEST **run, int count)
+{
+int i, sent = 0;
+t_stat status = SCPE_OK;
+
+switch (dev->eth_api) {
+#if defined(HAVE_SENDMMSG)
+  case ETH_API_UDP:
+    if (1) {
+      struct mmsghdr msgs[ETH_WRITE_BATCH_MAX];
+      struct iovec iovs[ETH_WRITE_BATCH_MAX];
+
+      memset (msgs, 0, count * sizeof (*msgs));
+      for (i = 0; i < count; i++) {
+        iovs[i].iov_base = run[i]->packet.msg;
+        iovs[i].iov_len = run[i]->packet.len;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+      while (sent < count) {
+        int status = sendmmsg (dev->fd_handle, &msgs[sent], count - sent, 0);
+
+        if (status <= 0)
+          break;
+        sent += status;
         }
       }
-    if (status < 0) {
-      ++dev->receive_packet_errors;
-      _eth_error (dev, "_eth_reader");
-      if (dev->handle) { /* Still attached? */
-#if defined (_WIN32)
-        hWait = (dev->eth_api == ETH_API_PCAP) ? pcap_getevent ((pcap_t*)dev->handle) : NULL;
+    break;
 #endif
-        if (do_select) {
-          select_fd = dev->fd_handle;
-#if !defined (_WIN32) && defined(HAVE_PCAP_NETWORK)
-          if (dev->eth_api == ETH_API_PCAP)
-            select_fd = pcap_get_selectable_fd((pcap_t *)dev->handle);
+#if defined(HAVE_AF_PACKET_NETWORK)
+  case ETH_API_AFPKT:
+    for (i = 0; i < count; i++) {
+      if (_eth_afpkt_send ((ETH_AFPKT *)dev->handle, run[i]->packet.msg, run[i]->packet.len, FALSE))
+        break;
+      }
+    sent = i;                   /* frames in the ring go out with a later flush if this one fails */
+    _eth_afpkt_flush ((ETH_AFPKT *)dev->handle);
+    break;
 #endif
-          }
-        }
+  }
+for (i = 0; i < sent; i++)
+  eth_packet_trace (dev, run[i]->packet.msg, run[i]->packet.len, "writing");
+dev->packets_sent += sent;
+for (i = sent; i < count; i++) {     /* short or failed batch */
+  if (_eth_write (dev, &run[i]->packet, NULL) != SCPE_OK)
+    status = SCPE_IOERR;
+  }
+dev->write_status = status;
+}
+#endif /* HAVE_SENDMMSG || HAVE_AF_PACKET_NETWORK */
+
+/* Write a batch of queued requests in order.  The last request in the
+   batch is returned so that the whole chain can be freed at once. */
+static ETH_WRITE_REQUEST *
+_eth_write_batch (ETH_DEV* dev, ETH_WRITE_REQUEST *batch)
+{
+ETH_WRITE_REQUEST *request, *last = NULL;
+#if defined(ETH_WRITE_BATCH_MAX)
+ETH_WRITE_REQUEST *run[ETH_WRITE_BATCH_MAX];
+int run_count = 0;
+#endif
+
+for (request = batch; request != NULL; request = request->next) {
+  last = request;
+  if (dev->handle == NULL)      /* Shutting down? */
+    continue;
+#if defined(ETH_WRITE_BATCH_MAX)
+  /* Gather ordinary frames into runs.  Any gathered run is flushed ahead
+     of a frame which must be sent by itself to preserve the packet order. */
+  if (_eth_write_batchable (dev, &request->packet)) {
+    run[run_count++] = request;
+    if (run_count == ETH_WRITE_BATCH_MAX) {
+      _eth_write_run (dev, run, run_count);
+      run_count = 0;
       }
+    continue;
+    }
+  if (run_count) {
+    _eth_write_run (dev, run, run_count);
+    run_count = 0;
     }
+#endif
+  _eth_write_throttle (dev);
+  dev->write_status = _eth_write(dev, &request->packet, NULL);
   }
-
-sim_debug(dev->dbit, dev->dptr, "Reader Thread Exiting\n");
-return NULL;
+#if defined(ETH_WRITE_BATCH_MAX)
+if (run_count && (dev->handle != NULL))
+  _eth_write_run (dev, run, run_count);
+#endif
+return last;
 }
 
 static void *
 _eth_writer(void *arg)
 {
 ETH_DEV* volatile dev = (ETH_DEV*)arg;
-ETH_WRITE_REQUEST *request;
+ETH_WRITE_REQUEST *batch, *last;
+int batch_size;
 
-/* Boost Priority for this I/O thread vs the CPU instruction execution 
-   thread which in general won't be readily yielding the processor when 
+/* Boost Priority for this I/O thread vs the CPU instruction execution
+   thread which in general won't be readily yielding the processor when
    this thread needs to run */
 sim_os_set_thread_priority (PRIORITY_ABOVE_NORMAL);
 
@@ -1902,29 +2938,24 @@ sim_debug(dev->dbit, dev->dptr, "Writer Thread Starting\n");
 pthread_mutex_lock (&dev->writer_lock);
 while (dev->handle) {
   pthread_cond_wait (&dev->writer_cond, &dev->writer_lock);
-  while (NULL != (request = dev->write_requests)) {
+  while (NULL != (batch = dev->write_requests)) {
     if (dev->handle == NULL)      /* Shutting down? */
       break;
-    /* Pull buffer off request list */
-    dev->write_requests = request->next;
+    /* Pull every pending request off the request list at once */
+    batch_size = dev->write_queue_size;
+    dev->write_requests = dev->write_requests_tail = NULL;
+    dev->write_queue_size = 0;
+    ++dev->write_batches;
+    if (batch_size > dev->write_batch_peak)
+      dev->write_batch_peak = batch_size;
     pthread_mutex_unlock (&dev->writer_lock);
 
-    if (dev->throttle_delay != ETH_THROT_DISABLED_DELAY) {
-      uint32 packet_delta_time = sim_os_msec() - dev->throttle_packet_time;
-      dev->throttle_events <<= 1;
-      dev->throttle_events += (packet_delta_time < dev->throttle_time) ? 1 : 0;
-      if ((dev->throttle_events & dev->throttle_mask) == dev->throttle_mask) {
-        sim_os_ms_sleep (dev->throttle_delay);
-        ++dev->throttle_count;
-        }
-      dev->throttle_packet_time = sim_os_msec();
-      }
-    dev->write_status = _eth_write(dev, &request->packet, NULL);
+    last = _eth_write_batch (dev, batch);
 
     pthread_mutex_lock (&dev->writer_lock);
-    /* Put buffer on free buffer list */
-    request->next = dev->write_buffers;
-    dev->write_buffers = request;
+    /* Put the whole batch on the free buffer list */
+    last->next = dev->write_buffers;
+    dev->write_buffers = batch;
     }
   }
 pthread_mutex_unlock (&dev->writer_lock);
@@ -1992,7 +3023,53 @@ if (bufsz < ETH_MAX_JUMBO_FRAME)
 
 /* attempt to connect device */
 memset(errbuf, 0, PCAP_ERRBUF_SIZE);
-if (0 == strncmp("tap:", savname, 4)) {
+if (0 == strncmp("afpacket:", savname, 9)) {
+  const char *devname = savname + 9;
+
+  while (isspace(*devname))
+      ++devname;
+#if defined(HAVE_AF_PACKET_NETWORK)
+  if (!strcmp(savname, "afpacket:ifname"))
+    return sim_messagef (SCPE_OPENERR, "Eth: Must specify actual host interface name (i.e. afpacket:eth0)\n");
+  if (1) {
+    ETH_AFPKT *afp = _eth_afpkt_open (devname, errbuf);
+
+    if (afp) {
+      /* Start with the device's current filter.  That matches nothing on
+         a fresh open and reinstates the filter when reopening after errors */
+      if (opaque)
+        _eth_afpkt_attach_filter (afp->fd, (ETH_DEV *)opaque);
+      *eth_api = ETH_API_AFPKT;
+      *handle = (void *)afp;
+      *fd_handle = afp->fd;
+      }
+    }
+#else
+  strlcpy(errbuf, "No support for afpacket: network devices", PCAP_ERRBUF_SIZE);
+#endif /* defined(HAVE_AF_PACKET_NETWORK) */
+  }
+else if (0 == strncmp("shm:", savname, 4)) {
+  const char *switchname = savname + 4;
+
+  while (isspace(*switchname))
+      ++switchname;
+#if defined(HAVE_SHM_NETWORK)
+  if (!strcmp(savname, "shm:switchname"))
+    return sim_messagef (SCPE_OPENERR, "Eth: Must specify a switch name (i.e. shm:cluster)\n");
+  if (1) {
+    ETH_SHM *shm = _eth_shm_open (switchname, errbuf);
+
+    if (shm) {
+      *eth_api = ETH_API_SHM;
+      *handle = (void *)shm;
+      sim_debug (dbit, dptr, "Attached to port %d of shared memory switch %s\n", shm->port, shm->name);
+      }
+    }
+#else
+  strlcpy(errbuf, "No support for shm: network devices", PCAP_ERRBUF_SIZE);
+#endif /* defined(HAVE_SHM_NETWORK) */
+  }
+else if (0 == strncmp("tap:", savname, 4)) {
   int  tun = -1;    /* TUN/TAP Socket */
   int  on = 1;
   const char *devname = savname + 4;
@@ -2006,14 +3083,32 @@ if (0 == strncmp("tap:", savname, 4)) {
 #if (defined(__linux) || defined(__linux__)) && defined(HAVE_TAP_NETWORK)
   if ((tun = open("/dev/net/tun", O_RDWR)) >= 0) {
     struct ifreq ifr; /* Interface Requests */
+    unsigned int features = 0;
+    int status;
 
     memset(&ifr, 0, sizeof(ifr));
     /* Set up interface flags */
     strcpy(ifr.ifr_name, devname);
     ifr.ifr_flags = IFF_TAP|IFF_NO_PI;
+#if defined(HAVE_TAP_VNET_HDR)
+    /* When the driver supports it, have each frame carry a virtio-net 
+       header so that the host can pass us frames with partial checksums
+       and large TCP segments (see _eth_tap_read()) */
+    if ((0 == ioctl(tun, TUNGETFEATURES, &features)) && (features & IFF_VNET_HDR))
+      ifr.ifr_flags |= IFF_VNET_HDR;
+#endif
 
     /* Send interface requests to TUN/TAP driver. */
-    if (ioctl(tun, TUNSETIFF, &ifr) >= 0) {
+    status = ioctl(tun, TUNSETIFF, &ifr);
+#if defined(IFF_MULTI_QUEUE)
+    /* A persistent tap created with multiple queues (ip tuntap add ... 
+       multi_queue) can only be attached to as one of its queues */
+    if ((status < 0) && (errno == EINVAL) && (features & IFF_MULTI_QUEUE)) {
+      ifr.ifr_flags |= IFF_MULTI_QUEUE;
+      status = ioctl(tun, TUNSETIFF, &ifr);
+      }
+#endif
+    if (status >= 0) {
       if (ioctl(tun, FIONBIO, &on)) {
         strlcpy(errbuf, strerror(errno), PCAP_ERRBUF_SIZE);
         close(tun);
@@ -2021,6 +3116,22 @@ if (0 == strncmp("tap:", savname, 4)) {
       else {
         *fd_handle = tun;
         strcpy(savname, ifr.ifr_name);
+#if defined(HAVE_TAP_VNET_HDR)
+        if (opaque) {
+          ETH_DEV *dev = (ETH_DEV *)opaque;
+
+          dev->tap_vnet_hdr = ((ifr.ifr_flags & IFF_VNET_HDR) != 0);
+          dev->tap_offloads = 0;
+          /* Accept unchecksummed frames and large IPv4 TCP segments */
+          if (dev->tap_vnet_hdr) {
+            if (0 == ioctl(tun, TUNSETOFFLOAD, TUN_F_CSUM|TUN_F_TSO4))
+              dev->tap_offloads = TUN_F_CSUM|TUN_F_TSO4;
+            else
+              if (0 == ioctl(tun, TUNSETOFFLOAD, TUN_F_CSUM))
+                dev->tap_offloads = TUN_F_CSUM;
+            }
+          }
+#endif
         }
       }
     else
@@ -2269,6 +3380,7 @@ if (bufsz < ETH_MAX_JUMBO_FRAME)
 
 /* initialize device */
 eth_zero(dev);
+_eth_crc32_init();                      /* CRC tables, before any thread uses them */
 
 /* translate name of type "ethX" to real device name */
 if ((strlen(name) == 4)
@@ -2386,6 +3498,16 @@ switch (eth_api) {
   case ETH_API_UDP:
     sim_close_sock(pcap_fd);
     break;
+#ifdef HAVE_AF_PACKET_NETWORK
+  case ETH_API_AFPKT:
+    _eth_afpkt_close((ETH_AFPKT *)pcap);
+    break;
+#endif
+#ifdef HAVE_SHM_NETWORK
+  case ETH_API_SHM:
+    _eth_shm_close((ETH_SHM *)pcap);
+    break;
+#endif
   }
 return SCPE_OK;
 }
@@ -2464,6 +3586,12 @@ fprintf (st, "    eth2   vde:device{:switch-port-number}      (Integrated VDE su
 fprintf (st, "    eth3   nat:{optional-nat-parameters}        (Integrated NAT (SLiRP) support)\n");
 #endif
 fprintf (st, "    eth4   udp:sourceport:remotehost:remoteport (Integrated UDP bridge support)\n");
+#if defined(HAVE_AF_PACKET_NETWORK)
+fprintf (st, "    eth5   afpacket:ifname                      (Integrated Linux AF_PACKET (TPACKET_V3) support)\n");
+#endif
+#if defined(HAVE_SHM_NETWORK)
+fprintf (st, "    eth6   shm:switchname                       (Integrated shared memory virtual switch)\n");
+#endif
 fprintf (st, "   sim> ATTACH %s eth0\n\n", dptr->name);
 fprintf (st, "or equivalently:\n\n");
 fprintf (st, "   sim> ATTACH %s en0\n\n", dptr->name);
@@ -2681,6 +3809,12 @@ switch (dev->eth_api) {
   case ETH_API_NAT:
       netname = "nat";
       break;
+  case ETH_API_AFPKT:
+      netname = "afpacket";
+      break;
+  case ETH_API_SHM:
+      netname = "shm";
+      break;
   }
 sprintf(msg, "%s(%s): ", where, netname);
 switch (dev->eth_api) {
@@ -2786,7 +3920,7 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
 #endif
 #ifdef HAVE_TAP_NETWORK
     case ETH_API_TAP:
-      status = (((int)packet->len == write(dev->fd_handle, (void *)packet->msg, packet->len)) ? 0 : -1);
+      status = (((int)packet->len == _eth_tap_write(dev, packet->msg, packet->len)) ? 0 : -1);
       break;
 #endif
 #ifdef HAVE_VDE_NETWORK
@@ -2813,6 +3947,16 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
     case ETH_API_UDP:
       status = (((int32)packet->len == sim_write_sock (dev->fd_handle, (char *)packet->msg, (int32)packet->len)) ? 0 : -1);
       break;
+#ifdef HAVE_AF_PACKET_NETWORK
+    case ETH_API_AFPKT:
+      status = _eth_afpkt_send ((ETH_AFPKT *)dev->handle, packet->msg, packet->len, TRUE);
+      break;
+#endif
+#ifdef HAVE_SHM_NETWORK
+    case ETH_API_SHM:
+      status = _eth_shm_send ((ETH_SHM *)dev->handle, packet->msg, packet->len);
+      break;
+#endif
     }
   ++dev->packets_sent;              /* basic bookkeeping */
   /* On error, correct loopback bookkeeping */
@@ -2844,7 +3988,6 @@ t_stat eth_write(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
 {
 #ifdef USE_READER_THREAD
 ETH_WRITE_REQUEST *request;
-int write_queue_size = 1;
 
 /* make sure device exists */
 if ((!dev) || (dev->eth_api == ETH_API_NONE)) return SCPE_UNATT;
@@ -2868,20 +4011,13 @@ memcpy(request->packet.msg, packet->msg, packet->len);
 /* packets make it to the wire in the order they were presented here) */
 pthread_mutex_lock (&dev->writer_lock);
 request->next = NULL;
-if (dev->write_requests) {
-  ETH_WRITE_REQUEST *last_request = dev->write_requests;
-
-  ++write_queue_size;
-  while (last_request->next) {
-    last_request = last_request->next;
-    ++write_queue_size;
-    }
-  last_request->next = request;
-  }
+if (dev->write_requests_tail)
+  dev->write_requests_tail->next = request;
 else
-    dev->write_requests = request;
-if (write_queue_size > dev->write_queue_peak)
-  dev->write_queue_peak = write_queue_size;
+  dev->write_requests = request;
+dev->write_requests_tail = request;
+if (++dev->write_queue_size > dev->write_queue_peak)
+  dev->write_queue_peak = dev->write_queue_size;
 pthread_mutex_unlock (&dev->writer_lock);
 
 /* Awaken writer thread to perform actual write */
@@ -2896,13 +4032,21 @@ return _eth_write(dev, packet, routine);
 #endif
 }
 
-static int
-_eth_hash_lookup(ETH_MULTIHASH hash, const u_char* data)
+/* Expand the AUTODIN II multicast hash into one flag per CRC derived key
+   so that each received multicast frame costs one MAC CRC and a lookup */
+static void
+_eth_hash_keys(ETH_MULTIHASH hash, uint8 *keys)
 {
-int key = 0x3f & (eth_crc32(0, data, 6) >> 26);
+int key;
+
+for (key = 0; key < 64; key++)
+  keys[key ^ 0x3f] = ((hash[key>>3] & (1 << (key&0x7))) != 0);
+}
 
-key ^= 0x3f;
-return (hash[key>>3] & (1 << (key&0x7)));
+static int
+_eth_hash_lookup(ETH_DEV* dev, const u_char* data)
+{
+return dev->hash_keys[_eth_crc32_mac(data) >> 26];
 }
 
 #if 0
@@ -3079,6 +4223,99 @@ sum += (sum >> 16);
 return (uint16)(~sum);
 }
 
+#if defined(HAVE_TAP_NETWORK)
+/* Complete a checksum the host left for the NIC to compute.  The host has
+   already stored the pseudo header sum at csum_start + csum_offset, so 
+   folding in everything from csum_start onward yields the final value. */
+static int
+_eth_complete_partial_csum(u_char* msg, size_t len, size_t csum_start, size_t csum_offset)
+{
+uint16 sum;
+
+if ((csum_start < 14) ||                                /* inside the Ethernet header? */
+    ((csum_start + csum_offset + sizeof(sum)) > len))
+  return 0;
+sum = ip_checksum((uint16 *)&msg[csum_start], (int)(len - csum_start));
+if (sum == 0)
+  sum = 0xFFFF;
+memcpy(&msg[csum_start + csum_offset], &sum, sizeof(sum));
+return 1;
+}
+
+static int
+_eth_tap_read(ETH_DEV* dev, u_char* buf, size_t size)
+{
+#if defined(HAVE_TAP_VNET_HDR)
+if (dev->tap_vnet_hdr) {
+  struct virtio_net_hdr vnet;
+  struct iovec iov[3];
+  u_char spill;
+  int len;
+
+  iov[0].iov_base = &vnet;
+  iov[0].iov_len = sizeof(vnet);
+  iov[1].iov_base = buf;
+  iov[1].iov_len = size;
+  iov[2].iov_base = &spill;                 /* anything here didn't fit */
+  iov[2].iov_len = sizeof(spill);
+  len = readv(dev->fd_handle, iov, 3);
+  if (len <= 0)
+    return len;
+  if (len < (int)sizeof(vnet))
+    return 0;
+  len -= sizeof(vnet);
+  if ((size_t)len > size) {
+    ++dev->jumbo_truncated;
+    return 0;
+    }
+  switch (vnet.gso_type & ~VIRTIO_NET_HDR_GSO_ECN) {
+    case VIRTIO_NET_HDR_GSO_NONE:
+      break;
+    case VIRTIO_NET_HDR_GSO_TCPV4:
+      if (dev->tap_offloads & TUN_F_TSO4)
+        break;
+      /* fall through */
+    default:                                /* an offload we didn't ask for */
+      ++dev->jumbo_dropped;
+      return 0;
+    }
+  /* Large segments are resegmented (with fresh checksums) on the jumbo 
+     frame path in _eth_callback(), so only complete checksums here on 
+     frames which will be delivered as they are */
+  if ((vnet.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) &&
+      (vnet.gso_type == VIRTIO_NET_HDR_GSO_NONE) &&
+      (len <= ETH_MIN_JUMBO_FRAME) &&
+      _eth_complete_partial_csum(buf, len, vnet.csum_start, vnet.csum_offset))
+    ++dev->offload_csum_completed;
+  return len;
+  }
+#endif
+return read(dev->fd_handle, buf, size);
+}
+
+static int
+_eth_tap_write(ETH_DEV* dev, const u_char* msg, size_t len)
+{
+#if defined(HAVE_TAP_VNET_HDR)
+if (dev->tap_vnet_hdr) {
+  /* Simulated NICs produce complete frames, so the header is all zero */
+  struct virtio_net_hdr vnet;
+  struct iovec iov[2];
+  int status;
+
+  memset(&vnet, 0, sizeof(vnet));
+  iov[0].iov_base = &vnet;
+  iov[0].iov_len = sizeof(vnet);
+  iov[1].iov_base = (void *)msg;
+  iov[1].iov_len = len;
+  status = writev(dev->fd_handle, iov, 2);
+  return (status < (int)sizeof(vnet)) ? -1 : status - (int)sizeof(vnet);
+  }
+#endif
+return write(dev->fd_handle, (void *)msg, len);
+}
+#endif /* HAVE_TAP_NETWORK */
+
 static void
 _eth_fix_ip_jumbo_offload(ETH_DEV* dev, u_char* msg, int len)
 {
@@ -3387,6 +4624,32 @@ eth_packet_trace(dev, response.msg, response.len, ((function == 1) ? "loopbackre
 return 1;
 }
 
+/* Frames are recorded and replayed (see sim_evlog_packet) one at a time 
+   where they are handed to the device, so a replay gives the device the 
+   recorded frames in place of whatever arrives from the network */
+
+static const char *_eth_evlog_source (ETH_DEV *dev)
+{
+return dev->dptr ? sim_dname (dev->dptr) : "ETH";
+}
+
+static int _eth_evlog_replay (ETH_DEV *dev, ETH_PACK *packet, ETH_PCALLBACK routine)
+{
+int32 len = sim_evlog_packet (_eth_evlog_source (dev), packet->msg, 0, ETH_FRAME_SIZE - ETH_CRC_SIZE);
+
+if (len <= 0) {
+  packet->len = 0;
+  return 0;
+  }
+packet->len = (uint32)len;
+packet->crc_len = dev->need_crc ? eth_add_packet_crc32 (packet->msg, packet->len) : 0;
+eth_packet_trace (dev, packet->msg, packet->len, "replayed");
+++dev->packets_received;
+if (routine)
+  routine(0);
+return 1;
+}
+
 static void
 _eth_callback(u_char* info, const struct pcap_pkthdr* header, const u_char* data)
 {
@@ -3416,13 +4679,15 @@ switch (dev->eth_api) {
     to_me = 1;
     /* AUTODIN II hash mode? */
     if ((dev->hash_filter) && (data[0] & 0x01) && (!dev->promiscuous) && (!dev->all_multicast))
-      to_me = _eth_hash_lookup(dev->hash, data);
+      to_me = _eth_hash_lookup(dev, data);
     break;
 #endif /* USE_BPF */
   case ETH_API_TAP:
   case ETH_API_VDE:
   case ETH_API_UDP:
   case ETH_API_NAT:
+  case ETH_API_AFPKT:
+  case ETH_API_SHM:
     bpf_used = 0;
     to_me = 0;
     eth_packet_trace (dev, data, header->len, "received");
@@ -3440,7 +4705,7 @@ switch (dev->eth_api) {
 
     /* AUTODIN II hash mode? */
     if ((dev->hash_filter) && (!to_me) && (data[0] & 0x01))
-      to_me = _eth_hash_lookup(dev->hash, data);
+      to_me = _eth_hash_lookup(dev, data);
     break;
   default:
     bpf_used = to_me = 0;                           /* Should NEVER happen */
@@ -3515,6 +4780,8 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
     free(moved_data);
     }
 #else /* !USE_READER_THREAD */
+  if (sim_evlog_replaying ())         /* replaced by the recorded frames */
+    return;
   /* set data in passed read packet */
   dev->read_packet->len = header->len;
   memcpy(dev->read_packet->msg, data, header->len);
@@ -3537,6 +4804,9 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
 
   eth_packet_trace (dev, dev->read_packet->msg, dev->read_packet->len, "reading");
 
+  if (sim_evlog_active ())
+    sim_evlog_packet (_eth_evlog_source (dev), dev->read_packet->msg, (int32)dev->read_packet->len, (int32)dev->read_packet->len);
+
   ++dev->packets_received;
 
   /* call optional read callback function */
@@ -3578,10 +4848,10 @@ do {
       if (1) {
         struct pcap_pkthdr header;
         int len;
-        u_char buf[ETH_MAX_JUMBO_FRAME];
+        u_char buf[ETH_MAX_TAP_FRAME];
 
         memset(&header, 0, sizeof(header));
-        len = read(dev->fd_handle, buf, sizeof(buf));
+        len = _eth_tap_read(dev, buf, sizeof(buf));
         if (len > 0) {
           status = 1;
           header.caplen = header.len = len;
@@ -3640,12 +4910,24 @@ do {
           }
         }
       break;
+#ifdef HAVE_AF_PACKET_NETWORK
+    case ETH_API_AFPKT:
+      status = _eth_afpkt_dispatch (dev, 1);
+      break;
+#endif
+#ifdef HAVE_SHM_NETWORK
+    case ETH_API_SHM:
+      status = _eth_shm_dispatch (dev, 1);
+      break;
+#endif
     }
   } while ((status > 0) && (0 == packet->len));
 if (status < 0) {
   ++dev->receive_packet_errors;
   _eth_error (dev, "eth_reader");
   }
+if (sim_evlog_replaying ())
+  status = _eth_evlog_replay (dev, packet, routine);
 
 #else /* USE_READER_THREAD */
 
@@ -3660,8 +4942,14 @@ if (status < 0) {
     ethq_remove(&dev->read_queue);
   }
   pthread_mutex_unlock (&dev->lock);  
-  if ((status) && (routine))
-    routine(0);
+  if (sim_evlog_replaying ())               /* live frame dropped */
+    status = _eth_evlog_replay (dev, packet, routine);
+  else {
+    if ((status) && (sim_evlog_active ()))
+      sim_evlog_packet (_eth_evlog_source (dev), packet->msg, (int32)packet->len, (int32)packet->len);
+    if ((status) && (routine))
+      routine(0);
+    }
 #endif
 
 return status;
@@ -3807,6 +5095,7 @@ dev->promiscuous   = promiscuous;
 dev->hash_filter = (hash != NULL);
 if (hash) {
   memcpy(dev->hash, hash, sizeof(*hash));
+  _eth_hash_keys(dev->hash, dev->hash_keys);
   sim_debug(dev->dbit, dev->dptr, "Multicast Hash: %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X\n",
                                   dev->hash[0], dev->hash[1], dev->hash[2], dev->hash[3], 
                                   dev->hash[4], dev->hash[5], dev->hash[6], dev->hash[7]);
@@ -3848,6 +5137,18 @@ eth_bpf_filter (dev, dev->addr_count, dev->filter_address,
                 dev->have_host_nic_phy_addr ? &dev->host_nic_phy_hw_addr: NULL,
                 (dev->hash_filter ? &dev->hash : NULL), buf);
 
+#ifdef HAVE_AF_PACKET_NETWORK
+if (dev->eth_api == ETH_API_AFPKT) {
+  if (_eth_afpkt_attach_filter (dev->fd_handle, dev))
+    sim_printf ("Eth: SO_ATTACH_FILTER error: %s\n", strerror (errno));
+#ifdef USE_READER_THREAD
+  pthread_mutex_lock (&dev->lock);
+  ethq_clear (&dev->read_queue); /* Empty FIFO Queue when filter list changes */
+  pthread_mutex_unlock (&dev->lock);
+#endif
+  }
+#endif /* HAVE_AF_PACKET_NETWORK */
+
 /* get netmask, which is a required argument for compiling.  The value, 
    in our case isn't actually interesting since the filters we generate 
    aren't referencing IP fields, networks or values */
@@ -4026,6 +5327,22 @@ if (used < max) {
   ++used;
   }
 #endif
+#ifdef HAVE_AF_PACKET_NETWORK
+if (used < max) {
+  sprintf(list[used].name, "%s", "afpacket:ifname");
+  sprintf(list[used].desc, "%s", "Integrated Linux AF_PACKET (TPACKET_V3) support");
+  list[used].eth_api = ETH_API_AFPKT;
+  ++used;
+  }
+#endif
+#ifdef HAVE_SHM_NETWORK
+if (used < max) {
+  sprintf(list[used].name, "%s", "shm:switchname");
+  sprintf(list[used].desc, "%s", "Integrated shared memory virtual switch");
+  list[used].eth_api = ETH_API_SHM;
+  ++used;
+  }
+#endif
 
 if (used < max) {
   sprintf(list[used].name, "%s", "udp:sourceport:remotehost:remoteport");
@@ -4102,6 +5419,13 @@ if (dev->jumbo_fragmented)
   fprintf(st, "  Jumbo Fragmented:        %d\n", dev->jumbo_fragmented);
 if (dev->jumbo_truncated)
   fprintf(st, "  Jumbo Truncated:         %d\n", dev->jumbo_truncated);
+#if defined(HAVE_TAP_VNET_HDR)
+if (dev->tap_vnet_hdr)
+  fprintf(st, "  TAP Offloads:            %s\n", (dev->tap_offloads & TUN_F_TSO4) ? "Checksum, TSO4" : 
+                                                ((dev->tap_offloads & TUN_F_CSUM) ? "Checksum" : "None"));
+#endif
+if (dev->offload_csum_completed)
+  fprintf(st, "  Offload Checksums Done:  %d\n", dev->offload_csum_completed);
 if (dev->packets_sent)
   fprintf(st, "  Packets Sent:            %d\n", dev->packets_sent);
 if (dev->transmit_packet_errors)
@@ -4124,6 +5448,18 @@ fprintf(st, "  Read Queue: Count:       %d\n", dev->read_queue.count);
 fprintf(st, "  Read Queue: High:        %d\n", dev->read_queue.high);
 fprintf(st, "  Read Queue: Loss:        %d\n", dev->read_queue.loss);
 fprintf(st, "  Peak Write Queue Size:   %d\n", dev->write_queue_peak);
+if (dev->write_batches) {
+  fprintf(st, "  Write Batches:           %d\n", dev->write_batches);
+  fprintf(st, "  Peak Write Batch Size:   %d\n", dev->write_batch_peak);
+  }
+#endif
+#if defined(HAVE_SHM_NETWORK)
+if ((dev->eth_api == ETH_API_SHM) && dev->handle) {
+  ETH_SHM *shm = (ETH_SHM *)dev->handle;
+
+  fprintf(st, "  Switch Port:             %d of %s\n", shm->port, shm->name);
+  fprintf(st, "  Switch Port Drops:       %d\n", shm->seg->port[shm->port].dropped);
+  }
 #endif
 if (dev->bpf_filter)
   fprintf(st, "  BPF Filter: %s\n", dev->bpf_filter);
@@ -4181,9 +5517,131 @@ for (val=0; val <= 0xFF; val++) {
     ++errors;
     }
   }
+if (1) {  /* The table sliced and accelerated CRCs must match a byte at a time CRC */
+  uint8 frame[ETH_MAX_PACKET + 16];
+  size_t len, offset;
+
+  for (len = 0; len < sizeof (frame); len++)
+    frame[len] = (uint8)((len * 151) ^ (len >> 3));
+  for (len = 0; len <= ETH_MAX_PACKET; len += (len < 160) ? 1 : 37) {
+    for (offset = 0; offset < 8; offset += 3) {
+      uint32 expected = 0xFFFFFFFF ^ _eth_crc32_bytewise (0xFFFFFFFF, frame + offset, len);
+
+      if (expected != eth_crc32 (0, frame + offset, len)) {
+        printf("Unexpected CRC for %d byte frame at offset %d. Expected %08X, got %08X\n",
+               (int)len, (int)offset, expected, eth_crc32 (0, frame + offset, len));
+        ++errors;
+        }
+      if ((len == 6) && (expected != _eth_crc32_mac (frame + offset))) {
+        printf("Unexpected MAC CRC at offset %d. Expected %08X, got %08X\n",
+               (int)offset, expected, _eth_crc32_mac (frame + offset));
+        ++errors;
+        }
+      }
+    }
+  }
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Check the multicast hash lookup against a hash computed by a DELQA */
+static
+t_stat eth_test_multicast_hash (DEVICE *dptr)
+{
+ETH_MAC tMacs[] = {
+                   {0xAB, 0x00, 0x04, 0x01, 0xAC, 0x10},
+                   {0xAB, 0x00, 0x00, 0x04, 0x00, 0x00},
+                   {0x09, 0x00, 0x2B, 0x00, 0x00, 0x0F},
+                   {0x09, 0x00, 0x2B, 0x02, 0x01, 0x04},
+                   {0x09, 0x00, 0x2B, 0x02, 0x01, 0x07},
+                   {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+                   {0x01, 0x00, 0x5E, 0x00, 0x00, 0x01}};
+ETH_MULTIHASH thash = {0x01, 0x40, 0x00, 0x00, 0x48, 0x88, 0x40, 0x00};
+ETH_MAC other = {0x09, 0x00, 0x2B, 0x00, 0x00, 0x00};
+ETH_DEV dev;
+int errors = 0;
+int i, key, set = 0;
+
+memset (&dev, 0, sizeof (dev));
+memcpy (dev.hash, thash, sizeof (thash));
+_eth_hash_keys (dev.hash, dev.hash_keys);
+for (key = 0; key < 64; key++)
+  set += dev.hash_keys[key];
+for (i = 0; i < (int)(sizeof (tMacs)/sizeof (tMacs[0])); i++)
+  if (!_eth_hash_lookup (&dev, tMacs[i])) {
+    char mac[20];
+
+    eth_mac_fmt (&tMacs[i], mac);
+    sim_printf ("Multicast hash lookup rejected %s\n", mac);
+    ++errors;
+    }
+if (_eth_hash_lookup (&dev, other)) {
+  sim_printf ("Multicast hash lookup accepted an address not in the hash\n");
+  ++errors;
+  }
+if (set != 7) {
+  sim_printf ("Multicast hash expanded to %d keys, expected 7\n", set);
+  ++errors;
+  }
 return (errors == 0) ? SCPE_OK : SCPE_IERR;
 }
 
+/* Report CRC throughput for typical frame sizes (minimum, DECnet/LAT 
+   sized and maximum) for each CRC implementation when the unit tests 
+   run with -B */
+static
+t_stat eth_bench_crc32 (DEVICE *dptr)
+{
+static const size_t sizes[] = {ETH_MIN_PACKET, 594, ETH_MAX_PACKET};
+const char *names[] = {"Byte", "Slice-8", "Selected"};
+uint8 frame[ETH_MAX_PACKET];
+volatile uint32 sink = 0;
+int s, impl;
+
+if (!sim_test_bench)
+  return SCPE_OK;
+for (s = 0; s < (int)sizeof (frame); s++)
+  frame[s] = (uint8)(s * 13);
+sim_printf ("CRC32 throughput (MB/sec) for %d/%d/%d byte frames%s:\n", 
+            (int)sizes[0], (int)sizes[1], (int)sizes[2],
+#if defined(ETH_CRC32_PCLMUL)
+            crcUsePclmul ? " (Selected is PCLMUL)" : 
+#endif
+            "");
+for (impl = 0; impl < 3; impl++) {
+  char line[128];
+
+  sprintf (line, "  %-10s", names[impl]);
+  for (s = 0; s < (int)(sizeof (sizes)/sizeof (sizes[0])); s++) {
+    uint32 start = sim_os_msec ();
+    uint32 elapsed;
+    double bytes = 0;
+
+    do {
+      int i;
+
+      for (i = 0; i < 1000; i++) {
+        switch (impl) {
+          case 0:
+            sink += _eth_crc32_bytewise (0xFFFFFFFF, frame, sizes[s]);
+            break;
+          case 1:
+            sink += _eth_crc32_slice8 (0xFFFFFFFF, frame, sizes[s]);
+            break;
+          default:
+            sink += eth_crc32 (0, frame, sizes[s]);
+            break;
+          }
+        }
+      bytes += 1000.0 * sizes[s];
+      elapsed = sim_os_msec () - start;
+      } while (elapsed < 20);
+    sprintf (line + strlen (line), " %9.1f", bytes / (elapsed * 1000.0));
+    }
+  sim_printf ("%s\n", line);
+  }
+return SCPE_OK;
+}
+
 static
 t_stat eth_test_bpf (DEVICE *dptr)
 {
@@ -4249,7 +5707,9 @@ for (eth_num=0; eth_num<eth_device_count; eth_num++) {
   if ((0 == memcmp (eth_list[eth_num].name, "nat:", 4)) ||
       (0 == memcmp (eth_list[eth_num].name, "tap:", 4)) ||
       (0 == memcmp (eth_list[eth_num].name, "vde:", 4)) ||
-      (0 == memcmp (eth_list[eth_num].name, "udp:", 4)))
+      (0 == memcmp (eth_list[eth_num].name, "udp:", 4)) ||
+      (0 == memcmp (eth_list[eth_num].name, "afpacket:", 9)) ||
+      (0 == memcmp (eth_list[eth_num].name, "shm:", 4)))
       continue;
   eth_name[sizeof (eth_name)-1] = '\0';
   snprintf (eth_name, sizeof (eth_name)-1, "eth%d", eth_num);
@@ -4328,6 +5788,207 @@ if (bpf_compile_skip_count)
 return (errors == 0) ? SCPE_OK : SCPE_IERR;
 }
 
+#if defined(HAVE_AF_PACKET_NETWORK)
+/* Exercise the kernel filter built for AF_PACKET devices by attaching it 
+   to a datagram socket pair and checking which frames get through */
+static
+t_stat eth_test_afpkt_filter (DEVICE *dptr)
+{
+static struct {
+  ETH_MAC dst;
+  int unicast, all_multicast, promiscuous;
+  } cases[] = {
+  /* destination                             filter set results */
+  {{0xAA, 0x00, 0x04, 0x00, 0x12, 0x34},     1, 1, 1},
+  {{0x08, 0x00, 0x2B, 0x01, 0x02, 0x03},     1, 1, 1},
+  {{0x08, 0x00, 0x2B, 0x01, 0x02, 0x04},     0, 0, 1},
+  {{0xAA, 0x00, 0x04, 0x00, 0x34, 0x12},     0, 0, 1},
+  {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},     1, 1, 1},
+  {{0xAB, 0x00, 0x00, 0x04, 0x00, 0x00},     0, 1, 1},
+  {{0x09, 0x00, 0x2B, 0x00, 0x00, 0x0F},     0, 1, 1},
+  };
+ETH_MAC filter[3] = {{0xAA, 0x00, 0x04, 0x00, 0x12, 0x34},
+                     {0x08, 0x00, 0x2B, 0x01, 0x02, 0x03},
+                     {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+ETH_DEV dev;
+int errors = 0;
+int mode, i;
+
+for (mode = 0; mode < 3; mode++) {
+  int fds[2];
+
+  memset (&dev, 0, sizeof (dev));
+  memcpy (dev.filter_address, filter, sizeof (filter));
+  dev.addr_count = 3;
+  dev.all_multicast = (mode == 1);
+  dev.promiscuous = (mode == 2);
+  if (socketpair (AF_UNIX, SOCK_DGRAM, 0, fds))
+    return sim_messagef (SCPE_IERR, "socketpair: %s\n", strerror (errno));
+  if (_eth_afpkt_attach_filter (fds[1], &dev)) {
+    sim_printf ("SO_ATTACH_FILTER: %s\n", strerror (errno));
+    ++errors;
+    }
+  for (i = 0; i < (int)(sizeof (cases)/sizeof (cases[0])); i++) {
+    uint8 frame[ETH_MIN_PACKET];
+    int expected = (mode == 0) ? cases[i].unicast : 
+                   ((mode == 1) ? cases[i].all_multicast : cases[i].promiscuous);
+    int got;
+
+    memset (frame, 0, sizeof (frame));
+    memcpy (frame, cases[i].dst, sizeof (ETH_MAC));
+    (void)send (fds[0], frame, sizeof (frame), 0);
+    got = (sizeof (frame) == recv (fds[1], frame, sizeof (frame), MSG_DONTWAIT));
+    if (got != expected) {
+      char mac[20];
+
+      eth_mac_fmt (&cases[i].dst, mac);
+      sim_printf ("AF_PACKET filter mode %d: frame to %s was %s\n", mode, mac, got ? "accepted" : "rejected");
+      ++errors;
+      }
+    }
+  close (fds[0]);
+  close (fds[1]);
+  }
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+#endif /* HAVE_AF_PACKET_NETWORK */
+
+#if defined(HAVE_TAP_NETWORK)
+/* Verify that completing a host offloaded (partial) TCP checksum gives
+   the same result as computing the whole checksum locally */
+static
+t_stat eth_test_partial_csum (DEVICE *dptr)
+{
+uint8 frame[ETH_MIN_PACKET + 10];
+struct IPHeader *IP = (struct IPHeader *)&frame[14];
+struct TCPHeader *TCP = (struct TCPHeader *)&frame[34];
+uint16 tcp_len = sizeof (frame) - 34;
+uint16 *addrs = (uint16 *)&IP->source_ip;
+uint16 expected;
+uint32 sum;
+int i;
+
+memset (frame, 0, sizeof (frame));
+frame[12] = 0x08;                           /* IPv4 */
+frame[14] = 0x45;                           /* version 4, 20 byte header */
+IP->total_len = htons (sizeof (frame) - 14);
+IP->proto = IPPROTO_TCP;
+IP->source_ip = htonl (0x0A000001);
+IP->dest_ip = htonl (0x0A000002);
+TCP->data_offset_and_flags = htons (0x5000 | TCP_ACK_FLAG);
+for (i = 54; i < (int)sizeof (frame); i++)
+  frame[i] = (uint8)(i * 7);
+expected = pseudo_checksum (tcp_len, IPPROTO_TCP, addrs, addrs + 2, (uint8 *)TCP);
+/* What the host leaves behind: the uncomplemented pseudo header sum */
+sum = addrs[0] + addrs[1] + addrs[2] + addrs[3] + htons (IPPROTO_TCP) + htons (tcp_len);
+sum = (sum >> 16) + (sum & 0xffff);
+sum += (sum >> 16);
+TCP->checksum = (uint16)sum;
+if ((!_eth_complete_partial_csum (frame, sizeof (frame), 34, 16)) ||
+    (TCP->checksum != expected)) {
+  sim_printf ("Partial checksum completion produced 0x%04X, expected 0x%04X\n", ntohs (TCP->checksum), ntohs (expected));
+  return SCPE_IERR;
+  }
+/* Offsets beyond the frame must be rejected */
+if (_eth_complete_partial_csum (frame, sizeof (frame), sizeof (frame) - 1, 16))
+  return sim_messagef (SCPE_IERR, "Partial checksum completion accepted an out of range offset\n");
+/* as must a start inside the Ethernet header */
+if (_eth_complete_partial_csum (frame, sizeof (frame), 4, 16))
+  return sim_messagef (SCPE_IERR, "Partial checksum completion accepted a start in the Ethernet header\n");
+return SCPE_OK;
+}
+#endif /* HAVE_TAP_NETWORK */
+
+#if defined(HAVE_SHM_NETWORK)
+/* Run frames through a private shared memory switch and check where the
+   switch delivers them */
+static
+t_stat eth_test_shm_switch (DEVICE *dptr)
+{
+char switchname[32];
+char errbuf[PCAP_ERRBUF_SIZE];
+ETH_SHM *port[3];
+uint8 frame[ETH_MIN_PACKET];
+int errors = 0;
+int i, p;
+static const struct {
+  int from;
+  uint8 dst, src;               /* last byte of AA-00-04-00-00-xx (0xFF is broadcast) */
+  int delivered[3];
+  } cases[] = {
+  {0, 0x02, 0x01, {0, 1, 1}},   /* unknown destination floods */
+  {1, 0x01, 0x02, {1, 0, 0}},   /* reply to the learned sender */
+  {0, 0x02, 0x01, {0, 1, 0}},   /* both ends learned */
+  {2, 0xFF, 0x03, {1, 1, 0}},   /* broadcast floods */
+  {1, 0x03, 0x02, {0, 0, 1}},   /* learned from the broadcast */
+  {0, 0x01, 0x01, {0, 0, 0}},   /* destination on the sending port */
+  };
+
+sprintf (switchname, "test-%d", (int)getpid ());
+memset (port, 0, sizeof (port));
+for (p = 0; p < 3; p++)
+  if (NULL == (port[p] = _eth_shm_open (switchname, errbuf))) {
+    sim_printf ("shm: open of port %d failed: %s\n", p, errbuf);
+    ++errors;
+    }
+for (i = 0; (errors == 0) && (i < (int)(sizeof (cases)/sizeof (cases[0]))); i++) {
+  memset (frame, 0, sizeof (frame));
+  memcpy (frame, "\xAA\x00\x04\x00\x00", 5);
+  frame[5] = cases[i].dst;
+  if (cases[i].dst == 0xFF)
+    memset (frame, 0xFF, 6);
+  memcpy (frame + 6, "\xAA\x00\x04\x00\x00", 5);
+  frame[11] = cases[i].src;
+  frame[12] = 0x60;
+  frame[13] = 0x03;
+  frame[14] = (uint8)i;
+  _eth_shm_send (port[cases[i].from], frame, sizeof (frame));
+  for (p = 0; p < 3; p++) {
+    int from = _eth_shm_ready (port[p]);
+    int got = 0;
+
+    while (from >= 0) {         /* Drain (and check) whatever arrived */
+      ETH_SHM_RING *ring = &port[p]->seg->ring[from][port[p]->port];
+      ETH_SHM_SLOT *slot = &ring->slot[ring->head & (ETH_SHM_RING_SLOTS - 1)];
+
+      if ((from == port[cases[i].from]->port) && (slot->len == sizeof (frame)) &&
+          (0 == memcmp (slot->msg, frame, sizeof (frame))))
+        ++got;
+      else
+        got = 2;
+      ++ring->head;
+      from = _eth_shm_ready (port[p]);
+      }
+    if (got != cases[i].delivered[p]) {
+      sim_printf ("shm: case %d: port %d received %d frames, expected %d\n", i, p, got, cases[i].delivered[p]);
+      ++errors;
+      }
+    }
+  }
+/* A full ring drops rather than blocks the sender */
+if (errors == 0) {
+  frame[5] = 0x02;
+  for (i = 0; i < ETH_SHM_RING_SLOTS + 5; i++)
+    _eth_shm_send (port[0], frame, sizeof (frame));
+  if (port[1]->seg->port[port[1]->port].dropped != 5) {
+    sim_printf ("shm: expected 5 dropped frames, found %d\n", port[1]->seg->port[port[1]->port].dropped);
+    ++errors;
+    }
+  }
+for (p = 0; p < 3; p++)
+  _eth_shm_close (port[p]);
+/* The last port to close removes the switch */
+sprintf (errbuf, "%s%s", ETH_SHM_NAME_PREFIX, switchname);
+if ((i = shm_open (errbuf, O_RDWR, 0)) >= 0) {
+  close (i);
+  shm_unlink (errbuf);
+  sim_printf ("shm: switch segment %s was not removed\n", errbuf);
+  ++errors;
+  }
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+#endif /* HAVE_SHM_NETWORK */
+
 #include <setjmp.h>
 
 t_stat sim_ether_test (DEVICE *dptr)
@@ -4337,8 +5998,20 @@ SIM_TEST_INIT;
 
 sim_printf ("Testing %s device sim_ether APIs\n", dptr->name);
 
+_eth_crc32_init ();                     /* as eth_open does */
 SIM_TEST(eth_test_crc32 (dptr));
+SIM_TEST(eth_test_multicast_hash (dptr));
+SIM_TEST(eth_bench_crc32 (dptr));
 SIM_TEST(eth_test_bpf (dptr));
+#if defined(HAVE_AF_PACKET_NETWORK)
+SIM_TEST(eth_test_afpkt_filter (dptr));
+#endif
+#if defined(HAVE_TAP_NETWORK)
+SIM_TEST(eth_test_partial_csum (dptr));
+#endif
+#if defined(HAVE_SHM_NETWORK)
+SIM_TEST(eth_test_shm_switch (dptr));
+#endif
 return stat;
 }
 #endif /* USE_NETWORK */
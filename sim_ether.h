@@ -264,6 +264,8 @@ struct eth_device {
 #define ETH_API_VDE  3                                  /* VDE API in use */
 #define ETH_API_UDP  4                                  /* UDP API in use */
 #define ETH_API_NAT  5                                  /* NAT (SLiRP) API in use */
+#define ETH_API_AFPKT 6                                 /* Linux AF_PACKET API in use */
+#define ETH_API_SHM  7                                  /* Shared memory virtual switch in use */
   ETH_PCALLBACK read_callback;                          /* read callback function */
   ETH_PCALLBACK write_callback;                         /* write callback function */
   ETH_PACK*     read_packet;                            /* read packet */
@@ -273,6 +275,7 @@ struct eth_device {
   ETH_BOOL      all_multicast;                          /* receive all multicast messages */
   ETH_BOOL      hash_filter;                            /* filter using AUTODIN II multicast hash */
   ETH_MULTIHASH hash;                                   /* AUTODIN II multicast hash */
+  uint8         hash_keys[64];                          /* hash expanded: accept flag per CRC key */
   int32         loopback_self_sent;                     /* loopback packets sent but not seen */
   int32         loopback_self_sent_total;               /* total loopback packets sent */
   int32         loopback_self_rcvd_total;               /* total loopback packets seen */
@@ -282,6 +285,9 @@ struct eth_device {
   uint32        jumbo_fragmented;                       /* Giant IPv4 Frames Fragmented */
   uint32        jumbo_dropped;                          /* Giant Frames Dropped */
   uint32        jumbo_truncated;                        /* Giant Frames too big for capture buffer - Dropped */
+  int           tap_vnet_hdr;                           /* tap: frames are preceded by a virtio-net header */
+  int           tap_offloads;                           /* tap: TUN_F_* offloads accepted from the host */
+  uint32        offload_csum_completed;                 /* Partial (offloaded) checksums completed */
   uint32        packets_sent;                           /* Total Packets Sent */
   uint32        packets_received;                       /* Total Packets Received */
   uint32        loopback_packets_processed;             /* Total Loopback Packets Processed */
@@ -320,8 +326,12 @@ struct eth_device {
   pthread_mutex_t     self_lock;
   pthread_cond_t      writer_cond;
   ETH_WRITE_REQUEST *write_requests;
+  ETH_WRITE_REQUEST *write_requests_tail;               /* last queued request (for O(1) append) */
+  int write_queue_size;                                 /* requests currently queued */
   int write_queue_peak;
   ETH_WRITE_REQUEST *write_buffers;
+  uint32 write_batches;                                 /* batches drained by the writer thread */
+  int write_batch_peak;                                 /* largest batch drained */
   t_stat write_status;
 #endif
 };
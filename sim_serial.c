@@ -46,6 +46,7 @@
      sim_read_serial        read from a serial port
      sim_write_serial       write to a serial port
      sim_close_serial       close a serial port
+     sim_serial_fd          return the descriptor to wait on for input
      sim_show_serial        shows the available host serial ports
 
 
@@ -110,6 +111,15 @@
    The serial port indicated by "port" is closed.
 
 
+   int sim_serial_fd (SERHANDLE port)
+   ----------------------------------
+
+   Returns the host descriptor which becomes readable when input arrives on
+   the serial port indicated by "port", so that callers can wait for input on
+   many ports (with select, poll or epoll) instead of reading each one.  -1
+   is returned when the host can't wait on the port this way.
+
+
    int sim_serial_devices (int max, SERIAL_LIST* list)
    ---------------------------------------------------
 
@@ -917,11 +927,38 @@ free (port);
 }
 
 
+/* Return the descriptor to wait on for input */
+
+int sim_serial_fd (SERHANDLE port)
+{
+return -1;
+}
+
+
 
 #elif defined (__unix__) || defined(__APPLE__) || defined(__hpux)
 
+/* Where the host can wait for a modem status change (TIOCMIWAIT), a thread
+   per port sleeps in the kernel until one of the incoming modem signals
+   changes, and keeps a copy of the modem status which sim_control_serial
+   returns without an ioctl.  The copy is also refreshed directly at least
+   every SER_MODEM_REFRESH_MS, so that a change which happens while the
+   watcher is between waits is never missed for long. */
+
+#if defined(SIM_ASYNCH_IO) && defined(TIOCMIWAIT) && defined(TIOCMGET)
+#define SER_MODEM_WAIT
+#define SER_MODEM_REFRESH_MS 1000
+#endif
+
 struct SERPORT {
     int port;
+#if defined(SER_MODEM_WAIT)
+    pthread_t modem_thread;                             /* modem status watcher */
+    t_bool modem_thread_started;
+    volatile t_bool modem_watched;                      /* modem_bits kept current by watcher */
+    volatile int modem_bits;                            /* last TIOCMGET value */
+    volatile uint32 modem_time;                         /* when modem_bits was read */
+#endif
     };
 
 #if defined(__linux) || defined(__linux__)
@@ -933,6 +970,58 @@ struct SERPORT {
 
 /* UNIX implementation */
 
+#if defined(SER_MODEM_WAIT)
+static void *
+_serial_modem_watch (void *arg)
+{
+SERHANDLE port = (SERHANDLE)arg;
+int bits, status, oldtype;
+
+while (1) {
+    pthread_setcanceltype (PTHREAD_CANCEL_ASYNCHRONOUS, &oldtype); /* close cancels the wait */
+    status = ioctl (port->port, TIOCMIWAIT, TIOCM_CTS | TIOCM_DSR | TIOCM_RNG | TIOCM_CAR);
+    pthread_setcanceltype (PTHREAD_CANCEL_DEFERRED, &oldtype);
+    if ((status && (errno != EINTR)) ||                 /* wait not supported (or port gone)? */
+        ioctl (port->port, TIOCMGET, &bits))
+        break;
+    port->modem_bits = bits;
+    port->modem_time = sim_os_msec ();
+    }
+port->modem_watched = FALSE;                            /* status must be read directly */
+return NULL;
+}
+
+static void _serial_modem_watch_start (SERHANDLE port)
+{
+int bits;
+pthread_attr_t attr;
+
+if (ioctl (port->port, TIOCMGET, &bits))                /* no modem signals (i.e. a pty)? */
+    return;
+port->modem_bits = bits;
+port->modem_time = sim_os_msec ();
+port->modem_watched = TRUE;
+pthread_attr_init (&attr);
+pthread_attr_setscope (&attr, PTHREAD_SCOPE_SYSTEM);
+port->modem_thread_started = (0 == pthread_create (&port->modem_thread, &attr, _serial_modem_watch, (void *)port));
+pthread_attr_destroy (&attr);
+if (!port->modem_thread_started)
+    port->modem_watched = FALSE;
+}
+
+static void _serial_modem_watch_stop (SERHANDLE port)
+{
+if (!port->modem_thread_started)
+    return;
+pthread_cancel (port->modem_thread);
+pthread_join (port->modem_thread, NULL);
+port->modem_thread_started = port->modem_watched = FALSE;
+}
+#else
+#define _serial_modem_watch_start(port)
+#define _serial_modem_watch_stop(port)
+#endif
+
 /* Enumerate the available serial ports.
 
    The serial port names generated by attempting to open /dev/ttyS0 thru
@@ -1164,6 +1253,7 @@ if (tcsetattr (port, TCSANOW, &tio)) {                  /* set the terminal attr
 
 serport = (SERHANDLE)calloc (1, sizeof(*serport));
 serport->port = port;
+_serial_modem_watch_start (serport);
 return serport;                                         /* return port fd for success */
 }
 
@@ -1294,10 +1384,22 @@ if (bits_to_clear) {
         }
     }
 if (incoming_bits) {
+#if defined(SER_MODEM_WAIT)
+    if ((port->modem_watched) &&                    /* watcher has current status? */
+        ((sim_os_msec () - port->modem_time) < SER_MODEM_REFRESH_MS))
+        bits = port->modem_bits;
+    else
+#endif
     if (ioctl (port->port, TIOCMGET, &bits)) {      /* get the modem bits */
         sim_error_serial ("ioctl", errno);          /* report unexpected error */
         return SCPE_IOERR;                          /* return failure status */
         }
+#if defined(SER_MODEM_WAIT)
+    else {
+        port->modem_bits = bits;
+        port->modem_time = sim_os_msec ();
+        }
+#endif
     *incoming_bits = ((bits&TIOCM_CTS) ? TMXR_MDM_CTS : 0) |
                      ((bits&TIOCM_DSR) ? TMXR_MDM_DSR : 0) |
                      ((bits&TIOCM_RNG) ? TMXR_MDM_RNG : 0) |
@@ -1336,7 +1438,9 @@ int read_count;
 char *bptr, *cptr;
 int32 remaining;
 
-read_count = read (port->port, (void *) buffer, (size_t) count);/* read from the serial port */
+do
+    read_count = read (port->port, (void *) buffer, (size_t) count);/* read from the serial port */
+while ((read_count == -1) && (errno == EINTR));             /* interrupted before anything arrived? */
 
 if (read_count == -1)                                       /* read error? */
     if (errno == EAGAIN)                                    /* no characters available? */
@@ -1386,7 +1490,9 @@ int32 sim_write_serial (SERHANDLE port, char *buffer, int32 count)
 {
 int written;
 
-written = write (port->port, (void *) buffer, (size_t) count);/* write the buffer to the serial port */
+do
+    written = write (port->port, (void *) buffer, (size_t) count);/* write the buffer to the serial port */
+while ((written == -1) && (errno == EINTR));                /* interrupted before anything was sent? */
 
 if (written == -1) {
     if (errno == EWOULDBLOCK)
@@ -1410,11 +1516,24 @@ return (int32) written;                                     /* return number of
 
 static void sim_close_os_serial (SERHANDLE port)
 {
+_serial_modem_watch_stop (port);
 close (port->port);                                           /* close the port */
 free (port);
 }
 
 
+/* Return the descriptor to wait on for input.
+
+   The port is opened non-blocking, so the descriptor can be registered
+   with select, poll or epoll by the caller.
+*/
+
+int sim_serial_fd (SERHANDLE port)
+{
+return port->port;
+}
+
+
 #elif defined (VMS)
 
 /* VMS implementation */
@@ -1851,6 +1970,14 @@ sys$dassgn (port->port);                                /* close the port */
 free (port);
 }
 
+
+/* Return the descriptor to wait on for input */
+
+int sim_serial_fd (SERHANDLE port)
+{
+return -1;
+}
+
 #else
 
 /* Non-implemented stubs */
@@ -1909,5 +2036,13 @@ static void sim_close_os_serial (SERHANDLE port)
 }
 
 
+/* Return the descriptor to wait on for input */
+
+int sim_serial_fd (SERHANDLE port)
+{
+return -1;
+}
+
+
 
 #endif                                                  /* end else !implemented */
@@ -77,6 +77,8 @@ extern "C" {
    sim_connect_sock     connect a socket to a remote destination
    sim_connect_sock_ex  connect a socket to a remote destination
    sim_accept_conn      accept connection
+   sim_accept_conns_ex  accept all pending connections
+   sim_accept_queue_depth  report connections waiting to be accepted
    sim_read_sock        read from socket
    sim_write_sock       write from socket
    sim_close_sock       close socket
@@ -110,6 +112,16 @@ SOCKET sim_accept_conn (SOCKET master, char **connectaddr);
 return INVALID_SOCKET;
 }
 
+int sim_accept_conns_ex (SOCKET master, SOCKET *socks, char **connectaddrs, int max, int opt_flags)
+{
+return 0;
+}
+
+int sim_accept_queue_depth (SOCKET master, int *backlog)
+{
+return -1;
+}
+
 int sim_read_sock (SOCKET sock, char *buf, int nbytes)
 {
 return -1;
@@ -910,8 +922,17 @@ if (opt_flags & SIM_SOCK_OPT_REUSEADDR) {
 
     sta = setsockopt (newsock, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on));
     }
+#if defined (SO_REUSEPORT)
+if (opt_flags & SIM_SOCK_OPT_REUSEPORT) {
+    int on = 1;
+
+    sta = setsockopt (newsock, SOL_SOCKET, SO_REUSEPORT, (char *)&on, sizeof(on));
+    if (sta == SOCKET_ERROR)                            /* setsockopt error? */
+        return sim_err_sock (newsock, "setsockopt REUSEPORT");
+    }
+#endif
 #if defined (SO_EXCLUSIVEADDRUSE)
-else {
+if (!(opt_flags & (SIM_SOCK_OPT_REUSEADDR | SIM_SOCK_OPT_REUSEPORT))) {
     int on = 1;
 
     sta = setsockopt (newsock, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (char *)&on, sizeof(on));
@@ -926,7 +947,7 @@ if (!(opt_flags & SIM_SOCK_OPT_BLOCKING)) {
     if (sta == SOCKET_ERROR)                            /* fcntl error? */
         return sim_err_sock (newsock, "fcntl");
     }
-sta = listen (newsock, 1);                              /* listen on socket */
+sta = listen (newsock, (opt_flags & SIM_SOCK_OPT_BACKLOG) ? SOMAXCONN : 1);/* listen on socket */
 if (sta == SOCKET_ERROR)                                /* listen error? */
     return sim_err_sock (newsock, "listen");
 return newsock;                                         /* got it! */
@@ -1061,7 +1082,18 @@ if (master == 0)                                        /* not attached? */
     return INVALID_SOCKET;
 size = sizeof (clientname);
 memset (&clientname, 0, sizeof(clientname));
+#if defined (__linux__) && defined (SOCK_NONBLOCK) && defined (SOCK_CLOEXEC)
+/* accept4 marks the new socket non-blocking as part of the accept, which
+   saves the separate fcntl calls for each connection */
+newsock = accept4 (master, (struct sockaddr *) &clientname, &size, 
+                   SOCK_CLOEXEC | ((opt_flags & SIM_SOCK_OPT_BLOCKING) ? 0 : SOCK_NONBLOCK));
+if ((newsock == INVALID_SOCKET) && (WSAGetLastError () == ENOSYS))
+    newsock = accept (master, (struct sockaddr *) &clientname, &size);
+else
+    opt_flags |= SIM_SOCK_OPT_BLOCKING;                 /* already in the desired mode */
+#else
 newsock = accept (master, (struct sockaddr *) &clientname, &size);
+#endif
 if (newsock == INVALID_SOCKET) {                        /* error? */
     err = WSAGetLastError ();
     if (err != WSAEWOULDBLOCK)
@@ -1100,6 +1132,50 @@ if (sta == -1)
 return newsock;
 }
 
+/* Accept every connection waiting on a listening socket, up to max, so that
+   a burst of incoming connections is drained by a single readiness event
+   rather than one per poll.  Returns the number of sockets accepted into
+   socks (and their addresses into connectaddrs when that is not NULL). */
+
+int sim_accept_conns_ex (SOCKET master, SOCKET *socks, char **connectaddrs, int max, int opt_flags)
+{
+int count = 0;
+
+while (count < max) {
+    SOCKET newsock = sim_accept_conn_ex (master, connectaddrs ? &connectaddrs[count] : NULL, opt_flags);
+
+    if (newsock == INVALID_SOCKET)                      /* nothing more pending (or an error)? */
+        break;
+    socks[count++] = newsock;
+    }
+return count;
+}
+
+/* Return the number of completed connections waiting to be accepted on a
+   listening socket, or -1 if the platform can't report it.  When backlog
+   is not NULL it receives the accept queue limit. */
+
+int sim_accept_queue_depth (SOCKET master, int *backlog)
+{
+#if defined (__linux__) && defined (TCP_INFO)
+struct tcp_info info;
+socklen_t size = sizeof (info);
+
+if (backlog)
+    *backlog = -1;
+if ((master == 0) || 
+    (getsockopt (master, IPPROTO_TCP, TCP_INFO, (char *)&info, &size) != 0))
+    return -1;
+if (backlog)                                            /* listeners report the limit in tcpi_sacked */
+    *backlog = (int)info.tcpi_sacked;
+return (int)info.tcpi_unacked;                          /* and the current queue length in tcpi_unacked */
+#else
+if (backlog)
+    *backlog = -1;
+return -1;
+#endif
+}
+
 int sim_check_conn (SOCKET sock, int rd)
 {
 fd_set rw_set, er_set;
@@ -117,12 +117,16 @@ int sim_parse_addr_ex (const char *cptr, char *host, size_t hostlen, const char
 #define SIM_SOCK_OPT_DATAGRAM       0x0002
 #define SIM_SOCK_OPT_NODELAY        0x0004
 #define SIM_SOCK_OPT_BLOCKING       0x0008
+#define SIM_SOCK_OPT_BACKLOG        0x0010              /* listen with a full depth accept queue */
+#define SIM_SOCK_OPT_REUSEPORT      0x0020              /* share the listening port (where supported) */
 SOCKET sim_master_sock_ex (const char *hostport, int *parse_status, int opt_flags);
 #define sim_master_sock(hostport, parse_status) sim_master_sock_ex(hostport, parse_status, ((sim_switches & SWMASK ('U')) ? SIM_SOCK_OPT_REUSEADDR : 0))
 SOCKET sim_connect_sock_ex (const char *sourcehostport, const char *hostport, const char *default_host, const char *default_port, int opt_flags);
 #define sim_connect_sock(hostport, default_host, default_port) sim_connect_sock_ex(NULL, hostport, default_host, default_port, 0)
 SOCKET sim_accept_conn_ex (SOCKET master, char **connectaddr, int opt_flags);
 #define sim_accept_conn(master, connectaddr) sim_accept_conn_ex(master, connectaddr, 0)
+int sim_accept_conns_ex (SOCKET master, SOCKET *socks, char **connectaddrs, int max, int opt_flags);
+int sim_accept_queue_depth (SOCKET master, int *backlog);
 int sim_check_conn (SOCKET sock, int rd);
 int sim_read_sock (SOCKET sock, char *buf, int nbytes);
 int sim_write_sock (SOCKET sock, const char *msg, int nbytes);
@@ -196,6 +196,7 @@ if ((!callback) || !ctx->asynch_io)
         ctx->bpi = _bpi;                                                \
         ctx->objupdate = _obj;                                          \
         ctx->callback = _callback;                                      \
+        ++sim_asynch_inflight;                                          \
         pthread_cond_signal (&ctx->io_cond);                            \
         pthread_mutex_unlock (&ctx->io_lock);                           \
         }                                                               \
@@ -330,6 +331,7 @@ if (ctx->asynch_io)
 
 if (ctx->callback) {
     ctx->callback = NULL;
+    --sim_asynch_inflight;
     if (ctx->asynch_io)
         pthread_mutex_unlock (&ctx->io_lock);
     callback (uptr, ctx->io_status);
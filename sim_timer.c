@@ -70,6 +70,9 @@
    sim_idle_ms_sleep -      sleep specified number of milliseconds
                             or until awakened by an asynchronous
                             event
+   sim_idle_ns_sleep -      sleep specified number of nanoseconds
+                            or until awakened by an asynchronous
+                            event (where available)
    sim_timespec_diff        subtract two timespec values
    sim_timer_activate_after schedule unit for specific time
    sim_timer_activate_time  determine activation time
@@ -99,6 +102,9 @@
 #endif
 
 uint32 sim_idle_ms_sleep (unsigned int msec);
+t_uint64 sim_idle_ns_sleep (t_uint64 nsec);
+
+#define NANOS_PER_SEC       1000000000
 
 /* MS_MIN_GRANULARITY exists here so that timing behavior for hosts systems  */
 /* with slow clock ticks can be assessed and tested without actually having  */
@@ -182,11 +188,24 @@ static uint32 sim_throt_delay = 3;
 #define CLK_INIT (sim_precalibrate_ips/CLK_TPS)
 static int32 sim_int_clk_tps;
 
+/* Units coscheduled with a clock are kept on a per timer wheel of
+   SIM_COSCHED_SLOTS FIFO lists, one per upcoming tick.  As with the
+   former countdown, a unit coscheduled for 0 or 1 ticks runs on the next
+   tick and one for n > 1 ticks on the n'th tick, so it is appended to slot
+   (cosched_slot + n - 1) % SIM_COSCHED_SLOTS and its time field holds that
+   slot plus SIM_COSCHED_SLOTS for each full turn of the wheel still to
+   go.  Coscheduling and canceling never walk the other pending units and
+   each tick only visits the units in a single slot. */
+#define SIM_COSCHED_SLOTS   64      /* must be a power of 2 */
+#define SIM_COSCHED_MASK    (SIM_COSCHED_SLOTS - 1)
+
 typedef struct RTC {
     UNIT *clock_unit;               /* registered ticking clock unit */
     UNIT *timer_unit;               /* points to related clock assist unit (sim_timer_units) */
-    UNIT *clock_cosched_queue;
-    int32 cosched_interval;
+    UNIT *cosched_wheel[SIM_COSCHED_SLOTS]; /* coscheduled units by due tick */
+    UNIT *cosched_tail[SIM_COSCHED_SLOTS];  /* last unit in each wheel slot */
+    uint32 cosched_slot;            /* wheel slot released by the next tick */
+    uint32 cosched_count;           /* units on the wheel */
     uint32 ticks;                   /* ticks */
     uint32 hz;                      /* tick rate */
     uint32 last_hz;                 /* prior tick rate */
@@ -221,6 +240,10 @@ typedef struct RTC {
     uint32 clock_calib_skip_idle;   /* Calibrations skipped due to idling */
     uint32 clock_calib_gap2big;     /* Calibrations skipped Gap Too Big */
     uint32 clock_calib_backwards;   /* Calibrations skipped Clock Running Backwards */
+    double calib_est[2];            /* busy and idle execution rate estimates */
+    uint32 calib_samples[2];        /* busy and idle rate samples */
+    uint32 calib_outliers;          /* rate samples clipped as outliers */
+    int32 calib_outlier_run;        /* consecutive outliers (+ high, - low) */
     } RTC;
 
 RTC rtcs[SIM_NTIMERS+1];
@@ -283,19 +306,18 @@ return sim_os_sleep_min_ms;
 #endif /* defined(MS_MIN_GRANULARITY) && (MS_MIN_GRANULARITY != 1) */
 
 #if defined(SIM_ASYNCH_IO)
-uint32 sim_idle_ms_sleep (unsigned int msec)
+t_uint64 sim_idle_ns_sleep (t_uint64 nsec)
 {
 struct timespec start_time, end_time, done_time, delta_time;
-uint32 delta_ms;
 t_bool timedout = FALSE;
 
 clock_gettime(CLOCK_REALTIME, &start_time);
 end_time = start_time;
-end_time.tv_sec += (msec/1000);
-end_time.tv_nsec += 1000000*(msec%1000);
-if (end_time.tv_nsec >= 1000000000) {
-  end_time.tv_sec += end_time.tv_nsec/1000000000;
-  end_time.tv_nsec = end_time.tv_nsec%1000000000;
+end_time.tv_sec += (time_t)(nsec/NANOS_PER_SEC);
+end_time.tv_nsec += (long)(nsec%NANOS_PER_SEC);
+if (end_time.tv_nsec >= NANOS_PER_SEC) {
+  end_time.tv_sec += end_time.tv_nsec/NANOS_PER_SEC;
+  end_time.tv_nsec = end_time.tv_nsec%NANOS_PER_SEC;
   }
 pthread_mutex_lock (&sim_asynch_lock);
 sim_idle_wait = TRUE;
@@ -310,9 +332,17 @@ if (!timedout) {
     AIO_UPDATE_QUEUE;
     }
 sim_timespec_diff (&delta_time, &done_time, &start_time);
-delta_ms = (uint32)((delta_time.tv_sec * 1000) + (delta_time.tv_nsec / 1000000));
-return delta_ms;
+return (((t_uint64)delta_time.tv_sec) * NANOS_PER_SEC) + delta_time.tv_nsec;
 }
+
+uint32 sim_idle_ms_sleep (unsigned int msec)
+{
+return (uint32)(sim_idle_ns_sleep (((t_uint64)msec) * (NANOS_PER_SEC/1000)) / (NANOS_PER_SEC/1000));
+}
+
+#if !defined(MS_MIN_GRANULARITY) || (MS_MIN_GRANULARITY == 1)
+#define SIM_IDLE_NS_SLEEP   1                           /* sim_idle sleeps in nanoseconds */
+#endif
 #else
 uint32 sim_idle_ms_sleep (unsigned int msec)
 {
@@ -679,6 +709,33 @@ treq.tv_nsec = (milliseconds % MILLIS_PER_SEC) * NANOS_PER_MILLI;
 return sim_os_msec () - stime;
 }
 
+/* Without asynchronous I/O there is nothing to wake an idle sleep early,
+   so sleep until an absolute monotonic deadline */
+
+#if !defined(SIM_ASYNCH_IO) && defined(_POSIX_CLOCK_SELECTION) && (_POSIX_CLOCK_SELECTION >= 0) && \
+    (!defined(MS_MIN_GRANULARITY) || (MS_MIN_GRANULARITY == 1))
+t_uint64 sim_idle_ns_sleep (t_uint64 nsec)
+{
+struct timespec start_time, end_time, done_time, delta_time;
+
+clock_gettime (CLOCK_MONOTONIC, &start_time);
+end_time = start_time;
+end_time.tv_sec += (time_t)(nsec/NANOS_PER_SEC);
+end_time.tv_nsec += (long)(nsec%NANOS_PER_SEC);
+if (end_time.tv_nsec >= NANOS_PER_SEC) {
+  end_time.tv_sec += end_time.tv_nsec/NANOS_PER_SEC;
+  end_time.tv_nsec = end_time.tv_nsec%NANOS_PER_SEC;
+  }
+while (EINTR == clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &end_time, NULL))
+    ;
+clock_gettime (CLOCK_MONOTONIC, &done_time);
+sim_timespec_diff (&delta_time, &done_time, &start_time);
+return (((t_uint64)delta_time.tv_sec) * NANOS_PER_SEC) + delta_time.tv_nsec;
+}
+
+#define SIM_IDLE_NS_SLEEP   1                           /* sim_idle sleeps in nanoseconds */
+#endif
+
 #if defined(NEED_THREAD_PRIORITY)
 #undef NEED_THREAD_PRIORITY
 #include <sys/time.h>
@@ -754,6 +811,10 @@ static void _double_to_timespec (struct timespec *time, double dtime);
 static t_bool _rtcn_tick_catchup_check (RTC *rtc, int32 time);
 static void _rtcn_configure_calibrated_clock (int32 newtmr);
 static t_bool _sim_coschedule_cancel (UNIT *uptr);
+static void _sim_coschedule_reset (RTC *rtc);
+static UNIT *_sim_coschedule_first (RTC *rtc);
+static int32 _sim_coschedule_ticks (RTC *rtc, UNIT *uptr);
+static int32 _sim_coschedule_find (UNIT *uptr, int32 *ticks);
 static t_bool _sim_wallclock_cancel (UNIT *uptr);
 static t_bool _sim_wallclock_is_active (UNIT *uptr);
 t_stat sim_timer_show_idle_mode (FILE* st, UNIT* uptr, int32 val, CONST void *  desc);
@@ -788,6 +849,63 @@ else
 static uint32 sim_idle_cyc_ms = 0;                          /* Cycles per millisecond while not idling */
 static uint32 sim_idle_cyc_sleep = 0;                       /* Cycles per minimum sleep interval */
 static double sim_idle_end_time = 0.0;                      /* Time when last idle completed */
+static uint32 sim_idle_ns_min = 0;                          /* Overshoot of a minimal nanosecond sleep (0 = ms sleeps) */
+static uint32 sim_idle_ns_residue = 0;                      /* Idled nsecs not yet counted in clock_time_idled */
+static t_bool sim_warp_enab = FALSE;                        /* Skip idle time rather than sleep */
+static t_uint64 sim_warp_ns = 0;                            /* Total idle time skipped */
+static uint32 sim_warp_count = 0;                           /* Number of idle periods skipped */
+
+/* Warp mode
+
+   When warping, sim_idle doesn't sleep until the next event.  It advances 
+   the clock calibration's notion of wall time by the time it would have 
+   slept and lets the next event happen immediately.  Calibrated clocks, 
+   catchup ticks and the time of day seen by simulators (sim_rtcn_get_time) 
+   all measure time with the functions below, so they stay consistent with 
+   sim_gtime while the simulator runs far faster than real time. */
+
+static uint32 _sim_warp_msec (void)
+{
+return sim_os_msec () + (uint32)(sim_warp_ns / (NANOS_PER_SEC/1000));
+}
+
+static double _sim_warp_timenow_double (void)
+{
+return sim_timenow_double () + ((double)sim_warp_ns) / NANOS_PER_SEC;
+}
+
+/* Anything in flight on an I/O thread completes in real time, so idle time 
+   can't be skipped until it is done.  The disk and tape libraries count
+   their requests in sim_asynch_inflight from the time they are handed to
+   the I/O thread until the completion has been dispatched. */
+
+static t_bool _sim_warp_io_pending (void)
+{
+#if defined(SIM_ASYNCH_IO)
+return (sim_asynch_inflight != 0) ||                    /* requests in flight */
+       (AIO_QUEUE_VAL != QUEUE_LIST_END);               /* or completions not yet processed? */
+#else
+return FALSE;
+#endif
+}
+
+#if defined(SIM_IDLE_NS_SLEEP)
+/* Measure how far past a very short deadline the host wakes us up.  Idle
+   sleeps end that much early so that they end as the next event is due. */
+
+static uint32 _compute_minimum_ns_sleep (void)
+{
+uint32 i;
+t_uint64 tot;
+
+sim_os_set_thread_priority (PRIORITY_ABOVE_NORMAL);
+for (i = 0, tot = 0; i < sleep1Samples; i++)
+    tot += sim_idle_ns_sleep (1000);
+sim_os_set_thread_priority (PRIORITY_NORMAL);
+tot = tot / sleep1Samples;                              /* Average time slept */
+return (uint32)((tot > 1000) ? tot - 1000 : 0);         /* less the time requested */
+}
+#endif
 
 UNIT sim_stop_unit;                                     /* Stop unit                         */
 UNIT sim_internal_timer_unit;                           /* Internal calibration timer */
@@ -831,6 +949,8 @@ DEBTAB sim_timer_debug[] = {
 extern DEVICE sim_timer_dev;
 extern DEVICE sim_throttle_dev;
 extern DEVICE sim_stop_dev;
+static void _sim_perf_start (void);
+static void _sim_perf_stop (void);
 
 
 void sim_rtcn_init_all (void)
@@ -883,7 +1003,7 @@ if (uptr) {
         sim_register_clock_unit_tmr (uptr, tmr);
     }
 rtc->gtime = sim_gtime();
-rtc->rtime = sim_is_running ? sim_os_msec () : sim_stop_time;
+rtc->rtime = sim_is_running ? _sim_warp_msec () : sim_stop_time;
 rtc->vtime = rtc->rtime;
 rtc->nxintv = 1000;
 rtc->ticks = 0;
@@ -906,11 +1026,169 @@ rtc->clock_catchup_ticks_curr = 0;
 rtc->calib_ticks_acked_tot += rtc->calib_ticks_acked;
 rtc->calib_ticks_acked = 0;
 ++rtc->calib_initializations;
-rtc->clock_init_base_time = sim_timenow_double ();
+rtc->clock_init_base_time = _sim_warp_timenow_double ();
+if (sim_evlog_active ())                                /* learned rates differ between runs */
+    rtc->based = rtc->currd = rtc->initd = time = (int32)sim_evlog_value ("INIT", time);
 _rtcn_configure_calibrated_clock (tmr);
 return time;
 }
 
+/* Execution rate estimation
+
+   Each second's calibration measures how many instructions actually ran.
+   A preempted host or a burst of I/O produces samples far from the real
+   rate, which the tick feedback alone would chase for several seconds.
+   The measured samples are therefore smoothed by an exponentially weighted
+   moving average, and samples more than SIM_CALIB_CLIP from the average
+   are clipped to that bound.  Only SIM_CALIB_SHIFT consecutive outliers in
+   the same direction are taken as a real change of the host's speed; the
+   tick feedback keeps its previous rate across a transient outlier.
+   Seconds which were mostly spent idling measure something different from
+   busy seconds, so they are averaged separately.
+
+   With SET CLOCK CALIBFILE=file the learned rates are kept in a file so
+   that the next run starts from them rather than from an estimate.
+*/
+
+#define SIM_CALIB_ALPHA         0.25                /* weight of a new sample */
+#define SIM_CALIB_CLIP          0.20                /* max fractional deviation of a sample */
+#define SIM_CALIB_SHIFT         3                   /* consecutive outliers which move the estimate */
+#define SIM_CALIB_IDLE_PCT      5                   /* idle % above which a sample is an idle sample */
+#define SIM_CALIB_SAVE_SECS     60                  /* seconds between calibration file updates */
+
+static char *sim_calib_file = NULL;                 /* learned rate file */
+static double sim_calib_seed[2] = {0.0, 0.0};       /* busy and idle rates loaded from it */
+
+static double _rtcn_calb_estimate (RTC *rtc, double sample, t_bool idle)
+{
+int i = idle ? 1 : 0;
+double est = rtc->calib_est[i];
+
+if ((rtc->calib_samples[i] == 0) && (sim_calib_seed[i] > 0.0))
+    est = sim_calib_seed[i];                        /* start from the learned rate */
+else {
+    if (rtc->calib_samples[i] < SIM_CALIB_SHIFT) {  /* still converging from the initial guess? */
+        ++rtc->calib_samples[i];
+        return rtc->calib_est[i] = sample;
+        }
+    }
+++rtc->calib_samples[i];
+if ((sample > est * (1.0 + SIM_CALIB_CLIP)) ||      /* outlier? */
+    (sample < est * (1.0 - SIM_CALIB_CLIP))) {
+    int32 dir = (sample > est) ? 1 : -1;
+
+    if ((rtc->calib_outlier_run * dir) > 0)         /* same direction as the last? */
+        rtc->calib_outlier_run += dir;
+    else
+        rtc->calib_outlier_run = dir;
+    if (abs (rtc->calib_outlier_run) >= SIM_CALIB_SHIFT) {/* persistent: the host speed changed */
+        sim_debug (DBG_CAL, &sim_timer_dev, "_rtcn_calb_estimate() rate changed from %.0f to %.0f\n", est, sample);
+        rtc->calib_outlier_run = 0;
+        return rtc->calib_est[i] = sample;
+        }
+    ++rtc->calib_outliers;
+    sim_debug (DBG_CAL, &sim_timer_dev, "_rtcn_calb_estimate() clipping %s outlier %.0f, estimate %.0f\n", idle ? "idle" : "busy", sample, est);
+    sample = est * (1.0 + dir * SIM_CALIB_CLIP);
+    }
+else
+    rtc->calib_outlier_run = 0;
+return rtc->calib_est[i] = est + SIM_CALIB_ALPHA * (sample - est);
+}
+
+static void _sim_calib_save (void)
+{
+RTC *rtc;
+FILE *f;
+
+if ((sim_calib_file == NULL) || (sim_calb_tmr == -1))
+    return;
+rtc = &rtcs[sim_calb_tmr];
+if ((rtc->calib_samples[0] == 0) && (rtc->calib_samples[1] == 0))
+    return;
+f = fopen (sim_calib_file, "w");
+if (f == NULL)
+    return;
+fprintf (f, "; %s execution rate calibration\n", sim_name);
+fprintf (f, "simulator %s\n", sim_name);
+if (rtc->calib_samples[0])
+    fprintf (f, "busy %.0f\n", rtc->calib_est[0]);
+if (rtc->calib_samples[1])
+    fprintf (f, "idle %.0f\n", rtc->calib_est[1]);
+fclose (f);
+}
+
+static t_stat _sim_calib_load (const char *filename)
+{
+FILE *f;
+char line[CBUFSIZE], key[CBUFSIZE];
+const char *value;
+double rate[2] = {0.0, 0.0};
+t_bool ours = FALSE;
+int32 tmr;
+
+f = fopen (filename, "r");
+if (f == NULL)                                      /* not there yet is fine */
+    return SCPE_OK;
+while (fgets (line, sizeof (line), f)) {
+    sim_trim_endspc (line);
+    if (line[0] == ';')
+        continue;
+    value = get_glyph_nc (line, key, 0);
+    if ((key[0] == '\0') || (*value == '\0'))
+        continue;
+    if (0 == strcmp (key, "simulator"))
+        ours = (0 == strcmp (value, sim_name));
+    else if (0 == strcmp (key, "busy"))
+        rate[0] = strtod (value, NULL);
+    else if (0 == strcmp (key, "idle"))
+        rate[1] = strtod (value, NULL);
+    }
+fclose (f);
+if (!ours)
+    return sim_messagef (SCPE_ARG, "%s doesn't hold a %s calibration\n", filename, sim_name);
+if (!((rate[0] >= 0.0) && (rate[0] <= (double)0x7FFFFFFF) &&    /* rates must fit */
+      (rate[1] >= 0.0) && (rate[1] <= (double)0x7FFFFFFF)))     /* sim_precalibrate_ips */
+    return sim_messagef (SCPE_ARG, "%s holds an invalid calibration\n", filename);
+sim_calib_seed[0] = rate[0];
+sim_calib_seed[1] = rate[1];
+if (rate[0] > 0.0) {                                /* start at the learned busy rate */
+    sim_precalibrate_ips = (int32)rate[0];
+    sim_inst_per_sec_last = rate[0];
+    for (tmr = 0; tmr <= SIM_NTIMERS; tmr++) {
+        RTC *rtc = &rtcs[tmr];
+
+        if (rtc->hz && (rtc->calib_samples[0] == 0))
+            rtc->currd = rtc->based = (int32)(rate[0] / rtc->hz);
+        }
+    }
+return SCPE_OK;
+}
+
+/* SET CLOCK CALIBFILE=file and NOCALIBFILE */
+
+t_stat sim_timer_set_calib_file (int32 flag, CONST char *cptr)
+{
+t_stat r;
+
+if (!flag) {
+    if (cptr && *cptr)
+        return SCPE_2MARG;
+    _sim_calib_save ();
+    free (sim_calib_file);
+    sim_calib_file = NULL;
+    return SCPE_OK;
+    }
+if ((cptr == NULL) || (*cptr == '\0'))
+    return sim_messagef (SCPE_2FARG, "Missing calibration file name\n");
+r = _sim_calib_load (cptr);
+if (r != SCPE_OK)
+    return r;
+free (sim_calib_file);
+sim_calib_file = (char *)malloc (1 + strlen (cptr));
+strcpy (sim_calib_file, cptr);
+return SCPE_OK;
+}
+
 int32 sim_rtcn_calb_tick (int32 tmr)
 {
 RTC *rtc = &rtcs[tmr];
@@ -918,8 +1196,33 @@ RTC *rtc = &rtcs[tmr];
 return sim_rtcn_calb (rtc->hz, tmr);
 }
 
+static int32 _sim_rtcn_calb (uint32 ticksper, int32 tmr);
+
+/* A recorded or replayed run (see sim_evlog_value) uses the calibration 
+   results of the recording whenever they were derived from host time. */
+
 int32 sim_rtcn_calb (uint32 ticksper, int32 tmr)
 {
+int32 itmr = (tmr == SIM_INTERNAL_CLK) ? SIM_NTIMERS : tmr;
+RTC *rtc = ((itmr >= 0) && (itmr <= SIM_NTIMERS)) ? &rtcs[itmr] : NULL;
+uint32 calibrations = rtc ? rtc->calibrations : 0;
+uint32 hz = rtc ? rtc->hz : 0;
+int32 currd = _sim_rtcn_calb (ticksper, tmr);
+
+if (sim_evlog_active () && (rtc != NULL) &&             /* events recorded or replayed and */
+    ((rtc->calibrations != calibrations) ||             /*   calibrated or */
+     (rtc->hz != hz))) {                                /*   rate changed? */
+    int32 logged = (int32)sim_evlog_value ("CALIB", rtc->currd);
+
+    if (currd == rtc->currd)
+        currd = logged;
+    rtc->currd = logged;
+    }
+return currd;
+}
+
+static int32 _sim_rtcn_calb (uint32 ticksper, int32 tmr)
+{
 uint32 new_rtime, delta_rtime, last_idle_pct, catchup_ticks_curr;
 int32 delta_vtime;
 double new_gtime;
@@ -938,13 +1241,16 @@ if (rtc->hz != ticksper) {                          /* changing tick rate? */
     uint32 prior_hz = rtc->hz;
 
     if (rtc->hz == 0)
-        rtc->clock_tick_start_time = sim_timenow_double ();
+        rtc->clock_tick_start_time = _sim_warp_timenow_double ();
     if ((rtc->last_hz != 0) && 
         (rtc->last_hz != ticksper) && 
         (ticksper != 0))
         rtc->currd = (int32)(sim_timer_inst_per_sec () / ticksper);
     rtc->last_hz = rtc->hz;
     rtc->hz = ticksper;
+    if ((prior_hz == 0) && (ticksper != 0) &&           /* starting with a learned rate? */
+        (sim_calib_seed[0] > 0.0) && (rtc->calib_samples[0] == 0))
+        rtc->based = rtc->currd = (int32)(sim_calib_seed[0] / ticksper);
     _rtcn_configure_calibrated_clock (tmr);
     if (ticksper != 0) {
         RTC *crtc = &rtcs[sim_calb_tmr];
@@ -986,8 +1292,10 @@ if (sim_calb_tmr != tmr) {
     sim_debug (DBG_CAL, &sim_timer_dev, "sim_rtcn_calb(tmr=%d) calibrated against internal system tmr=%d, tickper=%d (result: %d)\n", tmr, sim_calb_tmr, ticksper, rtc->currd);
     return rtc->currd;
     }
-new_rtime = sim_os_msec ();                         /* wall time */
+new_rtime = _sim_warp_msec ();                      /* wall time */
 ++rtc->calibrations;                                /* count calibrations */
+if (sim_calib_file && ((rtc->calibrations % SIM_CALIB_SAVE_SECS) == 0))
+    _sim_calib_save ();                             /* keep the learned rates */
 sim_debug (DBG_TRC, &sim_timer_dev, "sim_rtcn_calb(ticksper=%d, tmr=%d)\n", ticksper, tmr);
 if (new_rtime < rtc->rtime) {                       /* time running backwards? */
     /* This happens when the value returned by sim_os_msec wraps (as an uint32) */
@@ -999,7 +1307,7 @@ if (new_rtime < rtc->rtime) {                       /* time running backwards? *
     rtc->nxintv = 1000;
     rtc->based = rtc->currd;
     if (rtc->clock_catchup_eligible) {
-        rtc->clock_catchup_base_time = sim_timenow_double();
+        rtc->clock_catchup_base_time = _sim_warp_timenow_double ();
         rtc->calib_tick_time = 0.0;
         }
     return rtc->currd;                              /* can't calibrate */
@@ -1049,7 +1357,7 @@ if (sim_asynch_timer || (catchup_ticks_curr > 0)) {
     /* An asynchronous clock or when catchup ticks have  */
     /* occurred, we merely needs to divide the number of */
     /* instructions actually executed by the clock rate. */
-    new_currd = (int32)((new_gtime - rtc->gtime)/ticksper);
+    new_currd = (int32)(_rtcn_calb_estimate (rtc, new_gtime - rtc->gtime, (last_idle_pct > SIM_CALIB_IDLE_PCT))/ticksper);
     /* avoid excessive swings in the calibrated result */
     if (new_currd > 10*rtc->currd)              /* don't swing big too fast */
         new_currd = 10*rtc->currd;
@@ -1063,15 +1371,23 @@ if (sim_asynch_timer || (catchup_ticks_curr > 0)) {
                     sim_asynch_timer ? "asynch" : "catchup", tmr, ticksper, catchup_ticks_curr, last_idle_pct, rtc->currd);
     return rtc->currd;                          /* calibrated result */
     }
-rtc->gtime = new_gtime;                         /* save instruction time */
 /* This self regulating algorithm depends directly on the assumption */
 /* that this routine is called back after processing the number of */
 /* instructions which was returned the last time it was called. */
 if (delta_rtime == 0)                           /* gap too small? */
     rtc->based = rtc->based * ticksper;         /* slew wide */
-else
+else {
+    int32 last_based = rtc->based;
+    uint32 last_outliers = rtc->calib_outliers;
+
     rtc->based = (int32) (((double) rtc->based * (double) rtc->nxintv) /
                                 ((double) delta_rtime));/* new base rate */
+    _rtcn_calb_estimate (rtc, ((new_gtime - rtc->gtime) * 1000.0) / delta_rtime, 
+                         (last_idle_pct > SIM_CALIB_IDLE_PCT));/* measured rate */
+    if (rtc->calib_outliers != last_outliers)   /* transient outlier? */
+        rtc->based = last_based;                /* hold the rate rather than chase it */
+    }
+rtc->gtime = new_gtime;                         /* save instruction time */
 delta_vtime = rtc->vtime - rtc->rtime;          /* gap */
 if (delta_vtime > SIM_TMAX)                     /* limit gap */
     delta_vtime = SIM_TMAX;
@@ -1125,16 +1441,22 @@ for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
     rtc->timer_unit = &sim_timer_units[tmr];
     rtc->timer_unit->action = &sim_timer_tick_svc;
     rtc->timer_unit->flags = UNIT_DIS | UNIT_IDLE;
-    rtc->clock_cosched_queue = QUEUE_LIST_END;
+    _sim_coschedule_reset (rtc);
     }
 sim_stop_unit.action = &sim_timer_stop_svc;
 SIM_INTERNAL_UNIT.flags = UNIT_IDLE;
 sim_register_internal_device (&sim_timer_dev);          /* Register Clock Assist device */
 sim_register_internal_device (&sim_throttle_dev);       /* Register Throttle Device */
+sim_register_internal_device (&sim_perf_dev);           /* Register Performance Counters */
 sim_throttle_unit.action = &sim_throt_svc;
 sim_register_clock_unit_tmr (&SIM_INTERNAL_UNIT, SIM_INTERNAL_CLK);
 sim_idle_enab = FALSE;                                  /* init idle off */
 sim_idle_rate_ms = sim_os_ms_sleep_init ();             /* get OS timer rate */
+#if defined(SIM_IDLE_NS_SLEEP)
+sim_idle_ns_min = _compute_minimum_ns_sleep ();         /* get fine grained sleep overshoot */
+if (sim_idle_ns_min == 0)
+    sim_idle_ns_min = 1;
+#endif
 sim_set_rom_delay_factor (sim_get_rom_delay_factor ()); /* initialize ROM delay factor */
 
 sim_stop_time = clock_last = clock_start = sim_os_msec ();
@@ -1183,11 +1505,17 @@ fprintf (st, "Minimum Host Sleep Time:        %d ms (%dHz)\n", sim_os_sleep_min_
 if (sim_os_sleep_min_ms != sim_os_sleep_inc_ms)
     fprintf (st, "Minimum Host Sleep Incr Time:   %d ms\n", sim_os_sleep_inc_ms);
 fprintf (st, "Host Clock Resolution:          %d ms\n", sim_os_clock_resoluton_ms);
+if (sim_idle_ns_min != 0)
+    fprintf (st, "Idle Sleep Resolution:          nanoseconds (%.1f usecs wakeup overshoot)\n", sim_idle_ns_min / 1000.0);
 fprintf (st, "Execution Rate:                 %s cycles/sec\n", sim_fmt_numeric (inst_per_sec));
 if (sim_idle_enab) {
     fprintf (st, "Idling:                         Enabled\n");
     fprintf (st, "Time before Idling starts:      %d seconds\n", sim_idle_stable);
     }
+if (sim_warp_enab || (sim_warp_ns != 0)) {
+    fprintf (st, "Warp:                           %s\n", sim_warp_enab ? "Enabled" : "Disabled");
+    fprintf (st, "Idle Time Skipped:              %s in %s idle periods\n", sim_fmt_secs (((double)sim_warp_ns) / NANOS_PER_SEC), sim_fmt_numeric ((double)sim_warp_count));
+    }
 if (sim_throt_type != SIM_THROT_NONE) {
     sim_show_throt (st, NULL, uptr, val, desc);
     }
@@ -1197,6 +1525,8 @@ fprintf (st, "Calibrated Timer:               %s\n", (calb_tmr == -1) ? "Undeter
 if (calb_tmr == SIM_NTIMERS)
     fprintf (st, "Catchup Ticks:                  %s\n", sim_catchup_ticks ? "Enabled" : "Disabled");
 fprintf (st, "Pre-Calibration Estimated Rate: %s\n", sim_fmt_numeric ((double)sim_precalibrate_ips));
+if (sim_calib_file)
+    fprintf (st, "Calibration File:               %s\n", sim_calib_file);
 if (sim_idle_calib_pct == 100)
     fprintf (st, "Calibration:                    Always\n");
 else
@@ -1207,7 +1537,7 @@ fprintf (st, "Asynchronous Clocks:            %s\n", sim_asynch_timer ? "Active"
 if (sim_time_at_sim_prompt != 0.0) {
     double prompt_time = 0.0;
     if (!sim_is_running)
-        prompt_time = ((double)(sim_os_msec () - sim_stop_time)) / 1000.0;
+        prompt_time = ((double)(_sim_warp_msec () - sim_stop_time)) / 1000.0;
     fprintf (st, "Time at sim> prompt:            %s\n", sim_fmt_secs (sim_time_at_sim_prompt + prompt_time));
     }
 
@@ -1235,6 +1565,12 @@ for (tmr=clocks=0; tmr<=SIM_NTIMERS; ++tmr) {
     fprintf (st, "  Seconds Running:           %s (%s)\n",   sim_fmt_numeric ((double)rtc->elapsed), sim_fmt_secs ((double)rtc->elapsed));
     if (tmr == calb_tmr) {
         fprintf (st, "  Calibration Opportunities: %s\n",   sim_fmt_numeric ((double)rtc->calibrations));
+        if (rtc->calib_samples[0])
+            fprintf (st, "  Busy Rate Estimate:        %s cycles/sec\n", sim_fmt_numeric (rtc->calib_est[0]));
+        if (rtc->calib_samples[1])
+            fprintf (st, "  Idle Rate Estimate:        %s cycles/sec\n", sim_fmt_numeric (rtc->calib_est[1]));
+        if (rtc->calib_outliers)
+            fprintf (st, "  Outlier Samples Clipped:   %s\n", sim_fmt_numeric ((double)rtc->calib_outliers));
         if (sim_idle_calib_pct && (sim_idle_calib_pct != 100))
             fprintf (st, "  Calib Skip when Idle >:    %u%%\n",   sim_idle_calib_pct);
         if (rtc->clock_calib_skip_idle)
@@ -1339,28 +1675,40 @@ for (tmr=0; tmr<=SIM_NTIMERS; ++tmr) {
 
     if (rtc->clock_unit == NULL)
         continue;
-    if (rtc->clock_cosched_queue != QUEUE_LIST_END) {
-        int32 accum;
+    if (rtc->cosched_count != 0) {
+        uint32 shown = 0;
+        int32 turn, next_turn, slot, accum;
 
         fprintf (st, "%s #%d clock (%s) co-schedule event queue status\n",
                  sim_name, tmr, sim_uname(rtc->clock_unit));
-        accum = 0;
-        for (uptr = rtc->clock_cosched_queue; uptr != QUEUE_LIST_END; uptr = uptr->next) {
-            if ((dptr = find_dev_from_unit (uptr)) != NULL) {
-                fprintf (st, "  %s", sim_dname (dptr));
-                if (dptr->numunits > 1)
-                    fprintf (st, " unit %d", (int32) (uptr - dptr->units));
+        /* Visit the wheel a turn at a time so units are listed in due order */
+        for (turn = 0; shown < rtc->cosched_count; turn = next_turn) {
+            next_turn = 0x7FFFFFFF;
+            for (slot = 0; slot < SIM_COSCHED_SLOTS; slot++) {
+                for (uptr = rtc->cosched_wheel[(rtc->cosched_slot + slot) & SIM_COSCHED_MASK]; uptr != QUEUE_LIST_END; uptr = uptr->next) {
+                    accum = _sim_coschedule_ticks (rtc, uptr) - 1;
+                    if ((accum - slot) != turn) {
+                        if (((accum - slot) > turn) && ((accum - slot) < next_turn))
+                            next_turn = accum - slot;
+                        continue;
+                        }
+                    ++shown;
+                    if ((dptr = find_dev_from_unit (uptr)) != NULL) {
+                        fprintf (st, "  %s", sim_dname (dptr));
+                        if (dptr->numunits > 1)
+                            fprintf (st, " unit %d", (int32) (uptr - dptr->units));
+                        }
+                    else
+                        fprintf (st, "  Unknown");
+                    if (accum == 0)
+                        fprintf (st, " on next tick");
+                    else
+                        fprintf (st, " after %d ticks", accum + 1);
+                    if (uptr->usecs_remaining)
+                        fprintf (st, " plus %.0f usecs", uptr->usecs_remaining);
+                    fprintf (st, "\n");
+                    }
                 }
-            else
-                fprintf (st, "  Unknown");
-            if (accum == 0)
-                fprintf (st, " on next tick");
-            else
-                fprintf (st, " after %d tick%s", accum, (accum > 1) ? "s" : "");
-            if (uptr->usecs_remaining)
-                fprintf (st, " plus %.0f usecs", uptr->usecs_remaining);
-            fprintf (st, "\n");
-            accum = accum + uptr->time;
             }
         }
     }
@@ -1373,6 +1721,7 @@ return SCPE_OK;
 REG sim_timer_reg[] = {
     { DRDATAD (IDLE_CYC_MS,      sim_idle_cyc_ms,        32, "Cycles Per Millisecond"), PV_RSPC|REG_RO},
     { DRDATAD (IDLE_CYC_SLEEP,   sim_idle_cyc_sleep,     32, "Cycles Per Minimum Sleep"), PV_RSPC|REG_RO},
+    { DRDATAD (IDLE_NS_MIN,      sim_idle_ns_min,        32, "Idle Sleep Wakeup Overshoot (nsecs)"), PV_RSPC},
     { DRDATAD (IDLE_STABLE,      sim_idle_stable,        32, "IDLE stability delay"), PV_RSPC},
     { DRDATAD (ROM_DELAY,        sim_rom_delay,          32, "ROM memory reference delay"), PV_RSPC|REG_RO},
     { DRDATAD (TICK_RATE_0,      rtcs[0].hz,             32, "Timer 0 Ticks Per Second") },
@@ -1433,6 +1782,20 @@ fprintf (st, "Calibrated Ticks%s", sim_catchup_ticks ? " with Catchup Ticks" : "
 return SCPE_OK;
 }
 
+/* Set warp mode */
+
+t_stat sim_timer_set_warp (int32 flag, CONST char *cptr)
+{
+if (cptr && *cptr)
+    return SCPE_2MARG;
+sim_warp_enab = (flag != 0);
+if (sim_warp_enab && !sim_idle_enab)
+    sim_printf ("Idle time is only skipped when idling is enabled (SET CPU IDLE)\n");
+if (sim_warp_enab && sim_asynch_timer)
+    sim_printf ("Idle time is only skipped with synchronous clocks (SET CLOCK NOASYNCH)\n");
+return SCPE_OK;
+}
+
 /* Set idle calibration threshold */
 
 t_stat sim_timer_set_idle_pct (int32 flag, CONST char *cptr)
@@ -1511,6 +1874,10 @@ static CTAB set_timer_tab[] = {
     { "NOCATCHUP",  &sim_timer_set_catchup,  0 },
     { "CALIB",      &sim_timer_set_idle_pct, 0 },
     { "STOP",       &sim_timer_set_stop, 0 },
+    { "CALIBFILE",  &sim_timer_set_calib_file, 1 },
+    { "NOCALIBFILE",&sim_timer_set_calib_file, 0 },
+    { "WARP",       &sim_timer_set_warp, 1 },
+    { "NOWARP",     &sim_timer_set_warp, 0 },
     { NULL, NULL, 0 }
     };
 
@@ -1568,6 +1935,212 @@ DEVICE sim_throttle_dev = {
     NULL, NULL, NULL, NULL, NULL, NULL, 
     NULL, DEV_NOSAVE};
 
+/* Performance counters
+
+   The PERF device's registers are the simulator's performance counters,
+   so EXAMINE PERF STATE (locally or through the remote console) is just a
+   register display.  Events and asynchronous completions are counted as
+   they happen, the rest are brought up to date whenever the simulator 
+   stops, when SHOW PERF displays them and when EXAMINE reads a PERF
+   register (which the remote console can do while running), so nothing
+   is scheduled just to keep them current.  SET PERF EXPORT=file writes the counters to that 
+   file every INTERVAL seconds in the Prometheus text format, replacing the 
+   file as a whole so a reader never sees part of it.  The PERF unit is 
+   only on the event queue while an export file is set.
+*/
+
+#define PERF_BITS           (sizeof (t_value) * 8)
+#define PERF_EXPORT_SECS    10                      /* default export interval */
+
+t_value sim_perf_events = 0;                        /* events processed */
+t_value sim_perf_asynch = 0;                        /* asynchronous I/O completions */
+static t_value sim_perf_instr = 0;                  /* instructions executed */
+static t_value sim_perf_idle_ms = 0;                /* time idled */
+static t_value sim_perf_calibrations = 0;           /* execution rate calibrations */
+static uint32 sim_perf_ips = 0;                     /* current execution rate */
+static uint32 sim_perf_calib_err = 0;               /* simulated vs wall clock time (msecs) */
+static char *sim_perf_file = NULL;                  /* export file */
+static int32 sim_perf_interval = PERF_EXPORT_SECS;  /* seconds between exports */
+
+static t_stat sim_perf_svc (UNIT *uptr);
+static t_stat sim_perf_set_export (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
+static t_stat sim_perf_set_interval (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
+static t_stat sim_perf_show_export (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+static t_stat sim_perf_show_counters (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+
+static UNIT sim_perf_unit = { UDATA (&sim_perf_svc, UNIT_IDLE, 0) };
+
+static REG sim_perf_reg[] = {
+    { DRDATAD (INSTRUCTIONS,     sim_perf_instr,         PERF_BITS, "Instructions executed"), PV_LEFT|REG_RO},
+    { DRDATAD (EVENTS,           sim_perf_events,        PERF_BITS, "Events processed"), PV_LEFT|REG_RO},
+    { DRDATAD (ASYNCH,           sim_perf_asynch,        PERF_BITS, "Asynchronous I/O completions"), PV_LEFT|REG_RO},
+    { DRDATAD (IDLE_MS,          sim_perf_idle_ms,       PERF_BITS, "Time idled (msecs)"), PV_LEFT|REG_RO},
+    { DRDATAD (CALIBRATIONS,     sim_perf_calibrations,  PERF_BITS, "Execution rate calibrations"), PV_LEFT|REG_RO},
+    { DRDATAD (INST_PER_SEC,     sim_perf_ips,           32, "Current execution rate"), PV_LEFT|REG_RO},
+    { DRDATAD (CALIB_ERR_MS,     sim_perf_calib_err,     32, "Simulated vs wall clock time difference (msecs)"), PV_LEFT|REG_RO},
+    { NULL }
+    };
+
+static MTAB sim_perf_mod[] = {
+    { MTAB_XTD|MTAB_VDV, 0, "COUNTERS", NULL,
+        NULL, &sim_perf_show_counters, NULL, "Display the current counter values" },
+    { MTAB_XTD|MTAB_VDV|MTAB_VALR|MTAB_NC, 1, "EXPORT", "EXPORT=file",
+        &sim_perf_set_export, &sim_perf_show_export, NULL, "Write the counters to file periodically" },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOEXPORT",
+        &sim_perf_set_export, NULL, NULL, "Stop writing the counters to a file" },
+    { MTAB_XTD|MTAB_VDV|MTAB_VALR, 0, NULL, "INTERVAL=seconds",
+        &sim_perf_set_interval, NULL, NULL, "Set the time between exports" },
+    { 0 }
+    };
+
+static const char *sim_perf_description (DEVICE *dptr)
+{
+return "Performance counters";
+}
+
+DEVICE sim_perf_dev = {
+    "PERF", &sim_perf_unit, sim_perf_reg, sim_perf_mod, 
+    1, 0, 0, 0, 0, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL, 
+    NULL, DEV_NOSAVE, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL,
+    sim_perf_description};
+
+/* Bring the counters which aren't kept as they happen up to date */
+
+void sim_perf_update (void)
+{
+int32 tmr = (sim_calb_tmr != -1) ? sim_calb_tmr : sim_calb_tmr_last;
+t_value idled = 0;
+int i;
+
+sim_perf_instr = (t_value)sim_gtime ();
+for (i = 0; i <= SIM_NTIMERS; i++)
+    idled += rtcs[i].clock_time_idled;
+sim_perf_idle_ms = idled;
+sim_perf_ips = (uint32)sim_timer_inst_per_sec ();
+if (tmr != -1) {
+    sim_perf_calibrations = rtcs[tmr].calibrations;
+    sim_perf_calib_err = (uint32)abs ((int32)(rtcs[tmr].vtime - rtcs[tmr].rtime));
+    }
+}
+
+static void _sim_perf_metric (FILE *f, const char *name, const char *type, const char *help, double value)
+{
+fprintf (f, "# HELP simh_%s %s\n", name, help);
+fprintf (f, "# TYPE simh_%s %s\n", name, type);
+fprintf (f, "simh_%s{simulator=\"%s\"} %.15g\n", name, sim_name, value);
+}
+
+static t_stat _sim_perf_export (void)
+{
+char tmpname[CBUFSIZE + 8];
+FILE *f;
+
+snprintf (tmpname, sizeof (tmpname), "%s.tmp", sim_perf_file);
+f = sim_fopen (tmpname, "w");
+if (f == NULL)
+    return sim_messagef (SCPE_OPENERR, "Can't create %s: %s\n", tmpname, strerror (errno));
+_sim_perf_metric (f, "instructions_total", "counter", "Instructions executed", sim_gtime ());
+_sim_perf_metric (f, "events_total", "counter", "Events processed", (double)sim_perf_events);
+_sim_perf_metric (f, "asynch_completions_total", "counter", "Asynchronous I/O completions", (double)sim_perf_asynch);
+_sim_perf_metric (f, "idle_seconds_total", "counter", "Time idled", sim_perf_idle_ms / 1000.0);
+_sim_perf_metric (f, "calibrations_total", "counter", "Execution rate calibrations", (double)sim_perf_calibrations);
+_sim_perf_metric (f, "instructions_per_second", "gauge", "Current execution rate", (double)sim_perf_ips);
+_sim_perf_metric (f, "calibration_error_seconds", "gauge", "Simulated vs wall clock time difference", sim_perf_calib_err / 1000.0);
+_sim_perf_metric (f, "running", "gauge", "Instructions are being executed", sim_is_running ? 1.0 : 0.0);
+fclose (f);
+#if defined (_WIN32)
+remove (sim_perf_file);                             /* rename won't replace */
+#endif
+if (rename (tmpname, sim_perf_file))
+    return sim_messagef (SCPE_IOERR, "Can't rename %s to %s: %s\n", tmpname, sim_perf_file, strerror (errno));
+return SCPE_OK;
+}
+
+static void _sim_perf_start (void)
+{
+if ((sim_perf_file != NULL) && !sim_is_active (&sim_perf_unit))
+    sim_activate_after_d (&sim_perf_unit, sim_perf_interval * 1000000.0);
+}
+
+static void _sim_perf_stop (void)
+{
+sim_perf_update ();
+if (sim_perf_file != NULL)
+    _sim_perf_export ();
+}
+
+static t_stat sim_perf_svc (UNIT *uptr)
+{
+if (sim_perf_file == NULL)                          /* export stopped? */
+    return SCPE_OK;
+sim_perf_update ();
+_sim_perf_export ();
+return sim_activate_after_d (uptr, sim_perf_interval * 1000000.0);
+}
+
+/* SET PERF EXPORT=file and NOEXPORT */
+
+static t_stat sim_perf_set_export (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+char gbuf[CBUFSIZE];
+
+free (sim_perf_file);
+sim_perf_file = NULL;
+sim_cancel (&sim_perf_unit);
+if (val == 0) {                                     /* NOEXPORT? */
+    if ((cptr != NULL) && (*cptr != 0))
+        return SCPE_2MARG;
+    return SCPE_OK;
+    }
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+get_glyph_nc (cptr, gbuf, 0);
+sim_perf_file = strdup (gbuf);
+sim_perf_update ();
+return _sim_perf_export ();                         /* make sure it can be written */
+}
+
+/* SET PERF INTERVAL=seconds */
+
+static t_stat sim_perf_set_interval (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+int32 secs;
+t_stat r;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+secs = (int32) get_uint (cptr, 10, 86400, &r);
+if ((r != SCPE_OK) || (secs == 0))
+    return sim_messagef (SCPE_ARG, "Invalid export interval: %s\n", cptr);
+sim_perf_interval = secs;
+if (sim_is_active (&sim_perf_unit)) {               /* reschedule a pending export */
+    sim_cancel (&sim_perf_unit);
+    _sim_perf_start ();
+    }
+return SCPE_OK;
+}
+
+static t_stat sim_perf_show_export (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+if (sim_perf_file)
+    fprintf (st, "exporting to %s every %d second%s", sim_perf_file, sim_perf_interval, (sim_perf_interval == 1) ? "" : "s");
+else
+    fprintf (st, "not exporting");
+return SCPE_OK;
+}
+
+static t_stat sim_perf_show_counters (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+sim_perf_update ();
+fprintf (st, "instructions=%.0f, events=%.0f, asynch=%.0f, idle=%.0fms, ", 
+             (double)sim_perf_instr, (double)sim_perf_events, (double)sim_perf_asynch, (double)sim_perf_idle_ms);
+fprintf (st, "calibrations=%.0f, %u inst/sec, calib err=%ums", 
+             (double)sim_perf_calibrations, sim_perf_ips, sim_perf_calib_err);
+return SCPE_OK;
+}
+
 /* SET CLOCK command */
 
 t_stat sim_set_timers (int32 arg, CONST char *cptr)
@@ -1674,6 +2247,77 @@ if ((sim_idle_rate_ms == 0) || (sim_idle_cyc_ms == 0)) {/* not possible? */
     sim_debug (DBG_IDL, &sim_timer_dev, "not possible idle_rate_ms=%d - cyc/ms=%d\n", sim_idle_rate_ms, sim_idle_cyc_ms);
     return FALSE;
     }
+if (sim_evlog_active () &&                              /* recording or replaying events */
+    (!sim_asynch_timer) &&                              /*   with clocks driven by sim_interval */
+    (sim_interval > 0)) {                               /*   and time left before the next event? */
+    /* How long the host actually slept mustn't decide how far simulated 
+       time moves, so idling always runs to the next event. */
+    t_uint64 w_ns = (((t_uint64)sim_interval) * (NANOS_PER_SEC/1000)) / sim_idle_cyc_ms;
+
+    sim_debug (DBG_IDL, &sim_timer_dev, "idling %.0f usecs - pending event on %s in %d instructions\n", w_ns / 1000.0, (sim_clock_queue == QUEUE_LIST_END) ? "" : sim_uname (sim_clock_queue), sim_interval);
+    if (sim_warp_enab) {
+        sim_warp_ns += w_ns;
+        ++sim_warp_count;
+        }
+    else {
+#if defined(SIM_IDLE_NS_SLEEP)
+        sim_idle_ns_sleep (w_ns);
+#else
+        sim_idle_ms_sleep ((uint32)(w_ns / (NANOS_PER_SEC/1000)));
+#endif
+        }
+    rtc->clock_time_idled += (uint32)(w_ns / (NANOS_PER_SEC/1000));
+    sim_interval = 0;                                   /* next event is due now */
+    sim_idle_end_time = sim_gtime();
+    return TRUE;
+    }
+if (sim_warp_enab &&                                    /* warping */
+    (!sim_asynch_timer) &&                              /*   with clocks driven by sim_interval */
+    (sim_interval > 0) &&                               /*   and time left before the next event */
+    (!_sim_warp_io_pending ())) {                       /*   and no I/O in flight? */
+    t_uint64 w_ns = (((t_uint64)sim_interval) * (NANOS_PER_SEC/1000)) / sim_idle_cyc_ms;
+    t_uint64 idled_ns = w_ns + sim_idle_ns_residue;
+
+    sim_warp_ns += w_ns;                                /* move wall time forward */
+    ++sim_warp_count;
+    rtc->clock_time_idled += (uint32)(idled_ns / (NANOS_PER_SEC/1000));
+    sim_idle_ns_residue = (uint32)(idled_ns % (NANOS_PER_SEC/1000));
+    sim_debug (DBG_IDL, &sim_timer_dev, "warping %.0f usecs - pending event on %s in %d instructions\n", w_ns / 1000.0, (sim_clock_queue == QUEUE_LIST_END) ? "" : sim_uname (sim_clock_queue), sim_interval);
+    sim_interval = 0;                                   /* next event is due now */
+    sim_idle_end_time = sim_gtime();
+    return TRUE;
+    }
+#if defined(SIM_IDLE_NS_SLEEP)
+/* With nanosecond sleeps there is no host tick to round to.  Sleep until 
+   the next event is due (less the host's wakeup overshoot) and count down 
+   sim_interval by the instructions which would have run while asleep. */
+if (sim_idle_ns_min != 0) {
+    t_uint64 w_ns, act_ns, idled_ns;
+
+    w_ns = (sim_interval <= 0) ? 0 : (((t_uint64)sim_interval) * (NANOS_PER_SEC/1000)) / sim_idle_cyc_ms;
+    if (w_ns <= 2 * (t_uint64)sim_idle_ns_min) {        /* not worth sleeping? */
+        sim_interval -= sin_cyc;
+        if (!in_nowait)
+            sim_debug (DBG_IDL, &sim_timer_dev, "no wait, too short: %u nsecs\n", (uint32)w_ns);
+        in_nowait = TRUE;
+        return FALSE;
+        }
+    in_nowait = FALSE;
+    if (sim_clock_queue == QUEUE_LIST_END)
+        sim_debug (DBG_IDL, &sim_timer_dev, "sleeping for %.0f usecs - pending event in %d instructions\n", w_ns / 1000.0, sim_interval);
+    else
+        sim_debug (DBG_IDL, &sim_timer_dev, "sleeping for %.0f usecs - pending event on %s in %d instructions\n", w_ns / 1000.0, sim_uname(sim_clock_queue), sim_interval);
+    act_ns = sim_idle_ns_sleep (w_ns - sim_idle_ns_min);/* wait */
+    idled_ns = act_ns + sim_idle_ns_residue;            /* total time idled is kept in msecs */
+    rtc->clock_time_idled += (uint32)(idled_ns / (NANOS_PER_SEC/1000));
+    sim_idle_ns_residue = (uint32)(idled_ns % (NANOS_PER_SEC/1000));
+    act_cyc = (int32)MIN((act_ns * sim_idle_cyc_ms) / (NANOS_PER_SEC/1000), (t_uint64)sim_interval);
+    sim_interval = sim_interval - act_cyc;              /* count down sim_interval to reflect idle period */
+    sim_idle_end_time = sim_gtime();                    /* save idle completed time */
+    sim_debug (DBG_IDL, &sim_timer_dev, "slept for %.0f usecs - pending event in %d instructions\n", act_ns / 1000.0, sim_interval);
+    return TRUE;
+    }
+#endif
 w_ms = (uint32) sim_interval / sim_idle_cyc_ms;         /* ms to wait */
 /* When the host system has a clock tick which is less frequent than the    */
 /* simulated system's clock, idling will cause delays which will miss       */
@@ -1729,7 +2373,8 @@ if (cptr && *cptr) {
     sim_idle_stable = v;
     }
 sim_idle_enab = TRUE;
-if (sim_throt_type != SIM_THROT_NONE) {
+if ((sim_throt_type != SIM_THROT_NONE) &&               /* fair share throttling can idle */
+    (sim_throt_type != SIM_THROT_FAIR)) {
     sim_set_throt (0, NULL);
     sim_printf ("Throttling disabled\n");
     }
@@ -1759,6 +2404,353 @@ return SCPE_OK;
 
 /* Throttling package */
 
+/* Fair share throttling
+
+   Simulators on one host which SET THROTTLE FAIR cooperate through a small
+   scoreboard in shared memory.  About once a second each of them publishes
+   its weight, the host CPU it used and the host CPU it wants: a full core
+   if it used all of its share, otherwise what it used plus some headroom.
+   Every instance computes the same weighted max-min division of the host's
+   CPUs among the active instances (those wanting less than their weighted
+   share get what they want and the rest is divided among the others) and
+   throttles itself to its own part of it.  Nobody is held back while the
+   instances together want no more than the host has.
+
+   Throttling sleeps after a number of instructions which is adjusted each
+   second so that the process CPU time used converges on the share.  The
+   slots of instances which stop updating are reclaimed after a few seconds.
+*/
+
+#define SIM_THROT_FAIR_MAGIC      0x46414952        /* "FAIR" */
+#define SIM_THROT_FAIR_SLOTS      128               /* instances per scoreboard */
+#define SIM_THROT_FAIR_PERIOD_MS  1000              /* share recomputation period */
+#define SIM_THROT_FAIR_STALE_MS   5000              /* slot abandoned when not updated for */
+#define SIM_THROT_FAIR_SLEEP_MS   10                /* throttle sleep time */
+#define SIM_THROT_FAIR_UNIT       1000.0            /* CPU amounts are in 1/1000ths of a core */
+
+typedef struct {
+    int32               id;                         /* owning process id (0 = free) */
+    int32               weight;                     /* relative weight */
+    int32               demand;                     /* CPU wanted */
+    int32               used;                       /* CPU used in the last period */
+    int32               share;                      /* CPU share computed in the last period */
+    int32               heartbeat;                  /* sim_os_msec () of the last update */
+    } THROT_SLOT;
+
+typedef struct {
+    int32               magic;                      /* SIM_THROT_FAIR_MAGIC (-1 while initializing) */
+    int32               slots;                      /* SIM_THROT_FAIR_SLOTS */
+    int32               cpus;                       /* host CPUs shared */
+    THROT_SLOT          slot[SIM_THROT_FAIR_SLOTS];
+    } THROT_BOARD;
+
+static SHMEM *sim_throt_fair_shmem = NULL;
+static THROT_BOARD *sim_throt_fair_board = NULL;
+static int32 sim_throt_fair_slot = -1;              /* our scoreboard slot */
+static char sim_throt_fair_group[CBUFSIZE];         /* scoreboard name */
+static double sim_throt_fair_share = 1.0;           /* our share of a host CPU */
+static double sim_throt_fair_used = 0.0;            /* host CPU used in the last period */
+static int32 sim_throt_fair_active = 0;             /* instances sharing the host */
+static t_bool sim_throt_fair_limiting = FALSE;      /* sleeping to hold to the share */
+static uint32 sim_throt_fair_ms_last = 0;           /* time of last update */
+static double sim_throt_fair_cpu_last = 0.0;        /* process CPU msecs at last update */
+
+static int32 _sim_throt_fair_pid (void)
+{
+#if defined (_WIN32)
+return (int32)GetCurrentProcessId ();
+#else
+return (int32)getpid ();
+#endif
+}
+
+static int32 _sim_throt_fair_host_cpus (void)
+{
+#if defined (_WIN32)
+SYSTEM_INFO info;
+
+GetSystemInfo (&info);
+return (int32)info.dwNumberOfProcessors;
+#elif defined (_SC_NPROCESSORS_ONLN)
+long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+return (cpus > 0) ? (int32)cpus : 1;
+#else
+return 1;
+#endif
+}
+
+/* Process CPU time in milliseconds */
+
+static double _sim_throt_fair_cpu_ms (void)
+{
+#if defined (_WIN32)
+FILETIME create, exit, kernel, user;
+ULARGE_INTEGER k, u;
+
+if (!GetProcessTimes (GetCurrentProcess (), &create, &exit, &kernel, &user))
+    return 0.0;
+k.LowPart = kernel.dwLowDateTime;
+k.HighPart = kernel.dwHighDateTime;
+u.LowPart = user.dwLowDateTime;
+u.HighPart = user.dwHighDateTime;
+return (double)(k.QuadPart + u.QuadPart) / 10000.0;
+#else
+return (1000.0 * (double)clock ()) / CLOCKS_PER_SEC;
+#endif
+}
+
+static void _sim_throt_fair_leave (void)
+{
+if (sim_throt_fair_board && (sim_throt_fair_slot >= 0))
+    sim_throt_fair_board->slot[sim_throt_fair_slot].id = 0;
+sim_throt_fair_slot = -1;
+sim_shmem_close (sim_throt_fair_shmem);
+sim_throt_fair_shmem = NULL;
+sim_throt_fair_board = NULL;
+sim_throt_fair_limiting = FALSE;
+sim_throt_fair_share = 1.0;
+}
+
+/* Join a scoreboard.  The number of host CPUs shared belongs to the group:
+   the first instance to join sets it (from CPUS=n or the host's CPU count)
+   and later instances may only repeat the same CPUS=n. */
+
+static t_stat _sim_throt_fair_join (const char *group, int32 weight, int32 cpus)
+{
+char name[CBUFSIZE];
+THROT_BOARD *b;
+void *addr;
+int32 i, id = _sim_throt_fair_pid (), now = (int32)sim_os_msec ();
+int32 tries, others = 0;
+t_stat r = SCPE_OK;
+
+if ((sim_throt_fair_board == NULL) || strcmp (group, sim_throt_fair_group)) {
+    _sim_throt_fair_leave ();
+    snprintf (name, sizeof (name), "simh-throttle-%s", group);
+    for (tries = 0; tries < 10; tries++) {              /* another instance may be creating it */
+        r = sim_shmem_open (name, sizeof (THROT_BOARD), &sim_throt_fair_shmem, &addr);
+        if (r == SCPE_OK)
+            break;
+        sim_os_ms_sleep (10);
+        }
+    if (r != SCPE_OK)
+        return sim_messagef (SCPE_OPENERR, "Can't open the fair share throttle scoreboard %s\n", name);
+    b = sim_throt_fair_board = (THROT_BOARD *)addr;
+    if (sim_shmem_atomic_cas (&b->magic, 0, -1)) {      /* first user initializes it */
+        b->slots = SIM_THROT_FAIR_SLOTS;
+        b->cpus = (int32)(_sim_throt_fair_host_cpus () * SIM_THROT_FAIR_UNIT);
+        b->magic = SIM_THROT_FAIR_MAGIC;
+        }
+    for (tries = 0; (b->magic == -1) && (tries < 100); tries++)
+        sim_os_ms_sleep (10);
+    if ((b->magic != SIM_THROT_FAIR_MAGIC) || (b->slots != SIM_THROT_FAIR_SLOTS)) {
+        _sim_throt_fair_leave ();
+        return sim_messagef (SCPE_INCOMP, "Incompatible fair share throttle scoreboard %s\n", name);
+        }
+    strlcpy (sim_throt_fair_group, group, sizeof (sim_throt_fair_group));
+    }
+b = sim_throt_fair_board;
+for (i = 0; (sim_throt_fair_slot < 0) && (i < SIM_THROT_FAIR_SLOTS); i++) {
+    int32 owner = b->slot[i].id;
+
+    if (((owner == 0) ||                                /* free or */
+         (((uint32)now - (uint32)b->slot[i].heartbeat) > SIM_THROT_FAIR_STALE_MS)) &&/* abandoned? */
+        sim_shmem_atomic_cas (&b->slot[i].id, owner, id))
+        sim_throt_fair_slot = i;
+    }
+if (sim_throt_fair_slot < 0) {
+    _sim_throt_fair_leave ();
+    return sim_messagef (SCPE_NXM, "All %d fair share throttle slots are in use\n", SIM_THROT_FAIR_SLOTS);
+    }
+for (i = 0; i < SIM_THROT_FAIR_SLOTS; i++)             /* count the other members */
+    if ((i != sim_throt_fair_slot) && (b->slot[i].id != 0) &&
+        (((uint32)now - (uint32)b->slot[i].heartbeat) <= SIM_THROT_FAIR_STALE_MS))
+        ++others;
+if (others == 0)                                        /* alone, so the count is ours */
+    b->cpus = (int32)(((cpus > 0) ? cpus : _sim_throt_fair_host_cpus ()) * SIM_THROT_FAIR_UNIT);
+else {
+    if ((cpus > 0) && (b->cpus != (int32)(cpus * SIM_THROT_FAIR_UNIT))) {
+        double shared = b->cpus / SIM_THROT_FAIR_UNIT;
+
+        _sim_throt_fair_leave ();
+        return sim_messagef (SCPE_ARG, "Fair share throttle group %s already shares %.2f host CPUs among %d other instance%s\n", 
+                                       group, shared, others, (others == 1) ? "" : "s");
+        }
+    }
+b->slot[sim_throt_fair_slot].weight = weight;
+b->slot[sim_throt_fair_slot].demand = (int32)SIM_THROT_FAIR_UNIT;
+b->slot[sim_throt_fair_slot].used = 0;
+b->slot[sim_throt_fair_slot].share = (int32)SIM_THROT_FAIR_UNIT;
+b->slot[sim_throt_fair_slot].heartbeat = now;
+sim_throt_fair_ms_last = (uint32)now;
+sim_throt_fair_cpu_last = _sim_throt_fair_cpu_ms ();
+sim_throt_fair_share = 1.0;
+sim_throt_fair_used = 0.0;
+sim_throt_fair_active = 1;
+sim_throt_fair_limiting = FALSE;
+return SCPE_OK;
+}
+
+/* Publish our use, divide the host among the active instances and
+   adjust the interval between throttle sleeps toward our share.  Returns
+   FALSE if our slot was taken over and no other slot could be had. */
+
+static t_bool _sim_throt_fair_update (uint32 now)
+{
+THROT_BOARD *b = sim_throt_fair_board;
+THROT_SLOT *me = &b->slot[sim_throt_fair_slot];
+double cpu = _sim_throt_fair_cpu_ms ();
+double demand, left, weights, fair, ratio;
+double want[SIM_THROT_FAIR_SLOTS], got[SIM_THROT_FAIR_SLOTS];
+int32 i, active = 0;
+t_bool changed;
+
+if (now == sim_throt_fair_ms_last)
+    return TRUE;
+sim_throt_fair_used = (cpu - sim_throt_fair_cpu_last) / (double)(now - sim_throt_fair_ms_last);
+sim_throt_fair_cpu_last = cpu;
+sim_throt_fair_ms_last = now;
+if (me->id != _sim_throt_fair_pid ()) {                 /* slot taken over while we were stopped? */
+    sim_throt_fair_slot = -1;
+    if (_sim_throt_fair_join (sim_throt_fair_group, (int32)sim_throt_val, 0) != SCPE_OK)
+        return FALSE;                                   /* scoreboard closed */
+    me = &b->slot[sim_throt_fair_slot];
+    }
+if (sim_throt_fair_limiting && (sim_throt_fair_used >= 0.9 * sim_throt_fair_share))
+    demand = 1.0;                                       /* held back, wants all it can get */
+else
+    demand = MIN (1.0, 1.25 * sim_throt_fair_used + 0.05);
+me->demand = (int32)(demand * SIM_THROT_FAIR_UNIT);
+me->used = (int32)(sim_throt_fair_used * SIM_THROT_FAIR_UNIT);
+me->heartbeat = (int32)now;
+for (i = 0; i < SIM_THROT_FAIR_SLOTS; i++) {            /* gather the active instances */
+    want[i] = got[i] = -1.0;
+    if ((b->slot[i].id != 0) && (b->slot[i].weight > 0) &&
+        ((now - (uint32)b->slot[i].heartbeat) <= SIM_THROT_FAIR_STALE_MS)) {
+        want[i] = b->slot[i].demand / SIM_THROT_FAIR_UNIT;
+        ++active;
+        }
+    }
+left = b->cpus / SIM_THROT_FAIR_UNIT;
+do {                                                    /* satisfy those wanting less than a fair share */
+    changed = FALSE;
+    for (i = 0, weights = 0.0; i < SIM_THROT_FAIR_SLOTS; i++)
+        if ((want[i] >= 0.0) && (got[i] < 0.0))
+            weights += b->slot[i].weight;
+    for (i = 0; (weights > 0.0) && (i < SIM_THROT_FAIR_SLOTS); i++) {
+        if ((want[i] < 0.0) || (got[i] >= 0.0))
+            continue;
+        fair = (left * b->slot[i].weight) / weights;
+        if (want[i] <= fair) {
+            got[i] = want[i];
+            left -= want[i];
+            changed = TRUE;
+            }
+        }
+    } while (changed);
+for (i = 0, weights = 0.0; i < SIM_THROT_FAIR_SLOTS; i++)
+    if ((want[i] >= 0.0) && (got[i] < 0.0))
+        weights += b->slot[i].weight;
+for (i = 0; i < SIM_THROT_FAIR_SLOTS; i++)              /* divide the rest by weight */
+    if ((want[i] >= 0.0) && (got[i] < 0.0))
+        got[i] = (left * b->slot[i].weight) / weights;
+sim_throt_fair_active = active;
+sim_throt_fair_share = MIN (1.0, got[sim_throt_fair_slot]);
+me->share = (int32)(sim_throt_fair_share * SIM_THROT_FAIR_UNIT);
+if (sim_throt_fair_share >= MIN (demand, 0.995)) {     /* not held back? */
+    if (sim_throt_fair_limiting)
+        sim_debug (DBG_THR, &sim_timer_dev, "_sim_throt_fair_update() Share %.3f of %d instances covers demand %.3f, throttling stopped\n",
+                                            sim_throt_fair_share, active, demand);
+    sim_throt_fair_limiting = FALSE;
+    sim_throt_wait = MAX (SIM_THROT_WMIN, (int32)(sim_timer_inst_per_sec () / 10.0));
+    return TRUE;
+    }
+if (!sim_throt_fair_limiting) {                         /* start from the calibrated rate */
+    sim_throt_wait = (int32)((sim_timer_inst_per_sec () * sim_throt_fair_share * sim_throt_sleep_time) / 
+                             (1000.0 * (1.0 - sim_throt_fair_share)));
+    sim_throt_fair_limiting = TRUE;
+    }
+else {                                                  /* then converge on the share */
+    ratio = (sim_throt_fair_used > 0.01) ? sim_throt_fair_share / sim_throt_fair_used : 2.0;
+    ratio = MAX (0.5, MIN (2.0, ratio));
+    sim_throt_wait = (int32)(sim_throt_wait * ratio);
+    }
+sim_throt_wait = MAX (SIM_THROT_WMIN, sim_throt_wait);
+sim_debug (DBG_THR, &sim_timer_dev, "_sim_throt_fair_update() Used %.3f, share %.3f of %d instances, wait = %d\n",
+                                    sim_throt_fair_used, sim_throt_fair_share, active, sim_throt_wait);
+return TRUE;
+}
+
+static t_stat _sim_throt_fair_svc (UNIT *uptr)
+{
+uint32 now;
+
+if (sim_throt_fair_board == NULL) {                     /* left the group? */
+    sim_throt_type = SIM_THROT_NONE;
+    return SCPE_OK;
+    }
+if (sim_throt_fair_limiting)
+    sim_idle_ms_sleep (sim_throt_sleep_time);
+now = sim_os_msec ();
+if (((now - sim_throt_fair_ms_last) >= SIM_THROT_FAIR_PERIOD_MS) &&
+    !_sim_throt_fair_update (now)) {
+    sim_printf ("Fair share throttling stopped: no free slot in group %s\n", sim_throt_fair_group);
+    sim_throt_type = SIM_THROT_NONE;                    /* no scoreboard, so stop throttling */
+    return SCPE_OK;
+    }
+return sim_activate (uptr, sim_throt_wait);
+}
+
+/* Parse FAIR{=weight}{,CPUS=n}{,GROUP=name} */
+
+static t_stat _sim_throt_fair_set (CONST char *cptr)
+{
+char gbuf[CBUFSIZE], group[CBUFSIZE] = "default";
+char *vptr;
+int32 weight = 100, cpus = 0;
+t_stat r;
+
+while (*cptr) {
+    cptr = get_glyph_nc (cptr, gbuf, ',');
+    vptr = strchr (gbuf, '=');
+    if (vptr)
+        *vptr++ = '\0';
+    if (0 == sim_strcasecmp (gbuf, "FAIR")) {
+        if (vptr) {
+            weight = (int32)get_uint (vptr, 10, 10000, &r);
+            if ((r != SCPE_OK) || (weight == 0))
+                return sim_messagef (SCPE_ARG, "Invalid fair share weight: %s\n", vptr);
+            }
+        }
+    else if ((0 == sim_strcasecmp (gbuf, "CPUS")) && vptr) {
+        cpus = (int32)get_uint (vptr, 10, 4096, &r);
+        if ((r != SCPE_OK) || (cpus == 0))
+            return sim_messagef (SCPE_ARG, "Invalid fair share CPU count: %s\n", vptr);
+        }
+    else if ((0 == sim_strcasecmp (gbuf, "GROUP")) && vptr && *vptr && (strlen (vptr) < 64) &&
+             (strspn (vptr, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-") == strlen (vptr)))
+        strlcpy (group, vptr, sizeof (group));
+    else
+        return sim_messagef (SCPE_ARG, "Invalid fair share throttle option: %s%s%s\n", gbuf, vptr ? "=" : "", vptr ? vptr : "");
+    }
+r = _sim_throt_fair_join (group, weight, cpus);
+if (r != SCPE_OK) {
+    if (sim_throt_type == SIM_THROT_FAIR) {             /* no longer in any group */
+        sim_throt_type = SIM_THROT_NONE;
+        sim_throt_cancel ();
+        }
+    return r;
+    }
+sim_throt_type = SIM_THROT_FAIR;
+sim_throt_val = (uint32)weight;
+sim_throt_sleep_time = MAX (sim_idle_rate_ms, SIM_THROT_FAIR_SLEEP_MS);
+sim_throt_state = SIM_THROT_STATE_THROTTLE;
+sim_throt_wait = MAX (SIM_THROT_WMIN, (int32)(sim_timer_inst_per_sec () / 10.0));
+return SCPE_OK;
+}
+
+
 t_stat sim_set_throt (int32 arg, CONST char *cptr)
 {
 CONST char *tptr;
@@ -1768,6 +2760,8 @@ t_value val, val2 = 0;
 if (arg == 0) {
     if ((cptr != NULL) && (*cptr != 0))
         return sim_messagef (SCPE_ARG, "Unexpected NOTHROTTLE argument: %s\n", cptr);
+    if (sim_throt_type == SIM_THROT_FAIR)
+        _sim_throt_fair_leave ();
     sim_throt_type = SIM_THROT_NONE;
     sim_throt_cancel ();
     }
@@ -1777,6 +2771,8 @@ else if (sim_idle_rate_ms == 0) {
 else {
     if (*cptr == '\0')
         return sim_messagef (SCPE_ARG, "Missing throttle mode specification\n");
+    if (0 == sim_strncasecmp (cptr, "FAIR", 4))
+        return _sim_throt_fair_set (cptr);
     val = strtotv (cptr, &tptr, 10);
     if (cptr == tptr)
         return sim_messagef (SCPE_ARG, "Invalid throttle specification: %s\n", cptr);
@@ -1796,6 +2792,7 @@ else {
     else if ((c == '/') && (val2 != 0))
         sim_throt_type = SIM_THROT_SPC;
     else return sim_messagef (SCPE_ARG, "Invalid throttle specification: %s\n", cptr);
+    _sim_throt_fair_leave ();
     if (sim_idle_enab) {
         sim_printf ("Idling disabled\n");
         sim_clr_idle (NULL, 0, NULL, NULL);
@@ -1858,11 +2855,34 @@ else {
         fprintf (st, "Throttling by sleeping for:    %d ms every %d cycles\n", sim_throt_sleep_time, sim_throt_val);
         break;
 
+    case SIM_THROT_FAIR:
+        fprintf (st, "Throttle:                      fair share, weight %d, group %s\n", sim_throt_val, sim_throt_fair_group);
+        if (sim_throt_fair_board)
+            fprintf (st, "Sharing:                       %.2f host CPUs among %d instances\n", sim_throt_fair_board->cpus / SIM_THROT_FAIR_UNIT, sim_throt_fair_active);
+        fprintf (st, "Target Share:                  %.1f%% of a host CPU\n", 100.0 * sim_throt_fair_share);
+        fprintf (st, "Achieved Share:                %.1f%% of a host CPU\n", 100.0 * sim_throt_fair_used);
+        if (sim_throt_fair_limiting)
+            fprintf (st, "Throttling by sleeping for:    %d ms every %d cycles\n", sim_throt_sleep_time, sim_throt_wait);
+        if ((flag || (sim_switches & SWMASK ('D'))) && sim_throt_fair_board) {
+            int32 i;
+            uint32 now = sim_os_msec ();
+
+            for (i = 0; i < SIM_THROT_FAIR_SLOTS; i++) {
+                const THROT_SLOT *sp = &sim_throt_fair_board->slot[i];
+
+                if ((sp->id == 0) || ((now - (uint32)sp->heartbeat) > SIM_THROT_FAIR_STALE_MS))
+                    continue;
+                fprintf (st, "  Process %-8d weight %-5d wants %5.1f%%  target %5.1f%%  used %5.1f%%\n", (int)sp->id, (int)sp->weight,
+                             sp->demand / 10.0, sp->share / 10.0, sp->used / 10.0);
+                }
+            }
+        break;
+
     default:
         fprintf (st, "Throttling:                    Disabled\n");
         break;
         }
-    if (sim_throt_type != SIM_THROT_NONE) {
+    if ((sim_throt_type != SIM_THROT_NONE) && (sim_throt_type != SIM_THROT_FAIR)) {
         if (sim_throt_state != SIM_THROT_STATE_THROTTLE)
             fprintf (st, "Throttle State:                %s - wait: %d\n", (sim_throt_state == SIM_THROT_STATE_INIT) ? "Waiting for Init" : "Timing", sim_throt_wait);
         }
@@ -1909,6 +2929,8 @@ uint32 delta_ms;
 double a_cps, d_cps, delta_inst;
 RTC *rtc = NULL;
 
+if (sim_throt_type == SIM_THROT_FAIR)
+    return _sim_throt_fair_svc (uptr);
 if (sim_calb_tmr != -1)
     rtc = &rtcs[sim_calb_tmr];
 switch (sim_throt_state) {
@@ -2092,31 +3114,31 @@ t_stat sim_timer_tick_svc (UNIT *uptr)
 int32 tmr = (int32)(uptr-sim_timer_units);
 t_stat stat;
 RTC *rtc = &rtcs[tmr];
+uint32 slot;
+UNIT *sptr, *cptr;
+UNIT *first = QUEUE_LIST_END, *last = NULL;
 
 rtc->clock_ticks += 1;
 rtc->calib_tick_time += rtc->clock_tick_size;
 /*
  * Some devices may depend on executing during the same instruction or 
  * immediately after the clock tick event.  To satisfy this, we directly 
- * run the clock event here and if it completes successfully, schedule any
- * currently coschedule units to run now.  Ticks should never return a 
- * non-success status, while co-schedule activities might, so they are 
- * queued to run from sim_process_event
+ * run the clock event here and then schedule any currently coscheduled
+ * units to run now.  The wheel advances on every tick, even when the
+ * clock's action returns a non-success status (a breakpoint or stop),
+ * so coscheduled units never slip behind the ticks.  Co-schedule
+ * activities may return non-success statuses, so they are queued to run
+ * from sim_process_event
  */
-sim_debug (DBG_QUE, &sim_timer_dev, "sim_timer_tick_svc(tmr=%d) - scheduling %s - cosched interval: %d\n", tmr, sim_uname (rtc->clock_unit), rtc->cosched_interval);
+sim_debug (DBG_QUE, &sim_timer_dev, "sim_timer_tick_svc(tmr=%d) - scheduling %s - coscheduled units: %u\n", tmr, sim_uname (rtc->clock_unit), rtc->cosched_count);
 if (rtc->clock_unit->action == NULL)
     return SCPE_IERR;
 stat = rtc->clock_unit->action (rtc->clock_unit);
---rtc->cosched_interval;                    /* Countdown ticks */
-if (rtc->clock_cosched_queue != QUEUE_LIST_END)
-    rtc->clock_cosched_queue->time = rtc->cosched_interval;
-if ((stat == SCPE_OK)                               && 
-    (rtc->cosched_interval <= 0)                &&
-    (rtc->clock_cosched_queue != QUEUE_LIST_END)) {
-    UNIT *sptr = rtc->clock_cosched_queue;
-    UNIT *cptr = QUEUE_LIST_END;
-
-    if (rtc->clock_catchup_eligible) {      /* calibration started? */
+slot = rtc->cosched_slot;
+sptr = rtc->cosched_wheel[slot];
+rtc->cosched_slot = (slot + 1) & SIM_COSCHED_MASK;      /* Advance the wheel */
+if (sptr != QUEUE_LIST_END) {
+    if (rtc->clock_catchup_eligible) {  /* calibration started? */
         struct timespec now;
         double skew;
 
@@ -2126,40 +3148,49 @@ if ((stat == SCPE_OK)                               &&
         if (fabs(skew) > fabs(rtc->clock_skew_max))
             rtc->clock_skew_max = skew;
         }
-    /* Gather any queued events which are scheduled for right now */
-    do {
-        cptr = rtc->clock_cosched_queue;
-        rtc->clock_cosched_queue = cptr->next;
-        if (rtc->clock_cosched_queue != QUEUE_LIST_END) {
-            rtc->clock_cosched_queue->time += rtc->cosched_interval;
-            rtc->cosched_interval = rtc->clock_cosched_queue->time;
-            }
-        else
-            rtc->cosched_interval  = 0;
-        } while ((rtc->cosched_interval <= 0) &&
-                 (rtc->clock_cosched_queue != QUEUE_LIST_END));
-    if (cptr != QUEUE_LIST_END)
-        cptr->next = QUEUE_LIST_END;
-    /* Now dispatch that list (in order). */
+    rtc->cosched_wheel[slot] = QUEUE_LIST_END;
+    rtc->cosched_tail[slot] = NULL;
+    /* Gather the slot's units which are due now (in order), */
+    /* leaving those with further turns of the wheel to go */
     while (sptr != QUEUE_LIST_END) {
         cptr = sptr;
         sptr = sptr->next;
-        cptr->next = NULL;
+        cptr->next = QUEUE_LIST_END;
+        if (cptr->time >= SIM_COSCHED_SLOTS) {
+            cptr->time -= SIM_COSCHED_SLOTS;
+            if (rtc->cosched_tail[slot] == NULL)
+                rtc->cosched_wheel[slot] = cptr;
+            else
+                rtc->cosched_tail[slot]->next = cptr;
+            rtc->cosched_tail[slot] = cptr;
+            continue;
+            }
+        --rtc->cosched_count;
         cptr->cancel = NULL;
         cptr->time = 0;
         if (cptr->usecs_remaining) {
-            sim_debug (DBG_QUE, &sim_timer_dev, "Rescheduling %s after %.0f usecs %s%s\n", sim_uname (cptr), cptr->usecs_remaining, (sptr != QUEUE_LIST_END) ? "- next: " : "", (sptr != QUEUE_LIST_END) ? sim_uname (sptr) : "");
-            stat = sim_timer_activate_after (cptr, cptr->usecs_remaining);
-            }
-        else {
-            sim_debug (DBG_QUE, &sim_timer_dev, "Activating %s now %s%s\n", sim_uname (cptr), (sptr != QUEUE_LIST_END) ? "- next: " : "", (sptr != QUEUE_LIST_END) ? sim_uname (sptr) : "");
-            stat = _sim_activate (cptr, 0);
-            }
-        if (stat != SCPE_OK) {
-            sim_debug (DBG_QUE, &sim_timer_dev, "Activating %s failed: %s\n", sim_uname (cptr), sim_error_text (stat));
-            break;
+            t_stat rstat;
+
+            cptr->next = NULL;
+            sim_debug (DBG_QUE, &sim_timer_dev, "Rescheduling %s after %.0f usecs\n", sim_uname (cptr), cptr->usecs_remaining);
+            rstat = sim_timer_activate_after (cptr, cptr->usecs_remaining);
+            if (rstat != SCPE_OK) {
+                sim_debug (DBG_QUE, &sim_timer_dev, "Activating %s failed: %s\n", sim_uname (cptr), sim_error_text (rstat));
+                if (stat == SCPE_OK)
+                    stat = rstat;
+                }
+            continue;
             }
+        sim_debug (DBG_QUE, &sim_timer_dev, "Activating %s now\n", sim_uname (cptr));
+        if (last == NULL)
+            first = cptr;
+        else
+            last->next = cptr;
+        last = cptr;
         }
+    /* Now queue the due units to run now, in a single pass */
+    if (last != NULL)
+        _sim_activate_list (first, last);
     }
 return stat;
 }
@@ -2173,6 +3204,16 @@ void sim_rtcn_get_time (struct timespec *now, int tmr)
 {
 sim_debug (DBG_GET, &sim_timer_dev, "sim_rtcn_get_time(tmr=%d)\n", tmr);
 clock_gettime (CLOCK_REALTIME, now);
+if (sim_warp_ns != 0) {
+    t_uint64 nsec = (t_uint64)now->tv_nsec + sim_warp_ns;
+
+    now->tv_sec += (time_t)(nsec / NANOS_PER_SEC);
+    now->tv_nsec = (long)(nsec % NANOS_PER_SEC);
+    }
+if (sim_evlog_active ()) {
+    now->tv_sec = (time_t)sim_evlog_value ("TODSEC", (t_int64)now->tv_sec);
+    now->tv_nsec = (long)sim_evlog_value ("TODNSEC", (t_int64)now->tv_nsec);
+    }
 }
 
 /* 
@@ -2217,14 +3258,15 @@ static t_bool _rtcn_tick_catchup_check (RTC *rtc, int32 time)
 int32 tmr;
 t_bool bReturn = FALSE;
 
-if (!sim_catchup_ticks)
+if ((!sim_catchup_ticks) ||                              /* catchup disabled or */
+    sim_evlog_active ())                                /*   host time mustn't inject ticks? */
     return FALSE;
 if (time == -1) {
     for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
         rtc = &rtcs[tmr];
         if ((rtc->hz > 0) && rtc->clock_catchup_eligible)
             {
-            double tnow = sim_timenow_double();
+            double tnow = _sim_warp_timenow_double ();
 
             if (tnow > (rtc->clock_catchup_base_time + (rtc->calib_tick_time + rtc->clock_tick_size))) {
                 if (!rtc->clock_catchup_pending) {
@@ -2241,7 +3283,7 @@ if (time == -1) {
     }
 if ((!rtc->clock_catchup_eligible) &&           /* not eligible yet? */
     (time != -1)) {                             /* called from ack? */
-    rtc->clock_catchup_base_time = sim_timenow_double();
+    rtc->clock_catchup_base_time = _sim_warp_timenow_double ();
     rtc->clock_ticks_tot += rtc->clock_ticks;
     rtc->clock_ticks = 0;
     rtc->calib_tick_time_tot += rtc->calib_tick_time;
@@ -2257,7 +3299,7 @@ if ((!rtc->clock_catchup_eligible) &&           /* not eligible yet? */
 if ((rtc->hz > 0) && 
     rtc->clock_catchup_eligible)
     {
-    double tnow = sim_timenow_double();
+    double tnow = _sim_warp_timenow_double ();
 
     if (tnow > (rtc->clock_catchup_base_time + (rtc->calib_tick_time + rtc->clock_tick_size))) {
         if (!rtc->clock_catchup_pending) {
@@ -2474,8 +3516,8 @@ if (tmr == SIM_NTIMERS) {                   /* None found? */
                 /* appropriately. */
                 /* temporarily restore prior hz to get correct remaining time */
                 crtc->hz = crtc->last_hz;
-                while (crtc->clock_cosched_queue != QUEUE_LIST_END) {
-                    UNIT *uptr = crtc->clock_cosched_queue;
+                while (crtc->cosched_count != 0) {
+                    UNIT *uptr = _sim_coschedule_first (crtc);
                     double usecs_remaining = sim_timer_activate_time_usecs (uptr) - 1;
 
                     _sim_coschedule_cancel (uptr);
@@ -2520,8 +3562,8 @@ else {
             /* appropriately. */
             /* temporarily restore prior hz to get correct remaining time */
             crtc->hz = crtc->last_hz;
-            while (crtc->clock_cosched_queue != QUEUE_LIST_END) {
-                UNIT *uptr = crtc->clock_cosched_queue;
+            while (crtc->cosched_count != 0) {
+                UNIT *uptr = _sim_coschedule_first (crtc);
                 double usecs_remaining = sim_timer_activate_time_usecs (uptr) - 1;
 
                 _sim_coschedule_cancel (uptr);
@@ -2555,7 +3597,7 @@ return SCPE_OK;
 void sim_start_timer_services (void)
 {
 int32 tmr;
-uint32 sim_prompt_time = sim_os_msec () - sim_stop_time;
+uint32 sim_prompt_time = _sim_warp_msec () - sim_stop_time;
 int32 registered_units = 0;
 
 sim_time_at_sim_prompt +=  (((double)sim_prompt_time) / 1000.0);
@@ -2586,6 +3628,7 @@ else {
     }
 if (sim_timer_stop_time > sim_gtime())
     sim_activate_abs (&sim_stop_unit, (int32)(sim_timer_stop_time - sim_gtime()));
+_sim_perf_start ();                                 /* keep performance counters current */
 #if defined(SIM_ASYNCH_CLOCKS)
 pthread_mutex_lock (&sim_timer_lock);
 if (sim_asynch_timer) {
@@ -2613,6 +3656,8 @@ sim_debug (DBG_TRC, &sim_timer_dev, "sim_stop_timer_services(sim_interval=%d, si
 if (sim_interval < 0)
     sim_interval = 0;               /* No catching up after stopping */
 
+_sim_calib_save ();                 /* Keep the learned execution rates */
+
 for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
     int32 accum;
     RTC *rtc = &rtcs[tmr];
@@ -2630,21 +3675,16 @@ for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
         /* scheduled to fire at the same time as the related */
         /* clock unit is to fire with excess time reflected in */
         /* the unit usecs_remaining value */
-        accum = rtc->cosched_interval;
-        while (rtc->clock_cosched_queue != QUEUE_LIST_END) {
-            UNIT *cptr = rtc->clock_cosched_queue;
+        while (rtc->cosched_count != 0) {
+            UNIT *cptr = _sim_coschedule_first (rtc);
             double usecs_remaining = cptr->usecs_remaining;
 
-            rtc->clock_cosched_queue = cptr->next;
-            cptr->next = NULL;
-            cptr->cancel = NULL;
-            accum += cptr->time;
-            cptr->usecs_remaining = 0.0;
+            accum = _sim_coschedule_ticks (rtc, cptr);
+            _sim_coschedule_cancel (cptr);
             _sim_activate (cptr, clock_time);
             cptr->usecs_remaining = usecs_remaining + floor(1000000.0 * (accum - ((accum > 0) ? 1 : 0)) * rtc->clock_tick_size);
             sim_debug (DBG_QUE, &sim_timer_dev, "sim_stop_timer_services() - tmr=%d scheduling %s after %d and %.0f usecs\n", tmr, sim_uname (cptr), clock_time, cptr->usecs_remaining);
             }
-        rtc->cosched_interval = 0;
         }
     }
 
@@ -2654,7 +3694,8 @@ sim_cancel (&SIM_INTERNAL_UNIT);                    /* Make sure Internal Timer
 sim_cancel (&sim_timer_units[SIM_NTIMERS]);
 sim_calb_tmr_last = sim_calb_tmr;                   /* Save calibrated timer value for display */
 sim_inst_per_sec_last = sim_timer_inst_per_sec ();  /* Save execution rate for display */
-sim_stop_time = sim_os_msec ();                     /* record when execution stopped */
+sim_stop_time = _sim_warp_msec ();                  /* record when execution stopped */
+_sim_perf_stop ();                                  /* counters as of the stop */
 #if defined(SIM_ASYNCH_CLOCKS)
 pthread_mutex_lock (&sim_timer_lock);
 if (sim_timer_thread_running) {
@@ -2892,8 +3933,8 @@ rtc = &rtcs[tmr];
 if (NULL == uptr) {                         /* deregistering? */
     /* Migrate any coscheduled devices to the standard queue */
     /* they will fire and subsequently requeue themselves */
-    while (rtc->clock_cosched_queue != QUEUE_LIST_END) {
-        UNIT *uptr = rtc->clock_cosched_queue;
+    while (rtc->cosched_count != 0) {
+        UNIT *uptr = _sim_coschedule_first (rtc);
         double usecs_remaining = sim_timer_activate_time_usecs (uptr);
 
         _sim_coschedule_cancel (uptr);
@@ -2909,7 +3950,7 @@ if (NULL == uptr) {                         /* deregistering? */
     return SCPE_OK;
     }
 if (NULL == rtc->clock_unit)
-    rtc->clock_cosched_queue = QUEUE_LIST_END;
+    _sim_coschedule_reset (rtc);
 rtc->clock_unit = uptr;
 uptr->dynflags |= UNIT_TMR_UNIT;
 rtc->timer_unit->flags = ((tmr == SIM_NTIMERS) ? 0 : UNIT_DIS) | 
@@ -2951,7 +3992,7 @@ sim_cancel (uptr);
 return sim_clock_coschedule (uptr, interval);
 }
 
-/* ticks - 0 means on the next tick, 1 means the second tick, etc.  */
+/* ticks - 0 or 1 means on the next tick, 2 means the second tick, etc.  */
 
 t_stat sim_clock_coschedule_tmr (UNIT *uptr, int32 tmr, int32 ticks)
 {
@@ -2975,34 +4016,19 @@ if ((NULL == rtc->clock_unit) || (rtc->hz == 0)) {
     return sim_activate (uptr, ticks * (rtc->currd ? rtc->currd : rtcs[sim_rtcn_calibrated_tmr ()].currd));
     }
 else {
-    UNIT *cptr, *prvptr;
-    int32 accum;
+    int32 due = ticks - (ticks > 0);                    /* ticks after the next */
+    uint32 slot = (rtc->cosched_slot + due) & SIM_COSCHED_MASK;
 
-    if (rtc->clock_cosched_queue != QUEUE_LIST_END)
-        rtc->clock_cosched_queue->time = rtc->cosched_interval;
-    prvptr = NULL;
-    accum = 0;
-    for (cptr = rtc->clock_cosched_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-        if (ticks < (accum + cptr->time))
-            break;
-        accum += cptr->time;
-        prvptr = cptr;
-        }
-    if (prvptr == NULL) {
-        cptr = uptr->next = rtc->clock_cosched_queue;
-        rtc->clock_cosched_queue = uptr;
-        }
-    else {
-        cptr = uptr->next = prvptr->next;
-        prvptr->next = uptr;
-        }
-    uptr->time = ticks - accum;
-    if (cptr != QUEUE_LIST_END)
-        cptr->time = cptr->time - uptr->time;
+    uptr->time = (due & ~SIM_COSCHED_MASK) + slot;      /* further turns and slot */
+    uptr->next = QUEUE_LIST_END;
+    if (rtc->cosched_tail[slot] == NULL)                /* append to slot */
+        rtc->cosched_wheel[slot] = uptr;
+    else
+        rtc->cosched_tail[slot]->next = uptr;
+    rtc->cosched_tail[slot] = uptr;
+    ++rtc->cosched_count;
     uptr->cancel = &_sim_coschedule_cancel;             /* bind cleanup method */
-    if (uptr == rtc->clock_cosched_queue)
-        rtc->cosched_interval = rtc->clock_cosched_queue->time;
-    sim_debug (DBG_QUE, &sim_timer_dev, "sim_clock_coschedule_tmr(%s, tmr=%d, ticks=%d, hz=%d) - queueing for clock co-schedule, interval now: %d\n", sim_uname (uptr), tmr, ticks, rtc->hz, rtc->cosched_interval);
+    sim_debug (DBG_QUE, &sim_timer_dev, "sim_clock_coschedule_tmr(%s, tmr=%d, ticks=%d, hz=%d) - queueing for clock co-schedule, coscheduled units now: %u\n", sim_uname (uptr), tmr, ticks, rtc->hz, rtc->cosched_count);
     }
 return SCPE_OK;
 }
@@ -3013,43 +4039,91 @@ sim_cancel (uptr);
 return sim_clock_coschedule_tmr (uptr, tmr, ticks);
 }
 
+/* Empty a timer's coschedule wheel */
+static void _sim_coschedule_reset (RTC *rtc)
+{
+int32 slot;
+
+for (slot = 0; slot < SIM_COSCHED_SLOTS; slot++) {
+    rtc->cosched_wheel[slot] = QUEUE_LIST_END;
+    rtc->cosched_tail[slot] = NULL;
+    }
+rtc->cosched_slot = 0;
+rtc->cosched_count = 0;
+}
+
+/* Earliest unit in the first non empty slot of a timer's coschedule wheel */
+static UNIT *_sim_coschedule_first (RTC *rtc)
+{
+uint32 i;
+
+if (rtc->cosched_count != 0) {
+    for (i = 0; i < SIM_COSCHED_SLOTS; i++) {
+        UNIT *uptr = rtc->cosched_wheel[(rtc->cosched_slot + i) & SIM_COSCHED_MASK];
+
+        if (uptr != QUEUE_LIST_END)
+            return uptr;
+        }
+    }
+return QUEUE_LIST_END;
+}
+
+/* Ticks until a unit on a timer's coschedule wheel is due (1 is the next tick) */
+static int32 _sim_coschedule_ticks (RTC *rtc, UNIT *uptr)
+{
+int32 slot = uptr->time & SIM_COSCHED_MASK;
+
+return (int32)((slot - rtc->cosched_slot) & SIM_COSCHED_MASK) + (uptr->time - slot) + 1;
+}
+
+/* Locate a coscheduled unit, returning its timer (or -1) and ticks until due */
+static int32 _sim_coschedule_find (UNIT *uptr, int32 *ticks)
+{
+int32 tmr;
+
+for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
+    RTC *rtc = &rtcs[tmr];
+    UNIT *cptr;
+
+    for (cptr = rtc->cosched_wheel[uptr->time & SIM_COSCHED_MASK]; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+        if (cptr == uptr) {
+            *ticks = _sim_coschedule_ticks (rtc, uptr);
+            return tmr;
+            }
+        }
+    }
+return -1;
+}
+
 /* Cancel a unit on the coschedule queue */
 static t_bool _sim_coschedule_cancel (UNIT *uptr)
 {
 AIO_UPDATE_QUEUE;
 if (uptr->next) {                           /* On a queue? */
+    int32 slot = uptr->time & SIM_COSCHED_MASK;
     int tmr;
-    UNIT *nptr;
 
     for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
         RTC *rtc = &rtcs[tmr];
+        UNIT *cptr, *prvptr = NULL;
 
-        if (rtc->clock_unit) {
-            if (uptr == rtc->clock_cosched_queue) {
-                nptr = rtc->clock_cosched_queue = uptr->next;
+        for (cptr = rtc->cosched_wheel[slot]; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+            if (cptr == uptr) {             /* found? */
+                if (prvptr == NULL)
+                    rtc->cosched_wheel[slot] = uptr->next;
+                else
+                    prvptr->next = uptr->next;
+                if (rtc->cosched_tail[slot] == uptr)
+                    rtc->cosched_tail[slot] = prvptr;
+                --rtc->cosched_count;
                 uptr->next = NULL;
-                }
-            else {
-                UNIT *cptr;
-
-                for (cptr = rtc->clock_cosched_queue;
-                     (cptr != QUEUE_LIST_END);
-                     cptr = cptr->next) {
-                    if (cptr->next == uptr) {
-                        nptr = cptr->next = (uptr)->next;
-                        uptr->next = NULL;
-                        break;
-                        }
-                    }
-                }
-            if (uptr->next == NULL) {           /* found? */
                 uptr->cancel = NULL;
+                uptr->time = 0;
                 uptr->usecs_remaining = 0;
-                if (nptr != QUEUE_LIST_END)
-                    nptr->time += uptr->time;
                 sim_debug (DBG_QUE, &sim_timer_dev, "Canceled Clock Coscheduled Event for %s\n", sim_uname(uptr));
                 return TRUE;
                 }
+            prvptr = cptr;
             }
         }
     }
@@ -3203,22 +4277,11 @@ if (uptr->a_next)
 #endif /* defined(SIM_ASYNCH_CLOCKS) */
 
 if (uptr->cancel == &_sim_coschedule_cancel) {
-    for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
-        int32 accum = 0;
-        RTC *rtc = &rtcs[tmr];
-
+    int32 accum;
 
-        for (cptr = rtc->clock_cosched_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-            if (cptr == rtc->clock_cosched_queue) {
-                if (rtc->cosched_interval > 0)
-                    accum += rtc->cosched_interval;
-                }
-            else
-                accum += cptr->time;
-            if (cptr == uptr)
-                return (rtc->currd * accum) + sim_activate_time (&sim_timer_units[tmr]);
-            }
-        }
+    tmr = _sim_coschedule_find (uptr, &accum);
+    if (tmr >= 0)
+        return (rtcs[tmr].currd * accum) + sim_activate_time (&sim_timer_units[tmr]);
     }
 for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
     if ((uptr == &sim_timer_units[tmr]) && (uptr->next)){
@@ -3282,23 +4345,15 @@ if (uptr->a_next) {
 #endif /* defined(SIM_ASYNCH_CLOCKS) */
 
 if (uptr->cancel == &_sim_coschedule_cancel) {
-    for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
-        int32 accum = 0;
+    int32 accum;
+
+    tmr = _sim_coschedule_find (uptr, &accum);
+    if (tmr >= 0) {
         RTC *rtc = &rtcs[tmr];
 
-        for (cptr = rtc->clock_cosched_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-            if (cptr == rtc->clock_cosched_queue) {
-                if (rtc->cosched_interval > 0)
-                    accum += rtc->cosched_interval;
-                }
-            else
-                accum += cptr->time;
-            if (cptr == uptr) {
-                result = uptr->usecs_remaining + ceil(1000000.0 * ((rtc->currd * accum) + sim_activate_time (&sim_timer_units[tmr]) - 1) / sim_timer_inst_per_sec ());
-                sim_debug (DBG_QUE, &sim_timer_dev, "sim_timer_activate_time_usecs(%s) coscheduled - %.0f usecs, inst_per_sec=%.0f, tmr=%d, ticksize=%d, ticks=%d, inst_til_tick=%d, usecs_remaining=%.0f\n", sim_uname (uptr), result, sim_timer_inst_per_sec (), tmr, rtc->currd, accum, sim_activate_time (&sim_timer_units[tmr]) - 1, uptr->usecs_remaining);
-                return result;
-                }
-            }
+        result = uptr->usecs_remaining + ceil(1000000.0 * ((rtc->currd * accum) + sim_activate_time (&sim_timer_units[tmr]) - 1) / sim_timer_inst_per_sec ());
+        sim_debug (DBG_QUE, &sim_timer_dev, "sim_timer_activate_time_usecs(%s) coscheduled - %.0f usecs, inst_per_sec=%.0f, tmr=%d, ticksize=%d, ticks=%d, inst_til_tick=%d, usecs_remaining=%.0f\n", sim_uname (uptr), result, sim_timer_inst_per_sec (), tmr, rtc->currd, accum, sim_activate_time (&sim_timer_units[tmr]) - 1, uptr->usecs_remaining);
+        return result;
         }
     }
 for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
@@ -3425,6 +4480,8 @@ start = sim_os_msec();
 sim_instr();
 end = sim_os_msec();
 sim_precalibrate_ips = (int32)(1000.0 * (sim_precalibrate_ips / (double)(end - start)));
+if (sim_evlog_active ())
+    sim_precalibrate_ips = (int32)sim_evlog_value ("PRECALIB", sim_precalibrate_ips);
 
 for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
     RTC *rtc = &rtcs[tmr];
@@ -3443,3 +4500,86 @@ for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
 sim_inst_per_sec_last = sim_precalibrate_ips;
 sim_idle_stable = 0;
 }
+
+/* Unit tests */
+
+static t_stat sim_timer_test_clock_stat;
+
+static t_stat sim_timer_test_clock_svc (UNIT *uptr)
+{
+return sim_timer_test_clock_stat;
+}
+
+static t_stat sim_timer_test_unit_svc (UNIT *uptr)
+{
+return SCPE_OK;
+}
+
+/* Units coscheduled for 0 or 1 ticks run on the next tick and those for
+   n ticks on the n'th tick, and the wheel advances on every tick even
+   when the clock's action returns a stop status */
+
+static t_stat sim_timer_test_cosched (void)
+{
+static const int32 ticks[] = {0, 1, 2, 3, SIM_COSCHED_SLOTS, SIM_COSCHED_SLOTS + 1};
+static const int32 due[]   = {1, 1, 2, 3, SIM_COSCHED_SLOTS, SIM_COSCHED_SLOTS + 1};
+#define TEST_UNITS (sizeof (ticks) / sizeof (ticks[0]))
+UNIT clock, units[TEST_UNITS];
+t_bool reported[TEST_UNITS];
+RTC saved, *rtc;
+int32 tmr, tick;
+uint32 i;
+int errors = 0;
+
+for (tmr = 0; (tmr < SIM_NTIMERS) && (rtcs[tmr].clock_unit != NULL); tmr++)
+    ;
+if (tmr == SIM_NTIMERS)                             /* no unused timer? */
+    return SCPE_OK;
+rtc = &rtcs[tmr];
+saved = *rtc;
+memset (&clock, 0, sizeof (clock));
+memset (units, 0, sizeof (units));
+memset (reported, 0, sizeof (reported));
+clock.action = &sim_timer_test_clock_svc;
+rtc->clock_unit = &clock;
+rtc->hz = 100;
+rtc->clock_catchup_eligible = FALSE;
+_sim_coschedule_reset (rtc);
+for (i = 0; i < TEST_UNITS; i++) {
+    units[i].action = &sim_timer_test_unit_svc;
+    sim_clock_coschedule_tmr (&units[i], tmr, ticks[i]);
+    if (_sim_coschedule_ticks (rtc, &units[i]) != due[i]) {
+        sim_printf ("timer: unit coscheduled for %d ticks reported due in %d ticks\n", ticks[i], _sim_coschedule_ticks (rtc, &units[i]));
+        ++errors;
+        }
+    }
+for (tick = 1; tick <= SIM_COSCHED_SLOTS + 1; tick++) {
+    sim_timer_test_clock_stat = (tick == 2) ? SCPE_STOP : SCPE_OK;
+    sim_timer_tick_svc (&sim_timer_units[tmr]);
+    for (i = 0; i < TEST_UNITS; i++) {
+        t_bool ran = (units[i].cancel != &_sim_coschedule_cancel);
+
+        if ((ran != (tick >= due[i])) && !reported[i]) {
+            sim_printf ("timer: unit coscheduled for %d ticks %s on tick %d\n", ticks[i], ran ? "ran" : "had not run", tick);
+            reported[i] = TRUE;
+            ++errors;
+            }
+        }
+    }
+for (i = 0; i < TEST_UNITS; i++)
+    sim_cancel (&units[i]);
+*rtc = saved;
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+#include <setjmp.h>
+
+t_stat sim_timer_test (void)
+{
+t_stat stat = SCPE_OK;
+SIM_TEST_INIT;
+
+sim_printf ("Testing sim_timer APIs\n");
+SIM_TEST(sim_timer_test_cosched ());
+return stat;
+}
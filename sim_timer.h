@@ -95,6 +95,7 @@ int clock_gettime(int clock_id, struct timespec *tp);
 #define SIM_THROT_KCYC            2                 /* KiloCycles Per Sec */
 #define SIM_THROT_PCT             3                 /* Max Percent of host CPU */
 #define SIM_THROT_SPC             4                 /* Specific periodic Delay */
+#define SIM_THROT_FAIR            5                 /* Fair share of host CPUs with other instances */
 #define SIM_THROT_STATE_INIT      0                 /* Starting */
 #define SIM_THROT_STATE_TIME      1                 /* Checking Time */
 #define SIM_THROT_STATE_THROTTLE  2                 /* Throttling  */
@@ -104,6 +105,7 @@ int clock_gettime(int clock_id, struct timespec *tp);
 #define TIMER_DBG_MUX   0x004                       /* Debug Flag for Asynch Queue Debugging */
 
 t_bool sim_timer_init (void);
+t_stat sim_timer_test (void);                           /* unit test routine */
 void sim_timespec_diff (struct timespec *diff, struct timespec *min, struct timespec *sub);
 double sim_timenow_double (void);
 int32 sim_rtcn_init (int32 time, int32 tmr);
@@ -158,11 +160,15 @@ t_stat sim_os_set_thread_priority (int below_normal_above);
 uint32 sim_get_rom_delay_factor (void);
 void sim_set_rom_delay_factor (uint32 delay);
 int32 sim_rom_read_with_delay (int32 val);
+void sim_perf_update (void);
 
 extern t_bool sim_idle_enab;                        /* idle enabled flag */
 extern volatile t_bool sim_idle_wait;               /* idle waiting flag */
 extern t_bool sim_asynch_timer;
 extern DEVICE sim_timer_dev;
+extern DEVICE sim_perf_dev;
+extern t_value sim_perf_events;                     /* events processed */
+extern t_value sim_perf_asynch;                     /* asynchronous I/O completions */
 extern UNIT * volatile sim_clock_cosched_queue[SIM_NTIMERS+1];
 extern const t_bool rtc_avail;
 
@@ -67,10 +67,12 @@
    tmxr_reset_ln -                      reset line (drops Telnet/tcp and serial connections)
    tmxr_detach_ln -                     reset line and close per line listener and outgoing destination
    tmxr_getc_ln -                       get character for line
+   tmxr_read_ln -                       get characters for line
    tmxr_get_packet_ln -                 get packet from line
    tmxr_get_packet_ln_ex -              get packet from line with separater byte
    tmxr_poll_rx -                       poll receive
    tmxr_putc_ln -                       put character for line
+   tmxr_write_ln -                      put characters for line
    tmxr_put_packet_ln -                 put packet on line
    tmxr_put_packet_ln_ex -              put packet on line with separator byte
    tmxr_poll_tx -                       poll transmit
@@ -147,6 +149,8 @@
 
         sim> atta MUX 23,Log=LogFileName
         sim> atta MUX Connect=ser0,Log=LogFileName
+        sim> atta MUX 23,Record=RecordFileName
+        sim> atta MUX 23,Buffered,Replay=RecordFileName;MAX
 
     Specifying a Log value for a multi-line multiplexer is specifying a 
     template filename.  The actual file name used for each line will be
@@ -449,10 +453,61 @@ static u_char mantra[] = {                  /* Telnet Option Negotiation Mantra
 
 #define TMXR_LINE_DISABLED (-1)
 
+/* Input replay state of a line (see _tmxr_replay_poll) */
+
+typedef struct {
+    double              delay;                          /* seconds after the previous record */
+    uint8               *data;                          /* input data */
+    uint32              size;                           /* input data size */
+    } TMXR_REPLAY_REC;
+
+struct tmxr_replay {
+    char                *name;                          /* replay file name */
+    double              rate;                           /* pace multiplier (0 = as fast as possible) */
+    int32               count;                          /* number of records */
+    TMXR_REPLAY_REC     *rec;                           /* records */
+    int32               next;                           /* next record to queue */
+    double              start;                          /* time replay started (0 = not yet) */
+    double              due;                            /* time next record is due */
+    double              sent;                           /* time last record was queued */
+    t_bool              awaiting;                       /* awaiting guest response to last record */
+    int32               responses;                      /* response latency samples */
+    double              latsum;                         /* total response latency (seconds) */
+    double              latmin;                         /* min response latency (seconds) */
+    double              latmax;                         /* max response latency (seconds) */
+    };
+
 /* Local routines */
 
 static void tmxr_add_to_open_list (TMXR* mux);
 
+/* Return the receive and transmit buffer size of an unbuffered line */
+
+static int32 _tmxr_ln_bufsize (const TMLN *lp)
+{
+if (lp->bufsize)
+    return lp->bufsize;
+if (lp->mp && lp->mp->bufsize)
+    return lp->mp->bufsize;
+return TMXR_MAXBUF;
+}
+
+/* Record the time queued input waited before a device first consumed it */
+
+static void _tmxr_rx_consumed (TMLN *lp)
+{
+double latency;
+
+if (lp->rxarrive == 0.0)                                /* not timing anything? */
+    return;
+latency = sim_timenow_double () - lp->rxarrive;
+lp->rxarrive = 0.0;
+lp->rxlatsum = lp->rxlatsum + latency;
+if (latency > lp->rxlatmax)
+    lp->rxlatmax = latency;
+++lp->rxlatcnt;
+}
+
 /* Initialize the line state.
 
    Reset the line state to represent an idle line.  Note that we do not clear
@@ -469,6 +524,8 @@ static void tmxr_init_line (TMLN *lp)
 lp->tsta = 0;                                           /* init telnet state */
 lp->xmte = 1;                                           /* enable transmit */
 lp->dstb = 0;                                           /* default bin mode */
+lp->rxdrp = lp->rxdrp + (lp->rxbpi - lp->rxbpr);        /* count unread input */
+lp->rxarrive = 0.0;
 lp->rxbpr = lp->rxbpi = lp->rxcnt = lp->rxpcnt = 0;     /* init receive indexes */
 if (!lp->txbfd || lp->notelnet)                         /* if not buffered telnet */
     lp->txbpr = lp->txbpi = lp->txcnt = lp->txpcnt = 0; /*   init transmit indexes */
@@ -476,9 +533,9 @@ lp->txdrp = lp->txstall = 0;
 tmxr_set_get_modem_bits (lp, 0, 0, NULL);
 if (lp->mp && (!lp->mp->buffered) && (!lp->txbfd)) {
     lp->txbfd = 0;
-    lp->txbsz = TMXR_MAXBUF;
+    lp->txbsz = _tmxr_ln_bufsize (lp);
     lp->txb = (char *)realloc (lp->txb, lp->txbsz);
-    lp->rxbsz = TMXR_MAXBUF;
+    lp->rxbsz = lp->txbsz;
     lp->rxb = (char *)realloc(lp->rxb, lp->rxbsz);
     lp->rbr = (char *)realloc(lp->rbr, lp->rxbsz);
     }
@@ -588,6 +645,157 @@ if (lp->notelnet)
 tmxr_linemsgf (lp, "\r\nDisconnected from the %s simulator\r\n\n", sim_name);/* report disconnection */
 }
 
+/* Event log support (see sim_evlog_input)
+
+   A line's input is logged as "<dev>:<line>".  Connections made and 
+   ringing raised by the host side of a multiplexer are logged as 
+   "<dev>:CONN" events and lines closed after a host I/O error as 
+   "<dev>:<line>:DISC" events, so that a replay connects, rings and 
+   disconnects the same lines at the same points of the run without 
+   any network sessions or serial ports being involved.  Disconnects 
+   the simulated system asks for happen again by themselves.
+*/
+
+#define TMXR_EV_CONN    'C'                             /* line connected */
+#define TMXR_EV_RING    'R'                             /* ring raised on idle lines */
+#define TMXR_EV_NOANS   'N'                             /* ring not answered */
+#define TMXR_EV_DISC    'D'                             /* line closed */
+
+static const char *_tmxr_evlog_source (TMXR *mp, int32 ln, const char *event)
+{
+static char source[CBUFSIZE];
+const char *dname = mp->dptr ? sim_dname (mp->dptr) : "MUX";
+
+if (ln < 0)
+    snprintf (source, sizeof (source), "%s:%s", dname, event);
+else
+    if (event)
+        snprintf (source, sizeof (source), "%s:%d:%s", dname, (int)ln, event);
+    else
+        snprintf (source, sizeof (source), "%s:%d", dname, (int)ln);
+return source;
+}
+
+static void _tmxr_evlog_conn_event (TMXR *mp, int32 ln, uint8 event)
+{
+uint8 ev[4];
+
+if (!sim_evlog_active () || sim_evlog_replaying ())     /* not recording? */
+    return;
+ev[0] = event;
+ev[1] = (uint8)(ln >> 8);
+ev[2] = (uint8)ln;
+ev[3] = (ln >= 0) ? (uint8)mp->ldsc[ln].notelnet : 0;
+sim_evlog_input (_tmxr_evlog_source (mp, -1, "CONN"), ev, sizeof (ev), sizeof (ev));
+}
+
+/* Note a line closed after a host side I/O error */
+
+static void _tmxr_evlog_disc (TMLN *lp)
+{
+uint8 ev = TMXR_EV_DISC;
+
+if (!sim_evlog_active () || sim_evlog_replaying ())     /* not recording? */
+    return;
+sim_evlog_input (_tmxr_evlog_source (lp->mp, (int32)(lp - lp->mp->ldsc), "DISC"), &ev, 1, 1);
+}
+
+/* Return TRUE when a replayed connection was closed at this point */
+
+static t_bool _tmxr_evlog_disc_due (TMLN *lp)
+{
+uint8 ev;
+
+return (lp->evlog_conn && sim_evlog_replaying () &&
+        (sim_evlog_input (_tmxr_evlog_source (lp->mp, (int32)(lp - lp->mp->ldsc), "DISC"), &ev, 0, 1) > 0));
+}
+
+/* Raise the ring signal on the lines which could answer an incoming call */
+
+static int32 _tmxr_ring_lines (TMXR *mp)
+{
+int32 j, ringable_count = 0;
+
+for (j = 0; j < mp->lines; j++) {
+    TMLN *lp = mp->ldsc + j;
+
+    if ((lp->conn == FALSE) &&                          /* is the line available? */
+        (lp->destination == NULL) &&
+        (lp->master == 0) &&
+        (lp->ser_connect_pending == FALSE) &&
+        ((lp->modembits & TMXR_MDM_DTR) == 0)) {
+        ++ringable_count;
+        lp->modembits |= TMXR_MDM_RNG;
+        tmxr_debug_connect_line (lp, "tmxr_poll_conn() - Ringing line");
+        }
+    }
+return ringable_count;
+}
+
+/* Turn off the ring signal on the lines which didn't answer */
+
+static void _tmxr_ring_off (TMXR *mp)
+{
+int ln;
+
+for (ln = 0; ln < mp->lines; ln++) {
+    TMLN *tlp = mp->ldsc + ln;
+    if (((tlp->destination == NULL) && (tlp->master == 0)) &&
+        (tlp->modembits & TMXR_MDM_RNG) && (tlp->conn == FALSE))
+        tlp->modembits &= ~TMXR_MDM_RNG;
+    }
+}
+
+/* Connect a line as an event log replay says the host side did */
+
+static void _tmxr_evlog_connect (TMLN *lp, t_bool notelnet)
+{
+if (lp->serport || lp->loopback) {                      /* serial port or loopback? */
+    lp->ser_connect_pending = FALSE;
+    lp->conn = TRUE;
+    return;
+    }
+lp->conn = TRUE;                                        /* record connection */
+lp->evlog_conn = TRUE;                                  /*   without a socket */
+tmxr_init_line (lp);                                    /* init line */
+lp->notelnet = notelnet;
+if (!lp->notelnet) {
+    lp->telnet_sent_opts = (uint8 *)realloc (lp->telnet_sent_opts, 256);
+    memset (lp->telnet_sent_opts, 0, 256);
+    }
+tmxr_report_connection (lp->mp, lp);
+lp->cnms = sim_os_msec ();                              /* time of connection */
+}
+
+/* Replay the connection events which are due */
+
+static int32 _tmxr_evlog_poll_conn (TMXR *mp)
+{
+uint8 ev[4];
+int32 ln;
+
+if (sim_evlog_input (_tmxr_evlog_source (mp, -1, "CONN"), ev, 0, sizeof (ev)) != sizeof (ev))
+    return -1;
+ln = (int32)((ev[1] << 8) | ev[2]);
+switch (ev[0]) {
+    case TMXR_EV_CONN:
+        if ((ln >= mp->lines) || mp->ldsc[ln].conn)
+            break;
+        _tmxr_evlog_connect (mp->ldsc + ln, ev[3]);
+        return ln;
+    case TMXR_EV_RING:
+        if (_tmxr_ring_lines (mp) == 0)
+            break;
+        mp->ring_evlog = TRUE;
+        return -2;
+    case TMXR_EV_NOANS:
+        _tmxr_ring_off (mp);
+        mp->ring_evlog = FALSE;
+        break;
+    }
+return -1;
+}
+
 static int32 loop_write_ex (TMLN *lp, char *buf, int32 length, t_bool prefix_datagram)
 {
 int32 written = 0;
@@ -729,7 +937,12 @@ else {
             }
         }
     else {
-        if ((lp->conn == TMXR_LINE_DISABLED) ||
+        if (lp->evlog_conn) {                           /* connection replayed from an event log? */
+            if (_tmxr_evlog_disc_due (lp))              /* host side closed here? */
+                return -1;
+            written = length;                           /* output goes nowhere */
+            }
+        else if ((lp->conn == TMXR_LINE_DISABLED) ||
             ((lp->conn == 0) && lp->txbfd)){
             written = length;                           /* Count here output timing is correct */
             if (lp->conn == TMXR_LINE_DISABLED)
@@ -746,22 +959,19 @@ return written;
 }
 
 
-/* Remove a character from the read buffer.
-
-   The character at position "p" in the read buffer associated with line "lp" is
-   removed by moving all of the following received characters down one position.
-   The receive break status array is adjusted accordingly.
-*/
+/* Return the length of the run of received characters which need no Telnet
+   processing.  Only an IAC (and a CR when the Telnet binary mode is off)
+   can start something the Telnet state machine must see. */
 
-static void tmxr_rmvrc (TMLN *lp, int32 p)
+static int32 _tmxr_telnet_run (const char *buf, int32 len, int32 crpad)
 {
-for ( ; p < lp->rxbpi; p++) {                           /* work from "p" through end of buffer */
-    lp->rxb[p] = lp->rxb[p + 1];                        /* slide following character down */
-    lp->rbr[p] = lp->rbr[p + 1];                        /* adjust break status too */
-    }
+const char *eptr = (const char *)memchr (buf, TN_IAC, len);
 
-lp->rbr[p] = 0;                                         /* clear potential break from vacated slot */
-lp->rxbpi = lp->rxbpi - 1;                              /* drop buffer insert index */
+if (eptr)
+    len = (int32)(eptr - buf);
+if (crpad && (NULL != (eptr = (const char *)memchr (buf, TN_CR, len))))
+    len = (int32)(eptr - buf);
+return len;
 }
 
 
@@ -878,6 +1088,16 @@ if (mp->logfiletmpl[0])                                 /* logfile info */
     sprintf (growstring(&tptr, 7 + strlen (mp->logfiletmpl)), ",Log=%s", mp->logfiletmpl);
 if (mp->buffered)
     sprintf (growstring(&tptr, 10 + 10), ",Buffered=%d", mp->buffered);
+if (mp->bufsize)
+    sprintf (growstring(&tptr, 10 + 10), ",BufSize=%d", mp->bufsize);
+if (mp->backlog)
+    sprintf (growstring(&tptr, 10 + 10), ",Backlog=%d", mp->backlog);
+if (mp->reuseport)
+    strcpy (growstring(&tptr, 12), ",ReusePort");
+if (mp->recordtmpl[0])
+    sprintf (growstring(&tptr, 10 + strlen (mp->recordtmpl)), ",Record=%s", mp->recordtmpl);
+if (mp->replaytmpl[0])
+    sprintf (growstring(&tptr, 10 + strlen (mp->replaytmpl)), ",Replay=%s", mp->replaytmpl);
 while ((*tptr == ',') || (*tptr == ' '))
     memmove (tptr, tptr+1, strlen(tptr+1)+1);
 for (i=0; i<mp->lines; ++i) {
@@ -921,13 +1141,15 @@ return tptr;
 char *tmxr_line_attach_string(TMLN *lp)
 {
 char* tptr = NULL;
+t_bool record = (lp->rxrecordname && !lp->mp->recordtmpl[0]);/* line specific record/replay */
+t_bool replay = (lp->replay && !lp->mp->replaytmpl[0]);
 
 tptr = (char *) calloc (1, 1);
 
 if (tptr == NULL)                                       /* no more mem? */
     return tptr;
 
-if (lp->destination || lp->port || lp->txlogname || (lp->conn == TMXR_LINE_DISABLED)) {
+if (lp->destination || lp->port || lp->txlogname || record || replay || (lp->conn == TMXR_LINE_DISABLED)) {
     if ((lp->mp->lines > 1) || (lp->port))
         sprintf (growstring(&tptr, 32), "Line=%d", (int)(lp-lp->mp->ldsc));
     if (lp->conn == TMXR_LINE_DISABLED)
@@ -938,6 +1160,8 @@ if (lp->destination || lp->port || lp->txlogname || (lp->conn == TMXR_LINE_DISAB
         sprintf (growstring(&tptr, 32), ",Buffered=%d", lp->txbsz);
     if (!lp->txbfd && (lp->mp->buffered > 0))
         sprintf (growstring(&tptr, 32), ",UnBuffered");
+    if (lp->bufsize && (lp->bufsize != lp->mp->bufsize))
+        sprintf (growstring(&tptr, 32), ",BufSize=%d", lp->bufsize);
     if (lp->mp->datagram != lp->datagram)
         sprintf (growstring(&tptr, 8), ",%s", lp->datagram ? "UDP" : "TCP");
     if (lp->mp->packet != lp->packet)
@@ -956,6 +1180,16 @@ if (lp->destination || lp->port || lp->txlogname || (lp->conn == TMXR_LINE_DISAB
         }
     if (lp->txlogname)
         sprintf (growstring(&tptr, 12 + strlen (lp->txlogname)), ",Log=%s", lp->txlogname);
+    if (record)
+        sprintf (growstring(&tptr, 10 + strlen (lp->rxrecordname)), ",Record=%s", lp->rxrecordname);
+    if (replay) {
+        if (lp->replay->rate == 1.0)
+            sprintf (growstring(&tptr, 10 + strlen (lp->replay->name)), ",Replay=%s", lp->replay->name);
+        else if (lp->replay->rate == 0.0)
+            sprintf (growstring(&tptr, 14 + strlen (lp->replay->name)), ",Replay=%s;MAX", lp->replay->name);
+        else
+            sprintf (growstring(&tptr, 40 + strlen (lp->replay->name)), ",Replay=%s;%g", lp->replay->name, lp->replay->rate);
+        }
     if (lp->loopback)
         sprintf (growstring(&tptr, 12 ), ",Loopback");
     }
@@ -979,6 +1213,227 @@ mp->poll_interval = seconds;
 return SCPE_OK;
 }
 
+/* Socket readiness tracking
+
+   On hosts with epoll each multiplexer keeps an epoll descriptor which
+   watches its master listening socket and every line's connected,
+   connecting and listening sockets.  The poll routines collect the pending
+   readiness events once and then only read, accept or check connection
+   completion on the sockets which have something to report, so idle lines
+   cost no system calls.  A socket is registered the first time a poll
+   routine sees it and is unregistered before the library closes it.
+   Host serial ports are watched for input the same way, so one epoll
+   descriptor serves all of a multiplexer's serial lines too.
+
+   Without epoll, or if the descriptor can't be created, every socket is
+   considered ready and each poll visits every line as it always has.
+*/
+
+#if defined(HAVE_EPOLL)
+#include <sys/epoll.h>
+#endif
+
+#define TMXR_WATCH_MASTER       0                       /* mux master listening socket */
+#define TMXR_WATCH_RX           1                       /* line data socket */
+#define TMXR_WATCH_CONN         2                       /* line outgoing connecting socket */
+#define TMXR_WATCH_LISTEN       3                       /* line listening socket */
+#define TMXR_WATCH_TAG(line, kind)  (((uint32)(line) << 2) | (kind))
+
+static void _tmxr_unwatch (TMXR *mp, SOCKET *watch)
+{
+#if defined(HAVE_EPOLL)
+if ((mp == NULL) || (mp->poll_fd <= 0) || (*watch == 0))
+    return;
+epoll_ctl (mp->poll_fd, EPOLL_CTL_DEL, *watch, NULL);   /* socket is still open here */
+--mp->poll_watched;
+#endif
+*watch = 0;
+}
+
+/* Forget any readiness registration for a line socket about to be closed */
+
+static void _tmxr_unwatch_ln (TMLN *lp, SOCKET sock)
+{
+if (sock == 0)
+    return;
+if (lp->rx_watch == sock)
+    _tmxr_unwatch (lp->mp, &lp->rx_watch);
+if (lp->conn_watch == sock)
+    _tmxr_unwatch (lp->mp, &lp->conn_watch);
+if (lp->master_watch == sock)
+    _tmxr_unwatch (lp->mp, &lp->master_watch);
+}
+
+/* Collect pending readiness events.  Returns TRUE if readiness is tracked
+   for this multiplexer, FALSE if all sockets must be polled directly. */
+
+static t_bool _tmxr_poll_ready (TMXR *mp)
+{
+#if defined(HAVE_EPOLL)
+struct epoll_event *events;
+int i, count;
+
+if (mp->poll_fd == 0) {                                 /* first use? */
+    mp->poll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    if (mp->poll_fd == 0) {                             /* 0 means unopened, so don't use it */
+        close (mp->poll_fd);
+        mp->poll_fd = -1;
+        }
+    }
+if (mp->poll_fd < 0)
+    return FALSE;
+if (mp->poll_watched == 0)
+    return TRUE;
+if (mp->poll_events_size < mp->poll_watched) {          /* room for everything that could be ready */
+    free (mp->poll_events);
+    mp->poll_events_size = mp->poll_watched + 16;
+    mp->poll_events = calloc (mp->poll_events_size, sizeof (*events));
+    }
+events = (struct epoll_event *)mp->poll_events;
+count = epoll_wait (mp->poll_fd, events, mp->poll_events_size, 0);
+for (i = 0; i < count; i++) {
+    uint32 line = events[i].data.u32 >> 2;
+    uint32 kind = events[i].data.u32 & 3;
+
+    if (kind == TMXR_WATCH_MASTER)
+        mp->ready = 1;
+    else
+        if (line < (uint32)mp->lines)
+            mp->ldsc[line].ready |= (1u << kind);
+    }
+return TRUE;
+#else
+return FALSE;
+#endif
+}
+
+/* Decide whether a socket in a particular role needs attention.  Sockets
+   which aren't registered yet are registered and reported as ready so that
+   they get polled once directly.  The kind's readiness is consumed. */
+
+static t_bool _tmxr_sock_ready (TMXR *mp, TMLN *lp, SOCKET sock, SOCKET *watch, uint32 kind)
+{
+#if defined(HAVE_EPOLL)
+uint32 *ready = lp ? &lp->ready : &mp->ready;
+uint32 bit = lp ? (1u << kind) : 1;
+struct epoll_event ev;
+
+if ((mp->poll_fd <= 0) || (sock == 0))
+    return TRUE;
+if (*watch != sock) {                                   /* socket changed? */
+    if (*watch)                                         /* stop watching the prior one */
+        _tmxr_unwatch (mp, watch);
+    if (lp)                                             /* a connecting socket becomes the data socket */
+        _tmxr_unwatch_ln (lp, sock);
+    memset (&ev, 0, sizeof (ev));
+    ev.events = (kind == TMXR_WATCH_CONN) ? EPOLLOUT : (EPOLLIN | EPOLLRDHUP);
+    ev.data.u32 = TMXR_WATCH_TAG(lp ? (lp - mp->ldsc) : 0, kind);
+    if (epoll_ctl (mp->poll_fd, EPOLL_CTL_ADD, sock, &ev) == 0) {
+        ++mp->poll_watched;
+        *watch = sock;
+        }
+    else                                                /* not watched, so it stays always ready */
+        sim_debug (TMXR_DBG_ASY, mp->dptr, "Can't watch socket %d for readiness: %s\n", (int)sock, strerror (errno));
+    *ready &= ~bit;
+    return TRUE;
+    }
+if (*ready & bit) {
+    *ready &= ~bit;
+    return TRUE;
+    }
+return FALSE;
+#else
+return TRUE;
+#endif
+}
+
+static t_bool _tmxr_ln_rx_ready (TMLN *lp)
+{
+if (lp->loopback || (lp->mp == NULL))                   /* not a socket or serial port read? */
+    return TRUE;
+if (lp->serport) {
+    int fd = sim_serial_fd (lp->serport);
+
+    if (fd <= 0)                                        /* can't wait on this port? */
+        return TRUE;
+    return _tmxr_sock_ready (lp->mp, lp, (SOCKET)fd, &lp->rx_watch, TMXR_WATCH_RX);
+    }
+return _tmxr_sock_ready (lp->mp, lp, lp->sock, &lp->rx_watch, TMXR_WATCH_RX);
+}
+
+/* Close a line's serial port, forgetting its readiness registration first */
+
+static void _tmxr_close_serial (TMLN *lp)
+{
+int fd = sim_serial_fd (lp->serport);
+
+if (fd > 0)
+    _tmxr_unwatch_ln (lp, (SOCKET)fd);
+sim_close_serial (lp->serport);
+}
+
+static void _tmxr_poll_close (TMXR *mp)
+{
+int i;
+
+for (i = 0; i < mp->lines; i++) {
+    mp->ldsc[i].rx_watch = mp->ldsc[i].conn_watch = mp->ldsc[i].master_watch = 0;
+    mp->ldsc[i].ready = 0;
+    }
+mp->master_watch = 0;
+mp->ready = 0;
+#if defined(HAVE_EPOLL)
+if (mp->poll_fd > 0)
+    close (mp->poll_fd);
+#endif
+mp->poll_fd = 0;
+mp->poll_watched = 0;
+free (mp->poll_events);
+mp->poll_events = NULL;
+mp->poll_events_size = 0;
+}
+
+/* Accepted connection batches
+
+   When a backlog is configured the listening socket is created with a full
+   depth accept queue, and every pending connection (up to the backlog) is
+   accepted each time it becomes readable.  The accepted sockets wait here
+   and are handed to lines one per tmxr_poll_conn call without waiting for
+   the connection poll interval, so a burst of reconnects is drained in as
+   many calls as there are connections rather than as many poll intervals.
+*/
+
+static void _tmxr_accept_batch (TMXR *mp)
+{
+char msg[80];
+
+mp->acc_next = 0;
+mp->acc_count = sim_accept_conns_ex (mp->master, mp->acc_sock, mp->acc_ipad, mp->backlog, (mp->packet ? SIM_SOCK_OPT_NODELAY : 0));
+if (mp->acc_count == 0)
+    return;
+++mp->acc_batches;
+if (mp->acc_count > mp->acc_batch_max)
+    mp->acc_batch_max = mp->acc_count;
+snprintf (msg, sizeof (msg), "tmxr_poll_conn() - Accepted %d pending connection%s", mp->acc_count, (mp->acc_count == 1) ? "" : "s");
+tmxr_debug_connect (mp, msg);
+}
+
+static void _tmxr_accept_flush (TMXR *mp)
+{
+for (; mp->acc_next < mp->acc_count; mp->acc_next++) {  /* close connections never assigned */
+    sim_close_sock (mp->acc_sock[mp->acc_next]);
+    free (mp->acc_ipad[mp->acc_next]);
+    }
+mp->acc_count = mp->acc_next = 0;
+}
+
+static SOCKET _tmxr_master_sock (const char *listen, t_bool backlog, t_bool reuseport, int *parse_status)
+{
+return sim_master_sock_ex (listen, parse_status, ((sim_switches & SWMASK ('U')) ? SIM_SOCK_OPT_REUSEADDR : 0) |
+                                                 (backlog ? SIM_SOCK_OPT_BACKLOG : 0) |
+                                                 (reuseport ? SIM_SOCK_OPT_REUSEPORT : 0));
+}
+
 /* Poll for new connection
 
    Called from unit service routine to test for new connection
@@ -992,6 +1447,10 @@ return SCPE_OK;
    not -1 (indicating default order), then the order array is used to find an
    open line.  Otherwise, a search is made of all lines in numerical sequence.
 
+   When accepts are batched (see _tmxr_accept_batch) the listening socket
+   is checked on every call, rather than once per poll interval, and the
+   connections accepted in a batch are assigned one per call.
+
 */
 
 int32 tmxr_poll_conn (TMXR *mp)
@@ -1004,6 +1463,7 @@ int32 ringing = -1;
 char *address;
 char msg[512];
 uint32 poll_time = sim_os_msec ();
+t_bool too_soon;
 
 memset (msg, 0, sizeof (msg));
 if (mp->last_poll_time == 0) {                          /* first poll initializations */
@@ -1043,16 +1503,25 @@ if (mp->last_poll_time == 0) {                          /* first poll initializa
         }
     }
 
-if ((poll_time - mp->last_poll_time) < mp->poll_interval*1000)
-    return -1;                                          /* too soon to try */
+if (sim_evlog_replaying ())                             /* connections come from an event log? */
+    return _tmxr_evlog_poll_conn (mp);
 
-srand((unsigned int)poll_time);
-tmxr_debug_trace (mp, "tmxr_poll_conn()");
+too_soon = ((poll_time - mp->last_poll_time) < mp->poll_interval*1000);
+if (too_soon &&                                         /* too soon to try */
+    ((!mp->backlog) || (!mp->master)))                  /*   unless batching accepts on the listener? */
+    return -1;
+
+if (!too_soon) {
+    srand((unsigned int)poll_time);
+    tmxr_debug_trace (mp, "tmxr_poll_conn()");
+    mp->last_poll_time = poll_time;
+    }
 
-mp->last_poll_time = poll_time;
+_tmxr_poll_ready (mp);                                  /* collect socket readiness */
 
 /* Check for a pending Telnet/tcp connection */
 
+next_accepted:
 if (mp->master) {
     if (mp->ring_sock != INVALID_SOCKET) {  /* Use currently 'ringing' socket if one is active */
         newsock = mp->ring_sock;
@@ -1060,8 +1529,22 @@ if (mp->master) {
         address = mp->ring_ipad;
         mp->ring_ipad = NULL;
         }
-    else
-        newsock = sim_accept_conn_ex (mp->master, &address, (mp->packet ? SIM_SOCK_OPT_NODELAY : 0));/* poll connect */
+    else {
+        if ((mp->backlog) &&                            /* batching accepts */
+            (mp->acc_next == mp->acc_count) &&          /*   and the last batch is assigned? */
+            (_tmxr_sock_ready (mp, NULL, mp->master, &mp->master_watch, TMXR_WATCH_MASTER)))
+            _tmxr_accept_batch (mp);                    /* accept everything pending */
+        if (mp->acc_next < mp->acc_count) {             /* accepted connection waiting for a line? */
+            newsock = mp->acc_sock[mp->acc_next];
+            address = mp->acc_ipad[mp->acc_next++];
+            }
+        else
+            if ((!mp->backlog) && 
+                (_tmxr_sock_ready (mp, NULL, mp->master, &mp->master_watch, TMXR_WATCH_MASTER)))
+                newsock = sim_accept_conn_ex (mp->master, &address, (mp->packet ? SIM_SOCK_OPT_NODELAY : 0));/* poll connect */
+            else
+                newsock = INVALID_SOCKET;               /* nothing pending */
+        }
 
     if (newsock != INVALID_SOCKET) {                    /* got a live one? */
         snprintf (msg, sizeof (msg) - 1, "tmxr_poll_conn() - Connection from %s", address);
@@ -1086,22 +1569,11 @@ if (mp->master) {
             }
 
         if (i >= mp->lines) {                           /* all busy? */
-            int32 ringable_count = 0;
-
-            for (j = 0; j < mp->lines; j++, i++) {      /* find next avail line */
-                lp = mp->ldsc + j;                      /* get pointer to line descriptor */
-                if ((lp->conn == FALSE) &&              /* is the line available? */
-                    (lp->destination == NULL) &&
-                    (lp->master == 0) &&
-                    (lp->ser_connect_pending == FALSE) &&
-                    ((lp->modembits & TMXR_MDM_DTR) == 0)) {
-                    ++ringable_count;
-                    lp->modembits |= TMXR_MDM_RNG;
-                    tmxr_debug_connect_line (lp, "tmxr_poll_conn() - Ringing line");
-                    }
-                }
+            int32 ringable_count = _tmxr_ring_lines (mp);
+
             if (ringable_count > 0) {
                 ringing = -2;
+                _tmxr_evlog_conn_event (mp, -1, TMXR_EV_RING);
                 if (mp->ring_start_time == 0) {
                     mp->ring_start_time = poll_time;
                     mp->ring_sock = newsock;
@@ -1113,15 +1585,8 @@ if (mp->master) {
                         mp->ring_ipad = address;
                         }
                     else {                                      /* Timeout waiting for DTR */
-                        int ln;
-
-                        /* turn off pending ring signals */
-                        for (ln = 0; ln < lp->mp->lines; ln++) {
-                            TMLN *tlp = lp->mp->ldsc + ln;
-                            if (((tlp->destination == NULL) && (tlp->master == 0)) &&
-                                (tlp->modembits & TMXR_MDM_RNG) && (tlp->conn == FALSE))
-                                tlp->modembits &= ~TMXR_MDM_RNG;
-                            }
+                        _tmxr_ring_off (mp);                    /* turn off pending ring signals */
+                        _tmxr_evlog_conn_event (mp, -1, TMXR_EV_NOANS);
                         mp->ring_start_time = 0;
                         tmxr_msg (newsock, "No answer on any connection\r\n");
                         tmxr_debug_connect (mp, "tmxr_poll_conn() - No Answer - All connections busy");
@@ -1135,6 +1600,8 @@ if (mp->master) {
                 tmxr_debug_connect (mp, "tmxr_poll_conn() - All connections busy");
                 sim_close_sock (newsock);
                 free (address);
+                if (mp->acc_next < mp->acc_count)       /* more of the batch waiting? */
+                    goto next_accepted;                 /*   they're busy too */
                 }
             }
         else {
@@ -1152,11 +1619,15 @@ if (mp->master) {
                 }
             tmxr_report_connection (mp, lp);
             lp->cnms = sim_os_msec ();                  /* time of connection */
+            _tmxr_evlog_conn_event (mp, i, TMXR_EV_CONN);
             return i;
             }
         }                                               /* end if newsock */
     }
 
+if (too_soon)                                           /* only the listener is checked between polls */
+    return ringing;
+
 /* Look for per line listeners or outbound connecting sockets */
 for (i = 0; i < mp->lines; i++) {                       /* check each line in sequence */
     int j, r = rand();
@@ -1167,6 +1638,7 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
     if (lp->ser_connect_pending) {
         lp->ser_connect_pending = FALSE;
         lp->conn = TRUE;
+        _tmxr_evlog_conn_event (mp, i, TMXR_EV_CONN);
         return i;
         }
 
@@ -1187,7 +1659,8 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
     for (j=0; j<2; j++)
         switch ((j+r)&1) {
             case 0:
-                if (lp->connecting) {                           /* connecting? */
+                if ((lp->connecting) &&                         /* connecting and something to report? */
+                    (_tmxr_sock_ready (mp, lp, lp->connecting, &lp->conn_watch, TMXR_WATCH_CONN))) {
                     char *sockname, *peername;
 
                     switch (sim_check_conn(lp->connecting, FALSE))
@@ -1210,6 +1683,7 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
                                 lp->telnet_sent_opts = (uint8 *)realloc (lp->telnet_sent_opts, 256);
                                 memset (lp->telnet_sent_opts, 0, 256);
                                 }
+                            _tmxr_evlog_conn_event (mp, i, TMXR_EV_CONN);
                             return i;
                         case -1:                                /* failed connection */
                             snprintf (msg, sizeof (msg) -1, "tmxr_poll_conn() - Outgoing Line Connection to %s failed", lp->destination);
@@ -1220,7 +1694,8 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
                     }
                 break;
             case 1:
-                if (lp->master) {                                   /* Check for a pending Telnet/tcp connection */
+                if ((lp->master) &&                                 /* Check for a pending Telnet/tcp connection */
+                    (_tmxr_sock_ready (mp, lp, lp->master, &lp->master_watch, TMXR_WATCH_LISTEN))) {
                     while (INVALID_SOCKET != (newsock = sim_accept_conn_ex (lp->master, &address, (lp->packet ? SIM_SOCK_OPT_NODELAY : 0)))) {/* got a live one? */
                         char *sockname, *peername;
 
@@ -1245,6 +1720,7 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
                             if (lp->connecting) {
                                 snprintf (msg, sizeof (msg) -1, "tmxr_poll_conn() - aborting outgoing line connection attempt to: %s", lp->destination);
                                 tmxr_debug_connect_line (lp, msg);
+                                _tmxr_unwatch_ln (lp, lp->connecting);
                                 sim_close_sock (lp->connecting);    /* abort our as yet unconnnected socket */
                                 lp->connecting = 0;
                                 }
@@ -1263,6 +1739,7 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
                                     }
                                 tmxr_report_connection (mp, lp);
                                 lp->cnms = sim_os_msec ();          /* time of connection */
+                                _tmxr_evlog_conn_event (mp, i, TMXR_EV_CONN);
                                 return i;
                                 }
                             else {
@@ -1322,7 +1799,7 @@ tmxr_debug_connect_line (lp, msg);
 
 if (lp->serport) {
     if (closeserial) {
-        sim_close_serial (lp->serport);
+        _tmxr_close_serial (lp);
         lp->serport = 0;
         lp->ser_connect_pending = FALSE;
         free (lp->destination);
@@ -1340,11 +1817,15 @@ if (lp->serport) {
             }
     }
 else                                                    /* Telnet connection */
-    if (lp->sock) {
-        sim_close_sock (lp->sock);                      /* close socket */
+    if ((lp->sock) || (lp->evlog_conn)) {
+        if (lp->sock) {
+            _tmxr_unwatch_ln (lp, lp->sock);
+            sim_close_sock (lp->sock);                  /* close socket */
+            }
         free (lp->telnet_sent_opts);
         lp->telnet_sent_opts = NULL;
         lp->sock = 0;
+        lp->evlog_conn = FALSE;
         lp->conn = FALSE;
         lp->cnms = 0;
         lp->xmte = 1;
@@ -1353,6 +1834,7 @@ free(lp->ipad);
 lp->ipad = NULL;
 if ((lp->destination) && (!lp->serport)) {
     if (lp->connecting) {
+        _tmxr_unwatch_ln (lp, lp->connecting);
         sim_close_sock (lp->connecting);
         lp->connecting = 0;
         }
@@ -1556,7 +2038,7 @@ if ((bits_to_set & ~(TMXR_MDM_OUTGOING)) ||         /* Assure only settable bits
 before_modem_bits = lp->modembits;
 lp->modembits |= bits_to_set;
 lp->modembits &= ~bits_to_clear;
-if ((lp->sock) || (lp->serport) || (lp->loopback)) {
+if ((lp->sock) || (lp->serport) || (lp->loopback) || (lp->evlog_conn)) {
     if (lp->modembits & TMXR_MDM_DTR) {
         incoming_state = TMXR_MDM_DSR;
         if (lp->modembits & TMXR_MDM_RTS)
@@ -1578,9 +2060,16 @@ else {
         (lp->modembits & TMXR_MDM_RNG)) {               /* and Ring Signal Present */
         if ((lp->destination == NULL) && 
             (lp->master == 0) &&
-            (lp->mp && (lp->mp->ring_sock))) {
-            int ln;
-            
+            (lp->mp && lp->mp->ring_evlog)) {           /* ring replayed from an event log? */
+            lp->mp->ring_evlog = FALSE;
+            _tmxr_evlog_connect (lp, lp->mp->notelnet);
+            lp->modembits &= ~TMXR_MDM_RNG;             /* turn off ring on this line*/
+            _tmxr_ring_off (lp->mp);                    /* turn off other pending ring signals */
+            }
+        else if ((lp->destination == NULL) && 
+            (lp->master == 0) &&
+            (lp->mp && (lp->mp->ring_sock)) &&
+            (!sim_evlog_replaying ())) {
             lp->conn = TRUE;                            /* record connection */
             lp->sock = lp->mp->ring_sock;               /* save socket */
             lp->mp->ring_sock = INVALID_SOCKET;
@@ -1598,13 +2087,7 @@ else {
             tmxr_report_connection (lp->mp, lp);
             lp->cnms = sim_os_msec ();                  /* time of connection */
             lp->modembits &= ~TMXR_MDM_RNG;             /* turn off ring on this line*/
-            /* turn off other pending ring signals */
-            for (ln = 0; ln < lp->mp->lines; ln++) {
-                TMLN *tlp = lp->mp->ldsc + ln;
-                if (((tlp->destination == NULL) && (tlp->master == 0)) &&
-                    (tlp->modembits & TMXR_MDM_RNG) && (tlp->conn == FALSE))
-                    tlp->modembits &= ~TMXR_MDM_RNG;
-                }
+            _tmxr_ring_off (lp->mp);                    /* turn off other pending ring signals */
             }
         }
     if (!lp->conn)
@@ -1634,9 +2117,9 @@ if (lp->mp && lp->modem_control) {                  /* This API ONLY works on mo
             }
         if (lp->serport)
             return sim_control_serial (lp->serport, bits_to_set, bits_to_clear, incoming_bits);
-        if ((lp->sock) || (lp->connecting)) {
+        if ((lp->sock) || (lp->connecting) || (lp->evlog_conn)) {
             if ((before_modem_bits & bits_to_clear & TMXR_MDM_DTR) != 0) { /* drop DTR? */
-                if (lp->sock)
+                if ((lp->sock) || (lp->evlog_conn))
                     tmxr_report_disconnection (lp);     /* report closure */
                 tmxr_reset_ln (lp);
                 }
@@ -1655,9 +2138,9 @@ if (lp->mp && lp->modem_control) {                  /* This API ONLY works on mo
         }
     return SCPE_OK;
     }
-if ((lp->sock) || (lp->connecting)) {
+if ((lp->sock) || (lp->connecting) || (lp->evlog_conn)) {
     if ((before_modem_bits & bits_to_clear & TMXR_MDM_DTR) != 0) { /* drop DTR? */
-        if (lp->sock)
+        if ((lp->sock) || (lp->evlog_conn))
             tmxr_report_disconnection (lp);     /* report closure */
         tmxr_reset_ln (lp);
         }
@@ -1797,9 +2280,13 @@ if (((lp->conn || lp->txbfd) && lp->rcve) &&            /* (conn or buffered) &
                 val = val | SCPE_BREAK;                 /* indicate to caller */
                 }
             lp->rxbpr = lp->rxbpr + 1;                  /* adv pointer */
+            _tmxr_rx_consumed (lp);
             }
         }
     }                                                   /* end if conn */
+else
+    if (lp->rcve && lp->rxbps && (lp->rxbpi != lp->rxbpr))/* input held back by speed limit? */
+        ++lp->rxdefer;
 if (lp->rxbpi == lp->rxbpr)                             /* empty? zero ptrs */
     lp->rxbpi = lp->rxbpr = 0;
 if (val) {                                              /* Got something? */
@@ -1812,6 +2299,81 @@ tmxr_debug_return(lp, val);
 return val;
 }
 
+/* Get characters from specific line
+
+   Inputs:
+        *lp     =       pointer to terminal line descriptor
+        *buf    =       pointer to buffer for the received characters
+        *brk    =       pointer to receive break status buffer (or NULL)
+        size    =       size of buf (and brk)
+   Output:
+        count of characters stored in buf, 0 if no data is currently
+        available on the specified line.
+
+   Implementation notes:
+
+    1. This is the bulk form of tmxr_getc_ln for devices which can accept
+       several characters at once (silos, FIFOs, etc.).
+    2. If brk is provided, the break status of each character is returned
+       in the corresponding brk element and cleared.  Otherwise the transfer
+       stops ahead of a character received with a line break so that the
+       next tmxr_getc_ln call reports it with SCPE_BREAK.
+    3. Rate limited lines and lines with SEND data pending are read through
+       tmxr_getc_ln so that their input timing is preserved.
+*/
+
+int32 tmxr_read_ln (TMLN *lp, uint8 *buf, uint8 *brk, int32 size)
+{
+int32 count = 0;
+int32 val;
+
+tmxr_debug_trace_line (lp, "tmxr_read_ln()");
+if (lp->rxbps ||                                        /* rate limited or */
+    (lp->send.extoff < lp->send.insoff)) {              /*   injected input characters? */
+    while (count < size) {
+        if ((brk == NULL) &&                            /* break must come from getc and */
+            (lp->send.extoff >= lp->send.insoff) &&     /*   next char is from the line */
+            (lp->rxbpr < lp->rxbpi) &&                  /*   and has break status? */
+            lp->rbr[lp->rxbpr])
+            break;
+        val = tmxr_getc_ln (lp);
+        if (val == 0)
+            break;
+        buf[count] = (uint8)val;
+        if (brk)
+            brk[count] = (val & SCPE_BREAK) ? 1 : 0;
+        ++count;
+        }
+    return count;
+    }
+if ((lp->conn || lp->txbfd) && lp->rcve) {              /* (conn or buffered) & enb? */
+    count = lp->rxbpi - lp->rxbpr;                      /* # input chrs */
+    if (count > size)
+        count = size;
+    if (brk) {
+        memcpy (brk, &lp->rbr[lp->rxbpr], count);       /* return break status */
+        memset (&lp->rbr[lp->rxbpr], 0, count);         /* and clear it */
+        }
+    else {
+        for (val = 0; val < count; val++)               /* stop ahead of a break */
+            if (lp->rbr[lp->rxbpr + val])
+                break;
+        count = val;
+        }
+    memcpy (buf, &lp->rxb[lp->rxbpr], count);
+    lp->rxbpr = lp->rxbpr + count;                      /* adv pointer */
+    if (count)
+        _tmxr_rx_consumed (lp);
+    }
+if (lp->rxbpi == lp->rxbpr)                             /* empty? zero ptrs */
+    lp->rxbpi = lp->rxbpr = 0;
+if (count) {                                            /* Got something? */
+    lp->rxnexttime = floor (sim_gtime () + ((lp->mp->uptr->wait * sim_timer_inst_per_sec ()) / USECS_PER_SECOND));
+    tmxr_debug (TMXR_DBG_RET, lp, "Read", (char *)buf, count);
+    }
+return count;
+}
+
 /* Get packet from specific line
 
    Inputs:
@@ -1879,6 +2441,309 @@ if (lp->conn)
 return SCPE_LOST;
 }
 
+/* Input recording and replay
+
+   The data received on a line (after Telnet processing) can be recorded
+   to a text file with one record per read:
+
+       <seconds since the previous record> "<data>"
+
+   where the data is quoted and escaped as for the SEND command.  A
+   recording can later be replayed into a line to drive the simulated
+   system the same way again.  Each record is queued as SEND input for the
+   line when it is due: at the recorded pace, N times faster, or (MAX) as
+   soon as the guest has read the previous record and responded to it.
+   The time from queueing a record to the next output the guest writes to
+   the line is accumulated as the response latency of the replay.
+
+   Replay starts when the line can first be read (it is connected or
+   buffered).
+*/
+
+#define TMXR_RECORD_CHUNK       256                     /* max data bytes per record */
+#define TMXR_REPLAY_MAX_WAIT    1.0                     /* max response wait replaying at MAX (seconds) */
+
+/* Name of the record or replay file for a line.  Multiplexer wide names
+   get the line number appended when there are several lines, as for Log */
+
+static void _tmxr_line_file_name (const TMLN *lp, const char *tmpl, t_bool mux_wide, char *name, size_t size)
+{
+if (mux_wide && (lp->mp->lines > 1))
+    snprintf (name, size, "%s_%d", tmpl, (int)(lp - lp->mp->ldsc));
+else
+    strlcpy (name, tmpl, size);
+}
+
+static void _tmxr_record_close (TMLN *lp)
+{
+if (lp->rxrecord)
+    fclose (lp->rxrecord);
+lp->rxrecord = NULL;
+free (lp->rxrecordname);
+lp->rxrecordname = NULL;
+}
+
+static t_stat _tmxr_record_open (TMLN *lp, const char *name)
+{
+time_t now = time (NULL);
+
+_tmxr_record_close (lp);
+lp->rxrecord = sim_fopen (name, "w");
+if (lp->rxrecord == NULL)
+    return SCPE_OPENERR;
+lp->rxrecordname = (char *)malloc (1 + strlen (name));
+strcpy (lp->rxrecordname, name);
+lp->rxrecordlast = sim_timenow_double ();
+fprintf (lp->rxrecord, "; %s line %d input recorded %s",
+                       lp->mp->dptr ? sim_dname (lp->mp->dptr) : "", (int)(lp - lp->mp->ldsc), ctime (&now));
+fprintf (lp->rxrecord, "; <seconds since previous record> \"<data>\"\n");
+return SCPE_OK;
+}
+
+static void _tmxr_record (TMLN *lp, const char *data, int32 size, double now)
+{
+while (size > 0) {
+    int32 chunk = (size > TMXR_RECORD_CHUNK) ? TMXR_RECORD_CHUNK : size;
+    char *quoted = sim_encode_quoted_string ((const uint8 *)data, (uint32)chunk);
+
+    if (quoted == NULL)
+        return;
+    fprintf (lp->rxrecord, "%.6f %s\n", now - lp->rxrecordlast, quoted);
+    free (quoted);
+    lp->rxrecordlast = now;
+    data += chunk;
+    size -= chunk;
+    }
+}
+
+static void _tmxr_replay_close (TMLN *lp)
+{
+struct tmxr_replay *rp = lp->replay;
+int32 i;
+
+if (rp == NULL)
+    return;
+for (i = 0; i < rp->count; i++)
+    free (rp->rec[i].data);
+free (rp->rec);
+free (rp->name);
+free (rp);
+lp->replay = NULL;
+}
+
+/* Split a Replay=file{;rate} specifier.  The rate is a multiple of the
+   recorded pace (optionally followed by X) or MAX. */
+
+static t_stat _tmxr_replay_spec (const char *spec, char *file, size_t size, double *rate)
+{
+const char *semi = strrchr (spec, ';');
+char *end;
+
+*rate = 1.0;
+if (semi == NULL) {
+    strlcpy (file, spec, size);
+    return (*file != '\0') ? SCPE_OK : SCPE_ARG;
+    }
+if ((semi == spec) || ((size_t)(semi - spec) >= size))
+    return SCPE_ARG;
+memcpy (file, spec, semi - spec);
+file[semi - spec] = '\0';
+++semi;
+if (0 == sim_strcasecmp (semi, "MAX")) {
+    *rate = 0.0;
+    return SCPE_OK;
+    }
+*rate = strtod (semi, &end);
+if ((end == semi) || (*rate <= 0.0) ||
+    ((*end != '\0') && (0 != sim_strcasecmp (end, "X"))))
+    return SCPE_ARG;
+return SCPE_OK;
+}
+
+static t_stat _tmxr_replay_open (TMLN *lp, const char *name, double rate)
+{
+struct tmxr_replay *rp;
+TMXR_REPLAY_REC *rec;
+FILE *f;
+char buf[8*TMXR_RECORD_CHUNK], *cptr, *eptr;
+int32 lineno = 0;
+size_t len;
+
+_tmxr_replay_close (lp);
+f = sim_fopen (name, "r");
+if (f == NULL)
+    return SCPE_OPENERR;
+rp = (struct tmxr_replay *)calloc (1, sizeof (*rp));
+if (rp == NULL) {
+    fclose (f);
+    return SCPE_MEM;
+    }
+lp->replay = rp;
+rp->name = (char *)malloc (1 + strlen (name));
+strcpy (rp->name, name);
+rp->rate = rate;
+while (fgets (buf, sizeof (buf), f)) {
+    ++lineno;
+    len = strlen (buf);
+    while ((len > 0) && isspace ((u_char)buf[len - 1]))
+        buf[--len] = '\0';
+    for (cptr = buf; isspace ((u_char)*cptr); ++cptr)
+        ;
+    if ((*cptr == '\0') || (*cptr == ';') || (*cptr == '#'))/* blank or comment? */
+        continue;
+    rec = (TMXR_REPLAY_REC *)realloc (rp->rec, (rp->count + 1) * sizeof (*rp->rec));
+    if (rec == NULL)
+        break;
+    rp->rec = rec;
+    rec = &rp->rec[rp->count];
+    rec->delay = strtod (cptr, &eptr);
+    if ((eptr == cptr) || (rec->delay < 0.0) || (!isspace ((u_char)*eptr)))
+        break;
+    while (isspace ((u_char)*eptr))
+        ++eptr;
+    rec->data = (uint8 *)malloc (1 + strlen (eptr));
+    if ((rec->data == NULL) ||
+        (SCPE_OK != sim_decode_quoted_string (eptr, rec->data, &rec->size))) {
+        free (rec->data);
+        break;
+        }
+    ++rp->count;
+    }
+if (!feof (f)) {
+    fclose (f);
+    _tmxr_replay_close (lp);
+    return sim_messagef (SCPE_ARG, "Invalid replay record at line %d of %s\n", (int)lineno, name);
+    }
+fclose (f);
+return SCPE_OK;
+}
+
+/* Queue the records which are due as input for the line */
+
+static void _tmxr_replay_poll (TMLN *lp, double now)
+{
+struct tmxr_replay *rp = lp->replay;
+int32 saved_switches;
+
+if ((rp->next >= rp->count) ||                          /* finished or */
+    (!((lp->conn || lp->txbfd) && lp->rcve)))           /*   line can't be read yet? */
+    return;
+if (rp->start == 0.0) {                                 /* first chance starts the clock */
+    rp->start = now;
+    rp->due = now + ((rp->rate > 0.0) ? rp->rec[0].delay / rp->rate : 0.0);
+    }
+saved_switches = sim_switches;
+sim_switches = 0;                                       /* SEND delays in instructions */
+while (rp->next < rp->count) {
+    TMXR_REPLAY_REC *rec = &rp->rec[rp->next];
+
+    if (rp->rate > 0.0) {
+        if (now < rp->due)                              /* not due yet? */
+            break;
+        }
+    else {
+        if ((lp->send.extoff < lp->send.insoff) ||      /* previous record not read yet or */
+            (rp->awaiting &&                            /*   response outstanding? */
+             ((now - rp->sent) < TMXR_REPLAY_MAX_WAIT)))
+            break;
+        }
+    sim_send_input (&lp->send, rec->data, rec->size, 0, 0);
+    rp->sent = now;
+    rp->awaiting = TRUE;
+    if (++rp->next < rp->count)
+        rp->due = rp->due + ((rp->rate > 0.0) ? rp->rec[rp->next].delay / rp->rate : 0.0);
+    }
+sim_switches = saved_switches;
+}
+
+/* Guest output after a replayed record completes a response latency sample */
+
+static void _tmxr_replay_output (TMLN *lp)
+{
+struct tmxr_replay *rp = lp->replay;
+double latency;
+
+if (!rp->awaiting)
+    return;
+rp->awaiting = FALSE;
+latency = sim_timenow_double () - rp->sent;
+if ((rp->responses == 0) || (latency < rp->latmin))
+    rp->latmin = latency;
+if (latency > rp->latmax)
+    rp->latmax = latency;
+rp->latsum = rp->latsum + latency;
+++rp->responses;
+}
+
+static void _tmxr_replay_show (FILE *st, const TMLN *lp)
+{
+const struct tmxr_replay *rp = lp->replay;
+char rate[32];
+
+if (rp->rate > 0.0)
+    snprintf (rate, sizeof (rate), "%gx", rp->rate);
+else
+    strcpy (rate, "MAX");
+fprintf (st, " Replaying %s at %s: %d of %d records sent", rp->name, rate, (int)rp->next, (int)rp->count);
+if (rp->start != 0.0)
+    fprintf (st, " in %.3f seconds", ((rp->next < rp->count) ? sim_timenow_double () : rp->sent) - rp->start);
+fprintf (st, "\n");
+if (rp->responses)
+    fprintf (st, " Replay response latency avg/min/max = %.3f/%.3f/%.3f ms (%d samples)\n",
+                 (1000.0 * rp->latsum) / rp->responses, 1000.0 * rp->latmin, 1000.0 * rp->latmax, (int)rp->responses);
+}
+
+/* Apply the Record, NoRecord, Replay and NoReplay attach options to a line
+   or (line < 0) to all lines of a multiplexer */
+
+static t_stat _tmxr_open_record_replay (TMXR *mp, int32 line, const char *record, t_bool norecord, const char *replay, t_bool noreplay)
+{
+int32 i, first = (line < 0) ? 0 : line, last = (line < 0) ? mp->lines - 1 : line, replays = 0;
+char name[CBUFSIZE + 16], file[CBUFSIZE];
+double rate;
+t_stat r;
+
+if (norecord || record[0]) {
+    for (i = first; i <= last; i++)
+        _tmxr_record_close (&mp->ldsc[i]);
+    if (line < 0)
+        mp->recordtmpl[0] = '\0';
+    }
+if (noreplay || replay[0]) {
+    for (i = first; i <= last; i++)
+        _tmxr_replay_close (&mp->ldsc[i]);
+    if (line < 0)
+        mp->replaytmpl[0] = '\0';
+    }
+if (record[0]) {
+    for (i = first; i <= last; i++) {
+        _tmxr_line_file_name (&mp->ldsc[i], record, (line < 0), name, sizeof (name));
+        if (SCPE_OK != _tmxr_record_open (&mp->ldsc[i], name))
+            return sim_messagef (SCPE_OPENERR, "Can't open record file: %s\n", name);
+        }
+    if (line < 0)
+        strlcpy (mp->recordtmpl, record, sizeof (mp->recordtmpl));
+    }
+if (replay[0]) {
+    if (SCPE_OK != _tmxr_replay_spec (replay, file, sizeof (file), &rate))
+        return sim_messagef (SCPE_ARG, "Invalid Replay Specifier: %s\n", replay);
+    for (i = first; i <= last; i++) {
+        _tmxr_line_file_name (&mp->ldsc[i], file, (line < 0), name, sizeof (name));
+        r = _tmxr_replay_open (&mp->ldsc[i], name, rate);
+        if (r == SCPE_OK)
+            ++replays;
+        else
+            if ((r != SCPE_OPENERR) || (first == last))     /* lines without a recording are skipped */
+                return (r == SCPE_OPENERR) ? sim_messagef (r, "Can't open replay file: %s\n", name) : r;
+        }
+    if (replays == 0)
+        return sim_messagef (SCPE_OPENERR, "No replay files found for %s\n", file);
+    if (line < 0)
+        strlcpy (mp->replaytmpl, replay, sizeof (mp->replaytmpl));
+    }
+return SCPE_OK;
+}
+
 /* Poll for input
 
    Inputs:
@@ -1888,26 +2753,55 @@ return SCPE_LOST;
 
 void tmxr_poll_rx (TMXR *mp)
 {
-int32 i, nbytes, j;
+int32 i, nbytes, j, start;
 TMLN *lp;
+double now = sim_timenow_double ();
 
 tmxr_debug_trace (mp, "tmxr_poll_rx()");
+if (mp->poll_last != 0.0) {                             /* time between polls */
+    double interval = now - mp->poll_last;
+
+    mp->poll_intsum = mp->poll_intsum + interval;
+    if (interval > mp->poll_intmax)
+        mp->poll_intmax = interval;
+    }
+mp->poll_last = now;
+++mp->polls;
+_tmxr_poll_ready (mp);                                  /* collect socket readiness */
 for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
     lp = mp->ldsc + i;                                  /* get line desc */
-    if (!(lp->sock || lp->serport || lp->loopback) || 
+    if (lp->replay)                                     /* replaying recorded input? */
+        _tmxr_replay_poll (lp, now);
+    if (!(lp->sock || lp->serport || lp->loopback || lp->evlog_conn) || 
         !(lp->rcve))                                    /* skip if not connected */
         continue;
 
     nbytes = 0;
-    if (lp->rxbpi == 0)                                 /* need input? */
-        nbytes = tmxr_read (lp,                         /* yes, read */
-            lp->rxbsz - TMXR_GUARD);                    /* leave spc for Telnet cruft */
-    else if (lp->tsta)                                  /* in Telnet seq? */
-        nbytes = tmxr_read (lp,                         /* yes, read to end */
-            lp->rxbsz - lp->rxbpi);
+    if (sim_evlog_replaying ()) {                       /* input comes from an event log? */
+        if ((lp->rxbpi == 0) || lp->tsta) {
+            nbytes = sim_evlog_input (_tmxr_evlog_source (mp, i, NULL), (uint8 *)&lp->rxb[lp->rxbpi], 0, 
+                                      (lp->rxbpi == 0) ? lp->rxbsz - TMXR_GUARD : lp->rxbsz - lp->rxbpi);
+            if ((nbytes == 0) && _tmxr_evlog_disc_due (lp))/* host side closed here? */
+                nbytes = -1;
+            }
+        }
+    else {
+        if (((lp->rxbpi == 0) || lp->tsta) &&           /* would read but */
+            !_tmxr_ln_rx_ready (lp))                    /*   nothing has arrived? */
+            continue;
+        if (lp->rxbpi == 0)                             /* need input? */
+            nbytes = tmxr_read (lp,                     /* yes, read */
+                lp->rxbsz - TMXR_GUARD);                /* leave spc for Telnet cruft */
+        else if (lp->tsta)                              /* in Telnet seq? */
+            nbytes = tmxr_read (lp,                     /* yes, read to end */
+                lp->rxbsz - lp->rxbpi);
+        if ((nbytes > 0) && sim_evlog_active ())        /* recording events? */
+            sim_evlog_input (_tmxr_evlog_source (mp, i, NULL), (uint8 *)&lp->rxb[lp->rxbpi], nbytes, nbytes);
+        }
 
     if (nbytes < 0) {                                   /* line error? */
         if (!lp->datagram) {                            /* ignore errors reading UDP sockets */
+            _tmxr_evlog_disc (lp);                      /* note the close when recording */
             if (!lp->txbfd || lp->notelnet) 
                 lp->txbpi = lp->txbpr = 0;              /* Drop the data we already know we can't send */
             tmxr_close_ln (lp);                         /* disconnect line */
@@ -1918,38 +2812,60 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
 
         tmxr_debug (TMXR_DBG_RCV, lp, "Received", &(lp->rxb[lp->rxbpi]), nbytes);
 
-        j = lp->rxbpi;                                  /* start of data */
+        start = j = lp->rxbpi;                          /* start of data */
         lp->rxbpi = lp->rxbpi + nbytes;                 /* adv pointers */
         lp->rxcnt = lp->rxcnt + nbytes;
 
 /* Examine new data, remove TELNET cruft before making input available */
 
         if (!lp->notelnet) {                            /* Are we looking for telnet interpretation? */
-            for (; j < lp->rxbpi; ) {                   /* loop thru char */
-                u_char tmp = (u_char)lp->rxb[j];        /* get char */
+            int32 k = j;                                /* kept chars are compacted to k */
+            int32 end = lp->rxbpi;                      /* end of new data */
+
+            while ((j < end) &&                         /* loop thru char */
+                   (lp->rxbpi == end)) {                /*   unless line reset by a reply */
+                u_char tmp;
+
+                if (lp->tsta == TNS_NORM) {             /* pass plain text runs straight through */
+                    int32 run = _tmxr_telnet_run (&lp->rxb[j], end - j, lp->dstb);
+
+                    if (run > 0) {
+                        if (k != j) {
+                            memmove (&lp->rxb[k], &lp->rxb[j], run);
+                            memmove (&lp->rbr[k], &lp->rbr[j], run);
+                            }
+                        j = j + run;
+                        k = k + run;
+                        if (j == end)
+                            break;
+                        }
+                    }
+                tmp = (u_char)lp->rxb[j];               /* get char */
                 switch (lp->tsta) {                     /* case tlnt state */
 
                 case TNS_NORM:                          /* normal */
                     if (tmp == TN_IAC) {                /* IAC? */
                         lp->tsta = TNS_IAC;             /* change state */
-                        tmxr_rmvrc (lp, j);             /* remove char */
+                        j = j + 1;                      /* remove char */
                         break;
                         }
                     if ((tmp == TN_CR) && lp->dstb)     /* CR, no bin */
                         lp->tsta = TNS_CRPAD;           /* skip pad char */
-                    j = j + 1;                          /* advance j */
+                    lp->rxb[k] = lp->rxb[j];            /* keep char */
+                    lp->rbr[k++] = lp->rbr[j++];
                     break;
 
                 case TNS_IAC:                           /* IAC prev */
                     if (tmp == TN_IAC) {                /* IAC + IAC */
                         lp->tsta = TNS_NORM;            /* treat as normal */
-                        j = j + 1;                      /* advance j */
-                        break;                          /* keep IAC */
+                        lp->rxb[k] = lp->rxb[j];        /* keep IAC */
+                        lp->rbr[k++] = lp->rbr[j++];
+                        break;
                         }
                     if (tmp == TN_BRK) {                /* IAC + BRK? */
                         lp->tsta = TNS_NORM;            /* treat as normal */
-                        lp->rxb[j] = 0;                 /* char is null */
-                        lp->rbr[j] = 1;                 /* flag break */
+                        lp->rxb[k] = 0;                 /* char is null */
+                        lp->rbr[k++] = 1;               /* flag break */
                         j = j + 1;                      /* advance j */
                         break;
                         }
@@ -1978,7 +2894,7 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                         lp->tsta = TNS_NORM;            /* ignore */
                         break;
                         }
-                    tmxr_rmvrc (lp, j);                 /* remove char */
+                    j = j + 1;                          /* remove char */
                     break;
 
                 case TNS_WILL:                          /* IAC+WILL prev */
@@ -2035,7 +2951,7 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                             lp->dstb = 1;
                             }
                         }
-                    tmxr_rmvrc (lp, j);                 /* remove it */
+                    j = j + 1;                          /* remove it */
                     lp->tsta = TNS_NORM;                /* next normal */
                     break;
 
@@ -2057,7 +2973,7 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                     lp->tsta = TNS_NORM;                /* next normal */
                     if ((tmp == TN_LF) ||               /* CR + LF ? */
                         (tmp == TN_NUL))                /* CR + NUL? */
-                        tmxr_rmvrc (lp, j);             /* remove it */
+                        j = j + 1;                      /* remove it */
                     break;
 
                 case TNS_DO:                            /* pending DO request */
@@ -2107,15 +3023,27 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                         }
                     /* fall through */
                 case TNS_SKIP: default:                 /* skip char */
-                    tmxr_rmvrc (lp, j);                 /* remove char */
+                    j = j + 1;                          /* remove char */
                     lp->tsta = TNS_NORM;                /* next normal */
                     break;
                     }                                   /* end case state */
                 }                                       /* end for char */
+            if (lp->rxbpi == end) {                     /* still the same data? */
+                memset (&lp->rbr[k], 0, end - k);       /* clear vacated break status */
+                lp->rxbpi = k;                          /* drop buffer insert index */
+                }
             if (nbytes != (lp->rxbpi-lp->rxbpr)) {
                 tmxr_debug (TMXR_DBG_RCV, lp, "Remaining", &(lp->rxb[lp->rxbpr]), lp->rxbpi-lp->rxbpr);
                 }
             }
+        if (lp->rxrecord && (lp->rxbpi > start))        /* recording input? */
+            _tmxr_record (lp, &lp->rxb[start], lp->rxbpi - start, now);
+        if (lp->rxbpi != lp->rxbpr) {                   /* input available? */
+            if ((lp->rxbpi - lp->rxbpr) > lp->rxpeak)
+                lp->rxpeak = lp->rxbpi - lp->rxbpr;
+            if (lp->rxarrive == 0.0)                    /* time its wait */
+                lp->rxarrive = now;
+            }
         }                                               /* end else nbytes */
     }                                                   /* end for lines */
 for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
@@ -2205,6 +3133,8 @@ if ((lp->txbfd && !lp->notelnet) || (TXBUF_AVAIL(lp) > 1)) {/* room for char (+
         fputc (chr, lp->txlog);                         /* log to actual file */
         sim_oline = save_oline;                         /* resture output socket */
         }
+    if (lp->replay)                                     /* response to replayed input? */
+        _tmxr_replay_output (lp);
     sim_exp_check (&lp->expect, chr);                   /* process expect rules as needed */
     if (!sim_is_running) {                              /* attach message or other non simulation time message? */
         tmxr_send_buffered_data (lp);                   /* put data on wire */
@@ -2218,6 +3148,90 @@ if ((lp->txbfd && !lp->notelnet) || (TXBUF_AVAIL(lp) > 1)) {/* room for char (+
 return SCPE_STALL;                                      /* char not sent */
 }
 
+/* Put characters on specific line
+
+   Inputs:
+        *lp     =       pointer to line descriptor
+        *buf    =       pointer to characters
+        size    =       number of characters
+        *sent   =       pointer to count of characters accepted (or NULL)
+   Outputs:
+        status  =       ok, connection lost, or stall
+
+   Implementation notes:
+
+    1. This is the bulk form of tmxr_putc_ln.  Characters are accepted in
+       order until the transmit buffer fills, in which case SCPE_STALL is
+       returned and *sent reflects how many were accepted.
+    2. If the line is not connected, the characters are discarded and
+       SCPE_LOST is returned.
+    3. Runs of characters are copied directly into the transmit buffer.
+       Lines which are rate limited, buffered, serial or have expect rules,
+       Telnet IAC characters and output outside of simulation time go
+       through tmxr_putc_ln one character at a time.
+*/
+
+t_stat tmxr_write_ln (TMLN *lp, const uint8 *buf, int32 size, int32 *sent)
+{
+int32 count = 0, run, avail, chunk;
+const uint8 *iac;
+t_stat r = SCPE_OK;
+
+tmxr_debug_trace_line (lp, "tmxr_write_ln()");
+while (count < size) {
+    if ((lp->conn == FALSE) || lp->txbfd ||             /* not connected or buffered, */
+        lp->txbps || lp->serport ||                     /* rate limited or serial, */
+        (lp->expect.size > 0) || (!sim_is_running) ||   /* expect rules or not running, */
+        ((buf[count] == TN_IAC) && (!lp->notelnet))) {  /* or an IAC to double? */
+        r = tmxr_putc_ln (lp, buf[count]);              /* then one char at a time */
+        if (r == SCPE_LOST) {                           /* discard the rest */
+            lp->txdrp = lp->txdrp + (size - count - 1);
+            count = size;
+            break;
+            }
+        if (r != SCPE_OK)
+            break;
+        ++count;
+        continue;
+        }
+    avail = lp->txbsz - tmxr_tqln (lp) - 1;             /* room (as tmxr_putc_ln) */
+    if (avail <= 0) {
+        ++lp->txstall; lp->xmte = 0;                    /* no room, dsbl line */
+        r = SCPE_STALL;
+        break;
+        }
+    lp->xmte = 1;                                       /* enable line transmit */
+    run = size - count;
+    if ((!lp->notelnet) &&                              /* telnet session? */
+        (NULL != (iac = (const uint8 *)memchr (&buf[count], TN_IAC, run))))
+        run = (int32)(iac - &buf[count]);               /* stop at next IAC */
+    if (run > avail)
+        run = avail;
+    chunk = lp->txbsz - lp->txbpi;                      /* contiguous space */
+    if (chunk > run)
+        chunk = run;
+    memcpy (&lp->txb[lp->txbpi], &buf[count], chunk);
+    memcpy (lp->txb, &buf[count + chunk], run - chunk);/* wrap */
+    lp->txbpi = (lp->txbpi + run) % lp->txbsz;
+    if ((lp->txbsz - tmxr_tqln (lp)) <= TMXR_GUARD)     /* near full? */
+        lp->xmte = 0;                                   /* disable line transmit until space available */
+    if (lp->txlog) {                                    /* log if available */
+        extern TMLN *sim_oline;                         /* Make sure to avoid recursion */
+        TMLN *save_oline = sim_oline;                   /* when logging to a socket */
+
+        sim_oline = NULL;                               /* save output socket */
+        fwrite (&buf[count], 1, run, lp->txlog);        /* log to actual file */
+        sim_oline = save_oline;                         /* resture output socket */
+        }
+    if (lp->replay)                                     /* response to replayed input? */
+        _tmxr_replay_output (lp);
+    count = count + run;
+    }
+if (sent)
+    *sent = count;
+return r;
+}
+
 /* Store packet in line buffer
 
    Inputs:
@@ -2325,6 +3339,8 @@ t_stat r;
 
 tmxr_debug_trace_line (lp, "tmxr_send_buffered_data()");
 nbytes = tmxr_tqln(lp);                                 /* avail bytes */
+if (nbytes > lp->txpeak)
+    lp->txpeak = nbytes;
 if (nbytes) {                                           /* >0? write */
     if (lp->txbpr < lp->txbpi)                          /* no wrap? */
         sbytes = tmxr_write (lp, nbytes);               /* write all data */
@@ -2341,6 +3357,7 @@ if (nbytes) {                                           /* >0? write */
             lp->txbpi = lp->txbpr = 0;                  /* Start next packet at beginning of buffer */
         }
     if (sbytes < 0) {                                   /* I/O Error? */
+        _tmxr_evlog_disc (lp);                          /* note the close when recording */
         lp->txbpi = lp->txbpr = 0;                      /* Drop the data we already know we can't send */
         lp->rxpboffset = lp->txppoffset = lp->txppsize = 0;/* Drop the data we already know we can't send */
         tmxr_close_ln (lp);                             /*  close line/port on error */
@@ -2408,6 +3425,7 @@ return 0;                           /* not done */
 static void _mux_detach_line (TMLN *lp, t_bool close_listener, t_bool close_connecting)
 {
 if (close_listener && lp->master) {
+    _tmxr_unwatch_ln (lp, lp->master);
     sim_close_sock (lp->master);
     lp->master = 0;
     free (lp->port);
@@ -2429,7 +3447,7 @@ if (close_connecting) {
 if (lp->serport) {                          /* close current serial connection */
     tmxr_reset_ln (lp);
     sim_control_serial (lp->serport, 0, TMXR_MDM_DTR|TMXR_MDM_RTS, NULL);/* drop DTR and RTS */
-    sim_close_serial (lp->serport);
+    _tmxr_close_serial (lp);
     lp->serport = 0;
     free (lp->serconfig);
     lp->serconfig = NULL;
@@ -2584,14 +3602,17 @@ return SCPE_OK;
 
 t_stat tmxr_open_master (TMXR *mp, CONST char *cptr)
 {
-int32 i, line, nextline = -1;
+int32 i, line, nextline = -1, bufsize;
 char tbuf[CBUFSIZE], listen[CBUFSIZE], destination[CBUFSIZE], 
      logfiletmpl[CBUFSIZE], buffered[CBUFSIZE], hostport[CBUFSIZE], 
-     port[CBUFSIZE], option[CBUFSIZE], speed[CBUFSIZE], dev_name[CBUFSIZE];
+     port[CBUFSIZE], option[CBUFSIZE], speed[CBUFSIZE], dev_name[CBUFSIZE],
+     recordtmpl[CBUFSIZE], replayspec[CBUFSIZE];
 SOCKET sock;
 SERHANDLE serport;
 CONST char *tptr = cptr;
-t_bool nolog, notelnet, listennotelnet, modem_control, loopback, datagram, packet, disabled;
+t_bool nolog, notelnet, listennotelnet, modem_control, loopback, datagram, packet, disabled, reuseport;
+t_bool norecord, noreplay;
+int32 backlog;
 TMLN *lp;
 t_stat r = SCPE_OK;
 
@@ -2604,7 +3625,12 @@ for (i = 0; i < mp->lines; i++) {               /* initialize lines */
     lp->modem_control = mp->modem_control;
     if (lp->bpsfactor == 0.0)
         lp->bpsfactor = 1.0;
+    lp->rxpeak = lp->txpeak = lp->rxdrp = lp->rxdefer = lp->rxlatcnt = 0;/* statistics since attach */
+    lp->rxlatsum = lp->rxlatmax = 0.0;
     }
+mp->polls = 0;
+mp->poll_last = mp->poll_intsum = mp->poll_intmax = 0.0;
+mp->acc_batches = mp->acc_batch_max = 0;
 mp->ring_sock = INVALID_SOCKET;
 free (mp->ring_ipad);
 mp->ring_ipad = NULL;
@@ -2619,11 +3645,17 @@ while (*tptr) {
     memset(port,        '\0', sizeof(port));
     memset(option,      '\0', sizeof(option));
     memset(speed,       '\0', sizeof(speed));
+    memset(recordtmpl,  '\0', sizeof(recordtmpl));
+    memset(replayspec,  '\0', sizeof(replayspec));
     nolog = notelnet = listennotelnet = loopback = disabled = FALSE;
+    norecord = noreplay = FALSE;
     datagram = mp->datagram;
     packet = mp->packet;
     if (mp->buffered)
         sprintf(buffered, "%d", mp->buffered);
+    bufsize = (line == -1) ? mp->bufsize : 0;
+    backlog = mp->backlog;
+    reuseport = mp->reuseport;
     if (line != -1)
         notelnet = listennotelnet = mp->notelnet;
     modem_control = mp->modem_control;
@@ -2675,12 +3707,71 @@ while (*tptr) {
                     }
                 continue;
                 }
+            if (0 == MATCH_CMD (gbuf, "BUFSIZE")) {
+                if ((NULL == cptr) || ('\0' == *cptr))
+                    return sim_messagef (SCPE_2FARG, "Missing BufSize Specifier\n");
+                bufsize = (int32) get_uint (cptr, 10, TMXR_MAXBUFSIZE, &r);
+                if (r || (bufsize < TMXR_MAXBUF))
+                    return sim_messagef (SCPE_ARG, "Invalid BufSize Specifier: %s\n", cptr);
+                continue;
+                }
+            if (0 == MATCH_CMD (gbuf, "BACKLOG")) {
+                if ((NULL == cptr) || ('\0' == *cptr))
+                    backlog = TMXR_DEFAULT_BACKLOG;
+                else {
+                    backlog = (int32) get_uint (cptr, 10, TMXR_MAX_BACKLOG, &r);
+                    if (r)
+                        return sim_messagef (SCPE_ARG, "Invalid Backlog Specifier: %s\n", cptr);
+                    }
+                continue;
+                }
+            if (0 == MATCH_CMD (gbuf, "NOBACKLOG")) {
+                if ((NULL != cptr) && ('\0' != *cptr))
+                    return sim_messagef (SCPE_2MARG, "Unexpected NoBacklog Specifier: %s\n", cptr);
+                backlog = 0;
+                continue;
+                }
+            if (0 == MATCH_CMD (gbuf, "REUSEPORT")) {
+                if ((NULL != cptr) && ('\0' != *cptr))
+                    return sim_messagef (SCPE_2MARG, "Unexpected ReusePort Specifier: %s\n", cptr);
+                reuseport = TRUE;
+                continue;
+                }
             if (0 == MATCH_CMD (gbuf, "NOLOG")) {
                 if ((NULL != cptr) && ('\0' != *cptr))
                     return sim_messagef (SCPE_2MARG, "Unexpected NoLog Specifier: %s\n", cptr);
                 nolog = TRUE;
                 continue;
                 }
+            if (0 == MATCH_CMD (gbuf, "RECORD")) {
+                if ((NULL == cptr) || ('\0' == *cptr))
+                    return sim_messagef (SCPE_2FARG, "Missing Record Specifier\n");
+                strlcpy(recordtmpl, cptr, sizeof(recordtmpl));
+                continue;
+                }
+            if (0 == MATCH_CMD (gbuf, "NORECORD")) {
+                if ((NULL != cptr) && ('\0' != *cptr))
+                    return sim_messagef (SCPE_2MARG, "Unexpected NoRecord Specifier: %s\n", cptr);
+                norecord = TRUE;
+                continue;
+                }
+            if (0 == MATCH_CMD (gbuf, "REPLAY")) {
+                char file[CBUFSIZE];
+                double rate;
+
+                if ((NULL == cptr) || ('\0' == *cptr))
+                    return sim_messagef (SCPE_2FARG, "Missing Replay Specifier\n");
+                if (SCPE_OK != _tmxr_replay_spec (cptr, file, sizeof (file), &rate))
+                    return sim_messagef (SCPE_ARG, "Invalid Replay Specifier: %s\n", cptr);
+                strlcpy(replayspec, cptr, sizeof(replayspec));
+                continue;
+                }
+            if (0 == MATCH_CMD (gbuf, "NOREPLAY")) {
+                if ((NULL != cptr) && ('\0' != *cptr))
+                    return sim_messagef (SCPE_2MARG, "Unexpected NoReplay Specifier: %s\n", cptr);
+                noreplay = TRUE;
+                continue;
+                }
             if (0 == MATCH_CMD (gbuf, "NOMODEM")) {
                 if ((NULL != cptr) && ('\0' != *cptr))
                     return sim_messagef (SCPE_2MARG, "Unexpected NoModem Specifier: %s\n", cptr);
@@ -2751,7 +3842,7 @@ while (*tptr) {
             cptr = init_cptr;
             }
         cptr = get_glyph_nc (cptr, port, ';');
-        sock = sim_master_sock (port, &r);                      /* make master socket to validate port */
+        sock = _tmxr_master_sock (port, FALSE, TRUE, &r);       /* make master socket to validate port */
         if (r)
             return sim_messagef (SCPE_ARG, "Invalid Port Specifier: %s\n", port);
         if (sock == INVALID_SOCKET)                             /* open error */
@@ -2826,7 +3917,7 @@ while (*tptr) {
                     snprintf(lp->txlogname, CBUFSIZE-1, "%s_%d", mp->logfiletmpl, i);
                 else
                     strlcpy (lp->txlogname, mp->logfiletmpl, CBUFSIZE);
-                r = sim_open_logfile (lp->txlogname, TRUE, &lp->txlog, &lp->txlogref);
+                r = sim_open_logstream (lp->txlogname, TRUE, &lp->txlog, &lp->txlogref);
                 if (r != SCPE_OK) {
                     free (lp->txlogname);
                     lp->txlogname = NULL;
@@ -2835,6 +3926,18 @@ while (*tptr) {
                 }
             }
         mp->buffered = atoi(buffered);
+        mp->bufsize = bufsize;
+        if ((backlog != mp->backlog) || (reuseport != mp->reuseport)) {
+            if ((mp->master) && (!listen[0]))               /* listener needs to be recreated? */
+                return sim_messagef (SCPE_ARG, "Backlog and ReusePort must be specified with the listen port\n");
+            _tmxr_accept_flush (mp);
+            mp->backlog = backlog;
+            mp->reuseport = reuseport;
+            }
+        if (mp->backlog) {
+            mp->acc_sock = (SOCKET *)realloc (mp->acc_sock, mp->backlog * sizeof (*mp->acc_sock));
+            mp->acc_ipad = (char **)realloc (mp->acc_ipad, mp->backlog * sizeof (*mp->acc_ipad));
+            }
         for (i = 0; i < mp->lines; i++) { /* initialize line buffers */
             lp = mp->ldsc + i;
             if (mp->buffered) {
@@ -2843,9 +3946,9 @@ while (*tptr) {
                 lp->rxbsz = mp->buffered;
                 }
             else {
-                lp->txbsz = TMXR_MAXBUF;
+                lp->txbsz = _tmxr_ln_bufsize (lp);
                 lp->txbfd = 0;
-                lp->rxbsz = TMXR_MAXBUF;
+                lp->rxbsz = lp->txbsz;
                 }
             lp->txbpi = lp->txbpr = 0;
             lp->txb = (char *)realloc(lp->txb, lp->txbsz);
@@ -2864,13 +3967,18 @@ while (*tptr) {
                     }
                 }
             }
+        r = _tmxr_open_record_replay (mp, -1, recordtmpl, norecord, replayspec, noreplay);
+        if (r != SCPE_OK)
+            return r;
         if ((listen[0]) && (!datagram)) {
-            sock = sim_master_sock (listen, &r);            /* make master socket */
+            sock = _tmxr_master_sock (listen, (mp->backlog != 0), mp->reuseport, &r);/* make master socket */
             if (r)
                 return sim_messagef (SCPE_ARG, "Invalid network listen port: %s\n", listen);
             if (sock == INVALID_SOCKET)                     /* open error */
                 return sim_messagef (SCPE_OPENERR, "Can't open network socket for listen port: %s\n", listen);
             if (mp->port) {                                 /* close prior listener */
+                _tmxr_accept_flush (mp);
+                _tmxr_unwatch (mp, &mp->master_watch);
                 sim_close_sock (mp->master);
                 mp->master = 0;
                 free (mp->port);
@@ -2893,7 +4001,7 @@ while (*tptr) {
                 if (lp->serport) {                          /* serial port attached? */
                     tmxr_reset_ln (lp);                     /* close current serial connection */
                     sim_control_serial (lp->serport, 0, TMXR_MDM_DTR|TMXR_MDM_RTS, NULL);/* drop DTR and RTS */
-                    sim_close_serial (lp->serport);
+                    _tmxr_close_serial (lp);
                     lp->serport = 0;
                     free (lp->serconfig);
                     lp->serconfig = NULL;
@@ -2925,6 +4033,7 @@ while (*tptr) {
             if (serport != INVALID_HANDLE) {
                 _mux_detach_line (lp, TRUE, TRUE);
                 if (lp->mp && lp->mp->master) {             /* if existing listener, close it */
+                    _tmxr_unwatch (lp->mp, &lp->mp->master_watch);
                     sim_close_sock (lp->mp->master);
                     lp->mp->master = 0;
                     free (lp->mp->port);
@@ -2995,17 +4104,16 @@ while (*tptr) {
             lp->txlog = NULL;
             lp->txlogname = (char *)realloc (lp->txlogname, 1 + strlen (logfiletmpl));
             strcpy (lp->txlogname, logfiletmpl);
-            r = sim_open_logfile (lp->txlogname, TRUE, &lp->txlog, &lp->txlogref);
-            if (r == SCPE_OK)
-                setvbuf(lp->txlog, NULL, _IOFBF, 65536);
-            else {
+            r = sim_open_logstream (lp->txlogname, TRUE, &lp->txlog, &lp->txlogref);
+            if (r != SCPE_OK) {
                 free (lp->txlogname);
                 lp->txlogname = NULL;
                 return sim_messagef (r, "Can't open log file: %s\n", logfiletmpl);
                 }
             }
+        lp->bufsize = bufsize;
         if (buffered[0] == '\0') {
-            lp->rxbsz = lp->txbsz = TMXR_MAXBUF;
+            lp->rxbsz = lp->txbsz = _tmxr_ln_bufsize (lp);
             lp->txbfd = 0;
             }
         else {
@@ -3025,6 +4133,9 @@ while (*tptr) {
                 lp->txlog = NULL;
                 }
             }
+        r = _tmxr_open_record_replay (mp, line, recordtmpl, norecord, replayspec, noreplay);
+        if (r != SCPE_OK)
+            return r;
         if ((listen[0]) && (!datagram)) {
             if ((mp->lines == 1) && (mp->master))
                 return sim_messagef (SCPE_ARG, "Single Line MUX can have either line specific OR MUS listener but NOT both\n");
@@ -3216,15 +4327,108 @@ pthread_cond_t      sim_tmxr_startup_cond;
 int32               sim_tmxr_poll_count = 0;
 t_bool              sim_tmxr_poll_running = FALSE;
 
+/* Activate a unit which has input or a connection to service.  More than
+   one socket can be associated with the same unit, so each unit is only
+   activated once.  Called with sim_tmxr_poll_lock held. */
+
+static void _tmxr_poll_activate (UNIT *uptr, UNIT ***activated, int *activated_size, int *wait_count)
+{
+int j;
+DEVICE *d;
+
+for (j=0; j<*wait_count; ++j)
+    if ((*activated)[j] == uptr)
+        return;
+if (j == *activated_size) {
+    *activated_size *= 2;
+    *activated = (UNIT **)realloc (*activated, *activated_size * sizeof (**activated));
+    }
+(*activated)[j] = uptr;
+++*wait_count;
+d = find_dev_from_unit(uptr);
+if (!uptr->a_polling_now) {
+    uptr->a_polling_now = TRUE;
+    uptr->a_poll_waiter_count = 1;
+    sim_debug (TMXR_DBG_ASY, d, "_tmxr_poll() - Activating for data %s\n", sim_uname(uptr));
+    pthread_mutex_unlock (&sim_tmxr_poll_lock);
+    _sim_activate (uptr, 0);
+    pthread_mutex_lock (&sim_tmxr_poll_lock);
+    }
+else {
+    sim_debug (TMXR_DBG_ASY, d, "_tmxr_poll() - Already Activated %s %d times\n", sim_uname(uptr), uptr->a_poll_waiter_count);
+    ++uptr->a_poll_waiter_count;
+    }
+}
+
+#if defined(HAVE_EPOLL)
+#include <poll.h>
+
+/* With readiness tracking, the polling thread waits on each multiplexer's
+   epoll descriptor (which covers every registered socket of that mux) plus
+   the few descriptors which aren't registered yet, so the wait set scales
+   with the number of multiplexers rather than lines and isn't limited
+   by FD_SETSIZE. */
+
+typedef struct {
+    struct pollfd   *fds;                               /* descriptors to wait on */
+    UNIT            **units;                            /* unit to activate (NULL for a mux epoll descriptor) */
+    TMXR            **muxes;                            /* mux owning the descriptor */
+    int             count;
+    int             size;
+    } TMXR_POLL_SET;
+
+static void _tmxr_poll_set_add (TMXR_POLL_SET *ps, int fd, UNIT *uptr, TMXR *mp)
+{
+if (ps->count == ps->size) {
+    ps->size = ps->size ? 2 * ps->size : 64;
+    ps->fds = (struct pollfd *)realloc (ps->fds, ps->size * sizeof (*ps->fds));
+    ps->units = (UNIT **)realloc (ps->units, ps->size * sizeof (*ps->units));
+    ps->muxes = (TMXR **)realloc (ps->muxes, ps->size * sizeof (*ps->muxes));
+    }
+ps->fds[ps->count].fd = fd;
+ps->fds[ps->count].events = POLLIN;
+ps->fds[ps->count].revents = 0;
+ps->units[ps->count] = uptr;
+ps->muxes[ps->count] = mp;
+++ps->count;
+}
+
+/* Activate the units whose sockets are ready on a mux epoll descriptor */
+
+static void _tmxr_poll_activate_mux (TMXR *mp, UNIT ***activated, int *activated_size, int *wait_count)
+{
+struct epoll_event events[64];
+int i, count;
+
+count = epoll_wait (mp->poll_fd, events, sizeof (events) / sizeof (events[0]), 0);
+for (i = 0; i < count; i++) {
+    uint32 line = events[i].data.u32 >> 2;
+    uint32 kind = events[i].data.u32 & 3;
+    UNIT *uptr = mp->uptr;
+
+    if ((kind == TMXR_WATCH_MASTER) && !(mp->uptr->dynflags & UNIT_TM_POLL))
+        continue;
+    if ((kind == TMXR_WATCH_RX) && (line < (uint32)mp->lines) && (mp->ldsc[line].uptr))
+        uptr = mp->ldsc[line].uptr;
+    _tmxr_poll_activate (uptr, activated, activated_size, wait_count);
+    }
+}
+#endif /* HAVE_EPOLL */
+
 static void *
 _tmxr_poll(void *arg)
 {
+#if defined(HAVE_EPOLL)
+TMXR_POLL_SET ps;
+#else
 struct timeval timeout;
+UNIT **units = NULL;
+SOCKET *sockets = NULL;
+#endif
 int timeout_usec;
 DEVICE *dptr = tmxr_open_devices[0]->dptr;
-UNIT **units = NULL;
 UNIT **activated = NULL;
-SOCKET *sockets = NULL;
+int activated_size;
 int wait_count = 0;
 
 /* Boost Priority for this I/O thread vs the CPU instruction execution 
@@ -3234,17 +4438,25 @@ sim_os_set_thread_priority (PRIORITY_ABOVE_NORMAL);
 
 sim_debug (TMXR_DBG_ASY, dptr, "_tmxr_poll() - starting\n");
 
+#if defined(HAVE_EPOLL)
+memset (&ps, 0, sizeof (ps));
+activated_size = 64;
+#else
 units = (UNIT **)calloc(FD_SETSIZE, sizeof(*units));
-activated = (UNIT **)calloc(FD_SETSIZE, sizeof(*activated));
 sockets = (SOCKET *)calloc(FD_SETSIZE, sizeof(*sockets));
+activated_size = FD_SETSIZE;
+#endif
+activated = (UNIT **)calloc(activated_size, sizeof(*activated));
 timeout_usec = 1000000;
 pthread_mutex_lock (&sim_tmxr_poll_lock);
 pthread_cond_signal (&sim_tmxr_startup_cond);   /* Signal we're ready to go */
 while (sim_asynch_enabled) {
     int i, j, status, select_errno;
+#if !defined(HAVE_EPOLL)
     fd_set readfds, errorfds;
-    int socket_count;
     SOCKET max_socket_fd;
+#endif
+    int socket_count;
     TMXR *mp;
     DEVICE *d;
 
@@ -3263,6 +4475,28 @@ while (sim_asynch_enabled) {
         pthread_cond_wait (&sim_tmxr_poll_cond, &sim_tmxr_poll_lock);
         sim_debug (TMXR_DBG_ASY, dptr, "_tmxr_poll() - continuing with timeout of %dms\n", timeout_usec/1000);
         }
+#if defined(HAVE_EPOLL)
+    ps.count = 0;
+    for (i=0; i<tmxr_open_device_count; ++i) {
+        mp = tmxr_open_devices[i];
+        if (mp->poll_fd > 0)                    /* registered sockets */
+            _tmxr_poll_set_add (&ps, mp->poll_fd, NULL, mp);
+        if ((mp->master) && (mp->uptr->dynflags&UNIT_TM_POLL) && (mp->master_watch != mp->master))
+            _tmxr_poll_set_add (&ps, mp->master, mp->uptr, mp);
+        for (j=0; j<mp->lines; ++j) {
+            TMLN *lp = &mp->ldsc[j];
+            UNIT *uptr = lp->uptr ? lp->uptr : mp->uptr;
+
+            if ((lp->sock) && (lp->rx_watch != lp->sock))
+                _tmxr_poll_set_add (&ps, lp->sock, uptr, mp);
+            if ((lp->connecting) && (lp->conn_watch != lp->connecting))
+                _tmxr_poll_set_add (&ps, lp->connecting, mp->uptr, mp);
+            if ((lp->master) && (lp->master_watch != lp->master))
+                _tmxr_poll_set_add (&ps, lp->master, mp->uptr, mp);
+            }
+        }
+    socket_count = ps.count;
+#else
     FD_ZERO (&readfds);
     FD_ZERO (&errorfds);
     for (i=max_socket_fd=socket_count=0; i<tmxr_open_device_count; ++i) {
@@ -3321,24 +4555,30 @@ while (sim_asynch_enabled) {
                 }
             }
         }
+#endif
     pthread_mutex_unlock (&sim_tmxr_poll_lock);
     if (timeout_usec > 1000000)
         timeout_usec = 1000000;
-    timeout.tv_sec = timeout_usec/1000000;
-    timeout.tv_usec = timeout_usec%1000000;
     select_errno = 0;
     if (socket_count == 0) {
         sim_os_ms_sleep (timeout_usec/1000);
         status = 0;
         }
-    else
+    else {
+#if defined(HAVE_EPOLL)
+        status = poll (ps.fds, socket_count, timeout_usec/1000);
+#else
+        timeout.tv_sec = timeout_usec/1000000;
+        timeout.tv_usec = timeout_usec%1000000;
         status = select (1+(int)max_socket_fd, &readfds, NULL, &errorfds, &timeout);
+#endif
+        }
     select_errno = errno;
     wait_count=0;
     pthread_mutex_lock (&sim_tmxr_poll_lock);
     switch (status) {
         case 0:     /* timeout */
-            for (i=max_socket_fd=socket_count=0; i<tmxr_open_device_count; ++i) {
+            for (i=0; i<tmxr_open_device_count; ++i) {
                 mp = tmxr_open_devices[i];
                 if (mp->master) {
                     if (!mp->uptr->a_polling_now) {
@@ -3388,32 +4628,18 @@ while (sim_asynch_enabled) {
         default:
             wait_count = 0;
             for (i=0; i<socket_count; ++i) {
+#if defined(HAVE_EPOLL)
+                if (ps.fds[i].revents == 0)
+                    continue;
+                if (ps.units[i] == NULL)        /* mux epoll descriptor? */
+                    _tmxr_poll_activate_mux (ps.muxes[i], &activated, &activated_size, &wait_count);
+                else
+                    _tmxr_poll_activate (ps.units[i], &activated, &activated_size, &wait_count);
+#else
                 if (FD_ISSET(sockets[i], &readfds) || 
-                    FD_ISSET(sockets[i], &errorfds)) {
-                    /* More than one socket can be associated with the 
-                       same unit.  Only activate one time */
-                    for (j=0; j<wait_count; ++j)
-                        if (activated[j] == units[i])
-                            break;
-                    if (j == wait_count) {
-                        activated[j] = units[i];
-                        ++wait_count;
-                        if (!activated[j]->a_polling_now) {
-                            activated[j]->a_polling_now = TRUE;
-                            activated[j]->a_poll_waiter_count = 1;
-                            d = find_dev_from_unit(activated[j]);
-                            sim_debug (TMXR_DBG_ASY, d, "_tmxr_poll() - Activating for data %s\n", sim_uname(activated[j]));
-                            pthread_mutex_unlock (&sim_tmxr_poll_lock);
-                            _sim_activate (activated[j], 0);
-                            pthread_mutex_lock (&sim_tmxr_poll_lock);
-                            }
-                        else {
-                            d = find_dev_from_unit(activated[j]);
-                            sim_debug (TMXR_DBG_ASY, d, "_tmxr_poll() - Already Activated %s%d %d times\n", sim_uname(activated[j]), activated[j]->a_poll_waiter_count);
-                            ++activated[j]->a_poll_waiter_count;
-                            }
-                        }
-                    }
+                    FD_ISSET(sockets[i], &errorfds))
+                    _tmxr_poll_activate (units[i], &activated, &activated_size, &wait_count);
+#endif
                 }
             if (wait_count)
                 timeout_usec = 10000; /* Wait 10ms next time */
@@ -3422,9 +4648,15 @@ while (sim_asynch_enabled) {
     sim_tmxr_poll_count += wait_count;
     }
 pthread_mutex_unlock (&sim_tmxr_poll_lock);
+#if defined(HAVE_EPOLL)
+free(ps.fds);
+free(ps.units);
+free(ps.muxes);
+#else
 free(units);
-free(activated);
 free(sockets);
+#endif
+free(activated);
 
 sim_debug (TMXR_DBG_ASY, dptr, "_tmxr_poll() - exiting\n");
 
@@ -4009,6 +5241,12 @@ if (mp->modem_control)
     fprintf(st, ", ModemControl=enabled");
 if (mp->buffered)
     fprintf(st, ", Buffered=%d", mp->buffered);
+if (mp->bufsize)
+    fprintf(st, ", BufSize=%d", mp->bufsize);
+if (mp->backlog)
+    fprintf(st, ", Backlog=%d", mp->backlog);
+if (mp->reuseport)
+    fprintf(st, ", ReusePort");
 for (j = 1; j < mp->lines; j++)
     if (o_uptr != mp->ldsc[j].o_uptr)
         break;
@@ -4037,6 +5275,16 @@ if (mp->lines == 1) {
         }
     }
 fprintf(st, "\n");
+if (mp->backlog) {
+    int depth, limit;
+
+    depth = sim_accept_queue_depth (mp->master, &limit);
+    fprintf (st, "    accept queue: ");
+    if (depth >= 0)
+        fprintf (st, "%d pending (limit %d), ", depth, limit);
+    fprintf (st, "%d awaiting a line, %d batches, largest batch %d\n", 
+                 mp->acc_count - mp->acc_next, mp->acc_batches, mp->acc_batch_max);
+    }
 if (mp->ring_start_time) {
     fprintf (st, "    incoming Connection from: %s ringing for %d milliseconds\n", mp->ring_ipad, sim_os_msec () - mp->ring_start_time);
     }
@@ -4150,6 +5398,7 @@ for (i = 0; i < mp->lines; i++) {  /* loop thru conn */
         lp->conn = FALSE;
         }
     if (lp->master) {
+        _tmxr_unwatch_ln (lp, lp->master);
         sim_close_sock (lp->master);                    /* close master socket */
         lp->master = 0;
         free (lp->port);
@@ -4163,13 +5412,25 @@ for (i = 0; i < mp->lines; i++) {  /* loop thru conn */
     free (lp->rbr);
     lp->rbr = NULL;
     lp->modembits = 0;
+    _tmxr_record_close (lp);
+    _tmxr_replay_close (lp);
     }
+mp->recordtmpl[0] = mp->replaytmpl[0] = '\0';
 
-if (mp->master)
+if (mp->master) {
+    _tmxr_unwatch (mp, &mp->master_watch);
     sim_close_sock (mp->master);                        /* close master socket */
+    }
 mp->master = 0;
 free (mp->port);
 mp->port = NULL;
+_tmxr_accept_flush (mp);
+free (mp->acc_sock);
+mp->acc_sock = NULL;
+free (mp->acc_ipad);
+mp->acc_ipad = NULL;
+mp->backlog = 0;
+mp->reuseport = FALSE;
 if (mp->ring_sock != INVALID_SOCKET) {
     sim_close_sock (mp->ring_sock);
     mp->ring_sock = INVALID_SOCKET;
@@ -4178,6 +5439,7 @@ if (mp->ring_sock != INVALID_SOCKET) {
     mp->ring_start_time = 0;
     }
 _tmxr_remove_from_open_list (mp);
+_tmxr_poll_close (mp);
 return SCPE_OK;
 }
 
@@ -4408,10 +5670,22 @@ if (single_line) {          /* Single Line Multiplexer */
     fprintf (st, "Line buffering can be disabled for the %s device with:\n\n", dptr->name);
     fprintf (st, "   sim> ATTACH %s NoBuffer\n\n", dptr->name);
     fprintf (st, "The default buffer size is 32k bytes, the max buffer size is 1024k bytes\n\n");
+    fprintf (st, "The receive and transmit buffer size used when the %s device isn't\n", dptr->name);
+    fprintf (st, "buffered can be changed from the default of %d bytes with:\n\n", TMXR_MAXBUF);
+    fprintf (st, "   sim> ATTACH %s BufSize=bytes\n\n", dptr->name);
     fprintf (st, "The outbound traffic the %s device can be logged to a file with:\n", dptr->name);
     fprintf (st, "   sim> ATTACH %s Log=LogFileName\n\n", dptr->name);
     fprintf (st, "File logging can be disabled for the %s device with:\n\n", dptr->name);
     fprintf (st, "   sim> ATTACH %s NoLog\n\n", dptr->name);
+    fprintf (st, "The input received by the %s device can be recorded, with its timing,\n", dptr->name);
+    fprintf (st, "to a file and replayed into the device later:\n\n");
+    fprintf (st, "   sim> ATTACH %s Record=RecordFileName\n", dptr->name);
+    fprintf (st, "   sim> ATTACH %s Replay=RecordFileName{;rate}\n\n", dptr->name);
+    fprintf (st, "The rate is a multiple of the recorded pace (default 1) or MAX to send\n");
+    fprintf (st, "each record as soon as the simulated system has responded to the previous\n");
+    fprintf (st, "one.  Replay starts when the line is connected or buffered, and SHOW %s\n", dptr->name);
+    fprintf (st, "CONNECTIONS reports the progress and the response latencies.  NoRecord\n");
+    fprintf (st, "and NoReplay stop recording and replaying.\n\n");
     fprintf (st, "The %s device may be connected to a serial port on the host system.\n", dptr->name);
     }
 else {
@@ -4440,12 +5714,40 @@ else {
         fprintf (st, "Line buffering for all lines on the %s device can be disabled with:\n\n", dptr->name);
     fprintf (st, "   sim> ATTACH %s NoBuffer\n\n", dptr->name);
     fprintf (st, "The default buffer size is 32k bytes, the max buffer size is 1024k bytes\n\n");
+    fprintf (st, "The receive and transmit buffer size used by lines which aren't buffered\n");
+    fprintf (st, "can be changed from the default of %d bytes for all lines or for a\n", TMXR_MAXBUF);
+    fprintf (st, "specific line with:\n\n");
+    fprintf (st, "   sim> ATTACH %s BufSize=bytes\n", dptr->name);
+    fprintf (st, "   sim> ATTACH %s Line=n,BufSize=bytes\n\n", dptr->name);
+    fprintf (st, "Devices which transfer characters in bulk (such as the DHV11 with DMA\n");
+    fprintf (st, "output) benefit from larger buffers on high speed connections.\n\n");
+    fprintf (st, "By default one incoming connection is accepted per connection poll.  When\n");
+    fprintf (st, "many sessions connect at once (for example after a host network outage)\n");
+    fprintf (st, "all waiting connections can be accepted together, up to a limit, with:\n\n");
+    fprintf (st, "   sim> ATTACH %s {interface:}port,Backlog{=count}\n\n", dptr->name);
+    fprintf (st, "The default count is %d.  The listening port can also be shared with\n", TMXR_DEFAULT_BACKLOG);
+    fprintf (st, "other processes which listen on it the same way (where the host supports\n");
+    fprintf (st, "SO_REUSEPORT) with:\n\n");
+    fprintf (st, "   sim> ATTACH %s {interface:}port,ReusePort\n\n", dptr->name);
     fprintf (st, "The outbound traffic for the lines of the %s device can be logged to files\n", dptr->name);
     fprintf (st, "with:\n\n");
     fprintf (st, "   sim> ATTACH %s Log=LogFileName\n\n", dptr->name);
     fprintf (st, "The log file name for each line uses the above LogFileName as a template\n");
     fprintf (st, "for the actual file name which will be LogFileName_n where n is the line\n");
     fprintf (st, "number.\n\n");
+    fprintf (st, "The input received on the lines of the %s device can be recorded, with\n", dptr->name);
+    fprintf (st, "its timing, to files and replayed into the lines later:\n\n");
+    fprintf (st, "   sim> ATTACH %s Record=RecordFileName\n", dptr->name);
+    fprintf (st, "   sim> ATTACH %s Replay=RecordFileName{;rate}\n", dptr->name);
+    fprintf (st, "   sim> ATTACH %s Line=n,Record=RecordFileName\n", dptr->name);
+    fprintf (st, "   sim> ATTACH %s Line=n,Replay=RecordFileName{;rate}\n\n", dptr->name);
+    fprintf (st, "Without a Line, RecordFileName is a template like LogFileName, and lines\n");
+    fprintf (st, "without a recording aren't replayed.  The rate is a multiple of the\n");
+    fprintf (st, "recorded pace (default 1) or MAX to send each record as soon as the\n");
+    fprintf (st, "simulated system has responded to the previous one.  Replay starts when\n");
+    fprintf (st, "a line is connected or buffered, and SHOW %s CONNECTIONS reports the\n", dptr->name);
+    fprintf (st, "progress and the response latencies.  NoRecord and NoReplay stop recording\n");
+    fprintf (st, "and replaying.\n\n");
     fprintf (st, "Multiplexer lines may be connected to serial ports on the host system.\n");
     }
 fprintf (st, "Serial ports may be specified as an operating system specific device names\n");
@@ -4777,6 +6079,10 @@ if (lp->expect.buf)
     sim_exp_showall (st, &lp->expect);
 if (lp->txlog)
     fprintf (st, " Logging to %s\n", lp->txlogname);
+if (lp->rxrecord)
+    fprintf (st, " Recording input to %s\n", lp->rxrecordname);
+if (lp->replay)
+    _tmxr_replay_show (st, lp);
 }
 
 
@@ -4825,6 +6131,71 @@ if (lp->txdrp)
     fprintf (st, "  dropped = %d\n", lp->txdrp);
 if (lp->txstall)
     fprintf (st, "  stalled = %d\n", lp->txstall);
+if (lp->rxpeak || lp->txpeak)
+    fprintf (st, "  peak input/output buffer fill = %d/%d\n", lp->rxpeak, lp->txpeak);
+if (lp->rxdrp)
+    fprintf (st, "  input discarded = %d\n", lp->rxdrp);
+if (lp->rxdefer)
+    fprintf (st, "  input reads deferred by speed = %d\n", lp->rxdefer);
+if (lp->rxlatcnt)
+    fprintf (st, "  input latency avg/max = %.3f/%.3f ms (%d samples)\n", 
+                 (1000.0 * lp->rxlatsum) / lp->rxlatcnt, 1000.0 * lp->rxlatmax, lp->rxlatcnt);
+}
+
+/* Output the statistics of a multiplexer and all of its lines as key=value
+   records (one for the multiplexer followed by one per line).  Rates are
+   since the line connected, and the other statistics are since attach.
+   Times are in microseconds. */
+
+static void tmxr_fstats_records (FILE *st, const TMXR *mp)
+{
+int32 i, connected, rxdrp = 0, rxlatcnt = 0;
+double rxlatsum = 0.0, rxlatmax = 0.0;
+uint32 now = sim_os_msec ();
+const TMLN *lp;
+
+for (i = connected = 0; i < mp->lines; i++) {
+    lp = &mp->ldsc[i];
+    if (lp->sock || lp->serport)
+        ++connected;
+    rxdrp = rxdrp + lp->rxdrp;
+    rxlatcnt = rxlatcnt + lp->rxlatcnt;
+    rxlatsum = rxlatsum + lp->rxlatsum;
+    if (lp->rxlatmax > rxlatmax)
+        rxlatmax = lp->rxlatmax;
+    }
+fprintf (st, "mux=%s lines=%d connected=%d polls=%d poll_interval_avg_us=%.0f poll_interval_max_us=%.0f "
+             "rx_dropped=%d latency_samples=%d latency_avg_us=%.0f latency_max_us=%.0f "
+             "sessions=%d accept_queue=%d accept_waiting=%d accept_batches=%d accept_batch_max=%d\n",
+         mp->dptr ? sim_dname (mp->dptr) : "", mp->lines, connected, mp->polls,
+         (mp->polls > 1) ? (1000000.0 * mp->poll_intsum) / (mp->polls - 1) : 0.0, 1000000.0 * mp->poll_intmax,
+         rxdrp, rxlatcnt, rxlatcnt ? (1000000.0 * rxlatsum) / rxlatcnt : 0.0, 1000000.0 * rxlatmax,
+         mp->sessions, sim_accept_queue_depth (mp->master, NULL), mp->acc_count - mp->acc_next, 
+         mp->acc_batches, mp->acc_batch_max);
+for (i = 0; i < mp->lines; i++) {
+    double secs;
+
+    lp = &mp->ldsc[i];
+    secs = lp->cnms ? (now - lp->cnms) / 1000.0 : 0.0;
+    fprintf (st, "line=%d connected=%d rx_bytes=%d tx_bytes=%d rx_bps=%.0f tx_bps=%.0f "
+                 "rx_queued=%d tx_queued=%d rx_peak=%d tx_peak=%d rx_dropped=%d rx_deferred=%d "
+                 "tx_dropped=%d tx_stalled=%d latency_samples=%d latency_avg_us=%.0f latency_max_us=%.0f",
+             i, (lp->sock || lp->serport) ? 1 : 0, lp->rxcnt, lp->txcnt,
+             (secs > 0.0) ? lp->rxcnt / secs : 0.0, (secs > 0.0) ? lp->txcnt / secs : 0.0,
+             tmxr_rqln_bare (lp, FALSE), tmxr_tqln (lp), lp->rxpeak, lp->txpeak, lp->rxdrp, lp->rxdefer,
+             lp->txdrp, lp->txstall, lp->rxlatcnt, lp->rxlatcnt ? (1000000.0 * lp->rxlatsum) / lp->rxlatcnt : 0.0,
+             1000000.0 * lp->rxlatmax);
+    if (lp->replay) {
+        const struct tmxr_replay *rp = lp->replay;
+
+        fprintf (st, " replay_records=%d replay_sent=%d replay_rate=%g replay_responses=%d "
+                     "replay_latency_avg_us=%.0f replay_latency_min_us=%.0f replay_latency_max_us=%.0f",
+                 rp->count, rp->next, rp->rate, rp->responses,
+                 rp->responses ? (1000000.0 * rp->latsum) / rp->responses : 0.0,
+                 1000000.0 * rp->latmin, 1000000.0 * rp->latmax);
+        }
+    fprintf (st, "\n");
+    }
 }
 
 
@@ -4870,7 +6241,7 @@ lp = tmxr_get_ldsc (uptr, cptr, mp, &status);                   /* get reference
 if (lp == NULL)                                                 /* bad line number? */
     return status;                                              /* report it */
 
-if ((lp->sock) || (lp->serport)) {                              /* connection active? */
+if ((lp->sock) || (lp->serport) || (lp->evlog_conn)) {         /* connection active? */
     if (!lp->notelnet)
         tmxr_linemsg (lp, "\r\nOperator disconnected line\r\n\n");/* report closure */
     if (lp->serport && (sim_switches & SWMASK ('C')))
@@ -4900,7 +6271,7 @@ lp->txlogname = (char *) calloc (CBUFSIZE, sizeof (char)); /* alloc namebuf */
 if (lp->txlogname == NULL)                              /* can't? */
     return SCPE_MEM;
 strlcpy (lp->txlogname, cptr, CBUFSIZE);                /* save file name */
-sim_open_logfile (cptr, TRUE, &lp->txlog, &lp->txlogref);/* open log */
+sim_open_logstream (cptr, TRUE, &lp->txlog, &lp->txlogref);/* open log */
 if (lp->txlog == NULL) {                                /* error? */
     free (lp->txlogname);                               /* free buffer */
     return SCPE_OPENERR;
@@ -5148,7 +6519,11 @@ else
 return SCPE_OK;
 }
 
-/* Show conn/stat processor */
+/* Show conn/stat processor
+
+   With the -M switch, statistics are reported for every line as key=value
+   records which can be parsed by monitoring tools.
+*/
 
 t_stat tmxr_show_cstat (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
 {
@@ -5157,6 +6532,10 @@ int32 i, any;
 
 if (mp == NULL)
     return SCPE_IERR;
+if ((val == 0) && (sim_switches & SWMASK ('M'))) {      /* machine readable statistics? */
+    tmxr_fstats_records (st, mp);
+    return SCPE_OK;
+    }
 for (i = any = 0; i < mp->lines; i++) {
     if ((mp->ldsc[i].sock != 0) || 
         (mp->ldsc[i].serport != 0) || mp->ldsc[i].modem_control) {
@@ -5427,3 +6806,1048 @@ if ((dptr) && (dbits & dptr->dctrl)) {
         }
     }
 }
+
+/* Unit tests */
+
+#if !defined(_WIN32) && !defined(VMS)
+#include <fcntl.h>
+
+/* Lines with hundreds of connected but mostly idle sockets must only
+   deliver data from the lines which have some, must notice disconnects,
+   and must keep working when a closed socket's descriptor number is
+   reused for a new connection. */
+
+static t_stat tmxr_test_poll_rx (DEVICE *dptr)
+{
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+int peer[200];
+static const int busy[] = {3, 77, 199};
+int sv[2];
+int i, j, polls = 0, errors = 0;
+uint32 start_ms, elapsed_ms;
+t_bool bench = sim_test_bench;                          /* -B reports timings */
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.lines = sizeof (peer) / sizeof (peer[0]);
+mux.ldsc = (TMLN *)calloc (mux.lines, sizeof (*mux.ldsc));
+mux.ring_sock = INVALID_SOCKET;
+for (i = 0; i < mux.lines; i++) {
+    lp = &mux.ldsc[i];
+    lp->mp = &mux;
+    lp->notelnet = TRUE;
+    lp->rcve = 1;
+    tmxr_init_line (lp);
+    if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv)) {
+        sim_printf ("tmxr: socketpair() failed for line %d: %s\n", i, strerror (errno));
+        mux.lines = i;
+        ++errors;
+        break;
+        }
+    fcntl (sv[0], F_SETFL, fcntl (sv[0], F_GETFL) | O_NONBLOCK);
+    lp->sock = sv[0];
+    lp->conn = TRUE;
+    peer[i] = sv[1];
+    }
+tmxr_poll_rx (&mux);                                    /* first poll sees every line once */
+for (j = 0; (errors == 0) && (j < (int)(sizeof (busy) / sizeof (busy[0]))); j++)
+    if (write (peer[busy[j]], "hello", 5) != 5)
+        ++errors;
+tmxr_poll_rx (&mux);
+for (i = 0; (errors == 0) && (i < mux.lines); i++) {
+    int expected = 0;
+
+    for (j = 0; j < (int)(sizeof (busy) / sizeof (busy[0])); j++)
+        if (i == busy[j])
+            expected = 5;
+    if (tmxr_rqln (&mux.ldsc[i]) != expected) {
+        sim_printf ("tmxr: line %d has %d characters, expected %d\n", i, tmxr_rqln (&mux.ldsc[i]), expected);
+        ++errors;
+        }
+    }
+for (j = 0; (errors == 0) && (j < (int)(sizeof (busy) / sizeof (busy[0]))); j++)
+    while (tmxr_getc_ln (&mux.ldsc[busy[j]]))
+        ;
+/* A peer disconnect is noticed */
+close (peer[77]);
+peer[77] = -1;
+tmxr_poll_rx (&mux);
+if ((errors == 0) && (mux.ldsc[77].conn || mux.ldsc[77].sock)) {
+    sim_printf ("tmxr: line 77 disconnect wasn't noticed\n");
+    ++errors;
+    }
+/* The line is reconnected, most likely with the same descriptor number */
+if ((errors == 0) && (socketpair (AF_UNIX, SOCK_STREAM, 0, sv) == 0)) {
+    fcntl (sv[0], F_SETFL, fcntl (sv[0], F_GETFL) | O_NONBLOCK);
+    mux.ldsc[77].sock = sv[0];
+    mux.ldsc[77].conn = TRUE;
+    peer[77] = sv[1];
+    tmxr_poll_rx (&mux);
+    if (write (peer[77], "again", 5) != 5)
+        ++errors;
+    tmxr_poll_rx (&mux);
+    if (tmxr_rqln (&mux.ldsc[77]) != 5) {
+        sim_printf ("tmxr: reconnected line 77 has %d characters, expected 5\n", tmxr_rqln (&mux.ldsc[77]));
+        ++errors;
+        }
+    }
+if ((errors == 0) && bench) {
+    start_ms = sim_os_msec ();
+    do {
+        for (i = 0; i < 1000; i++)
+            tmxr_poll_rx (&mux);
+        polls += i;
+        elapsed_ms = sim_os_msec () - start_ms;
+        } while (elapsed_ms < 100);
+    sim_printf ("tmxr: %d idle lines: %.2f usecs per tmxr_poll_rx()\n", mux.lines, (1000.0 * elapsed_ms) / polls);
+    }
+for (i = 0; i < mux.lines; i++) {
+    lp = &mux.ldsc[i];
+    if (lp->sock)
+        tmxr_reset_ln (lp);
+    if (peer[i] >= 0)
+        close (peer[i]);
+    free (lp->txb);
+    free (lp->rxb);
+    free (lp->rbr);
+    }
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Move data through a line with the single character and the bulk APIs
+   and compare their throughput */
+
+static int tmxr_test_bulk_pass (TMLN *lp, int peer, t_bool bulk, int32 total, double *mbps)
+{
+uint8 out[4096], in[4096], brk[4096];
+int32 written = 0, received = 0, i, n, val;
+int errors = 0;
+uint32 start_ms = sim_os_msec (), elapsed_ms;
+
+while ((errors == 0) && (received < total)) {
+    while (written < total) {                           /* keep the peer busy */
+        n = total - written;
+        if (n > (int32)sizeof (out))
+            n = (int32)sizeof (out);
+        for (i = 0; i < n; i++)
+            out[i] = (uint8)((written + i) % 251);
+        n = (int32)write (peer, out, n);
+        if (n <= 0)
+            break;
+        written += n;
+        }
+    tmxr_poll_rx (lp->mp);
+    if (bulk) {
+        while ((n = tmxr_read_ln (lp, in, brk, sizeof (in))) > 0)
+            for (i = 0; i < n; i++, received++)
+                if ((in[i] != (uint8)(received % 251)) || brk[i])
+                    ++errors;
+        }
+    else {
+        while ((val = tmxr_getc_ln (lp)) != 0)
+            if ((val & 0xFF) != (received++ % 251))
+                ++errors;
+        }
+    if ((sim_os_msec () - start_ms) > 30000) {
+        sim_printf ("tmxr: %s transfer stalled after %d of %d bytes\n", bulk ? "bulk" : "character", received, total);
+        ++errors;
+        }
+    }
+if (errors)
+    sim_printf ("tmxr: %d %s receive data errors\n", errors, bulk ? "bulk" : "character");
+elapsed_ms = sim_os_msec () - start_ms;
+*mbps = total / (1000.0 * (elapsed_ms ? elapsed_ms : 1));
+return errors;
+}
+
+static t_stat tmxr_test_bulk (DEVICE *dptr)
+{
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+int sv[2] = {-1, -1};
+int32 i, n, sent;
+int errors = 0;
+const int32 total = 32*1024*1024;
+double getc_mbps, read_mbps;
+uint8 buf[600], in[2*sizeof (buf)];
+t_bool was_running = sim_is_running;
+t_bool bench = sim_test_bench;                          /* -B reports timings */
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.lines = 1;
+mux.ldsc = lp = (TMLN *)calloc (1, sizeof (*lp));
+mux.ring_sock = INVALID_SOCKET;
+mux.bufsize = 16384;
+lp->mp = &mux;
+lp->notelnet = TRUE;
+lp->rcve = 1;
+tmxr_init_line (lp);
+if ((lp->rxbsz != mux.bufsize) || (lp->txbsz != mux.bufsize)) {
+    sim_printf ("tmxr: BufSize=%d produced %d/%d byte buffers\n", mux.bufsize, lp->rxbsz, lp->txbsz);
+    ++errors;
+    }
+if ((errors == 0) && socketpair (AF_UNIX, SOCK_STREAM, 0, sv)) {
+    sim_printf ("tmxr: socketpair() failed: %s\n", strerror (errno));
+    ++errors;
+    }
+if (errors == 0) {
+    fcntl (sv[0], F_SETFL, fcntl (sv[0], F_GETFL) | O_NONBLOCK);
+    fcntl (sv[1], F_SETFL, fcntl (sv[1], F_GETFL) | O_NONBLOCK);
+    lp->sock = sv[0];
+    lp->conn = TRUE;
+    tmxr_poll_rx (&mux);
+    errors += tmxr_test_bulk_pass (lp, sv[1], FALSE, total, &getc_mbps);
+    errors += tmxr_test_bulk_pass (lp, sv[1], TRUE, total, &read_mbps);
+    if ((errors == 0) && bench)
+        sim_printf ("tmxr: %d byte buffers receive %.1f MB/sec with tmxr_getc_ln(), %.1f MB/sec with tmxr_read_ln()\n", 
+                    mux.bufsize, getc_mbps, read_mbps);
+    }
+/* A break stops a read without a break buffer and is returned in one */
+if (errors == 0) {
+    if (write (sv[1], "ab", 2) != 2)
+        ++errors;
+    tmxr_poll_rx (&mux);
+    lp->rbr[1] = 1;
+    if ((tmxr_read_ln (lp, in, NULL, sizeof (in)) != 1) || (in[0] != 'a') ||
+        (tmxr_read_ln (lp, in, NULL, sizeof (in)) != 0) ||
+        (tmxr_getc_ln (lp) != (TMXR_VALID | SCPE_BREAK | 'b'))) {
+        sim_printf ("tmxr: tmxr_read_ln() break handling failed\n");
+        ++errors;
+        }
+    }
+/* Bulk output doubles IACs in a Telnet session and stalls when full */
+if (errors == 0) {
+    sim_is_running = TRUE;                              /* as when called from a device */
+    lp->notelnet = FALSE;
+    for (i = 0; i < (int32)sizeof (buf); i++)
+        buf[i] = (uint8)((i % 100) ? (i % 250) : TN_IAC);
+    if ((tmxr_write_ln (lp, buf, sizeof (buf), &sent) != SCPE_OK) ||
+        (sent != (int32)sizeof (buf)) ||
+        (tmxr_tqln (lp) != (int32)sizeof (buf) + 6)) {
+        sim_printf ("tmxr: tmxr_write_ln() sent %d bytes, buffered %d\n", sent, tmxr_tqln (lp));
+        ++errors;
+        }
+    tmxr_send_buffered_data (lp);
+    n = (int32)read (sv[1], in, sizeof (in));
+    for (i = 0; (errors == 0) && (i < (int32)sizeof (buf)); i++) {
+        int32 off = i + 1 + i / 100;                    /* doubled IACs so far */
+
+        if ((n != (int32)sizeof (buf) + 6) || (in[off] != buf[i]) ||
+            ((buf[i] == TN_IAC) && (in[off-1] != TN_IAC))) {
+            sim_printf ("tmxr: tmxr_write_ln() data mismatch at %d of %d bytes\n", i, n);
+            ++errors;
+            }
+        }
+    lp->notelnet = TRUE;
+    for (i = 0; (errors == 0) && (i < 100) && (tmxr_write_ln (lp, buf, sizeof (buf), &sent) == SCPE_OK); i++)
+        ;
+    if ((errors == 0) && ((i == 100) || (tmxr_tqln (lp) != lp->txbsz - 1))) {
+        sim_printf ("tmxr: tmxr_write_ln() didn't stall with %d of %d bytes buffered\n", tmxr_tqln (lp), lp->txbsz);
+        ++errors;
+        }
+    sim_is_running = was_running;
+    }
+if (lp->sock)
+    tmxr_reset_ln (lp);
+if (sv[1] >= 0)
+    close (sv[1]);
+free (lp->txb);
+free (lp->rxb);
+free (lp->rbr);
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Telnet receive processing removes protocol sequences, including ones split
+   across reads, and passes long binary runs through quickly */
+
+static t_stat tmxr_test_telnet_rx (DEVICE *dptr)
+{
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+int sv[2] = {-1, -1};
+int errors = 0;
+int32 i, n, total = 0;
+uint32 start_ms, elapsed_ms;
+t_bool bench = sim_test_bench;                          /* -B reports timings */
+static const struct {
+    int32 dstb;
+    const char *in;
+    int32 in_size;
+    const char *out;
+    int32 out_size;
+    int32 brk;                                          /* offset of break (-1 for none) */
+    } cases[] = {
+        {0, "ab\377\377c",               5, "ab\377c",     4, -1},
+        {0, "a\377\361b\377\375\001c",  8, "abc",         3, -1},
+        {0, "a\377\363b",                4, "a\000b",      3,  1},
+        {1, "x\r\ny\r\000z\rq",           9, "x\ry\rz\rq",   7, -1},
+        {0, "x\r\ny",                    4, "x\r\ny",      4, -1},
+        {0, "split\377",                 6, "split",       5, -1},
+        {0, "\377tail",                  5, "\377tail",    5, -1},
+        };
+uint8 in[4096], brk[4096];
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.lines = 1;
+mux.ldsc = lp = (TMLN *)calloc (1, sizeof (*lp));
+mux.ring_sock = INVALID_SOCKET;
+mux.bufsize = 16384;
+lp->mp = &mux;
+lp->rcve = 1;
+tmxr_init_line (lp);
+if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv)) {
+    sim_printf ("tmxr: socketpair() failed: %s\n", strerror (errno));
+    ++errors;
+    }
+else {
+    fcntl (sv[0], F_SETFL, fcntl (sv[0], F_GETFL) | O_NONBLOCK);
+    lp->sock = sv[0];
+    lp->conn = TRUE;
+    }
+for (i = 0; (errors == 0) && (i < (int32)(sizeof (cases) / sizeof (cases[0]))); i++) {
+    lp->dstb = cases[i].dstb;
+    if (write (sv[1], cases[i].in, cases[i].in_size) != cases[i].in_size)
+        ++errors;
+    tmxr_poll_rx (&mux);
+    n = tmxr_read_ln (lp, in, brk, sizeof (in));
+    if ((n != cases[i].out_size) || memcmp (in, cases[i].out, n) ||
+        (cases[i].brk != ((memchr (brk, 1, n) == NULL) ? -1 : (int32)((uint8 *)memchr (brk, 1, n) - brk)))) {
+        sim_printf ("tmxr: Telnet receive case %d returned %d of %d characters\n", i, n, cases[i].out_size);
+        ++errors;
+        }
+    }
+/* Binary data with an occasional (doubled) IAC */
+if (errors == 0) {
+    uint8 out[4096];
+
+    for (i = 0, n = 0; n < (int32)sizeof (out) - 1; i++) {
+        out[n++] = (uint8)((i % 1000) ? (i % 255) : TN_IAC);
+        if (out[n-1] == TN_IAC)
+            out[n++] = TN_IAC;
+        }
+    start_ms = sim_os_msec ();
+    do {
+        for (i = 0; i < 100; i++) {
+            if (write (sv[1], out, n) != n)
+                ++errors;
+            tmxr_poll_rx (&mux);
+            total += tmxr_read_ln (lp, in, brk, sizeof (in));
+            }
+        elapsed_ms = sim_os_msec () - start_ms;
+        } while ((errors == 0) && (elapsed_ms < 200));
+    if (bench)
+        sim_printf ("tmxr: Telnet binary receive %.1f MB/sec\n", total / (1000.0 * (elapsed_ms ? elapsed_ms : 1)));
+    }
+if (lp->sock)
+    tmxr_reset_ln (lp);
+if (sv[1] >= 0)
+    close (sv[1]);
+free (lp->txb);
+free (lp->rxb);
+free (lp->rbr);
+free (lp->telnet_sent_opts);
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Line statistics track buffer peaks, input latency and discarded input */
+
+static t_stat tmxr_test_statistics (DEVICE *dptr)
+{
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+int sv[2] = {-1, -1};
+int errors = 0;
+char record[512];
+FILE *f = tmpfile ();
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.dptr = dptr;
+mux.lines = 1;
+mux.ldsc = lp = (TMLN *)calloc (1, sizeof (*lp));
+mux.ring_sock = INVALID_SOCKET;
+lp->mp = &mux;
+lp->notelnet = TRUE;
+lp->rcve = 1;
+tmxr_init_line (lp);
+if ((f == NULL) || socketpair (AF_UNIX, SOCK_STREAM, 0, sv)) {
+    sim_printf ("tmxr: statistics test setup failed: %s\n", strerror (errno));
+    ++errors;
+    }
+else {
+    fcntl (sv[0], F_SETFL, fcntl (sv[0], F_GETFL) | O_NONBLOCK);
+    lp->sock = sv[0];
+    lp->conn = TRUE;
+    lp->cnms = sim_os_msec ();
+    if (write (sv[1], "0123456789", 10) != 10)
+        ++errors;
+    tmxr_poll_rx (&mux);
+    sim_os_ms_sleep (2);
+    tmxr_poll_rx (&mux);
+    if ((tmxr_getc_ln (lp) != (TMXR_VALID | '0')) || (lp->rxpeak != 10) ||
+        (lp->rxlatcnt != 1) || (lp->rxlatmax < 0.001) || (mux.polls != 2) ||
+        (mux.poll_intmax < 0.001)) {
+        sim_printf ("tmxr: statistics peak=%d latency samples=%d max=%.6f polls=%d\n", lp->rxpeak, lp->rxlatcnt, lp->rxlatmax, mux.polls);
+        ++errors;
+        }
+    tmxr_fstats_records (f, &mux);
+    rewind (f);
+    if ((NULL == fgets (record, sizeof (record), f)) || (0 != strncmp (record, "mux=", 4)) ||
+        (NULL == fgets (record, sizeof (record), f)) || (NULL == strstr (record, "line=0 connected=1 rx_bytes=10 ")) ||
+        (NULL == strstr (record, " rx_queued=9 "))) {
+        sim_printf ("tmxr: unexpected statistics record: %s", record);
+        ++errors;
+        }
+    tmxr_reset_ln (lp);                                 /* unread input is discarded */
+    if (lp->rxdrp != 9) {
+        sim_printf ("tmxr: %d discarded characters counted, expected 9\n", lp->rxdrp);
+        ++errors;
+        }
+    }
+if (f)
+    fclose (f);
+if (sv[1] >= 0)
+    close (sv[1]);
+free (lp->txb);
+free (lp->rxb);
+free (lp->rbr);
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* A burst of connections is accepted together and assigned without
+   waiting for further connection polls */
+
+static t_stat tmxr_test_accept_batch (DEVICE *dptr)
+{
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+SOCKET first = INVALID_SOCKET;
+SOCKET clients[6];
+struct sockaddr_in addr;
+socklen_t size = sizeof (addr);
+int on = 1;
+int errors = 0;
+int32 i, ln, depth;
+char hostport[32], busy[64];
+const int32 nclients = (int32)(sizeof (clients) / sizeof (clients[0]));
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.dptr = dptr;
+mux.lines = 4;
+mux.ldsc = (TMLN *)calloc (mux.lines, sizeof (*mux.ldsc));
+mux.ring_sock = INVALID_SOCKET;
+mux.notelnet = TRUE;
+mux.backlog = TMXR_DEFAULT_BACKLOG;
+mux.acc_sock = (SOCKET *)calloc (mux.backlog, sizeof (*mux.acc_sock));
+mux.acc_ipad = (char **)calloc (mux.backlog, sizeof (*mux.acc_ipad));
+mux.poll_interval = TMXR_DEFAULT_CONNECT_POLL_INTERVAL;
+for (i = 0; i < mux.lines; i++)
+    mux.ldsc[i].mp = &mux;
+for (i = 0; i < nclients; i++)
+    clients[i] = INVALID_SOCKET;
+/* Find a free port with a listener of our own, then share it */
+memset (&addr, 0, sizeof (addr));
+addr.sin_family = AF_INET;
+addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+first = socket (AF_INET, SOCK_STREAM, 0);
+if ((first == INVALID_SOCKET) ||
+#if defined (SO_REUSEPORT)
+    setsockopt (first, SOL_SOCKET, SO_REUSEPORT, (char *)&on, sizeof (on)) ||
+#endif
+    bind (first, (struct sockaddr *)&addr, sizeof (addr)) ||
+    getsockname (first, (struct sockaddr *)&addr, &size) ||
+    listen (first, 1)) {
+    sim_printf ("tmxr: accept test listener setup failed: %s\n", strerror (errno));
+    ++errors;
+    }
+if (errors == 0) {
+    snprintf (hostport, sizeof (hostport), "127.0.0.1:%d", ntohs (addr.sin_port));
+#if defined (SO_REUSEPORT)
+    mux.master = sim_master_sock_ex (hostport, NULL, SIM_SOCK_OPT_BACKLOG | SIM_SOCK_OPT_REUSEPORT);
+#else
+    sim_close_sock (first);
+    first = INVALID_SOCKET;
+    mux.master = sim_master_sock_ex (hostport, NULL, SIM_SOCK_OPT_BACKLOG);
+#endif
+    if (mux.master == INVALID_SOCKET) {
+        sim_printf ("tmxr: can't listen on shared port %s\n", hostport);
+        mux.master = 0;
+        ++errors;
+        }
+    }
+if (first != INVALID_SOCKET)
+    sim_close_sock (first);                             /* leave the mux as the only listener */
+for (i = 0; (errors == 0) && (i < nclients); i++) {
+    clients[i] = socket (AF_INET, SOCK_STREAM, 0);
+    if ((clients[i] == INVALID_SOCKET) ||
+        connect (clients[i], (struct sockaddr *)&addr, sizeof (addr))) {
+        sim_printf ("tmxr: accept test connect %d failed: %s\n", i, strerror (errno));
+        ++errors;
+        }
+    }
+if (errors == 0) {
+    sim_os_ms_sleep (10);
+    depth = sim_accept_queue_depth (mux.master, NULL);
+#if defined (__linux__)
+    if (depth != nclients) {
+        sim_printf ("tmxr: accept queue depth %d, expected %d\n", depth, nclients);
+        ++errors;
+        }
+#endif
+    mux.last_poll_time = sim_os_msec () - 2000;         /* connection poll is due */
+    for (i = 0; i < nclients; i++) {
+        ln = tmxr_poll_conn (&mux);
+        if (ln != ((i < mux.lines) ? i : -1)) {
+            sim_printf ("tmxr: connection poll %d returned line %d\n", i, ln);
+            ++errors;
+            }
+        }
+    if ((mux.sessions != nclients) || (mux.acc_batches != 1) || 
+        (mux.acc_batch_max != nclients) || (mux.acc_next != mux.acc_count)) {
+        sim_printf ("tmxr: sessions=%d batches=%d largest=%d waiting=%d\n", mux.sessions, mux.acc_batches, mux.acc_batch_max, mux.acc_count - mux.acc_next);
+        ++errors;
+        }
+    for (i = mux.lines; i < nclients; i++) {            /* the extra connections were turned away */
+        memset (busy, 0, sizeof (busy));
+        if ((recv (clients[i], busy, sizeof (busy) - 1, 0) <= 0) ||
+            (NULL == strstr (busy, "All connections busy"))) {
+            sim_printf ("tmxr: client %d was sent: %s\n", i, busy);
+            ++errors;
+            }
+        }
+    }
+for (i = 0; i < nclients; i++)
+    if (clients[i] != INVALID_SOCKET)
+        sim_close_sock (clients[i]);
+for (i = 0; i < mux.lines; i++) {
+    lp = &mux.ldsc[i];
+    if (lp->sock)
+        sim_close_sock (lp->sock);
+    free (lp->ipad);
+    free (lp->txb);
+    free (lp->rxb);
+    free (lp->rbr);
+    }
+_tmxr_accept_flush (&mux);
+if (mux.master)
+    sim_close_sock (mux.master);
+free (mux.acc_sock);
+free (mux.acc_ipad);
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Host serial ports (a pty pair stands in for one) are read when the
+   readiness service reports input and written without blocking */
+
+static t_stat tmxr_test_serial (DEVICE *dptr)
+{
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+int master;
+int errors = 0;
+int32 i, c;
+char in[16];
+const char *name;
+t_stat r;
+static const char msg[] = "serial";
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.dptr = dptr;
+mux.lines = 1;
+mux.ldsc = lp = (TMLN *)calloc (1, sizeof (*lp));
+mux.ring_sock = INVALID_SOCKET;
+lp->mp = &mux;
+lp->notelnet = TRUE;
+lp->rcve = 1;
+master = posix_openpt (O_RDWR | O_NOCTTY);
+if ((master < 0) || grantpt (master) || unlockpt (master) ||
+    (NULL == (name = ptsname (master)))) {
+    sim_printf ("tmxr: pty setup failed: %s\n", strerror (errno));
+    if (master >= 0)
+        close (master);
+    free (mux.ldsc);
+    return SCPE_IERR;
+    }
+fcntl (master, F_SETFL, fcntl (master, F_GETFL) | O_NONBLOCK);
+lp->serport = sim_open_serial ((char *)name, NULL, &r);
+if (lp->serport == INVALID_HANDLE) {
+    sim_printf ("tmxr: can't open %s as a serial port: %d\n", name, r);
+    lp->serport = 0;
+    ++errors;
+    }
+else {
+    tmxr_init_line (lp);
+    lp->conn = TRUE;
+    if (sim_serial_fd (lp->serport) <= 0) {
+        sim_printf ("tmxr: no descriptor to wait on for %s\n", name);
+        ++errors;
+        }
+    tmxr_poll_rx (&mux);                                /* nothing arrived yet */
+#if defined(HAVE_EPOLL)
+    if ((mux.poll_fd > 0) && (mux.poll_watched != 1)) {
+        sim_printf ("tmxr: serial port not watched for input (%d watched)\n", mux.poll_watched);
+        ++errors;
+        }
+#endif
+    if (write (master, msg, strlen (msg)) != (ssize_t)strlen (msg))
+        ++errors;
+    sim_os_ms_sleep (20);
+    tmxr_poll_rx (&mux);
+    memset (in, 0, sizeof (in));
+    for (i = 0; (i < (int32)sizeof (in) - 1) && ((c = tmxr_getc_ln (lp)) & TMXR_VALID); i++)
+        in[i] = (char)c;
+    if (strcmp (in, msg)) {
+        sim_printf ("tmxr: serial port received \"%s\", expected \"%s\"\n", in, msg);
+        ++errors;
+        }
+    for (i = 0; msg[i]; i++)
+        tmxr_putc_ln (lp, msg[i]);
+    tmxr_poll_tx (&mux);
+    sim_os_ms_sleep (20);
+    memset (in, 0, sizeof (in));
+    if ((read (master, in, sizeof (in) - 1) != (ssize_t)strlen (msg)) || strcmp (in, msg)) {
+        sim_printf ("tmxr: serial port sent \"%s\", expected \"%s\"\n", in, msg);
+        ++errors;
+        }
+    _tmxr_close_serial (lp);
+    lp->serport = 0;
+#if defined(HAVE_EPOLL)
+    if (mux.poll_watched != 0) {
+        sim_printf ("tmxr: closed serial port still watched\n");
+        ++errors;
+        }
+#endif
+    }
+close (master);
+free (lp->txb);
+free (lp->rxb);
+free (lp->rbr);
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Console and line input recorded in an event log comes back the same
+   when it is replayed, along with the line's connection and disconnection,
+   without reading the host console or any network session.  Other
+   console status (a break here) isn't part of the log. */
+
+static void tmxr_test_evlog_append (char *result, size_t size, const char *fmt, int32 val)
+{
+size_t len = strlen (result);
+
+snprintf (result + len, size - len, fmt, val);
+}
+
+static t_stat tmxr_test_evlog (DEVICE *dptr)
+{
+static const char *file = "tmxr_test_evlog.tmp";
+static const char *keys[] = {"aBb", "xBy"};             /* host console input recorded, then ignored */
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+SOCKET client = INVALID_SOCKET;
+struct sockaddr_in addr;
+socklen_t size = sizeof (addr);
+int con[2] = {-1, -1};
+int stdin_save = -1;
+int32 saved_switches = sim_switches;
+int32 saved_brk = sim_brk_char;
+int32 i, pass, ln, c;
+int errors = 0;
+char result[2][256], cmd[CBUFSIZE];
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.dptr = dptr;
+mux.lines = 2;
+mux.ldsc = (TMLN *)calloc (mux.lines, sizeof (*mux.ldsc));
+mux.ring_sock = INVALID_SOCKET;
+mux.notelnet = TRUE;
+mux.poll_interval = TMXR_DEFAULT_CONNECT_POLL_INTERVAL;
+for (i = 0; i < mux.lines; i++) {
+    mux.ldsc[i].mp = &mux;
+    mux.ldsc[i].rcve = 1;
+    }
+memset (&addr, 0, sizeof (addr));
+addr.sin_family = AF_INET;
+addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+mux.master = socket (AF_INET, SOCK_STREAM, 0);
+if ((mux.master == INVALID_SOCKET) ||
+    bind (mux.master, (struct sockaddr *)&addr, sizeof (addr)) ||
+    getsockname (mux.master, (struct sockaddr *)&addr, &size) ||
+    listen (mux.master, 1) ||
+    ((stdin_save = dup (0)) < 0) ||
+    pipe (con) ||
+    (dup2 (con[0], 0) < 0) ||
+    (sim_set_cons_batch (1, NULL) != SCPE_OK)) {
+    sim_printf ("tmxr: event log test setup failed: %s\n", strerror (errno));
+    ++errors;
+    }
+sim_switches |= SWMASK ('Q');                           /* no replay progress messages */
+sim_brk_char = 'B';
+for (pass = 0; (errors == 0) && (pass < 2); pass++) {
+    char *res = result[pass];
+
+    res[0] = '\0';
+    snprintf (cmd, sizeof (cmd), "ASYNCH %s=%s", pass ? "REPLAY" : "RECORD", file);
+    if (set_cmd (0, cmd) != SCPE_OK) {
+        sim_printf ("tmxr: can't %s\n", cmd);
+        ++errors;
+        break;
+        }
+    if (pass == 0) {                                    /* recording: a real session */
+        client = socket (AF_INET, SOCK_STREAM, 0);
+        if ((client == INVALID_SOCKET) ||
+            connect (client, (struct sockaddr *)&addr, sizeof (addr))) {
+            sim_printf ("tmxr: event log test connect failed: %s\n", strerror (errno));
+            ++errors;
+            }
+        sim_os_ms_sleep (10);
+        }
+    mux.last_poll_time = sim_os_msec () - 2000;         /* connection poll is due */
+    ln = tmxr_poll_conn (&mux);
+    tmxr_test_evlog_append (res, sizeof (result[0]), "C%d ", ln);
+    if (write (con[1], keys[pass], strlen (keys[pass])) != (ssize_t)strlen (keys[pass]))
+        ++errors;
+    for (i = 0; i < (int32)strlen (keys[pass]); i++) {
+        c = sim_poll_kbd ();
+        if (c & SCPE_KFLAG)
+            tmxr_test_evlog_append (res, sizeof (result[0]), "%c", c & 0xFF);
+        else
+            tmxr_test_evlog_append (res, sizeof (result[0]), (c == SCPE_BREAK) ? "<BREAK>" : "<%d>", c);
+        }
+    if (pass == 0) {
+        if (send (client, "hello", 5, 0) != 5)
+            ++errors;
+        sim_os_ms_sleep (10);
+        }
+    tmxr_poll_rx (&mux);
+    tmxr_test_evlog_append (res, sizeof (result[0]), " ", 0);
+    while ((ln >= 0) && (c = tmxr_getc_ln (&mux.ldsc[ln])))
+        tmxr_test_evlog_append (res, sizeof (result[0]), "%c", c & 0xFF);
+    if (pass == 0) {
+        sim_close_sock (client);
+        client = INVALID_SOCKET;
+        sim_os_ms_sleep (10);
+        }
+    tmxr_poll_rx (&mux);
+    for (i = 0; i < mux.lines; i++)
+        tmxr_test_evlog_append (res, sizeof (result[0]), " %d", mux.ldsc[i].conn);
+    if (pass == 0)
+        set_cmd (0, "ASYNCH NORECORD");
+    else
+        if (sim_evlog_replaying ()) {
+            sim_printf ("tmxr: event log replay wasn't complete\n");
+            set_cmd (0, "ASYNCH NOREPLAY");
+            ++errors;
+            }
+    }
+if ((errors == 0) && strcmp (result[0], "C0 a<BREAK>b hello 0 0")) {
+    sim_printf ("tmxr: recorded \"%s\"\n", result[0]);
+    ++errors;
+    }
+if ((errors == 0) && strcmp (result[0], result[1])) {
+    sim_printf ("tmxr: recorded \"%s\", replayed \"%s\"\n", result[0], result[1]);
+    ++errors;
+    }
+sim_brk_char = saved_brk;
+sim_switches = saved_switches;
+if (stdin_save >= 0) {
+    sim_set_cons_batch (0, NULL);
+    dup2 (stdin_save, 0);
+    close (stdin_save);
+    }
+if (con[0] >= 0) {
+    close (con[0]);
+    close (con[1]);
+    }
+if (client != INVALID_SOCKET)
+    sim_close_sock (client);
+for (i = 0; i < mux.lines; i++) {
+    lp = &mux.ldsc[i];
+    if (lp->conn)
+        tmxr_reset_ln (lp);
+    free (lp->ipad);
+    free (lp->txb);
+    free (lp->rxb);
+    free (lp->rbr);
+    }
+if (mux.master != INVALID_SOCKET)
+    sim_close_sock (mux.master);
+_tmxr_poll_close (&mux);
+free (mux.ldsc);
+remove (file);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+#endif
+
+/* Line logs are written through log streams; exercise rotation, time
+   stamps, compression and the asynchronous writer */
+
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+static t_stat tmxr_test_logstream (DEVICE *dptr)
+{
+static const char *base = "tmxr_test_logstream.tmp";
+char name[CBUFSIZE], line[CBUFSIZE];
+FILE *log = NULL;
+FILEREF *ref = NULL;
+int errors = 0;
+int32 i, n, saved_switches = sim_switches;
+t_offset size, total;
+t_stat r;
+
+/* synchronous rotation: 1K files, 2 kept, time stamped lines */
+r = sim_set_logging (0, "SYNCHRONOUS,ROTATE=1K,KEEP=2,TIMESTAMP");
+if (SCPE_BARE_STATUS (r) == SCPE_NOFNC)                 /* no log streams on this host? */
+    return SCPE_OK;
+sim_switches = SWMASK ('N');                            /* start with empty files */
+if ((r != SCPE_OK) || (sim_open_logstream (base, TRUE, &log, &ref) != SCPE_OK)) {
+    sim_printf ("tmxr: can't open log stream %s\n", base);
+    ++errors;
+    }
+else {
+    for (i = 0; i < 40; i++) {
+        fprintf (log, "line %02d of the rotation test.......................................\n", (int)i);
+        fflush (log);
+        }
+    sim_close_logfile (&ref);
+    for (n = 0; n <= 3; n++) {
+        if (n == 0)
+            strlcpy (name, base, sizeof (name));
+        else
+            snprintf (name, sizeof (name), "%s.%d", base, (int)n);
+        size = sim_fsize_name_ex (name);
+        if ((n == 3) ? (size != 0) : ((size == 0) || (size > 1024 + 128))) {
+            sim_printf ("tmxr: rotated log %s has unexpected size %d\n", name, (int)size);
+            ++errors;
+            }
+        if ((n == 1) && (log = fopen (name, "r"))) {
+            while (fgets (line, sizeof (line), log))
+                if ((line[0] != '[') || (NULL == strstr (line, "] line "))) {
+                    sim_printf ("tmxr: log line not time stamped: %s", line);
+                    ++errors;
+                    break;
+                    }
+            fclose (log);
+            }
+        remove (name);
+        }
+    }
+/* asynchronous writer: more data than the hand-off buffer holds */
+total = 0;
+if ((sim_set_logging (0, "ASYNCHRONOUS,NOROTATE,NOTIMESTAMP") != SCPE_OK) ||
+    (sim_open_logstream (base, TRUE, &log, &ref) != SCPE_OK)) {
+    sim_printf ("tmxr: can't open asynchronous log stream %s\n", base);
+    ++errors;
+    }
+else {
+    for (i = 0; i < 100000; i++) {
+        n = fprintf (log, "async %06d\n", (int)i);
+        total += n;
+        if ((i % 1000) == 0)
+            fflush (log);
+        }
+    sim_close_logfile (&ref);
+    size = sim_fsize_name_ex (base);
+    if (size != total) {
+        sim_printf ("tmxr: asynchronous log has %d bytes, expected %d\n", (int)size, (int)total);
+        ++errors;
+        }
+    remove (base);
+    }
+#if defined(HAVE_ZLIB)
+/* compressed output reads back as written */
+if ((sim_set_logging (0, "COMPRESS") != SCPE_OK) ||
+    (sim_open_logstream (base, TRUE, &log, &ref) != SCPE_OK)) {
+    sim_printf ("tmxr: can't open compressed log stream %s\n", base);
+    ++errors;
+    }
+else {
+    gzFile gz;
+
+    snprintf (name, sizeof (name), "%s.gz", base);
+    fprintf (log, "compressed log data\n");
+    sim_close_logfile (&ref);
+    memset (line, 0, sizeof (line));
+    if ((NULL == (gz = gzopen (name, "rb"))) ||
+        (gzread (gz, line, sizeof (line) - 1) <= 0) ||
+        strcmp (line, "compressed log data\n")) {
+        sim_printf ("tmxr: compressed log %s read back \"%s\"\n", name, line);
+        ++errors;
+        }
+    if (gz)
+        gzclose (gz);
+    remove (name);
+    }
+#endif
+sim_set_logging (0, "ASYNCHRONOUS,NOROTATE,KEEP=5,NOCOMPRESS,NOTIMESTAMP");
+sim_switches = saved_switches;
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Recorded input replays in order, at the requested pace, and guest output
+   after a replayed record is counted as its response */
+
+static t_stat tmxr_test_replay (DEVICE *dptr)
+{
+static const char *file = "tmxr_test_replay.tmp";
+static const char *recs[] = {"login\r", "show \"users\"\r"};
+TMXR mux;
+UNIT unit;
+TMLN *lp;
+struct tmxr_replay *rp;
+int errors = 0;
+int32 i, j, c;
+char in[64], spec[CBUFSIZE];
+double rate, now;
+
+memset (&mux, 0, sizeof (mux));
+memset (&unit, 0, sizeof (unit));
+mux.uptr = &unit;
+mux.dptr = dptr;
+mux.lines = 1;
+mux.ldsc = lp = (TMLN *)calloc (1, sizeof (*lp));
+mux.ring_sock = INVALID_SOCKET;
+lp->mp = &mux;
+tmxr_init_line (lp);
+lp->txbfd = 1;                                          /* buffered, so readable unconnected */
+lp->rcve = 1;
+/* record two reads a quarter second apart */
+if (_tmxr_record_open (lp, file) != SCPE_OK) {
+    sim_printf ("tmxr: can't create recording %s\n", file);
+    free (lp->txb);
+    free (lp->rxb);
+    free (lp->rbr);
+    free (mux.ldsc);
+    return SCPE_IERR;
+    }
+now = sim_timenow_double ();
+for (i = 0; i < 2; i++)
+    _tmxr_record (lp, recs[i], (int32)strlen (recs[i]), now + 0.25 * i);
+_tmxr_record_close (lp);
+if ((_tmxr_replay_spec ("x;MAX", spec, sizeof (spec), &rate) != SCPE_OK) || (rate != 0.0) || strcmp (spec, "x") ||
+    (_tmxr_replay_spec ("x;2.5x", spec, sizeof (spec), &rate) != SCPE_OK) || (rate != 2.5) ||
+    (_tmxr_replay_spec ("x;fast", spec, sizeof (spec), &rate) == SCPE_OK) ||
+    (_tmxr_replay_spec ("x;0", spec, sizeof (spec), &rate) == SCPE_OK)) {
+    sim_printf ("tmxr: replay specifiers misparsed\n");
+    ++errors;
+    }
+/* MAX: the next record is queued once the guest has read and responded */
+if (_tmxr_replay_open (lp, file, 0.0) != SCPE_OK) {
+    sim_printf ("tmxr: can't open replay %s\n", file);
+    ++errors;
+    }
+else {
+    rp = lp->replay;
+    if (rp->count != 2) {
+        sim_printf ("tmxr: replay has %d records, expected 2\n", (int)rp->count);
+        ++errors;
+        }
+    now = sim_timenow_double ();
+    for (i = 0; (i < rp->count) && (i < 2); i++) {
+        _tmxr_replay_poll (lp, now);
+        _tmxr_replay_poll (lp, now);                    /* nothing more until a response */
+        if (rp->next != i + 1) {
+            sim_printf ("tmxr: replay at MAX queued %d records, expected %d\n", (int)rp->next, (int)(i + 1));
+            ++errors;
+            }
+        memset (in, 0, sizeof (in));
+        for (j = 0; (j < (int32)sizeof (in) - 1) && (c = tmxr_getc_ln (lp)); j++)
+            in[j] = (char)c;
+        if (strcmp (in, recs[i])) {
+            sim_printf ("tmxr: replayed record %d read back as \"%s\"\n", (int)i, in);
+            ++errors;
+            }
+        _tmxr_replay_output (lp);
+        }
+    if (rp->responses != 2) {
+        sim_printf ("tmxr: replay counted %d responses, expected 2\n", (int)rp->responses);
+        ++errors;
+        }
+    }
+/* paced: at 2x the second record is due an eighth of a second later */
+if (_tmxr_replay_open (lp, file, 2.0) != SCPE_OK) {
+    sim_printf ("tmxr: can't reopen replay %s\n", file);
+    ++errors;
+    }
+else {
+    rp = lp->replay;
+    now = 1000.0;
+    _tmxr_replay_poll (lp, now);
+    _tmxr_replay_poll (lp, now + 0.1);
+    if (rp->next != 1) {
+        sim_printf ("tmxr: paced replay queued %d records early\n", (int)rp->next);
+        ++errors;
+        }
+    _tmxr_replay_poll (lp, now + 0.13);
+    if (rp->next != 2) {
+        sim_printf ("tmxr: paced replay queued %d records, expected 2\n", (int)rp->next);
+        ++errors;
+        }
+    }
+_tmxr_replay_close (lp);
+remove (file);
+free (lp->send.buffer);
+free (lp->txb);
+free (lp->rxb);
+free (lp->rbr);
+free (mux.ldsc);
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+#include <setjmp.h>
+
+/* Throughput figures are only reported when the tests run with -B */
+
+t_stat sim_tmxr_test (DEVICE *dptr)
+{
+t_stat stat = SCPE_OK;
+SIM_TEST_INIT;
+
+sim_printf ("Testing %s device sim_tmxr APIs\n", dptr->name);
+
+#if !defined(_WIN32) && !defined(VMS)
+SIM_TEST(tmxr_test_poll_rx (dptr));
+SIM_TEST(tmxr_test_bulk (dptr));
+SIM_TEST(tmxr_test_telnet_rx (dptr));
+SIM_TEST(tmxr_test_statistics (dptr));
+SIM_TEST(tmxr_test_accept_batch (dptr));
+SIM_TEST(tmxr_test_serial (dptr));
+SIM_TEST(tmxr_test_evlog (dptr));
+#endif
+SIM_TEST(tmxr_test_logstream (dptr));
+SIM_TEST(tmxr_test_replay (dptr));
+return stat;
+}
@@ -60,11 +60,14 @@ typedef struct SERPORT *SERHANDLE;
 
 #define TMXR_V_VALID    15
 #define TMXR_VALID      (1 << TMXR_V_VALID)
-#define TMXR_MAXBUF     256                             /* buffer size */
+#define TMXR_MAXBUF     256                             /* default buffer size */
+#define TMXR_MAXBUFSIZE (1024*1024)                     /* largest configurable buffer size */
 
 #define TMXR_DTR_DROP_TIME 500                          /* milliseconds to drop DTR for 'pseudo' modem control */
 #define TMXR_MODEM_RING_TIME 3                          /* seconds to wait for DTR for incoming connections */
 #define TMXR_DEFAULT_CONNECT_POLL_INTERVAL 1            /* seconds between connection polls */
+#define TMXR_DEFAULT_BACKLOG 64                         /* connections accepted per readiness event */
+#define TMXR_MAX_BACKLOG 4096                           /* largest configurable accept batch */
 
 #define TMXR_DBG_XMT    0x00200000                       /* Debug Transmit Data */
 #define TMXR_DBG_RCV    0x00400000                       /* Debug Received Data */
@@ -136,6 +139,7 @@ struct loopbuf {
 struct tmln {
     int                 conn;                           /* line connected flag */
     SOCKET              sock;                           /* connection socket */
+    t_bool              evlog_conn;                     /* connection replayed from an event log */
     char                *ipad;                          /* IP address */
     SOCKET              master;                         /* line specific master socket */
     char                *port;                          /* line specific listening port */
@@ -158,14 +162,27 @@ struct tmln {
     int32               txpcnt;                         /* xmt packet count */
     int32               txdrp;                          /* xmt drop count */
     int32               txstall;                        /* xmt stall count */
+    int32               rxpeak;                         /* peak rcv buffer fill */
+    int32               txpeak;                         /* peak xmt buffer fill */
+    int32               rxdrp;                          /* rcv chars discarded unread */
+    int32               rxdefer;                        /* rcv reads deferred by speed limit */
+    int32               rxlatcnt;                       /* rcv latency samples */
+    double              rxarrive;                       /* time unread input arrived (0 = none) */
+    double              rxlatsum;                       /* total rcv latency (seconds) */
+    double              rxlatmax;                       /* max rcv latency (seconds) */
     int32               txbsz;                          /* xmt buffer size */
     int32               txbfd;                          /* xmt buffered flag */
+    int32               bufsize;                        /* unbuffered rcv/xmt buffer size (0 = mux default) */
     t_bool              modem_control;                  /* line supports modem control behaviors */
     t_bool              port_speed_control;             /* line programmatically sets port speed */
     int32               modembits;                      /* modem bits which are currently set */
     FILE                *txlog;                         /* xmt log file */
     FILEREF             *txlogref;                      /* xmt log file reference */
     char                *txlogname;                     /* xmt log file name */
+    FILE                *rxrecord;                      /* rcv data recording file */
+    char                *rxrecordname;                  /* rcv data recording file name */
+    double              rxrecordlast;                   /* time of last recorded rcv data */
+    struct tmxr_replay  *replay;                        /* rcv data replay state (private) */
     char                *rxb;                           /* rcv buffer */
     char                *rbr;                           /* rcv break */
     char                *txb;                           /* xmt buffer */
@@ -205,6 +222,10 @@ struct tmln {
     DEVICE              *dptr;                          /* line specific device */
     EXPECT              expect;                         /* Expect rules */
     SEND                send;                           /* Send input state */
+    SOCKET              rx_watch;                       /* data socket registered for readiness */
+    SOCKET              conn_watch;                     /* connecting socket registered for readiness */
+    SOCKET              master_watch;                   /* listening socket registered for readiness */
+    uint32              ready;                          /* readiness seen but not yet serviced */
     };
 
 struct tmxr {
@@ -216,19 +237,41 @@ struct tmxr {
     DEVICE              *dptr;                          /* multiplexer device */
     UNIT                *uptr;                          /* polling unit (connection) */
     char                logfiletmpl[FILENAME_MAX];      /* template logfile name */
+    char                recordtmpl[FILENAME_MAX];       /* template rcv data recording file name */
+    char                replaytmpl[FILENAME_MAX];       /* template rcv data replay file name{;rate} */
     int32               txcount;                        /* count of transmit bytes */
     int32               buffered;                       /* Buffered Line Behavior and Buffer Size Flag */
+    int32               bufsize;                        /* unbuffered line buffer size (0 = TMXR_MAXBUF) */
+    int32               polls;                          /* count of receive polls */
+    double              poll_last;                      /* time of last receive poll */
+    double              poll_intsum;                    /* total time between receive polls (seconds) */
+    double              poll_intmax;                    /* max time between receive polls (seconds) */
     int32               sessions;                       /* count of tcp connections received */
     uint32              poll_interval;                  /* frequency of connection polls (seconds) */
     uint32              last_poll_time;                 /* time of last connection poll */
     uint32              ring_start_time;                /* time ring signal was raised */
     char                *ring_ipad;                     /* incoming connection address awaiting DTR */
     SOCKET              ring_sock;                      /* incoming connection socket awaiting DTR */
+    t_bool              ring_evlog;                     /* ring replayed from an event log */
+    int32               backlog;                        /* connections accepted per readiness (0 = one per poll) */
+    t_bool              reuseport;                      /* listening port may be shared (SO_REUSEPORT) */
+    int32               acc_count;                      /* accepted connections */
+    int32               acc_next;                       /* next accepted connection to assign to a line */
+    SOCKET              *acc_sock;                      /* accepted connection sockets awaiting a line */
+    char                **acc_ipad;                     /* accepted connection addresses awaiting a line */
+    int32               acc_batches;                    /* count of accept batches */
+    int32               acc_batch_max;                  /* largest accept batch */
     t_bool              notelnet;                       /* default telnet capability for incoming connections */
     t_bool              modem_control;                  /* multiplexer supports modem control behaviors */
     t_bool              port_speed_control;             /* multiplexer programmatically sets port speed */
     t_bool              packet;                         /* Lines are packet oriented */
     t_bool              datagram;                       /* Lines use datagram packet transport */
+    int                 poll_fd;                        /* readiness (epoll) descriptor (-1 if unavailable) */
+    SOCKET              master_watch;                   /* master socket registered for readiness */
+    uint32              ready;                          /* master socket readiness not yet serviced */
+    int32               poll_watched;                   /* count of sockets registered for readiness */
+    int32               poll_events_size;               /* readiness event buffer size */
+    void                *poll_events;                   /* readiness event buffer */
     };
 
 int32 tmxr_poll_conn (TMXR *mp);
@@ -236,10 +279,12 @@ t_stat tmxr_reset_ln (TMLN *lp);
 t_stat tmxr_detach_ln (TMLN *lp);
 int32 tmxr_input_pending_ln (TMLN *lp);
 int32 tmxr_getc_ln (TMLN *lp);
+int32 tmxr_read_ln (TMLN *lp, uint8 *buf, uint8 *brk, int32 size);
 t_stat tmxr_get_packet_ln (TMLN *lp, const uint8 **pbuf, size_t *psize);
 t_stat tmxr_get_packet_ln_ex (TMLN *lp, const uint8 **pbuf, size_t *psize, uint8 frame_byte);
 void tmxr_poll_rx (TMXR *mp);
 t_stat tmxr_putc_ln (TMLN *lp, int32 chr);
+t_stat tmxr_write_ln (TMLN *lp, const uint8 *buf, int32 size, int32 *sent);
 t_stat tmxr_put_packet_ln (TMLN *lp, const uint8 *buf, size_t size);
 t_stat tmxr_put_packet_ln_ex (TMLN *lp, const uint8 *buf, size_t size, uint8 frame_byte);
 void tmxr_poll_tx (TMXR *mp);
@@ -309,6 +354,7 @@ t_stat tmxr_startup (void);
 t_stat tmxr_shutdown (void);
 t_stat tmxr_start_poll (void);
 t_stat tmxr_stop_poll (void);
+t_stat sim_tmxr_test (DEVICE *dptr);                    /* unit test routine */
 void _tmxr_debug (uint32 dbits, TMLN *lp, const char *msg, char *buf, int bufsize);
 #define tmxr_debug(dbits, lp, msg, buf, bufsize) do {if (sim_deb && (lp)->mp && (lp)->mp->dptr && ((dbits) & (lp)->mp->dptr->dctrl)) _tmxr_debug (dbits, lp, msg, buf, bufsize); } while (0)
 #define tmxr_debug_msg(dbits, lp, msg) do {if (sim_deb && (lp)->mp && (lp)->mp->dptr && ((dbits) & (lp)->mp->dptr->dctrl)) sim_debug (dbits, (lp)->mp->dptr, "%s", msg); } while (0)